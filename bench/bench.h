@@ -0,0 +1,33 @@
+// Minimal benchmark helpers (no external dependencies)
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Keeps the optimizer from discarding a computed value
+template <typename T>
+inline void DoNotOptimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    const volatile T *sink = &value;
+    (void)sink;
+#endif
+}
+
+// Runs fn(i) for i in [0, iterations) and prints the average cost per iteration
+template <typename Fn>
+inline double RunBenchmark(const char *name, uint64_t iterations, Fn &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        fn(i);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double nsPerOp = ns / (double)iterations;
+    printf("%-40s %12llu iters %10.2f ns/op\n", name, (unsigned long long)iterations, nsPerOp);
+    return nsPerOp;
+}
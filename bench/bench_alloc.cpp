@@ -0,0 +1,212 @@
+// Allocation check of the input -> flash -> present path
+// Replaces the global operator new, warms everything up, then runs a simulated
+// session and fails if a single heap allocation happens in steady state
+//
+// Usage: bench_alloc [events]
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "bench.h"
+#include "core/frame_times.h"
+#include "core/input_source.h"
+#include "core/latency_stages.h"
+#include "core/latency_tester.h"
+#include "core/overlay_text.h"
+#include "core/polling_rate.h"
+#include "core/raw_input.h"
+#include "core/reaction_tester.h"
+#include "core/wait_strategy.h"
+#include "headless/fake_device_enumerator.h"
+
+static std::atomic<uint64_t> g_allocations{0};
+static std::atomic<bool> g_counting{false};
+
+static void *CountedAlloc(size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+static void *CountedAlignedAlloc(size_t size, std::align_val_t align)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = (size_t)align;
+    void *p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size) { return CountedAlloc(size); }
+void *operator new[](size_t size) { return CountedAlloc(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try { return CountedAlloc(size); } catch (...) { return nullptr; }
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    try { return CountedAlloc(size); } catch (...) { return nullptr; }
+}
+void *operator new(size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+void *operator new[](size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { free(p); }
+
+class SessionNames : public LogNameSource
+{
+public:
+    explicit SessionNames(DeviceRegistry &devices) : m_devices(devices) {}
+
+    const wchar_t *DeviceName(uint16_t deviceId) override { return m_devices.DisplayName(deviceId); }
+    void KeyName(const InputEvent &, wchar_t *out, size_t outSize) override { swprintf(out, outSize, L"A"); }
+
+private:
+    DeviceRegistry &m_devices;
+};
+
+// The unpaced spin wait never blocks; the target only has to exist
+class SpinTarget : public WaitTarget
+{
+public:
+    bool Pending() override { return false; }
+    WakeReason Block(TimePoint, bool) override { return WakeReason::Deadline; }
+    bool AcquireFrame(TimePoint) override { return true; }
+};
+
+struct Session
+{
+    FakeDeviceEnumerator enumerator;
+    DeviceRegistry devices{enumerator};
+    RingInputSource input;
+    InputEvent batch[InputSource::MAX_POLL_EVENTS];
+    LatencyTester latency;
+    ReactionTester reaction{42};
+    PollingRateAnalyzer mouseRate;
+    FrameTimeRing frameTimes;
+    LatencyAttribution stages;
+    FrameWaiter waiter;
+    SpinTarget waitTarget;
+    InstructionText instructions;
+    SessionNames logNames{devices};
+    std::vector<uint8_t> clickRecord, moveRecord, keyRecord;
+    TimePoint now{};
+    uint64_t whiteFrames = 0;
+
+    Session()
+    {
+        enumerator.AddDevice(0x1001, L"\\\\?\\HID#VID_046D&PID_C547&MI_00#7&1234&0&0000#{378de44c}");
+        enumerator.AddDevice(0x2002, L"\\\\?\\HID#VID_1532&PID_0266&MI_00#8&5678&0&0000#{884b96c3}");
+        devices.OnArrival(0x1001);
+        devices.OnArrival(0x2002);
+        AppendRawMouse(clickRecord, 0x1001, MOUSE_LEFT_DOWN, 0, 0, 0);
+        AppendRawMouse(moveRecord, 0x1001, 0, 0, 3, -1);
+        AppendRawKeyboard(keyRecord, 0x2002, 0x41, 0x1E, 0);
+        latency.enableLog = true;
+        latency.filter.enableMouseDelta = true;
+        // Every other click here is a false start; the trial store doubles a few times per
+        // session, sized up front so only per-frame work is counted
+        reaction.trials.Reserve(1 << 17);
+        reaction.StartNewRound(now);
+    }
+
+    // One 8 kHz report: WM_INPUT decode + ring push, as ProcessRawInput does
+    void Report(uint64_t i)
+    {
+        const std::vector<uint8_t> &record = i % 97 == 0 ? keyRecord : (i % 16 == 0 ? clickRecord : moveRecord);
+        InputEvent ev;
+        if (DecodeRawInputRecord(record.data(), record.size(), now, devices, ev))
+            input.Push(ev);
+    }
+
+    // One loop iteration: drain input, update both testers, format the overlay
+    void Frame()
+    {
+        waiter.Wait(waitTarget);
+        frameTimes.Record(now);
+        size_t count = input.Poll(batch, InputSource::MAX_POLL_EVENTS);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const InputEvent &ev = batch[i];
+            if (IsMouseDelta(ev))
+                mouseRate.Record(ev.time);
+            uint32_t id = stages.OnInput();
+            if (latency.OnInput(ev, devices.DisplayName(ev.deviceId), L"A") != InputAction::None)
+                stages.OnTrigger(id, ev, now);
+            if (reaction.OnInput(ev) == ReactionEvent::Restart)
+                reaction.StartNewRound(now);
+        }
+
+        latency.UpdateFrame(now);
+        reaction.Update(now);
+        float color[4];
+        latency.GetClearColor(color);
+        if (color[0] > 0.0f)
+            whiteFrames++;
+        if (stages.Pending())
+        {
+            stages.OnClear(now);
+            stages.OnPresent(now, now, true);
+        }
+
+        wchar_t fpsBuffer[256];
+        PollingRateStats hz = mouseRate.Snapshot(now);
+        FrameTimeStats frames = frameTimes.Snapshot();
+        WaitStats wait = waiter.Stats(WaitStrategy::Spin);
+        size_t length = FormatFrameStats(10000.0f, 0.1f, &frames, &wait, &hz, fpsBuffer, 256);
+        const wchar_t *line = instructions.Update(latency, OverlayToggles());
+        DoNotOptimize(length);
+        DoNotOptimize(line);
+        for (size_t i = 0; i < latency.log.RowCount() && i < 30; ++i)
+            DoNotOptimize(latency.log.Row(i, logNames));
+    }
+
+    // 8 reports per 10 kHz-ish frame, 125 us apart
+    void Run(uint64_t reports)
+    {
+        for (uint64_t i = 0; i < reports; ++i)
+        {
+            now += std::chrono::microseconds(125);
+            Report(i);
+            if (i % 8 == 7)
+                Frame();
+        }
+    }
+};
+
+int main(int argc, char **argv)
+{
+    uint64_t reports = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    Session *session = new Session();
+
+    // Warm-up: fills the log ring and reaction stats, resolves device names
+    session->Run(100000);
+
+    session->whiteFrames = 0;
+    g_allocations = 0;
+    g_counting = true;
+    auto start = std::chrono::steady_clock::now();
+    session->Run(reports);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    g_counting = false;
+    uint64_t allocations = g_allocations.load();
+
+    printf("%llu reports, %llu frames, %llu white frames, %.1f ns/report\n", (unsigned long long)reports,
+           (unsigned long long)(reports / 8), (unsigned long long)session->whiteFrames, ns / (double)reports);
+    printf("heap allocations in steady state: %llu\n", (unsigned long long)allocations);
+    delete session;
+    return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// Audio configuration choice against fake capability tables: typical devices (onboard
+// codec, USB interface with a long exclusive period, an exclusive-disabled endpoint, a
+// pre-IAudioClient3 engine) must rank the expected lowest-latency configuration first and
+// keep every fallback behind it. Also round-trips the per-device cache, including the
+// period floor that re-ranks a device after underruns. Returns 1 if a check fails.
+
+#include <cstdio>
+#include <string>
+#include "bench.h"
+#include "core/audio_caps.h"
+
+static AudioFormat Format(uint32_t rate, uint16_t channels, SampleFormat sample)
+{
+    AudioFormat format;
+    format.sampleRate = rate;
+    format.channels = channels;
+    format.sample = sample;
+    return format;
+}
+
+static bool SameFormat(const AudioFormat &a, const AudioFormat &b)
+{
+    return a.sampleRate == b.sampleRate && a.channels == b.channels && a.sample == b.sample;
+}
+
+struct Case
+{
+    const char *name;
+    AudioDeviceCaps caps;
+    AudioConfigPreference preference;
+    AudioShareMode mode; // Expected first choice
+    AudioFormat format;
+    uint32_t periodFrames;
+    size_t count; // Expected number of configurations
+};
+
+static bool Check(const Case &c)
+{
+    std::vector<AudioConfig> ranked = RankAudioConfigs(c.caps, c.preference);
+    bool ok = ranked.size() == c.count && !ranked.empty() && ranked[0].mode == c.mode &&
+              SameFormat(ranked[0].format, c.format) && ranked[0].periodFrames == c.periodFrames;
+    for (size_t i = 1; i < ranked.size() && ok; ++i)
+        ok = ranked[i - 1].EstimatedLatencyMs() <= ranked[i].EstimatedLatencyMs() + 0.05;
+    // The plain shared stream is always offered when the mix format is usable
+    bool shared = false;
+    for (const AudioConfig &config : ranked)
+        shared = shared || config.mode == AudioShareMode::Shared;
+    ok = ok && (!c.caps.mixUsable || shared);
+
+    char chosen[128];
+    if (!ranked.empty())
+        FormatAudioConfig(ranked[0], chosen, sizeof(chosen));
+    printf("%-34s %zu configs, first: %s: %s\n", c.name, ranked.size(), ranked.empty() ? "none" : chosen,
+           ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main()
+{
+    const AudioFormat mixFloat = Format(48000, 2, SampleFormat::Float32);
+
+    // Onboard codec: exclusive 16-bit at 44.1/48 kHz, 3 ms minimum; engine down to 128 frames
+    AudioDeviceCaps onboard;
+    onboard.mixUsable = true;
+    onboard.mixFormat = mixFloat;
+    onboard.exclusiveFormats = {Format(44100, 2, SampleFormat::Int16), Format(48000, 2, SampleFormat::Int16)};
+    onboard.exclusiveMinPeriodUs = 3000;
+    onboard.sharedDefaultPeriodUs = 10000;
+    onboard.sharedMinFrames = 128;
+    onboard.sharedMaxFrames = 480;
+    onboard.sharedFundamentalFrames = 32;
+
+    // USB interface: exclusive only at 10 ms, so the low-latency engine (2.67 ms) wins
+    AudioDeviceCaps usb = onboard;
+    usb.exclusiveMinPeriodUs = 10000;
+
+    // Exclusive disabled by policy (no formats) and an engine without IAudioClient3
+    AudioDeviceCaps locked = onboard;
+    locked.exclusiveFormats.clear();
+    AudioDeviceCaps legacy = locked;
+    legacy.sharedMinFrames = legacy.sharedMaxFrames = legacy.sharedFundamentalFrames = 0;
+
+    // Interface with float exclusive formats down to 1.33 ms; 48 kHz preferred over 96 kHz
+    AudioDeviceCaps studio = onboard;
+    studio.exclusiveFormats = {Format(96000, 2, SampleFormat::Float32), Format(48000, 2, SampleFormat::Float32)};
+    studio.exclusiveMinPeriodUs = 1333;
+
+    AudioConfigPreference noExclusive;
+    noExclusive.allowExclusive = false;
+    AudioConfigPreference floor4ms;
+    floor4ms.minPeriodUs = 4000;
+    AudioConfigPreference floor20ms;
+    floor20ms.minPeriodUs = 20000;
+
+    const Case cases[] = {
+        {"onboard codec", onboard, {}, AudioShareMode::Exclusive, Format(48000, 2, SampleFormat::Int16), 144, 4},
+        {"usb, long exclusive period", usb, {}, AudioShareMode::SharedLowLatency, mixFloat, 128, 4},
+        {"exclusive disabled", locked, {}, AudioShareMode::SharedLowLatency, mixFloat, 128, 2},
+        {"no low-latency engine", legacy, {}, AudioShareMode::Shared, mixFloat, 480, 1},
+        {"studio, 1.33 ms exclusive", studio, {}, AudioShareMode::Exclusive, Format(48000, 2, SampleFormat::Float32),
+         64, 4},
+        {"onboard, -exclusive not allowed", onboard, noExclusive, AudioShareMode::SharedLowLatency, mixFloat, 128, 2},
+        // Floor above the minimum: exclusive at 4 ms (8 ms) still beats the engine at 192 frames (12 ms)
+        {"onboard, 4 ms floor", onboard, floor4ms, AudioShareMode::Exclusive, Format(48000, 2, SampleFormat::Int16),
+         192, 4},
+        // Floor above the engine's range: no low-latency entry, and exclusive at 20 ms (40 ms)
+        // loses to the default shared stream, which ignores the floor
+        {"onboard, 20 ms floor", onboard, floor20ms, AudioShareMode::Shared, mixFloat, 480, 3},
+    };
+    bool ok = true;
+    for (const Case &c : cases)
+        ok = Check(c) && ok;
+
+    AudioDeviceCaps unusable;
+    unusable.exclusiveMinPeriodUs = 3000; // No usable formats anywhere
+    bool none = RankAudioConfigs(unusable).empty();
+    printf("no usable format: %s\n", none ? "ok" : "FAIL");
+    printf("%s", FormatAudioCaps(onboard).c_str());
+
+    // Cache: round trip, mix-format change invalidates, floor forces a re-rank, junk is skipped
+    const std::string path = "bench_audio_caps.cache";
+    AudioConfig chosen = RankAudioConfigs(onboard)[0];
+    AudioCapsCache cache;
+    cache.Store("{0.0.0.00000000}.{onboard}", onboard.mixFormat, chosen);
+    cache.Store("{0.0.0.00000000}.{usb}", usb.mixFormat, RankAudioConfigs(usb)[0]);
+    bool cached = cache.Save(path);
+    FILE *f = fopen(path.c_str(), "a");
+    if (f)
+    {
+        fprintf(f, "broken line\n{0.0.0.00000000}.{bad}\t48000\t2\tfloat64\tshared\t48000\t2\tint16\t480\t0\n");
+        fclose(f);
+    }
+
+    AudioCapsCache loaded;
+    AudioConfig found;
+    cached = cached && loaded.Load(path) && loaded.Count() == 2 &&
+             loaded.Find("{0.0.0.00000000}.{onboard}", onboard.mixFormat, found) && found.mode == chosen.mode &&
+             SameFormat(found.format, chosen.format) && found.periodFrames == chosen.periodFrames &&
+             !loaded.Find("{0.0.0.00000000}.{onboard}", Format(44100, 2, SampleFormat::Float32), found) &&
+             !loaded.Find("{0.0.0.00000000}.{missing}", onboard.mixFormat, found);
+
+    // Underruns at 3 ms: the floor outlives a save/load, and the stored config no longer qualifies
+    loaded.SetPeriodFloor("{0.0.0.00000000}.{onboard}", 4500);
+    AudioCapsCache reloaded;
+    cached = cached && loaded.Save(path) && reloaded.Load(path) &&
+             reloaded.PeriodFloor("{0.0.0.00000000}.{onboard}") == 4500 &&
+             !reloaded.Find("{0.0.0.00000000}.{onboard}", onboard.mixFormat, found) &&
+             reloaded.Find("{0.0.0.00000000}.{usb}", usb.mixFormat, found);
+    AudioCapsCache missing;
+    cached = cached && !missing.Load("bench_audio_caps.missing") && missing.Count() == 0;
+    remove(path.c_str());
+    printf("device cache round trip, invalidation and period floor: %s\n", cached ? "ok" : "FAIL");
+
+    // Startup cost of ranking when the cache misses
+    RunBenchmark("RankAudioConfigs (onboard)", 100000, [&](uint64_t) {
+        std::vector<AudioConfig> ranked = RankAudioConfigs(onboard);
+        DoNotOptimize(ranked[0].periodFrames);
+    });
+    return ok && none && cached ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Audio clock correlation against synthetic device clocks: a sample clock running off
+// nominal by a fixed drift reports its position every period with jittered host
+// timestamps, and AudioClockCorrelator predicts when a frame two periods ahead reaches
+// the DAC. Checks that the prediction beats extrapolating at the nominal rate, that the
+// reported error covers the actual one, that delayed pairs are rejected, and that a
+// stream jump (underrun) restarts the fit. Returns 1 if a check fails.
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "core/audio_clock.h"
+
+struct ClockTrace
+{
+    const char *name;
+    double driftPpm;     // True rate = nominal * (1 + drift)
+    double jitterUs;     // Gaussian noise on each pair's host timestamp
+    double outlierRate;  // Fraction of pairs stamped 1-5 ms late
+    double jumpAtSec;    // Stream jumps 100 ms at this time (0: never)
+};
+
+struct TraceResult
+{
+    double rmsUs = 0.0;       // Fit prediction vs truth
+    double maxUs = 0.0;
+    double nominalRmsUs = 0.0; // Extrapolating the first pair at the nominal rate
+    double coverage = 0.0;    // Predictions within 3 reported errors
+    double driftPpm = 0.0;
+    uint64_t rejected = 0;
+    uint64_t restarts = 0;
+};
+
+static TraceResult RunTrace(const ClockTrace &trace, double seconds)
+{
+    const uint32_t nominal = 48000;
+    const uint64_t period = 480; // 10 ms
+    const double trueRate = nominal * (1.0 + trace.driftPpm * 1e-6);
+    const int64_t hostStart = 5000000000ll;
+
+    std::mt19937 rng(22);
+    std::normal_distribution<double> jitter(0.0, trace.jitterUs * 1000.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    AudioClockCorrelator clock;
+    TraceResult result;
+    double sumSq = 0.0, nominalSq = 0.0;
+    uint64_t predictions = 0, covered = 0;
+    uint64_t frameOffset = 0; // Frames lost to the jump
+    bool jumped = false;
+    uint64_t settleUntil = 0; // Skip scoring while the fit recovers from the jump
+
+    const uint64_t periods = (uint64_t)(seconds * trueRate / period);
+    for (uint64_t i = 0; i < periods; ++i)
+    {
+        uint64_t frame = i * period;
+        double trueNs = frame / trueRate * 1e9;
+        if (trace.jumpAtSec > 0.0 && !jumped && trueNs >= trace.jumpAtSec * 1e9)
+        {
+            jumped = true;
+            frameOffset = (uint64_t)(0.1 * trueRate); // The host clock ran on 100 ms without frames
+            settleUntil = i + AudioClockCorrelator::MAX_REJECTS + AudioClockCorrelator::MIN_SAMPLES;
+        }
+        double hostNs = trueNs + (jumped ? 0.1e9 : 0.0);
+        frame -= jumped ? frameOffset : 0;
+
+        double stamp = hostNs + jitter(rng);
+        if (unit(rng) < trace.outlierRate)
+            stamp += 1e6 + 4e6 * unit(rng);
+        clock.Add(frame, TimePoint(Clock::duration(hostStart + (int64_t)stamp)));
+
+        // When does the frame two periods ahead reach the DAC?
+        uint64_t target = frame + 2 * period;
+        double truthNs = hostStart + hostNs + 2.0 * period / trueRate * 1e9;
+        TimePoint predicted;
+        double errorNs = 0.0;
+        if (i < settleUntil || !clock.Fit().FrameTime(target, predicted, errorNs))
+            continue;
+        double err = predicted.time_since_epoch().count() - truthNs;
+        double nominalNs = hostStart + (target + (jumped ? frameOffset : 0)) * 1e9 / nominal;
+        double nominalErr = nominalNs + (jumped ? 0.1e9 : 0.0) - truthNs;
+        sumSq += err * err;
+        nominalSq += nominalErr * nominalErr;
+        result.maxUs = std::max(result.maxUs, std::fabs(err) / 1000.0);
+        covered += std::fabs(err) <= 3.0 * errorNs + 1000.0 ? 1 : 0; // 1 us timestamp rounding
+        predictions++;
+    }
+    result.rmsUs = predictions ? std::sqrt(sumSq / predictions) / 1000.0 : 0.0;
+    result.nominalRmsUs = predictions ? std::sqrt(nominalSq / predictions) / 1000.0 : 0.0;
+    result.coverage = predictions ? (double)covered / predictions : 0.0;
+    result.driftPpm = clock.Fit().DriftPpm(nominal);
+    result.rejected = clock.Rejected();
+    result.restarts = clock.Restarts();
+    return result;
+}
+
+int main()
+{
+    const double seconds = 60.0;
+    const ClockTrace traces[] = {
+        {"exact clock", 0.0, 0.0, 0.0, 0.0},
+        {"+80 ppm, 20 us jitter", 80.0, 20.0, 0.0, 0.0},
+        {"-35 ppm, 100 us jitter", -35.0, 100.0, 0.0, 0.0},
+        {"+50 ppm, 20 us, 3% late", 50.0, 20.0, 0.03, 0.0},
+        {"+50 ppm, 20 us, jump", 50.0, 20.0, 0.0, 30.0},
+    };
+
+    bool ok = true;
+    for (const ClockTrace &trace : traces)
+    {
+        TraceResult r = RunTrace(trace, seconds);
+        // Fit error well under the jitter; drift found to within the slope noise of a 2.56 s
+        // window (~1.7 ppm per 20 us of jitter); reported error covers the actual one
+        double limitUs = 1.0 + 0.5 * trace.jitterUs;
+        bool pass = r.rmsUs <= limitUs && std::fabs(r.driftPpm - trace.driftPpm) <= 1.0 + 0.25 * trace.jitterUs &&
+                    r.coverage >= 0.95;
+        if (trace.outlierRate > 0.0)
+            pass = pass && r.rejected >= (uint64_t)(0.02 * seconds * 100) && r.restarts == 0;
+        else if (trace.jumpAtSec > 0.0)
+            pass = pass && r.restarts == 1;
+        else
+            pass = pass && r.rejected == 0 && r.restarts == 0;
+        printf("%-26s fit rms %7.2f us (max %7.2f), nominal-rate rms %9.2f us, drift %+7.2f ppm, covered %5.1f%%, "
+               "%llu rejected, %llu restarts: %s\n",
+               trace.name, r.rmsUs, r.maxUs, r.nominalRmsUs, r.driftPpm, r.coverage * 100.0,
+               (unsigned long long)r.rejected, (unsigned long long)r.restarts, pass ? "ok" : "FAIL");
+        ok = ok && pass;
+    }
+
+    // Per-period cost on the audio thread (full window refit)
+    AudioClockCorrelator clock;
+    RunBenchmark("AudioClockCorrelator::Add (256 window)", 100000, [&](uint64_t i) {
+        clock.Add(i * 480, TimePoint(Clock::duration((int64_t)(i * 10000000))));
+    });
+    TimePoint at;
+    double errorNs = 0.0;
+    RunBenchmark("AudioClockFit::FrameTime", 1000000, [&](uint64_t i) {
+        clock.Fit().FrameTime(i, at, errorNs);
+        DoNotOptimize(at);
+    });
+    return ok ? 0 : 1;
+}
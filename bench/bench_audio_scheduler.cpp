@@ -0,0 +1,173 @@
+// Audio scheduler against a fake device clock: a simulated endpoint plays frames at the
+// sample rate while a jittery main loop tops its buffer up, and stimuli are armed at random
+// moments. Every rendered frame is captured and checked: each stimulus must sit exactly at
+// its recorded start frame with silence around it, and the onset delay after arming must
+// stay within the queued audio. Returns 1 if a check fails.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "core/audio_scheduler.h"
+
+// Endpoint that consumes frames at the sample rate on a virtual clock
+struct FakeDevice
+{
+    uint32_t sampleRate = 48000;
+    size_t bufferFrames = 480; // 10 ms
+    double nowSec = 0.0;
+    uint64_t played = 0;  // Frames the DAC has consumed
+    uint64_t written = 0; // Frames handed to the device
+    uint64_t underruns = 0;
+
+    void Advance(double seconds)
+    {
+        nowSec += seconds;
+        uint64_t target = (uint64_t)(nowSec * sampleRate);
+        if (target > written)
+        {
+            underruns++;
+            target = written; // Glitch: the device stalls on an empty buffer
+            nowSec = (double)written / sampleRate;
+        }
+        played = target;
+    }
+    size_t Padding() const { return (size_t)(written - played); }
+};
+
+static bool IsSilent(const float *frame, size_t channels)
+{
+    for (size_t ch = 0; ch < channels; ++ch)
+    {
+        if (frame[ch] != 0.0f)
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    AudioFormat format;
+    StimulusSpec spec;
+    spec.durationMs = 20.0f;
+    StimulusBuffer stimulus;
+    if (!stimulus.Prepare(spec, format))
+        return 1;
+    const size_t channels = format.channels;
+
+    AudioScheduler scheduler;
+    scheduler.Configure(&stimulus);
+    FakeDevice device;
+    const size_t targetFrames = 2 * 144; // Two 3 ms periods
+
+    std::mt19937 rng(20);
+    std::uniform_real_distribution<double> loop(50e-6, 1500e-6); // Main loop iteration
+    std::uniform_real_distribution<double> gap(0.03, 0.25);      // Time between stimuli
+    std::vector<float> captured;
+    std::vector<AudioStimulusStart> starts;
+    std::vector<double> onsetDelayMs;
+
+    auto pump = [&]() {
+        if (device.Padding() >= targetFrames)
+            return;
+        size_t frames = targetFrames - device.Padding();
+        captured.resize((size_t)(device.written + frames) * channels);
+        scheduler.Render(&captured[(size_t)device.written * channels], frames);
+        device.written += frames;
+    };
+
+    pump();
+    double nextArm = gap(rng);
+    uint32_t armed = 0;
+    uint64_t armPlayed = 0;
+    while (device.nowSec < 120.0)
+    {
+        device.Advance(loop(rng));
+        if (device.nowSec >= nextArm && !scheduler.Pending())
+        {
+            armed = scheduler.Arm();
+            armPlayed = device.played;
+            pump(); // As PlayBeepWASAPI does
+            AudioStimulusStart start;
+            if (scheduler.LastStart(start) && start.sequence == armed)
+            {
+                starts.push_back(start);
+                onsetDelayMs.push_back((double)(start.startFrame - armPlayed) * 1000.0 / format.sampleRate);
+            }
+            nextArm = device.nowSec + gap(rng);
+        }
+        pump();
+    }
+
+    // Every onset is exactly where the scheduler says, with silence before it
+    bool ok = !starts.empty() && scheduler.LateStarts() == 0;
+    const float *expected = (const float *)stimulus.Data();
+    for (size_t s = 0; s < starts.size() && ok; ++s)
+    {
+        uint64_t begin = starts[s].startFrame;
+        uint64_t end = s + 1 < starts.size() ? starts[s + 1].startFrame : device.written;
+        size_t length = (size_t)std::min<uint64_t>(stimulus.Frames(), end - begin);
+        ok = ok && begin >= 1 && IsSilent(&captured[(size_t)(begin - 1) * channels], channels);
+        ok = ok && memcmp(&captured[(size_t)begin * channels], expected, length * channels * sizeof(float)) == 0;
+        for (uint64_t f = begin + length; f < end && ok; ++f)
+            ok = IsSilent(&captured[(size_t)f * channels], channels);
+    }
+    std::sort(onsetDelayMs.begin(), onsetDelayMs.end());
+    double maxDelay = onsetDelayMs.empty() ? 0.0 : onsetDelayMs.back();
+    ok = ok && maxDelay <= targetFrames * 1000.0 / format.sampleRate;
+    printf("%zu stimuli over %.0f s (%llu underruns): arm -> DAC %.2f / %.2f / %.2f ms (min/median/max): %s\n",
+           starts.size(), device.nowSec, (unsigned long long)device.underruns, onsetDelayMs.front(),
+           onsetDelayMs[onsetDelayMs.size() / 2], maxDelay, ok ? "ok" : "FAIL");
+
+    // Explicit start frames land on the exact sample, across block boundaries
+    AudioScheduler exact;
+    exact.Configure(&stimulus);
+    std::vector<float> block(100 * channels);
+    bool placed = true;
+    const uint64_t targets[] = {37, 200, 299, 300, 1234};
+    for (uint64_t target : targets)
+    {
+        uint64_t begin = exact.WriteFrame();
+        uint64_t want = target < begin ? begin + target : target; // Always ahead of the cursor
+        exact.Arm(want);
+        std::vector<float> stream;
+        while (exact.Pending() || exact.Playing())
+        {
+            exact.Render(block.data(), 100);
+            stream.insert(stream.end(), block.begin(), block.end());
+        }
+        size_t offset = (size_t)(want - begin);
+        AudioStimulusStart start;
+        placed = placed && exact.LastStart(start) && start.startFrame == want &&
+                 IsSilent(&stream[(offset - 1) * channels], channels) &&
+                 memcmp(&stream[offset * channels], expected, stimulus.Bytes()) == 0;
+    }
+
+    // A frame already rendered starts at once and counts as late
+    uint64_t past = exact.WriteFrame() - 10;
+    exact.Arm(past);
+    exact.Render(block.data(), 100);
+    AudioStimulusStart late;
+    placed = placed && exact.LastStart(late) && late.startFrame == past + 10 && exact.LateStarts() == 1 &&
+             memcmp(block.data(), expected, block.size() * sizeof(float)) == 0;
+
+    // Re-arming restarts the stimulus; Cancel silences it
+    exact.Arm();
+    exact.Render(block.data(), 100);
+    placed = placed && memcmp(block.data(), expected, block.size() * sizeof(float)) == 0;
+    exact.Cancel();
+    exact.Render(block.data(), 100);
+    placed = placed && IsSilent(block.data(), channels) && IsSilent(&block[99 * channels], channels);
+    printf("explicit start frames, late start, re-arm and cancel: %s\n", placed ? "ok" : "FAIL");
+
+    // Per-block cost in the steady state (silence and stimulus blocks)
+    std::vector<float> out(288 * channels);
+    RunBenchmark("AudioScheduler::Render (288 frames)", 200000, [&](uint64_t i) {
+        if (i % 64 == 0)
+            scheduler.Arm();
+        scheduler.Render(out.data(), 288);
+        DoNotOptimize(out[0]);
+    });
+    return ok && placed ? 0 : 1;
+}
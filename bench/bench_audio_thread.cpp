@@ -0,0 +1,315 @@
+// Event-driven audio render thread against a simulated device: a device thread plays one
+// period every 3 ms and signals the period event, and AudioRenderThread refills the buffer
+// on each event while the main thread arms stimuli at random moments. Every frame the
+// thread hands over is captured and checked: each onset the thread reports must sit exactly
+// at its start frame, arms must reach the DAC within the queued audio, injected stalls must
+// show up as late fills and underruns, and a paused device as timeouts. Onsets must come
+// back timed from the device clock. Returns 1 if a check fails.
+//
+// Usage: bench_audio_thread [seconds]
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include "bench.h"
+#include "core/audio_thread.h"
+
+// Shared-mode style endpoint: a buffer of two periods, drained one period per event
+class SimulatedEndpoint : public AudioEndpoint
+{
+public:
+    SimulatedEndpoint(const AudioFormat &format, size_t periodFrames, size_t captureFrames)
+        : m_format(format), m_periodFrames(periodFrames), m_bufferFrames(2 * periodFrames),
+          m_capture(captureFrames * format.channels)
+    {
+    }
+
+    bool Enter() override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_played = 0;
+        m_written = 0;
+        m_starved = 0;
+        m_signaled = false;
+        m_woken = false;
+        return true;
+    }
+    bool Start() override
+    {
+        m_running.store(true);
+        m_device = std::thread([this] { DeviceLoop(); });
+        return true;
+    }
+    void Exit() override
+    {
+        m_running.store(false);
+        if (m_device.joinable())
+            m_device.join();
+    }
+    void Wake() override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_woken = true;
+        m_cv.notify_one();
+    }
+
+    bool WaitPeriod(uint32_t timeoutMs) override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return m_signaled || m_woken; });
+        bool period = m_signaled && !m_woken;
+        m_signaled = false;
+        m_woken = false;
+        return period;
+    }
+    size_t Writable() override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bufferFrames - (size_t)(m_written - m_played);
+    }
+    void *Acquire(size_t frames) override
+    {
+        if (m_stalls.load() > 0)
+        {
+            m_stalls.fetch_sub(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Over three periods
+        }
+        if ((m_written + frames) * m_format.channels > m_capture.size())
+            return nullptr;
+        return &m_capture[(size_t)m_written * m_format.channels];
+    }
+    void Release(size_t frames) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_written += frames;
+    }
+    bool PlayedFrames(uint64_t &frames, TimePoint &at) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        frames = m_played;
+        at = m_playedAt;
+        return true;
+    }
+
+    // Test controls (main thread)
+    void Stall(int periods) { m_stalls.store(periods); }
+    void Pause(bool paused) { m_paused.store(paused); }
+    uint64_t Played()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_played;
+    }
+    uint64_t Starved()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_starved;
+    }
+    const float *Capture() const { return m_capture.data(); } // After the thread stopped
+    uint64_t Written() const { return m_written; }
+    size_t BufferFrames() const { return m_bufferFrames; }
+
+private:
+    // Plays one period per tick; a buffer short of a period starves the DAC
+    void DeviceLoop()
+    {
+        const auto period = std::chrono::microseconds(1000000 * m_periodFrames / m_format.sampleRate);
+        auto next = std::chrono::steady_clock::now() + period;
+        while (m_running.load())
+        {
+            std::this_thread::sleep_until(next);
+            next += period;
+            if (m_paused.load())
+                continue;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            uint64_t queued = m_written - m_played;
+            if (queued < m_periodFrames)
+                m_starved++;
+            m_played += std::min<uint64_t>(queued, m_periodFrames);
+            m_playedAt = Clock::now();
+            m_signaled = true;
+            m_cv.notify_one();
+        }
+    }
+
+    AudioFormat m_format;
+    size_t m_periodFrames;
+    size_t m_bufferFrames;
+    std::vector<float> m_capture;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_signaled = false;
+    bool m_woken = false;
+    uint64_t m_played = 0;
+    TimePoint m_playedAt; // Device tick that reached m_played
+    uint64_t m_written = 0;
+    uint64_t m_starved = 0; // Ground truth: device ticks with less than a period queued
+
+    std::thread m_device;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_paused{false};
+    std::atomic<int> m_stalls{0};
+};
+
+static bool IsSilent(const float *frame, size_t channels)
+{
+    for (size_t ch = 0; ch < channels; ++ch)
+    {
+        if (frame[ch] != 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// Every reported onset holds the stimulus at exactly its start frame, with silence before
+static bool CheckOnsets(const SimulatedEndpoint &device, const StimulusBuffer &stimulus,
+                        const std::vector<AudioStimulusStart> &starts)
+{
+    const size_t channels = stimulus.Format().channels;
+    const float *capture = device.Capture();
+    for (size_t s = 0; s < starts.size(); ++s)
+    {
+        uint64_t begin = starts[s].startFrame;
+        uint64_t end = s + 1 < starts.size() ? starts[s + 1].startFrame : device.Written();
+        size_t length = (size_t)std::min<uint64_t>(stimulus.Frames(), end - begin);
+        if (begin == 0 || !IsSilent(&capture[(size_t)(begin - 1) * channels], channels))
+            return false;
+        if (memcmp(&capture[(size_t)begin * channels], stimulus.Data(), length * channels * sizeof(float)) != 0)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    if (seconds <= 0.0)
+        seconds = 3.0;
+
+    AudioFormat format;
+    StimulusSpec spec;
+    spec.durationMs = 20.0f;
+    StimulusBuffer stimulus;
+    if (!stimulus.Prepare(spec, format))
+        return 1;
+
+    const size_t periodFrames = 144; // 3 ms
+    const Clock::duration period = std::chrono::microseconds(3000);
+    SimulatedEndpoint device(format, periodFrames, (size_t)((seconds + 2.0) * format.sampleRate));
+    AudioRenderThread audio;
+    ThreadPolicy policy;
+    policy.priority = ThreadPriority::Realtime;
+    if (!audio.Start(device, stimulus, period, policy))
+    {
+        printf("audio thread failed to start\n");
+        return 1;
+    }
+    char applied[128];
+    FormatThreadPolicy(ThreadRole::Audio, policy, audio.Applied(), applied, sizeof(applied));
+    printf("%s\n", applied);
+
+    // Stimuli at random moments; each must reach the DAC within the queued audio
+    std::mt19937 rng(21);
+    std::uniform_int_distribution<int> gapMs(30, 120);
+    std::vector<AudioStimulusStart> starts;
+    std::vector<double> onsetMs;
+    AudioOnset polled[AudioRenderThread::ONSET_CAPACITY];
+    uint32_t armed = 0;
+    bool ordered = true;
+    size_t timed = 0;
+    double dacErrorUs = 0.0;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(gapMs(rng)));
+        uint64_t playedAtArm = device.Played();
+        uint32_t sequence = audio.Arm();
+        if (sequence == 0)
+            continue;
+        armed = sequence;
+        // Wait for the onset the way the reaction loop would, by polling once per frame
+        for (int wait = 0; wait < 200; ++wait)
+        {
+            size_t count = audio.PollOnsets(polled, AudioRenderThread::ONSET_CAPACITY);
+            for (size_t i = 0; i < count; ++i)
+            {
+                ordered = ordered && (starts.empty() || polled[i].start.sequence > starts.back().sequence);
+                starts.push_back(polled[i].start);
+                timed += polled[i].timed ? 1 : 0;
+                dacErrorUs = std::max(dacErrorUs, polled[i].errorUs);
+            }
+            if (!starts.empty() && starts.back().sequence == sequence)
+                break;
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        if (!starts.empty() && starts.back().sequence == sequence)
+            onsetMs.push_back((double)(starts.back().startFrame - playedAtArm) * 1000.0 / format.sampleRate);
+    }
+    AudioThreadStats clean = audio.Stats();
+    uint64_t cleanStarved = device.Starved();
+
+    // Explicit start frame, well ahead of the write cursor
+    uint64_t wantFrame = device.Played() + 20 * periodFrames;
+    uint32_t exactSequence = audio.Arm(wantFrame);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    size_t count = audio.PollOnsets(polled, AudioRenderThread::ONSET_CAPACITY);
+    bool exact = count == 1 && polled[0].start.sequence == exactSequence && polled[0].start.startFrame == wantFrame;
+    for (size_t i = 0; i < count; ++i)
+        starts.push_back(polled[i].start);
+
+    // Stalls inside the fill must be counted as late fills and underruns
+    const int injected = 3;
+    for (int i = 0; i < injected; ++i)
+    {
+        device.Stall(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    // A device that stops signalling is reported as timeouts, and the thread recovers
+    device.Pause(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    device.Pause(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    AudioThreadStats stressed = audio.Stats();
+    audio.Stop();
+    AudioThreadStats final = audio.Stats();
+
+    std::sort(onsetMs.begin(), onsetMs.end());
+    const double queuedMs = (double)(device.BufferFrames() + periodFrames) * 1000.0 / format.sampleRate;
+    bool onsets = ordered && starts.size() == armed + 1 && !onsetMs.empty() && onsetMs.back() <= queuedMs &&
+                  CheckOnsets(device, stimulus, starts);
+    printf("%zu stimuli over %.1f s: arm -> DAC %.2f / %.2f / %.2f ms (min/median/max, limit %.1f): %s\n",
+           starts.size(), seconds, onsetMs.empty() ? 0.0 : onsetMs.front(),
+           onsetMs.empty() ? 0.0 : onsetMs[onsetMs.size() / 2], onsetMs.empty() ? 0.0 : onsetMs.back(), queuedMs,
+           onsets ? "ok" : "FAIL");
+    printf("clean run: %llu periods, %llu underruns (device starved %llu), %llu late fills, fill p50 %.1f / p99 %.1f /"
+           " max %.1f us, command p99 %.1f us\n",
+           (unsigned long long)clean.periods, (unsigned long long)clean.underruns, (unsigned long long)cleanStarved,
+           (unsigned long long)clean.lateFills, clean.fillP50Us, clean.fillP99Us, clean.fillMaxUs, clean.commandP99Us);
+    printf("explicit start frame %llu: %s\n", (unsigned long long)wantFrame, exact ? "ok" : "FAIL");
+    // An underrun restarts the clock fit, which leaves at most the next onset untimed
+    bool clock = timed + clean.clockRestarts >= armed && clean.clockRestarts <= clean.underruns;
+    printf("device clock: %zu of %u onsets timed at the DAC (error <= %.1f us), drift %.1f ppm, residual %.1f us: %s\n",
+           timed, armed, dacErrorUs, clean.clockDriftPpm, clean.clockResidualUs, clock ? "ok" : "FAIL");
+
+    bool stalls = stressed.lateFills - clean.lateFills >= (uint64_t)injected && stressed.underruns > clean.underruns;
+    printf("%d injected 10 ms stalls: %llu late fills, %llu underruns: %s\n", injected,
+           (unsigned long long)(stressed.lateFills - clean.lateFills),
+           (unsigned long long)(stressed.underruns - clean.underruns), stalls ? "ok" : "FAIL");
+    bool timeouts = stressed.timeouts > 0 && stressed.periods > clean.periods;
+    printf("paused device: %llu timeouts: %s\n", (unsigned long long)stressed.timeouts, timeouts ? "ok" : "FAIL");
+
+    // Restart on the same endpoint starts a fresh stream
+    bool restart = final.periods >= stressed.periods && audio.Start(device, stimulus, period, ThreadPolicy());
+    uint32_t sequence = restart ? audio.Arm() : 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    restart = restart && audio.PollOnsets(polled, 1) == 1 && polled[0].start.sequence == sequence;
+    audio.Stop();
+    restart = restart && audio.Stats().periods > 0 && audio.Stats().timeouts == 0;
+    printf("stop / restart: %s\n", restart ? "ok" : "FAIL");
+
+    return onsets && exact && clock && stalls && timeouts && restart ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+// Acoustic click pairing against a synthetic microphone capture: ten minutes of room
+// noise and mains hum with two mice clicking next to the microphone (a 1000 Hz mouse and a
+// 125 Hz one), each press a short decaying burst followed by a quieter release click, a few
+// presses without a sound, and stray taps with no press. Button-down events arrive a known
+// switch -> WM_INPUT latency after each press sound. The capture goes through a WAV file,
+// EmphasizeTransients and the click detector, and MatchClickOnsets must pair every
+// sounding press with its own click and recover each device's latency distribution.
+// Returns 1 if a check fails.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "core/audio_stimulus.h"
+#include "core/onset_detector.h"
+#include "core/reaction_stats.h"
+#include "core/wav_file.h"
+
+struct Mouse
+{
+    const char *name;
+    double baseMs;   // Debounce and firmware
+    double pollMs;   // Uniform polling delay on top
+    double silent;   // Fraction of presses the microphone does not hear
+};
+
+int main()
+{
+    const uint32_t rate = 48000;
+    const double seconds = 600.0;
+    const double trueRate = rate * (1.0 + 30e-6); // Capture clock drift
+    const int64_t hostStart = 3000000000ll;
+    const size_t frames = (size_t)(seconds * rate);
+    const Mouse mice[] = {{"1000 Hz mouse", 0.6, 1.0, 0.03}, {"125 Hz mouse", 2.0, 8.0, 0.03}};
+
+    std::mt19937 rng(25);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> jitterNs(0.0, 20000.0);
+
+    // Room: -50 dB noise and -30 dB mains hum
+    std::vector<float> signal(frames);
+    SynthesizeNoise(signal.data(), frames, 3, 0.0055f);
+    std::vector<float> hum(frames);
+    SynthesizeTone(hum.data(), frames, 50.0, rate, 0.03f);
+    for (size_t i = 0; i < frames; ++i)
+        signal[i] += hum[i];
+
+    // A click: 4 ms of noise decaying with a 1 ms time constant
+    const size_t clickFrames = rate * 4 / 1000;
+    std::vector<float> click(clickFrames);
+    SynthesizeNoise(click.data(), clickFrames, 11, 1.0f);
+    auto addClick = [&](uint64_t frame, float level) {
+        for (size_t i = 0; i < clickFrames && frame + i < frames; ++i)
+            signal[frame + i] += click[i] * level * std::exp(-(float)i * 1000.0f / rate);
+    };
+    auto hostNs = [&](double frame) { return hostStart + frame / trueRate * 1e9; };
+
+    std::vector<ClickPress> presses;
+    std::map<int64_t, double> truth; // Arrival ns -> latency, for sounding presses
+    size_t sounding[2] = {};
+    size_t strays = 0;
+    for (uint64_t frame = rate / 2; frame + rate / 4 < frames; frame += (uint64_t)(rate * (0.3 + 0.5 * unit(rng))))
+    {
+        uint16_t device = (uint16_t)(unit(rng) < 0.5 ? 0 : 1);
+        const Mouse &mouse = mice[device];
+        bool heard = unit(rng) >= mouse.silent;
+        if (heard)
+        {
+            addClick(frame, 0.1f + 0.1f * (float)unit(rng));
+            addClick(frame + (uint64_t)(rate * (0.06 + 0.09 * unit(rng))), 0.05f); // Release
+            sounding[device]++;
+        }
+        double latencyMs = mouse.baseMs + mouse.pollMs * unit(rng);
+        int64_t arrival = (int64_t)(hostNs((double)frame) + latencyMs * 1e6);
+        presses.push_back({device, TimePoint(Clock::duration(arrival))});
+        if (heard)
+            truth[arrival] = latencyMs;
+
+        // Now and then a tap on the desk between presses, with no press after it
+        if (unit(rng) < 0.05)
+        {
+            addClick(frame + rate / 5, 0.08f);
+            strays++;
+        }
+    }
+
+    // Mono int16 capture with a sync pair every 10 ms
+    const char *path = "bench_click_pairing.wav";
+    AudioFormat format;
+    format.sampleRate = rate;
+    format.channels = 1;
+    format.sample = SampleFormat::Int16;
+    WavWriter writer;
+    bool ok = writer.Open(path, format);
+    std::vector<int16_t> packet(480);
+    for (size_t frame = 0; ok && frame < frames; frame += 480)
+    {
+        size_t count = std::min<size_t>(480, frames - frame);
+        InterleaveSamples(signal.data() + frame, count, format, packet.data());
+        ok = writer.Write(packet.data(), count);
+        writer.AddSync(frame, TimePoint(Clock::duration((int64_t)(hostNs((double)frame) + jitterNs(rng)))));
+    }
+    ok = ok && writer.Close();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    WavData wav;
+    std::vector<DetectedOnset> onsets;
+    std::vector<ClickMatch> matches;
+    ok = ok && ReadWav(path, wav);
+    if (ok)
+    {
+        EmphasizeTransients(wav.mono.data(), wav.mono.size());
+        OnsetDetector detector(rate, ClickDetectorConfig());
+        detector.Process(wav.mono.data(), wav.mono.size(), onsets);
+        ok = MatchClickOnsets(onsets, wav.sync, presses, 50.0, matches);
+    }
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    remove(path);
+
+    // Every match must be a sounding press paired with its own click
+    ReactionStats measured[2];
+    ReactionStats expected[2];
+    size_t wrong = 0;
+    double maxErrorMs = 0.0;
+    for (const ClickMatch &match : matches)
+    {
+        int64_t arrival = (match.sound + std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<double, std::milli>(match.latencyMs)))
+                              .time_since_epoch()
+                              .count();
+        auto it = truth.lower_bound(arrival - 1000);
+        if (it == truth.end() || it->first > arrival + 1000)
+        {
+            wrong++;
+            continue;
+        }
+        maxErrorMs = std::max(maxErrorMs, std::fabs(match.latencyMs - it->second));
+        measured[match.deviceId].Add((float)match.latencyMs);
+        expected[match.deviceId].Add((float)it->second);
+    }
+
+    printf("%zu presses (%zu + %zu heard), %zu stray taps, %zu onsets, %zu matched, %zu wrong, max latency err "
+           "%.3f ms\n",
+           presses.size(), sounding[0], sounding[1], strays, onsets.size(), matches.size(), wrong, maxErrorMs);
+    ok = ok && wrong == 0 && maxErrorMs <= 0.25;
+    for (uint16_t device = 0; device < 2; ++device)
+    {
+        const ReactionStats &m = measured[device];
+        bool pass = m.Count() == sounding[device] &&
+                    std::fabs(m.Median() - expected[device].Median()) <= 0.15;
+        printf("  %-14s n=%zu  click -> WM_INPUT median %.2f ms (true %.2f), p5 %.2f, p95 %.2f: %s\n",
+               mice[device].name, m.Count(), m.Median(), expected[device].Median(), m.Percentile(5.0),
+               m.Percentile(95.0), pass ? "ok" : "FAIL");
+        ok = ok && pass;
+    }
+    printf("read, filtered, detected and paired %.0f s in %.3f s wall (%.0fx real time)\n", seconds, wallSec,
+           wallSec > 0.0 ? seconds / wallSec : 0.0);
+    ok = ok && seconds >= 50.0 * wallSec;
+
+    std::vector<float> block(480);
+    SynthesizeNoise(block.data(), block.size(), 9, 0.01f);
+    RunBenchmark("EmphasizeTransients (480 samples)", 1000000, [&](uint64_t) {
+        EmphasizeTransients(block.data(), block.size());
+        DoNotOptimize(block[0]);
+    });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+// Hot-path costs of the portable core: input classification, flash update, reaction update
+
+#include "bench.h"
+#include "core/latency_tester.h"
+#include "core/reaction_tester.h"
+
+int main()
+{
+    constexpr uint64_t N = 2000000;
+    TimePoint t0{};
+
+    InputEvent move;
+    move.type = InputType::Mouse;
+    move.dx = 3;
+    move.dy = -1;
+
+    InputFilter filter;
+    RunBenchmark("ClassifyInput(move)", N, [&](uint64_t i) {
+        move.dx = (int32_t)(i & 7) + 1;
+        InputAction action = ClassifyInput(move, filter);
+        DoNotOptimize(action);
+    });
+
+    FlashState flash;
+    RunBenchmark("FlashState::Update", N, [&](uint64_t i) {
+        TimePoint now = t0 + std::chrono::microseconds(i * 100);
+        if ((i & 1023) == 0)
+            flash.Trigger(now);
+        bool flashing = flash.Update(now);
+        DoNotOptimize(flashing);
+    });
+
+    LatencyTester tester;
+    RunBenchmark("LatencyTester::OnInput(move)", N, [&](uint64_t i) {
+        move.time = t0 + std::chrono::microseconds(i * 125);
+        InputAction action = tester.OnInput(move, L"BENCH", nullptr);
+        DoNotOptimize(action);
+    });
+
+    ReactionTester reaction(42);
+    reaction.StartNewRound(t0);
+    RunBenchmark("ReactionTester::Update", N, [&](uint64_t i) {
+        ReactionEvent ev = reaction.Update(t0 + std::chrono::microseconds(i * 100));
+        DoNotOptimize(ev);
+    });
+
+    return 0;
+}
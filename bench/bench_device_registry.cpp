@@ -0,0 +1,86 @@
+// Device registry hit path vs. resolving and parsing the device name on every event, and
+// a long session of devices reconnecting under new handles: every reconnect must keep its
+// id and the table must never run out. Returns 1 if it does.
+
+#include "bench.h"
+#include "core/device_registry.h"
+#include "headless/fake_device_enumerator.h"
+
+int main()
+{
+    constexpr uint64_t N = 4000000;
+
+    FakeDeviceEnumerator enumerator;
+    const uint64_t handles[4] = {0x10047, 0x2003b, 0x7001f, 0x1a0055};
+    enumerator.AddDevice(handles[0], L"\\\\?\\HID#VID_046D&PID_C539&MI_01&Col01#8&1e5e2f2&0&0000#{378de44c-56ef-11d1-bc8c-00a0c91405dd}");
+    enumerator.AddDevice(handles[1], L"\\\\?\\HID#VID_1532&PID_00B7&MI_00#7&3a1c6c4b&0&0000#{378de44c-56ef-11d1-bc8c-00a0c91405dd}");
+    enumerator.AddDevice(handles[2], L"\\\\?\\HID#VID_04D9&PID_A0F8&MI_00#7&14b2d0a&0&0000#{884b96c3-56ef-11d1-bc8c-00a0c91405dd}");
+    enumerator.AddDevice(handles[3], L"\\\\?\\HID#VID_3434&PID_0361&MI_00#7&2a9be3f&0&0000#{884b96c3-56ef-11d1-bc8c-00a0c91405dd}");
+
+    DeviceRegistry registry(enumerator);
+    for (uint64_t h : handles)
+        registry.OnArrival(h);
+    uint64_t queriesBefore = enumerator.QueryCount();
+
+    // Mouse-move stream from a single device (the 8 kHz case)
+    RunBenchmark("registry lookup (same device)", N, [&](uint64_t) {
+        uint16_t id = registry.Lookup(handles[0]);
+        DoNotOptimize(id);
+    });
+
+    // Two mice and two keyboards interleaved
+    RunBenchmark("registry lookup (4 devices interleaved)", N, [&](uint64_t i) {
+        uint16_t id = registry.Lookup(handles[i & 3]);
+        DoNotOptimize(id);
+    });
+
+    RunBenchmark("registry display name", N, [&](uint64_t i) {
+        const wchar_t *name = registry.DisplayName((uint16_t)((i & 3) + 1));
+        DoNotOptimize(name);
+    });
+
+    // Previous per-event path: query the name and parse it every time
+    RunBenchmark("resolve + parse per event", N / 10, [&](uint64_t i) {
+        std::wstring path;
+        enumerator.GetDeviceName(handles[i & 3], path);
+        std::wstring name = ParseDeviceDisplayName(path);
+        DoNotOptimize(name);
+    });
+
+    printf("registry: %zu devices, %llu enumerator queries from lookups\n", registry.Count(),
+           (unsigned long long)(enumerator.QueryCount() - queriesBefore - N / 10));
+
+    // A wireless mouse and a hub-cycled keyboard drop out and come back 1000 times each,
+    // with a fresh handle every time, while the other two stay connected
+    bool ok = true;
+    uint64_t next = 0x300000;
+    uint64_t current[2] = {handles[0], handles[2]};
+    const uint16_t ids[2] = {registry.Lookup(handles[0]), registry.Lookup(handles[2])};
+    std::wstring paths[2];
+    enumerator.GetDeviceName(handles[0], paths[0]);
+    enumerator.GetDeviceName(handles[2], paths[1]);
+    const size_t cycles = 1000;
+    for (size_t cycle = 0; cycle < cycles && ok; ++cycle)
+    {
+        for (size_t d = 0; d < 2; ++d)
+        {
+            registry.OnRemoval(current[d]);
+            enumerator.RemoveDevice(current[d]);
+            ok = ok && !registry.Info(ids[d])->connected;
+            current[d] = next += 0x40;
+            enumerator.AddDevice(current[d], paths[d]);
+            if (cycle & 1)
+                registry.OnArrival(current[d]);
+            ok = ok && registry.Lookup(current[d]) == ids[d] && registry.Info(ids[d])->connected &&
+                 registry.Info(ids[d])->handle == current[d];
+        }
+        ok = ok && registry.Lookup(handles[1]) == 2 && registry.Lookup(handles[3]) == 4;
+    }
+
+    // A new device still gets a fresh id afterwards
+    enumerator.AddDevice(0x900001, L"\\\\?\\HID#VID_046D&PID_C08B&MI_00#9&1b2c3d4&0&0000#{378de44c}");
+    ok = ok && registry.Lookup(0x900001) == 5 && registry.Count() == 5;
+    printf("%zu reconnect cycles of 2 devices: ids kept, %zu of %u entries used: %s\n", cycles, registry.Count(),
+           DeviceRegistry::MAX_DEVICES, ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
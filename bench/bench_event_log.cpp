@@ -0,0 +1,72 @@
+// Event log: binary ring append and lazy row formatting, against the previous
+// vector<wstring> insert-at-front log formatted on every event
+
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "core/event_log.h"
+
+class BenchNames : public LogNameSource
+{
+public:
+    const wchar_t *DeviceName(uint16_t) override { return L"VID_046D&PID_C547"; }
+    void KeyName(const InputEvent &, wchar_t *out, size_t outSize) override { swprintf(out, outSize, L"A"); }
+};
+
+int main()
+{
+    constexpr uint64_t N = 4000000; // Wraps the 1M ring several times
+    constexpr size_t VISIBLE_ROWS = 30;
+    TimePoint t0{};
+
+    InputEvent move;
+    move.type = InputType::Mouse;
+    move.dx = 3;
+    move.dy = -1;
+
+    EventLog log;
+    log.Reset(t0);
+    BenchNames names;
+    RunBenchmark("EventLog::Add", N, [&](uint64_t i) {
+        move.time = t0 + std::chrono::microseconds(i * 125);
+        log.Add(move, InputAction::Move);
+    });
+    printf("log holds %zu of %zu records (%.1f MB)\n", log.Count(), log.Capacity(),
+           log.Capacity() * sizeof(LogRecord) / (1024.0 * 1024.0));
+
+    // Burst frame (e.g. 8 kHz mouse at 125 fps): 64 events arrive, 30 rows are drawn
+    constexpr int EVENTS_PER_FRAME = 64;
+    RunBenchmark("64 events + draw 30 rows per frame", N / 64, [&](uint64_t) {
+        for (int e = 0; e < EVENTS_PER_FRAME; ++e)
+        {
+            move.time += std::chrono::microseconds(125);
+            log.Add(move, InputAction::Move);
+        }
+        for (size_t row = 0; row < VISIBLE_ROWS; ++row)
+            DoNotOptimize(log.Row(row, names));
+    });
+
+    log.ScrollBy(500000);
+    RunBenchmark("draw 30 rows, scrolled back (cached)", N / 64, [&](uint64_t) {
+        for (size_t row = 0; row < VISIBLE_ROWS; ++row)
+            DoNotOptimize(log.Row(row, names));
+    });
+
+    // Previous approach: every event formatted and inserted at the front
+    std::vector<std::wstring> entries;
+    RunBenchmark("64 events formatted + inserted (old)", N / 64, [&](uint64_t i) {
+        for (int e = 0; e < EVENTS_PER_FRAME; ++e)
+        {
+            wchar_t inputInfo[128];
+            DescribeInput(move, InputAction::Move, nullptr, inputInfo, 128);
+            wchar_t deviceInfo[256];
+            DescribeDevice(move, names.DeviceName(0), deviceInfo, 256);
+            wchar_t entry[256];
+            size_t len = FormatLogEntry(i * 8.0 + e * 0.125, 0.125, inputInfo, deviceInfo, entry, 256);
+            entries.insert(entries.begin(), std::wstring(entry, len));
+            if (entries.size() > 30)
+                entries.pop_back();
+        }
+    });
+    return 0;
+}
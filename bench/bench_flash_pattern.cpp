@@ -0,0 +1,84 @@
+// Flash pattern parsing limits, the sequencer's guard against trains that take no frame,
+// and the pattern's round trip through trace Control records (what a replay applies).
+// Returns 1 if a check fails.
+
+#include <cstdio>
+#include "bench.h"
+#include "core/flash_pattern.h"
+#include "core/trace_file.h"
+
+static bool SamePattern(const FlashPattern &a, const FlashPattern &b)
+{
+    if (a.stepCount != b.stepCount || a.repeat != b.repeat || a.minFrames != b.minFrames)
+        return false;
+    for (size_t i = 0; i < a.stepCount; ++i)
+    {
+        if (a.steps[i].duration != b.steps[i].duration || a.steps[i].unit != b.steps[i].unit ||
+            a.steps[i].level != b.steps[i].level)
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    FlashPattern pattern;
+    bool ok = ParseFlashPattern("2f@1,500us@0.25,16ms@0,min2,x10", pattern) && pattern.stepCount == 3 &&
+              pattern.steps[1].duration == 500 && pattern.steps[2].duration == 16000 && pattern.repeat == 10 &&
+              pattern.minFrames == 2;
+    FlashPattern clamped;
+    ok = ok && ParseFlashPattern("1f@5,1f@-1", clamped) && clamped.steps[0].level == 1.0f &&
+         clamped.steps[1].level == 0.0f;
+
+    // Zero-length steps without a frame minimum, 32-bit overflow, non-finite levels
+    const char *bad[] = {"0f,0us,min0,x4000000000", "1f,0us,min0", "4294967296us", "5000000ms", "1f,x4294967296",
+                         "1f,min4294967296", "1f@nan", "1f@inf", "x10", "1f,x0", "1f,x-1"};
+    for (const char *spec : bad)
+    {
+        FlashPattern unchanged = pattern;
+        bool rejected = !ParseFlashPattern(spec, unchanged) && SamePattern(unchanged, pattern);
+        if (!rejected)
+            printf("  accepted invalid pattern %s\n", spec);
+        ok = ok && rejected;
+    }
+    ok = ok && ParseFlashPattern("0f,1f,min1", clamped) && ParseFlashPattern("4294967295us", clamped);
+    printf("pattern parsing: %s\n", ok ? "ok" : "FAIL");
+
+    // Built in code rather than parsed: a train of empty steps ends on the first frame
+    FlashPattern empty;
+    empty.AddStep(0, FlashUnit::Frames, 1.0f);
+    empty.AddStep(0, FlashUnit::Microseconds, 1.0f);
+    empty.minFrames = 0;
+    empty.repeat = 4000000000u;
+    FlashSequencer sequencer;
+    sequencer.Start(empty, TimePoint{});
+    float level = sequencer.OnFrame(TimePoint{});
+    bool guardOk = level == 0.0f && !sequencer.Active();
+    printf("empty train ends on its first frame: %s\n", guardOk ? "ok" : "FAIL");
+
+    // Trace round trip, with a stray step record before it and a second pattern after it
+    TraceRecord records[2 * (FlashPattern::MAX_STEPS + 1) + 1];
+    size_t count = 0;
+    records[count] = MakeControlRecord(TimePoint{}, TraceControl::PatternStep);
+    records[count++].deviceId = 5;
+    count += MakeFlashPatternRecords(TimePoint{}, pattern, records + count);
+    count += MakeFlashPatternRecords(TimePoint{}, clamped, records + count);
+    FlashPattern read;
+    size_t completed = 0;
+    bool traceOk = true;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!ReadFlashPatternRecord(records[i], read))
+            continue;
+        traceOk = traceOk && SamePattern(read, completed == 0 ? pattern : clamped);
+        completed++;
+    }
+    traceOk = traceOk && completed == 2;
+    printf("pattern through trace records: %s\n", traceOk ? "ok" : "FAIL");
+
+    RunBenchmark("ParseFlashPattern", 1000000, [&](uint64_t) {
+        FlashPattern parsed;
+        DoNotOptimize(ParseFlashPattern("2f@1,500us@0.25,16ms@0,min2,x10", parsed));
+    });
+    return ok && guardOk && traceOk ? 0 : 1;
+}
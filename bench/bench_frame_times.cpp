@@ -0,0 +1,98 @@
+// Frame-time ring: cost per loop iteration and snapshot, memory for 10 minutes at
+// 10k fps, exact rebuild of every frame after wrapping, and percentile error
+// against a full sort. Returns 1 if a check fails.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "core/frame_times.h"
+
+// Quantized start times of the newest `count` frames must rebuild exactly
+static bool CheckRebuild(const FrameTimeRing &ring, const std::vector<int64_t> &starts)
+{
+    size_t first = starts.size() - 1 - ring.Count();
+    size_t i = first;
+    bool ok = true;
+    ring.ForEach([&](int64_t startNs, int64_t frameNs) {
+        int64_t start = starts[i] / FrameTimeRing::UNIT_NS * FrameTimeRing::UNIT_NS;
+        int64_t end = starts[i + 1] / FrameTimeRing::UNIT_NS * FrameTimeRing::UNIT_NS;
+        ok = ok && startNs == start && frameNs == end - start;
+        i++;
+    });
+    return ok && i == starts.size() - 1;
+}
+
+int main()
+{
+    constexpr uint64_t N = 8000000; // Wraps the 6M ring
+    std::mt19937 rng(11);
+    std::normal_distribution<double> jitter(0.0, 8000.0);
+    std::uniform_int_distribution<int> stall(0, 999);
+
+    // ~10k fps with jitter; one frame in 1000 stalls for 2-40 ms
+    std::vector<int64_t> starts;
+    starts.reserve(N + 1);
+    int64_t ns = 1000000000;
+    for (uint64_t i = 0; i <= N; ++i)
+    {
+        starts.push_back(ns);
+        int64_t frame = 100000 + (int64_t)jitter(rng);
+        if (stall(rng) == 0)
+            frame += 2000000 + (int64_t)(rng() % 38000000);
+        ns += frame > 1000 ? frame : 1000;
+    }
+
+    FrameTimeRing ring;
+    RunBenchmark("FrameTimeRing::Record", starts.size(), [&](uint64_t i) {
+        ring.Record(TimePoint(Clock::duration(starts[i])));
+    });
+    FrameTimeStats stats;
+    RunBenchmark("FrameTimeRing::Snapshot", 10000, [&](uint64_t) {
+        stats = ring.Snapshot();
+        DoNotOptimize(stats);
+    });
+    uint32_t bins[64];
+    RunBenchmark("FrameTimeRing::Bins (64)", 10000, [&](uint64_t) {
+        DoNotOptimize(ring.Bins(400000, bins, 64));
+    });
+
+    double mb = (ring.Capacity() * sizeof(uint16_t) +
+                 ring.Capacity() / FrameTimeRing::LONG_FRAME_RATIO * sizeof(int64_t)) / (1024.0 * 1024.0);
+    printf("ring holds %zu of %llu frames (%.1f MB)\n", ring.Count(), (unsigned long long)ring.Total(), mb);
+    printf("mean %.4f ms, p50/p99/p99.9 %.4f/%.4f/%.4f ms, max %.3f ms\n", stats.meanMs, stats.p50Ms, stats.p99Ms,
+           stats.p999Ms, stats.maxMs);
+
+    bool rebuilt = CheckRebuild(ring, starts);
+    printf("rebuild of %zu frames after wrapping: %s\n", ring.Count(), rebuilt ? "ok" : "FAIL");
+
+    // Exact percentiles of the ring contents
+    std::vector<int64_t> frames;
+    frames.reserve(ring.Count());
+    ring.ForEach([&](int64_t, int64_t frameNs) { frames.push_back(frameNs); });
+    std::sort(frames.begin(), frames.end());
+    auto exact = [&](double p) { return frames[(size_t)(p / 100.0 * (frames.size() - 1))] / 1e6; };
+    double worst = 0.0;
+    const double ps[] = {50.0, 99.0, 99.9};
+    const double got[] = {stats.p50Ms, stats.p99Ms, stats.p999Ms};
+    for (int i = 0; i < 3; ++i)
+    {
+        double error = std::abs(got[i] - exact(ps[i])) / exact(ps[i]);
+        worst = std::max(worst, error);
+    }
+    bool percentilesOk = worst <= 0.035;
+    printf("p50/p99/p99.9 exact %.4f/%.4f/%.4f ms, worst error %.2f%%: %s\n", exact(50.0), exact(99.0), exact(99.9),
+           worst * 100.0, percentilesOk ? "ok" : "FAIL");
+
+    // All-long frames (60 Hz): the side ring bounds the span, not the frame ring
+    FrameTimeRing small(1024);
+    std::vector<int64_t> slow;
+    for (int64_t i = 0; i <= 5000; ++i)
+        slow.push_back(i * 16666667 + (i % 7) * 1000);
+    for (int64_t t : slow)
+        small.Record(TimePoint(Clock::duration(t)));
+    bool slowOk = small.Count() == 1024 / FrameTimeRing::LONG_FRAME_RATIO && CheckRebuild(small, slow);
+    printf("60 Hz frames in a 1024-frame ring: %zu kept, rebuild %s\n", small.Count(), slowOk ? "ok" : "FAIL");
+
+    return rebuilt && percentilesOk && slowOk ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+// Input thread handoff under stress: a paced producer on ThreadedInputSource's thread
+// publishes sequence-numbered events at 8 kHz and 32 kHz while the consumer plays a
+// render loop whose Present sometimes blocks for 2-20 ms. Checks that every event
+// arrives once and in order (or is counted as dropped), and measures how late the
+// producer stamps events (should not track the consumer's stalls) and the handoff
+// latency from timestamp to Poll(). Returns 1 on a reordered or silently lost event.
+//
+// Usage: bench_input_thread [seconds per rate]
+
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include "bench.h"
+#include "core/histogram.h"
+#include "core/input_thread.h"
+
+struct StressResult
+{
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+    uint64_t outOfOrder = 0;
+    uint64_t frames = 0;
+    LogHistogram lateness; // ns the producer stamped after the event was due
+    LogHistogram handoff;  // ns from the timestamp to the consumer's Poll()
+};
+
+static bool RunStress(const char *name, uint64_t rateHz, double seconds)
+{
+    const uint64_t total = (uint64_t)(rateHz * seconds);
+    const Clock::duration period(1000000000 / (int64_t)rateHz);
+    StressResult result;
+
+    ThreadedInputSource source;
+    bool started = source.Start([&](ThreadedInputSource &input) {
+        input.Ready(true);
+        const TimePoint start = Clock::now();
+        uint64_t sequence = 0;
+        while (!input.StopRequested() && sequence < total)
+        {
+            TimePoint due = start + period * (int64_t)sequence;
+            TimePoint now = Clock::now();
+            if (now < due)
+            {
+                std::this_thread::sleep_for(due - now);
+                continue;
+            }
+            InputEvent ev;
+            ev.time = now;
+            ev.type = InputType::Mouse;
+            ev.dx = (int32_t)sequence;
+            ev.dy = (int32_t)(sequence >> 32);
+            result.lateness.Record((now - due).count());
+            input.Publish(ev);
+            sequence++;
+        }
+        result.sent = sequence;
+    });
+    if (!started)
+    {
+        printf("%s: input thread failed to start\n", name);
+        return false;
+    }
+
+    // Render loop: ~100 us frames, one in 20 blocks for 2 ms and one in 200 for 20 ms
+    std::mt19937 rng(3);
+    static InputEvent batch[InputSource::MAX_POLL_EVENTS];
+    uint64_t expected = 0;
+    while (expected + result.dropped < total)
+    {
+        size_t count = source.Poll(batch, InputSource::MAX_POLL_EVENTS);
+        TimePoint polled = Clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint64_t sequence = (uint32_t)batch[i].dx | ((uint64_t)(uint32_t)batch[i].dy << 32);
+            if (sequence < expected)
+                result.outOfOrder++;
+            else
+                expected = sequence + 1;
+            result.handoff.Record((polled - batch[i].time).count());
+        }
+        result.received += count;
+        result.dropped = source.Dropped();
+        result.frames++;
+
+        uint32_t roll = rng() % 200;
+        std::this_thread::sleep_for(roll == 0 ? std::chrono::milliseconds(20)
+                                    : roll < 10 ? std::chrono::milliseconds(2)
+                                                : std::chrono::microseconds(100));
+    }
+    source.Stop();
+
+    bool ok = result.outOfOrder == 0 && result.received + result.dropped == result.sent;
+    printf("%s: %llu sent, %llu received, %llu dropped, %llu out of order over %llu frames: %s\n", name,
+           (unsigned long long)result.sent, (unsigned long long)result.received, (unsigned long long)result.dropped,
+           (unsigned long long)result.outOfOrder, (unsigned long long)result.frames, ok ? "ok" : "FAIL");
+    printf("  stamp lateness p50/p99/max %.1f/%.1f/%.1f us\n", result.lateness.Percentile(50.0) / 1000.0,
+           result.lateness.Percentile(99.0) / 1000.0, result.lateness.Max() / 1000.0);
+    printf("  handoff        p50/p99/max %.1f/%.1f/%.1f us\n", result.handoff.Percentile(50.0) / 1000.0,
+           result.handoff.Percentile(99.0) / 1000.0, result.handoff.Max() / 1000.0);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+
+    // Start/stop cycles: the body must see the stop and the source must be reusable
+    ThreadedInputSource source;
+    bool cyclesOk = true;
+    for (int i = 0; i < 100 && cyclesOk; ++i)
+    {
+        cyclesOk = source.Start([](ThreadedInputSource &input) {
+            input.Ready(true);
+            while (!input.StopRequested())
+                std::this_thread::yield();
+        });
+        source.Stop();
+    }
+    bool failOk = !source.Start([](ThreadedInputSource &input) { input.Ready(false); });
+    printf("100 start/stop cycles: %s, failed start reported: %s\n", cyclesOk ? "ok" : "FAIL",
+           failOk ? "ok" : "FAIL");
+
+    bool ok8 = RunStress("8 kHz", 8000, seconds);
+    bool ok32 = RunStress("32 kHz", 32000, seconds);
+    return cyclesOk && failOk && ok8 && ok32 ? 0 : 1;
+}
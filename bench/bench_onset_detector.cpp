@@ -0,0 +1,192 @@
+// Loopback latency analysis against synthetic captures: ten minutes of audio with a tone
+// (or click) every 1-2 s over digital silence or microphone-like noise, recorded by a
+// capture clock running off nominal, with stimulus triggers a known latency before each
+// sound. The capture goes through WavWriter/ReadWav, OnsetDetector finds the onsets and
+// MatchLoopbackOnsets recovers the trigger -> sound latencies. Checks onset placement,
+// false and missed onsets, the recovered latencies, and that the whole analysis runs far
+// faster than real time. Returns 1 if a check fails.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "core/audio_stimulus.h"
+#include "core/onset_detector.h"
+#include "core/reaction_stats.h"
+#include "core/wav_file.h"
+
+struct Capture
+{
+    const char *name;
+    StimulusShape shape;
+    float stimulusLevel;  // Peak amplitude at the capture
+    float noiseLevel;     // Uniform noise amplitude (0: digital silence)
+    double driftPpm;      // Capture clock against the host timebase
+    SampleFormat sample;  // WAV sample format
+    double maxErrorMs;    // Onset placement tolerance
+};
+
+struct CaptureResult
+{
+    size_t stimuli = 0;
+    size_t found = 0;
+    size_t falseOnsets = 0;
+    double maxErrorMs = 0.0;    // Detected vs true onset frame
+    double maxLatencyErrMs = 0.0; // Recovered vs true latency
+    size_t matched = 0;
+    double medianLatencyMs = 0.0;
+    double analysisSec = 0.0;
+    double seconds = 0.0;
+};
+
+static CaptureResult RunCapture(const Capture &capture, double seconds)
+{
+    const uint32_t rate = 48000;
+    const double trueRate = rate * (1.0 + capture.driftPpm * 1e-6);
+    const int64_t hostStart = 7000000000ll;
+    const size_t frames = (size_t)(seconds * rate);
+    std::mt19937 rng(24);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> jitterNs(0.0, 20000.0);
+
+    // Mono signal: noise floor plus stimuli at random spacing
+    std::vector<float> signal(frames, 0.0f);
+    if (capture.noiseLevel > 0.0f)
+        SynthesizeNoise(signal.data(), frames, 5, capture.noiseLevel);
+    const size_t stimulusFrames = capture.shape == StimulusShape::Click ? rate / 1000 : rate * 80 / 1000;
+    std::vector<float> stimulus(stimulusFrames, capture.stimulusLevel);
+    if (capture.shape == StimulusShape::Tone)
+        SynthesizeTone(stimulus.data(), stimulusFrames, 800.0, rate, capture.stimulusLevel);
+
+    std::vector<uint64_t> onsetFrames;
+    std::vector<LoopbackTrigger> triggers;
+    std::vector<double> latencies;
+    for (uint64_t frame = rate / 2; frame + stimulusFrames < frames; frame += (uint64_t)(rate * (1.0 + unit(rng))))
+    {
+        for (size_t i = 0; i < stimulusFrames; ++i)
+            signal[frame + i] += stimulus[i];
+        // The tone's first sample is sin(0) = 0; it is audible from the next one
+        onsetFrames.push_back(capture.shape == StimulusShape::Tone ? frame + 1 : frame);
+
+        double latencyMs = 10.0 + 4.0 * unit(rng);
+        double soundNs = hostStart + frame / trueRate * 1e9;
+        LoopbackTrigger trigger;
+        trigger.sequence = (uint32_t)triggers.size() + 1;
+        trigger.trigger = TimePoint(Clock::duration((int64_t)(soundNs - latencyMs * 1e6)));
+        trigger.dacEstimate = TimePoint(Clock::duration((int64_t)soundNs));
+        trigger.hasDacEstimate = true;
+        triggers.push_back(trigger);
+        latencies.push_back(latencyMs);
+    }
+
+    // Stereo capture in 10 ms packets, each with its position / host time pair
+    const char *path = "bench_onset_detector.wav";
+    AudioFormat format;
+    format.sampleRate = rate;
+    format.channels = 2;
+    format.sample = capture.sample;
+    WavWriter writer;
+    bool ok = writer.Open(path, format);
+    std::vector<uint8_t> packet(480 * format.FrameBytes());
+    for (size_t frame = 0; ok && frame < frames; frame += 480)
+    {
+        size_t count = std::min<size_t>(480, frames - frame);
+        InterleaveSamples(signal.data() + frame, count, format, packet.data());
+        ok = writer.Write(packet.data(), count);
+        double hostNs = hostStart + frame / trueRate * 1e9 + jitterNs(rng);
+        writer.AddSync(frame, TimePoint(Clock::duration((int64_t)hostNs)));
+    }
+    ok = ok && writer.Close();
+
+    CaptureResult result;
+    result.stimuli = onsetFrames.size();
+    result.seconds = seconds;
+    auto wallStart = std::chrono::steady_clock::now();
+    WavData wav;
+    std::vector<DetectedOnset> onsets;
+    std::vector<LoopbackMatch> matches;
+    ok = ok && ReadWav(path, wav) && wav.sampleRate == rate && wav.channels == 2 && wav.mono.size() == frames;
+    if (ok)
+    {
+        // Blocks of a capture packet, as a live capture would feed it
+        OnsetDetector detector(rate);
+        for (size_t i = 0; i < wav.mono.size(); i += 441)
+            detector.Process(wav.mono.data() + i, std::min<size_t>(441, wav.mono.size() - i), onsets);
+        ok = MatchLoopbackOnsets(onsets, wav.sync, triggers, 100.0, matches);
+    }
+    result.analysisSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    remove(path);
+    if (!ok)
+        return result;
+
+    // Pair detections with the true onsets (within 5 ms)
+    size_t next = 0;
+    for (const DetectedOnset &onset : onsets)
+    {
+        while (next < onsetFrames.size() && onsetFrames[next] + rate / 200 < onset.frame)
+            ++next;
+        double errorMs = next < onsetFrames.size() ? ((double)onset.frame - (double)onsetFrames[next]) * 1000.0 / rate
+                                                   : 1e9;
+        if (std::fabs(errorMs) > 5.0)
+        {
+            result.falseOnsets++;
+            continue;
+        }
+        result.found++;
+        result.maxErrorMs = std::max(result.maxErrorMs, std::fabs(errorMs));
+        ++next;
+    }
+
+    ReactionStats stats;
+    for (const LoopbackMatch &match : matches)
+    {
+        double truth = latencies[match.sequence - 1];
+        result.maxLatencyErrMs = std::max(result.maxLatencyErrMs, std::fabs(match.latencyMs - truth));
+        stats.Add((float)match.latencyMs);
+    }
+    result.matched = matches.size();
+    result.medianLatencyMs = stats.Empty() ? 0.0 : stats.Median();
+    return result;
+}
+
+int main()
+{
+    const double seconds = 600.0;
+    const Capture captures[] = {
+        {"loopback tone, float32", StimulusShape::Tone, 0.5f, 0.0f, 60.0, SampleFormat::Float32, 0.05},
+        {"loopback click, int16", StimulusShape::Click, 0.5f, 0.0f, -40.0, SampleFormat::Int16, 0.05},
+        {"microphone tone, -50 dB noise", StimulusShape::Tone, 0.1f, 0.0055f, 80.0, SampleFormat::Int16, 0.1},
+        {"noisy microphone, -40 dB noise", StimulusShape::Tone, 0.2f, 0.0173f, -25.0, SampleFormat::Float32, 0.25},
+    };
+
+    bool ok = true;
+    for (const Capture &capture : captures)
+    {
+        CaptureResult r = RunCapture(capture, seconds);
+        // Onsets within tolerance, every stimulus matched, latencies within the onset error
+        // plus the sync fit's (20 us pair jitter), and the file read and analysed at 50x
+        // real time at least (even unoptimized)
+        bool pass = r.stimuli > 0 && r.found == r.stimuli && r.falseOnsets == 0 &&
+                    r.maxErrorMs <= capture.maxErrorMs && r.matched == r.stimuli &&
+                    r.maxLatencyErrMs <= capture.maxErrorMs + 0.05 && r.seconds >= 50.0 * r.analysisSec;
+        printf("%-32s %zu stimuli, %zu found, %zu false, max onset err %.3f ms, %zu matched, median latency "
+               "%.2f ms (max err %.3f ms), analysed %.0fx real time: %s\n",
+               capture.name, r.stimuli, r.found, r.falseOnsets, r.maxErrorMs, r.matched, r.medianLatencyMs,
+               r.maxLatencyErrMs, r.analysisSec > 0.0 ? r.seconds / r.analysisSec : 0.0, pass ? "ok" : "FAIL");
+        ok = ok && pass;
+    }
+
+    // Detector alone, per 10 ms block of noise
+    std::vector<float> block(480);
+    SynthesizeNoise(block.data(), block.size(), 9, 0.01f);
+    OnsetDetector detector(48000);
+    std::vector<DetectedOnset> onsets;
+    double ns = RunBenchmark("OnsetDetector::Process (480 samples)", 200000, [&](uint64_t) {
+        detector.Process(block.data(), block.size(), onsets);
+        DoNotOptimize(onsets.size());
+    });
+    printf("detector alone: %.0fx real time\n", 10e6 / ns);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+// Polling-rate analyzer at 8 kHz with jitter and dropped reports,
+// against the previous vector + erase(begin()) one-second window
+
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "core/polling_rate.h"
+
+int main()
+{
+    constexpr uint64_t SECONDS = 30;
+    constexpr uint64_t RATE_HZ = 8000;
+    constexpr int64_t PERIOD_NS = 1000000000 / RATE_HZ;
+    constexpr uint64_t N = SECONDS * RATE_HZ;
+
+    // Synthetic 8 kHz stream: +-5 us jitter, one report in 500 dropped
+    std::mt19937 rng(7);
+    std::normal_distribution<double> jitter(0.0, 5000.0);
+    std::vector<TimePoint> times;
+    times.reserve(N);
+    uint64_t dropped = 0;
+    for (uint64_t i = 1; i <= N; ++i)
+    {
+        if (i % 500 == 0)
+        {
+            dropped++;
+            continue;
+        }
+        int64_t ns = (int64_t)i * PERIOD_NS + (int64_t)jitter(rng);
+        times.push_back(TimePoint{} + std::chrono::nanoseconds(ns));
+    }
+
+    PollingRateAnalyzer analyzer;
+    RunBenchmark("PollingRateAnalyzer::Record", times.size(), [&](uint64_t i) {
+        analyzer.Record(times[i]);
+    });
+
+    PollingRateStats stats;
+    RunBenchmark("PollingRateAnalyzer::Snapshot", 10000, [&](uint64_t) {
+        stats = analyzer.Snapshot(times.back());
+        DoNotOptimize(stats);
+    });
+
+    printf("rate %.0f Hz (instant %.0f), mean %.2f us, p1/p50/p99 %.1f/%.1f/%.1f us, jitter %.2f us\n",
+           stats.rateHz, stats.instantHz, stats.meanIntervalUs, stats.p1IntervalUs, stats.p50IntervalUs,
+           stats.p99IntervalUs, stats.jitterUs);
+    printf("reports %llu, dropped estimate %llu (actual %llu)\n", (unsigned long long)stats.reports,
+           (unsigned long long)stats.droppedEstimate, (unsigned long long)dropped);
+
+    // Previous approach: push_back per report, erase from the front once per 10k fps frame
+    std::vector<TimePoint> window;
+    size_t next = 0;
+    const uint64_t frames = SECONDS * 10000;
+    RunBenchmark("vector window, per frame (old)", frames, [&](uint64_t frame) {
+        TimePoint now = TimePoint{} + std::chrono::microseconds(frame * 100);
+        while (next < times.size() && times[next] <= now)
+            window.push_back(times[next++]);
+        while (!window.empty() && window.front() < now - std::chrono::seconds(1))
+            window.erase(window.begin());
+        float hz = (float)window.size();
+        DoNotOptimize(hz);
+    });
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Batched raw input decoding: a recorded 8 kHz mouse + keyboard session replayed
+// through RecordedInputSource one batch per simulated 10k fps loop iteration
+
+#include <cstdlib>
+#include "bench.h"
+#include "core/raw_input.h"
+#include "headless/fake_device_enumerator.h"
+#include "headless/recorded_input_source.h"
+
+int main(int argc, char **argv)
+{
+    constexpr uint64_t SECONDS = 10;
+    constexpr uint64_t MOUSE_HZ = 8000;
+    constexpr uint64_t LOOP_HZ = 10000;
+    constexpr uintptr_t MOUSE = 0x10047;
+    constexpr uintptr_t KEYBOARD = 0x2003b;
+
+    // Build the recording: each loop iteration drains whatever arrived since the last one
+    std::vector<RawBatch> batches;
+    uint64_t mouseReports = 0, keyReports = 0;
+    for (uint64_t loop = 0; loop < SECONDS * LOOP_HZ; ++loop)
+    {
+        RawBatch batch;
+        batch.time = TimePoint{} + std::chrono::microseconds(loop * (1000000 / LOOP_HZ));
+        while (mouseReports * LOOP_HZ < (loop + 1) * MOUSE_HZ)
+        {
+            uint16_t buttons = (mouseReports % 800 == 0) ? MOUSE_LEFT_DOWN : 0;
+            AppendRawMouse(batch.data, MOUSE, buttons, 0, (int32_t)(mouseReports & 0xFF), 1);
+            batch.count++;
+            mouseReports++;
+        }
+        if (loop % 2500 == 0)
+        {
+            AppendRawKeyboard(batch.data, KEYBOARD, 0x41, 0x1E, 0);
+            batch.count++;
+            keyReports++;
+        }
+        batches.push_back(std::move(batch));
+    }
+
+    // Optional round trip through a file: bench_raw_batch <path>
+    if (argc > 1)
+    {
+        std::vector<RawBatch> loaded;
+        if (!SaveRawBatches(argv[1], batches) || !LoadRawBatches(argv[1], loaded) || loaded.size() != batches.size())
+        {
+            fprintf(stderr, "failed to round-trip %s\n", argv[1]);
+            return 1;
+        }
+        batches.swap(loaded);
+    }
+
+    FakeDeviceEnumerator enumerator;
+    enumerator.AddDevice(MOUSE, L"\\\\?\\HID#VID_046D&PID_C539&MI_01#8&1e5e2f2&0&0000#{378de44c}");
+    enumerator.AddDevice(KEYBOARD, L"\\\\?\\HID#VID_04D9&PID_A0F8&MI_00#7&14b2d0a&0&0000#{884b96c3}");
+    DeviceRegistry devices(enumerator);
+
+    std::vector<InputEvent> out(InputSource::MAX_POLL_EVENTS);
+    uint64_t decoded = 0, clicks = 0, keys = 0, outOfOrder = 0;
+    int32_t expectedDx = 0;
+
+    RecordedInputSource source(batches, devices);
+    auto start = std::chrono::steady_clock::now();
+    while (!source.Finished())
+    {
+        size_t n = source.Poll(out.data(), out.size());
+        for (size_t i = 0; i < n; ++i)
+        {
+            const InputEvent &ev = out[i];
+            if (ev.type == InputType::Keyboard)
+            {
+                keys++;
+                continue;
+            }
+            if (ev.dx != expectedDx)
+                outOfOrder++;
+            expectedDx = (expectedDx + 1) & 0xFF;
+            if (ev.buttonFlags & MOUSE_LEFT_DOWN)
+                clicks++;
+        }
+        decoded += n;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-40s %12llu events %10.2f ns/event  (%zu batches)\n", "batch decode 8 kHz mouse + keyboard",
+           (unsigned long long)decoded, ns / (double)decoded, batches.size());
+
+    bool ok = decoded == mouseReports + keyReports && keys == keyReports && outOfOrder == 0 &&
+              devices.Count() == 2 && clicks == (mouseReports + 799) / 800;
+    printf("decoded %llu/%llu reports, %llu clicks, %llu out of order, %zu devices: %s\n",
+           (unsigned long long)decoded, (unsigned long long)(mouseReports + keyReports),
+           (unsigned long long)clicks, (unsigned long long)outOfOrder, devices.Count(), ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
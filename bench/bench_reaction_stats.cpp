@@ -0,0 +1,114 @@
+// Reaction statistics: cost per trial and per query with a large session, and every
+// statistic checked against a two-pass / full-sort reference on the same trials
+// (order statistics at the engine's 0.1 ms resolution). Returns 1 if a check fails.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "core/reaction_stats.h"
+
+static double Quantize(float ms)
+{
+    double bin = std::floor(ms / ReactionStats::BIN_MS + 0.5);
+    bin = std::min(std::max(bin, 0.0), (double)(ReactionStats::BINS - 1));
+    return bin * ReactionStats::BIN_MS;
+}
+
+static bool Near(double got, double want, double tolerance)
+{
+    return std::fabs(got - want) <= tolerance;
+}
+
+static bool Check(const ReactionStats &stats, const std::vector<float> &trials)
+{
+    size_t n = trials.size();
+    double mean = 0.0;
+    for (float t : trials)
+        mean += t;
+    mean /= (double)n;
+    double m2 = 0.0;
+    for (float t : trials)
+        m2 += (t - mean) * (t - mean);
+    double variance = n > 1 ? m2 / (double)(n - 1) : 0.0;
+
+    std::vector<double> sorted;
+    for (float t : trials)
+        sorted.push_back(Quantize(t));
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p) {
+        double h = (double)(n - 1) * p / 100.0;
+        size_t low = (size_t)h;
+        double value = sorted[low];
+        if (low + 1 < n)
+            value += (h - (double)low) * (sorted[low + 1] - value);
+        return value;
+    };
+
+    bool ok = Near(stats.Mean(), mean, 1e-6 * mean) && Near(stats.Variance(), variance, 1e-6 * variance + 1e-9) &&
+              stats.Best() == *std::min_element(trials.begin(), trials.end()) &&
+              stats.Worst() == *std::max_element(trials.begin(), trials.end()) && stats.Last() == trials.back();
+    const double ps[] = {0.0, 1.0, 10.0, 25.0, 50.0, 75.0, 90.0, 99.0, 99.9, 100.0};
+    for (double p : ps)
+        ok = ok && Near(stats.Percentile(p), percentile(p), 1e-9);
+
+    const double trims[] = {0.0, 5.0, 10.0, 25.0};
+    for (double trimPercent : trims)
+    {
+        size_t trim = (size_t)((double)n * trimPercent / 100.0);
+        double sum = 0.0;
+        for (size_t i = trim; i < n - trim; ++i)
+            sum += sorted[i];
+        ok = ok && Near(stats.TrimmedMean(trimPercent), sum / (double)(n - 2 * trim), 1e-6);
+    }
+
+    size_t shown = std::min(n, ReactionStats::DISPLAY_ENTRIES);
+    ok = ok && stats.RecentCount() == shown && stats.History().size() == n;
+    for (size_t i = 0; i < shown; ++i)
+        ok = ok && stats.Recent(i) == trials[n - 1 - i];
+    return ok;
+}
+
+int main()
+{
+    // Human-like trials (220 +- 30 ms) with 1% lapses of 0.5-12 s, past the last bin
+    std::mt19937 rng(17);
+    std::normal_distribution<float> reaction(220.0f, 30.0f);
+    std::uniform_real_distribution<float> lapse(500.0f, 12000.0f);
+    std::vector<float> trials;
+    for (size_t i = 0; i < 1000000; ++i)
+        trials.push_back(rng() % 100 == 0 ? lapse(rng) : std::max(reaction(rng), 90.0f));
+
+    bool ok = true;
+    ReactionStats stats;
+    const size_t checkpoints[] = {1, 2, 3, 24, 25, 26, 1000};
+    size_t next = 0;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        stats.Add(trials[i]);
+        if (i + 1 == checkpoints[next])
+        {
+            ok = ok && Check(stats, std::vector<float>(trials.begin(), trials.begin() + (ptrdiff_t)(i + 1)));
+            next++;
+        }
+    }
+    printf("small sessions (1-1000 trials): %s\n", ok ? "ok" : "FAIL");
+
+    stats.Clear();
+    ok = ok && stats.Empty() && stats.RecentCount() == 0 && stats.Percentile(50.0) == 0.0;
+    RunBenchmark("ReactionStats::Add", trials.size(), [&](uint64_t i) { stats.Add(trials[i]); });
+    double value = 0.0;
+    RunBenchmark("ReactionStats::Percentile", 100000, [&](uint64_t i) {
+        value += stats.Percentile((double)(i % 1000) / 10.0);
+    });
+    RunBenchmark("ReactionStats::TrimmedMean", 100000, [&](uint64_t i) {
+        value += stats.TrimmedMean((double)(i % 25));
+    });
+    DoNotOptimize(value);
+
+    bool large = Check(stats, trials);
+    printf("1M trials: mean %.2f sd %.2f median %.1f p99 %.1f trim10 %.2f: %s\n", stats.Mean(), stats.StdDev(),
+           stats.Median(), stats.Percentile(99.0), stats.TrimmedMean(10.0), large ? "ok" : "FAIL");
+    return ok && large ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Wake-up jitter of a periodic thread under CPU load, per scheduling policy
+// A cyclictest-style loop sleeps until every 500 us deadline and records how late it
+// woke, while one busy thread per CPU competes for the cores. Run once with the OS
+// defaults, once pinned, and once pinned at realtime priority (SCHED_FIFO / MMCSS
+// where the OS allows it) to see what ApplyThreadPolicy buys the input and audio
+// threads. Returns 1 if ParseSchedulerConfig misreads a known spec or a refusal goes
+// unreported.
+//
+// Usage: bench_sched_jitter [seconds per policy]
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "bench.h"
+#include "core/histogram.h"
+#include "core/thread_policy.h"
+#include "core/timing.h"
+
+static bool CheckParse()
+{
+    SchedulerConfig config = DefaultSchedulerConfig();
+    bool ok = ParseSchedulerConfig("render=2:high,input=3:rt,audio=1+4-5,process=high", config) &&
+              config[ThreadRole::Render].affinity == 0x4 &&
+              config[ThreadRole::Render].priority == ThreadPriority::High &&
+              config[ThreadRole::Input].affinity == 0x8 &&
+              config[ThreadRole::Input].priority == ThreadPriority::Realtime &&
+              config[ThreadRole::Audio].affinity == 0x32 &&
+              config[ThreadRole::Audio].priority == ThreadPriority::Normal && config.highPriorityClass;
+
+    // Unnamed roles keep their value; malformed specs leave the config untouched
+    SchedulerConfig partial = DefaultSchedulerConfig();
+    ok = ok && ParseSchedulerConfig("audio=*:realtime", partial) && partial[ThreadRole::Audio].affinity == 0 &&
+         partial[ThreadRole::Audio].priority == ThreadPriority::Realtime &&
+         partial[ThreadRole::Input].priority == ThreadPriority::Realtime;
+    const char *bad[] = {"gpu=1", "render=", "render=64", "render=3-1", "input=1:fast", "render=1;input=2"};
+    for (const char *spec : bad)
+    {
+        SchedulerConfig unchanged = DefaultSchedulerConfig();
+        ok = ok && !ParseSchedulerConfig(spec, unchanged) && unchanged[ThreadRole::Render].affinity == 0;
+    }
+    printf("scheduler spec parsing: %s\n", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// What the apps put on screen: only started roles count, and any refusal is named
+static bool CheckReport()
+{
+    SchedulerConfig config = DefaultSchedulerConfig();
+    ParseSchedulerConfig("render=2:high,input=3:rt", config);
+    SchedulerResult result;
+    ThreadPolicyResult accepted;
+    accepted.affinity = accepted.priority = true;
+    result.Set(ThreadRole::Render, accepted);
+    bool ok = !SchedulerRefused(config, result); // The input thread never started
+
+    ThreadPolicyResult refused = accepted;
+    refused.priority = false;
+    result.Set(ThreadRole::Input, refused);
+    char text[256];
+    size_t length = FormatSchedulerResult(config, result, text, sizeof(text));
+    ok = ok && SchedulerRefused(config, result) && length == strlen(text) && strstr(text, "render: cpus 2, high\n") &&
+         strstr(text, "input: cpus 3, realtime (refused)");
+
+    result.Set(ThreadRole::Input, accepted);
+    result.processPriority = false;
+    length = FormatSchedulerResult(config, result, text, sizeof(text));
+    ok = ok && SchedulerRefused(config, result) && strstr(text, "process: high priority class (refused)") &&
+         FormatSchedulerResult(config, result, text, 8) == 7;
+    printf("scheduler refusal report: %s\n", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static void RunJitter(const char *name, const ThreadPolicy &policy, double seconds)
+{
+    const Clock::duration period = std::chrono::microseconds(500);
+    const uint64_t wakes = (uint64_t)(seconds * 2000.0);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> load;
+    for (size_t i = 0; i < CpuCount(); ++i)
+    {
+        load.emplace_back([&stop] {
+            uint64_t spin = 0;
+            while (!stop.load(std::memory_order_relaxed))
+                DoNotOptimize(++spin);
+        });
+    }
+
+    LogHistogram lateness;
+    char applied[128];
+    std::thread timer([&] {
+        ThreadPolicyResult result = ApplyThreadPolicy(ThreadRole::Input, policy);
+        FormatThreadPolicy(ThreadRole::Input, policy, result, applied, sizeof(applied));
+
+        TimePoint due = Clock::now() + period;
+        for (uint64_t i = 0; i < wakes; ++i)
+        {
+            std::this_thread::sleep_until(due);
+            TimePoint now = Clock::now();
+            lateness.Record((now - due).count());
+            due += period;
+            if (due < now) // Skip deadlines missed during a long stall instead of bursting
+                due = now + period;
+        }
+    });
+    timer.join();
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread &thread : load)
+        thread.join();
+
+    printf("%-16s %s\n", name, applied);
+    printf("  wake lateness p50/p99/p99.9/max %.1f/%.1f/%.1f/%.1f us over %llu wakes\n",
+           lateness.Percentile(50.0) / 1000.0, lateness.Percentile(99.0) / 1000.0,
+           lateness.Percentile(99.9) / 1000.0, lateness.Max() / 1000.0, (unsigned long long)lateness.Count());
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    bool ok = CheckParse();
+    ok = CheckReport() && ok;
+
+    printf("%zu CPUs, %zu load threads, 500 us period\n", CpuCount(), CpuCount());
+    ThreadPolicy policy;
+    RunJitter("default", policy, seconds);
+    policy.affinity = 1ull << (CpuCount() - 1);
+    RunJitter("pinned", policy, seconds);
+    policy.priority = ThreadPriority::High;
+    RunJitter("pinned+high", policy, seconds);
+    policy.priority = ThreadPriority::Realtime;
+    RunJitter("pinned+realtime", policy, seconds);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// SPSC input ring: synthetic 8 kHz and 32 kHz mouse streams pushed through
+// SpscRing<InputEvent>, same thread and producer/consumer on two threads
+
+#include <memory>
+#include <thread>
+#include "bench.h"
+#include "core/input_event.h"
+#include "core/spsc_ring.h"
+
+using InputRing = SpscRing<InputEvent, 4096>;
+
+static InputEvent MakeMove(uint64_t i, uint64_t periodNs)
+{
+    InputEvent ev;
+    ev.time = TimePoint{} + std::chrono::nanoseconds(i * periodNs);
+    ev.type = InputType::Mouse;
+    ev.deviceId = 1;
+    ev.dx = (int32_t)(i & 0xFF); // Low bits double as a sequence check
+    ev.dy = -1;
+    return ev;
+}
+
+static void RunSameThread(const char *name, uint64_t events, uint64_t periodNs)
+{
+    auto ring = std::make_unique<InputRing>();
+    RunBenchmark(name, events, [&](uint64_t i) {
+        ring->TryPush(MakeMove(i, periodNs));
+        InputEvent out;
+        ring->TryPop(out);
+        DoNotOptimize(out);
+    });
+}
+
+static void RunTwoThreads(const char *name, uint64_t events, uint64_t periodNs)
+{
+    auto ring = std::make_unique<InputRing>();
+    uint64_t outOfOrder = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+        InputEvent batch[256];
+        uint64_t received = 0;
+        while (received < events)
+        {
+            size_t n = ring->PopBatch(batch, 256);
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (batch[i].dx != (int32_t)((received + i) & 0xFF))
+                    outOfOrder++;
+            }
+            received += n;
+        }
+    });
+
+    for (uint64_t i = 0; i < events; ++i)
+    {
+        InputEvent ev = MakeMove(i, periodNs);
+        while (!ring->TryPush(ev))
+        {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("%-40s %12llu events %10.2f ns/event  (%.0fs of input, %llu out of order)\n", name,
+           (unsigned long long)events, ns / (double)events, (double)(events * periodNs) / 1e9,
+           (unsigned long long)outOfOrder);
+}
+
+int main()
+{
+    constexpr uint64_t PERIOD_8KHZ_NS = 125000;
+    constexpr uint64_t PERIOD_32KHZ_NS = 31250;
+
+    // One minute of input at each rate
+    RunSameThread("push+pop 8 kHz (same thread)", 8000 * 60, PERIOD_8KHZ_NS);
+    RunSameThread("push+pop 32 kHz (same thread)", 32000 * 60, PERIOD_32KHZ_NS);
+    RunTwoThreads("8 kHz producer -> consumer thread", 8000 * 60, PERIOD_8KHZ_NS);
+    RunTwoThreads("32 kHz producer -> consumer thread", 32000 * 60, PERIOD_32KHZ_NS);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Timebase: clock read overhead, fixed-point conversion exactness, and drift of the
+// calibrated clock against a reference clock (returns 1 if a check fails)
+//
+// Usage: bench_timebase [drift seconds]
+
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include "bench.h"
+#include "core/timing.h"
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+// Reference for drift: the unslewed kernel clock where available
+static int64_t ReferenceNs()
+{
+#if defined(CLOCK_MONOTONIC_RAW)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static void BenchReads(const char *label)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "ReadTicks (%s)", label);
+    RunBenchmark(name, 5000000, [](uint64_t) { DoNotOptimize(ReadTicks()); });
+    snprintf(name, sizeof(name), "Clock::now (%s)", label);
+    RunBenchmark(name, 5000000, [](uint64_t) { DoNotOptimize(Clock::now()); });
+}
+
+// ns -> ticks -> ns round trip stays within one tick for a year of uptime
+static bool CheckConversion(int64_t frequency)
+{
+    Timebase timebase;
+    timebase.SetFrequency(TimebaseSource::Qpc, frequency);
+    const int64_t tickNs = (int64_t)std::ceil(1e9 / (double)frequency);
+    const int64_t year = 365ll * 24 * 3600 * 1000000000;
+    int64_t worst = 0;
+    for (int64_t ns = 1; ns < year; ns = ns * 3 + 7)
+    {
+        int64_t back = timebase.ToNs(timebase.FromNs(ns));
+        int64_t error = std::llabs(back - ns);
+        if (error > worst)
+            worst = error;
+    }
+
+    // Exact whole seconds: frequency ticks must map to 1e9 ns
+    int64_t secondError = std::llabs(timebase.ToNs(frequency * 3600) - 3600ll * 1000000000);
+    bool ok = worst <= tickNs + 1 && secondError <= 1;
+    printf("conversion @ %lld Hz: round trip error %lld ns, 1 h error %lld ns: %s\n", (long long)frequency,
+           (long long)worst, (long long)secondError, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool CheckDrift(double seconds, double maxPpm)
+{
+    TimePoint t0 = Clock::now();
+    int64_t ref0 = ReferenceNs();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    TimePoint t1 = Clock::now();
+    int64_t ref1 = ReferenceNs();
+
+    double clockNs = (double)(t1 - t0).count();
+    double refNs = (double)(ref1 - ref0);
+    double ppm = (clockNs - refNs) / refNs * 1e6;
+    bool ok = std::fabs(ppm) <= maxPpm;
+    printf("drift (%s, %lld Hz) over %.1f s: %+.3f ppm (limit %.0f): %s\n",
+           TimebaseSourceName(GetTimebase().source), (long long)GetTimebase().ticksPerSecond, seconds, ppm, maxPpm,
+           ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    double driftSeconds = argc > 1 ? atof(argv[1]) : 2.0;
+    bool ok = true;
+
+    const Timebase &timebase = GetTimebase();
+    printf("timebase %s, %lld ticks/s\n", TimebaseSourceName(timebase.source), (long long)timebase.ticksPerSecond);
+    BenchReads(TimebaseSourceName(timebase.source));
+    RunBenchmark("std::chrono::steady_clock::now", 5000000,
+                 [](uint64_t) { DoNotOptimize(std::chrono::steady_clock::now()); });
+    RunBenchmark("std::chrono::high_resolution_clock::now", 5000000,
+                 [](uint64_t) { DoNotOptimize(std::chrono::high_resolution_clock::now()); });
+
+    // QPC (10 MHz), 24 MHz, 3 GHz TSC, 1 GHz (identity)
+    ok &= CheckConversion(10000000);
+    ok &= CheckConversion(24000000);
+    ok &= CheckConversion(2999999937);
+    ok &= CheckConversion(1000000000);
+
+    ok &= CheckDrift(driftSeconds, 1.0);
+
+    if (UseTscTimebase(100))
+    {
+        BenchReads("TSC");
+        ok &= CheckDrift(driftSeconds, 50.0);
+    }
+    else
+    {
+        printf("invariant TSC not available, skipped\n");
+    }
+
+    return ok ? 0 : 1;
+}
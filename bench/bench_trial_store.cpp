@@ -0,0 +1,128 @@
+// Trial journal: render-thread append cost, then 100k trials over 25 sessions loaded
+// back in one pass and checked field by field, plus recovery from a torn last record.
+// Returns 1 if a check fails.
+//
+// Usage: bench_trial_store [path]
+
+#include <cstdio>
+#include <cwchar>
+#include "bench.h"
+#include "core/trial_store.h"
+
+constexpr uint32_t SESSIONS = 25;
+constexpr uint32_t PER_SESSION = 4000; // Below the queue capacity: nothing may be dropped
+
+static Trial MakeTrial(uint32_t session, uint32_t i)
+{
+    Trial trial;
+    trial.foreperiodNs = 1500000000ll + (int64_t)(i % 3500) * 1000000;
+    trial.responseNs = (int64_t)session * 3600000000000ll + (int64_t)i * 4000000000ll;
+    trial.device = (uint16_t)(i % 3);
+    trial.mode = (i & 4) ? TrialMode::Audio : TrialMode::Visual;
+    if (i % 50 == 0)
+        trial.flags = TRIAL_FALSE_START;
+    else
+        trial.stimulusNs = trial.responseNs - 150000000ll - (int64_t)(i % 200) * 1000000;
+    return trial;
+}
+
+static bool Same(const Trial &a, const Trial &b)
+{
+    return a.foreperiodNs == b.foreperiodNs && a.stimulusNs == b.stimulusNs && a.responseNs == b.responseNs &&
+           a.device == b.device && a.mode == b.mode && a.flags == b.flags;
+}
+
+static bool Check(const TrialStore &store, uint32_t sessions)
+{
+    if (store.Sessions().size() != sessions || store.Count() != (size_t)SESSIONS * PER_SESSION + sessions - SESSIONS)
+        return false;
+    for (uint32_t s = 0; s < SESSIONS; ++s)
+    {
+        if (store.Sessions()[s].seed != s + 1 || store.Sessions()[s].wallNs != 1700000000000000000ll + s)
+            return false;
+        if (wcscmp(store.DeviceName(s, 1), L"Mouse 1") != 0 || wcscmp(store.DeviceName(s, 3), L"") != 0)
+            return false;
+        for (uint32_t i = 0; i < PER_SESSION; ++i)
+        {
+            size_t row = (size_t)s * PER_SESSION + i;
+            if (store.Session()[row] != s || !Same(store.Row(row), MakeTrial(s, i)))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool WriteSession(TrialJournal &journal, const char *path, uint32_t s, uint32_t trials)
+{
+    TrialSession session;
+    session.wallNs = 1700000000000000000ll + s;
+    session.seed = s + 1;
+    if (!journal.Open(path, session))
+        return false;
+    for (uint32_t i = 0; i < trials; ++i)
+    {
+        Trial trial = MakeTrial(s, i);
+        journal.Append(trial, trial.device == 1 ? L"Mouse 1" : L"Mouse 0");
+    }
+    journal.Close();
+    return journal.Dropped() == 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "bench_trials.lttrials";
+    remove(path);
+
+    TrialJournal journal;
+    bool ok = true;
+    {
+        // Render-thread cost only; the writer drains the ring every flush interval
+        TrialSession session;
+        session.seed = 1;
+        ok = journal.Open(path, session);
+        RunBenchmark("TrialJournal::Append", PER_SESSION, [&](uint64_t i) {
+            journal.Append(MakeTrial(0, (uint32_t)i), L"Mouse 0");
+        });
+        journal.Close();
+        remove(path);
+    }
+
+    for (uint32_t s = 0; s < SESSIONS && ok; ++s)
+        ok = WriteSession(journal, path, s, PER_SESSION);
+    printf("wrote %u sessions x %u trials: %s\n", SESSIONS, PER_SESSION, ok ? "ok" : "FAIL");
+
+    TrialStore store;
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = TrialJournal::Load(path, store);
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    bool round = loaded && Check(store, SESSIONS);
+    printf("loaded %zu trials in %.2f ms: %s\n", store.Count(), loadMs, round ? "ok" : "MISMATCH");
+
+    // Column scan over the loaded session
+    double sum = 0.0;
+    RunBenchmark("reaction ms column scan (100k trials)", 100, [&](uint64_t) {
+        const std::vector<int64_t> &stimulus = store.StimulusNs();
+        const std::vector<int64_t> &response = store.ResponseNs();
+        const std::vector<uint8_t> &flags = store.Flags();
+        for (size_t i = 0; i < store.Count(); ++i)
+            sum += (flags[i] & TRIAL_FALSE_START) ? 0.0 : (double)(response[i] - stimulus[i]);
+    });
+    DoNotOptimize(sum);
+
+    // A crash mid-record leaves a partial Trial record; reopening pads over it
+    FILE *f = fopen(path, "ab");
+    const uint8_t torn[10] = {(uint8_t)TrialRecordType::Trial, 0, 0, 0, 1, 0, 0, 0, 7, 7};
+    bool recovered = f && fwrite(torn, sizeof(torn), 1, f) == 1;
+    if (f)
+        fclose(f);
+    TrialStore tornStore;
+    recovered = recovered && TrialJournal::Load(path, tornStore) && Check(tornStore, SESSIONS);
+    recovered = recovered && WriteSession(journal, path, SESSIONS, 1);
+    TrialStore reopened;
+    recovered = recovered && TrialJournal::Load(path, reopened) && Check(reopened, SESSIONS + 1) &&
+                Same(reopened.Row(reopened.Count() - 1), MakeTrial(SESSIONS, 0));
+    printf("torn last record: %s\n", recovered ? "ok" : "FAIL");
+
+    remove(path);
+    return ok && round && recovered ? 0 : 1;
+}
@@ -0,0 +1,294 @@
+// Main-loop wait strategies against a simulated render loop
+// An input thread publishes events at random intervals (~500 Hz, stamped on arrival)
+// and a fake display signals "frame can be queued" at 1 kHz, like the swap chain's
+// frame-latency waitable object. The loop waits with each strategy, drains input and
+// spins 100 us as its render. Reports the loop thread's CPU usage, deadline lateness and
+// input-arrival-to-handled latency per strategy, then checks that a paused (unfocused)
+// loop only wakes for input. The display is modelled like DXGI's object, a counting
+// semaphore released once per presented frame it scans out; waitable must keep its count
+// within the maximum frame latency however many frames input wakes, without holding the
+// input back until the next signal. Returns 1 if an event is lost, a strategy stops
+// rendering or handles input late, or waitable lets the count drift or stalls twice per
+// timed-out wait.
+//
+// Usage: bench_wait_strategy [seconds per strategy]
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "bench.h"
+#include "core/input_thread.h"
+#include "core/wait_strategy.h"
+
+// SetMaximumFrameLatency(1), as main.cpp sets it
+static constexpr uint32_t MAX_FRAME_LATENCY = 1;
+// Median input arrival -> handled, a quarter of the display period
+static constexpr double INPUT_HANDLED_LIMIT_US = 250.0;
+
+// Portable stand-in for Win32WaitTarget: a condition variable rung by the input
+// thread's doorbell and by the fake display
+class CondvarWaitTarget : public WaitTarget
+{
+public:
+    explicit CondvarWaitTarget(ThreadedInputSource &input) : m_input(input)
+    {
+        m_input.SetDoorbell([this] {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_rung = true;
+            m_cv.notify_one();
+        });
+    }
+
+    // The loop queued a frame
+    void Present()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued++;
+    }
+
+    // Vblank: scanning out a queued frame releases the semaphore once
+    void SignalFrame()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queued == 0)
+            return;
+        m_queued--;
+        m_frameCount++;
+        m_maxFrameCount = std::max(m_maxFrameCount, m_frameCount);
+        m_cv.notify_one();
+    }
+
+    uint32_t MaxFrameCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_maxFrameCount;
+    }
+
+    bool Pending() override { return m_input.HasPending(); }
+
+    WakeReason Block(TimePoint deadline, bool frame) override
+    {
+        if (!m_input.ArmDoorbell())
+            return WakeReason::Input;
+        WakeReason reason = WakeReason::Deadline;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;)
+            {
+                if (m_rung)
+                {
+                    reason = WakeReason::Input;
+                    break;
+                }
+                if (frame && m_frameCount > 0)
+                {
+                    reason = WakeReason::Frame;
+                    break;
+                }
+                if (deadline == TimePoint::max())
+                {
+                    m_cv.wait(lock);
+                    continue;
+                }
+                Clock::duration remaining = deadline - Clock::now();
+                if (remaining.count() <= 0)
+                    break;
+                m_cv.wait_for(lock, std::chrono::nanoseconds(remaining.count()));
+            }
+            m_rung = false;
+            if (reason == WakeReason::Frame)
+                m_frameCount--;
+        }
+        m_input.DisarmDoorbell();
+        return reason;
+    }
+
+    bool AcquireFrame(TimePoint deadline) override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_frameCount == 0)
+        {
+            Clock::duration remaining = deadline - Clock::now();
+            if (remaining.count() <= 0)
+                return false;
+            m_cv.wait_for(lock, std::chrono::nanoseconds(remaining.count()));
+        }
+        m_frameCount--;
+        return true;
+    }
+
+private:
+    ThreadedInputSource &m_input;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_rung = false;
+    uint32_t m_frameCount = MAX_FRAME_LATENCY; // Starts with room for a full queue
+    uint32_t m_maxFrameCount = MAX_FRAME_LATENCY;
+    uint32_t m_queued = 0;
+};
+
+// A swap chain that never signals (occluded, lost device): every wait times out
+class SilentWaitTarget : public WaitTarget
+{
+public:
+    bool Pending() override { return false; }
+    WakeReason Block(TimePoint, bool) override { return WakeReason::Deadline; }
+    bool AcquireFrame(TimePoint deadline) override
+    {
+        if (deadline != TimePoint())
+            blockingAcquires++;
+        return false;
+    }
+
+    uint64_t blockingAcquires = 0;
+};
+
+struct RunResult
+{
+    uint64_t published = 0;
+    uint64_t received = 0;
+    uint64_t frames = 0;
+    uint32_t maxFrameCount = 0; // Highest frame-latency semaphore count seen
+    WaitStats stats;
+};
+
+static RunResult RunLoop(const WaitConfig &config, double seconds, bool focused)
+{
+    ThreadedInputSource input;
+    CondvarWaitTarget target(input);
+    std::atomic<bool> displayStop{false};
+    RunResult result;
+
+    bool started = input.Start([&](ThreadedInputSource &source) {
+        source.Ready(true);
+        std::mt19937 rng(7);
+        std::exponential_distribution<double> gapUs(1.0 / 2000.0);
+        while (!source.StopRequested())
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds((int64_t)gapUs(rng) + 1));
+            InputEvent ev;
+            ev.time = Clock::now();
+            ev.type = InputType::Mouse;
+            source.Publish(ev);
+        }
+    });
+    if (!started)
+        return result;
+
+    std::thread display([&] {
+        TimePoint next = Clock::now();
+        while (!displayStop.load(std::memory_order_relaxed))
+        {
+            next += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(next);
+            target.SignalFrame();
+        }
+    });
+
+    FrameWaiter waiter;
+    waiter.SetFocused(focused);
+    TimePoint start = Clock::now();
+    waiter.Configure(config, start);
+    InputEvent batch[InputSource::MAX_POLL_EVENTS];
+    const TimePoint end = start + std::chrono::microseconds((int64_t)(seconds * 1e6));
+    for (TimePoint now = start; now < end; now = Clock::now())
+    {
+        waiter.Wait(target);
+        size_t count = input.Poll(batch, InputSource::MAX_POLL_EVENTS);
+        if (count > 0)
+            waiter.OnInput(batch[0].time); // Handled here
+        result.received += count;
+
+        // Render: 100 us of work
+        TimePoint renderEnd = Clock::now() + std::chrono::microseconds(100);
+        while (Clock::now() < renderEnd)
+        {
+        }
+        waiter.BeforePresent(target);
+        target.Present();
+        result.frames++;
+    }
+    waiter.Sample(Clock::now());
+
+    input.Stop();
+    displayStop.store(true, std::memory_order_relaxed);
+    display.join();
+    result.received += input.Poll(batch, InputSource::MAX_POLL_EVENTS);
+    result.published = input.Published();
+    result.stats = waiter.Stats(config.strategy);
+    result.maxFrameCount = target.MaxFrameCount();
+    return result;
+}
+
+static bool Report(const char *name, const RunResult &result, double seconds)
+{
+    const WaitStats &stats = result.stats;
+    // Input that ends a wait is handled at once, not after the next frame signal (1 ms here)
+    bool ok = result.frames > 0 && result.received == result.published &&
+              (stats.inputSamples == 0 || stats.inputP50Us < INPUT_HANDLED_LIMIT_US);
+    printf("%-14s %7.0f FPS  CPU %5.1f%%  late p50/p99 %6.1f/%6.1f us  handled p50/p99 %6.1f/%6.1f us (%llu)  %s\n",
+           name, result.frames / seconds, stats.cpuPercent, stats.lateP50Us, stats.lateP99Us, stats.inputP50Us,
+           stats.inputP99Us, (unsigned long long)stats.inputSamples, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    bool ok = true;
+
+    WaitConfig parsed;
+    ok = ok && ParseWaitConfig("hybrid:2000,pause", parsed) && parsed.strategy == WaitStrategy::Hybrid &&
+         parsed.period == std::chrono::microseconds(500) && parsed.pauseUnfocused;
+    ok = ok && !ParseWaitConfig("sleep", parsed) && !ParseWaitConfig("spin:0", parsed) &&
+         !ParseWaitConfig("yield,stop", parsed) && parsed.strategy == WaitStrategy::Hybrid;
+    printf("wait spec parsing: %s\n", ok ? "ok" : "FAIL");
+
+    printf("%zu CPUs, ~500 Hz input, 1 kHz display, 100 us render\n", (size_t)std::thread::hardware_concurrency());
+    WaitConfig config;
+    ok &= Report("spin", RunLoop(config, seconds, true), seconds);
+
+    config.period = std::chrono::milliseconds(1);
+    ok &= Report("spin@1000", RunLoop(config, seconds, true), seconds);
+    config.strategy = WaitStrategy::SpinYield;
+    ok &= Report("yield@1000", RunLoop(config, seconds, true), seconds);
+    config.strategy = WaitStrategy::Hybrid;
+    ok &= Report("hybrid@1000", RunLoop(config, seconds, true), seconds);
+    config.strategy = WaitStrategy::Waitable;
+    RunResult waitable = RunLoop(config, seconds, true);
+    ok &= Report("waitable", waitable, seconds);
+
+    // Every presented frame took one signal, input-woken ones included
+    bool balanced = waitable.stats.inputWakes > 0 && waitable.maxFrameCount <= MAX_FRAME_LATENCY;
+    printf("waitable frame-latency count stays <= %u over %llu input wakes: %s (max %u)\n", MAX_FRAME_LATENCY,
+           (unsigned long long)waitable.stats.inputWakes, balanced ? "ok" : "FAIL", waitable.maxFrameCount);
+    ok = ok && balanced;
+
+    // Timed-out waits leave nothing to balance, so they must not block a second time
+    SilentWaitTarget silent;
+    FrameWaiter occluded;
+    occluded.Configure(config, Clock::now());
+    for (int i = 0; i < 100; ++i)
+    {
+        occluded.Wait(silent);
+        occluded.BeforePresent(silent);
+    }
+    bool noStall = silent.blockingAcquires == 0;
+    printf("waitable timed-out waits take no extra frame wait: %s (%llu)\n", noStall ? "ok" : "FAIL",
+           (unsigned long long)silent.blockingAcquires);
+    ok = ok && noStall;
+
+    // Unfocused with pause: every wake is an input wake, so frames track input, not the clock
+    config.strategy = WaitStrategy::Spin;
+    config.period = Clock::duration(0);
+    config.pauseUnfocused = true;
+    RunResult paused = RunLoop(config, seconds, false);
+    bool pauseOk = Report("spin,paused", paused, seconds) && paused.stats.pausedMs > 0.0 &&
+                   paused.frames <= paused.stats.inputWakes + 1;
+    printf("paused loop wakes only for input: %s (%.0f ms blocked)\n", pauseOk ? "ok" : "FAIL",
+           paused.stats.pausedMs);
+    return ok && pauseOk ? 0 : 1;
+}
@@ -5,6 +5,11 @@ REM Tries MSVC (cl.exe) first, falls back to GCC (g++) if not found
 
 echo Building Latency Tester and Reaction Tester...
 
+REM Portable timing core shared by both apps
+set CORE_SRC=core\audio_caps.cpp core\audio_clock.cpp core\audio_scheduler.cpp core\audio_stimulus.cpp core\audio_thread.cpp core\device_registry.cpp core\event_log.cpp core\file_path.cpp core\flash.cpp core\flash_pattern.cpp core\frame_times.cpp core\histogram.cpp core\input_filter.cpp core\input_thread.cpp core\latency_stages.cpp ^
+    core\latency_tester.cpp core\onset_detector.cpp core\overlay_text.cpp core\polling_rate.cpp core\raw_input.cpp ^
+    core\reaction_stats.cpp core\reaction_tester.cpp core\thread_policy.cpp core\timebase.cpp core\trace_file.cpp core\trial_store.cpp core\wait_strategy.cpp core\wav_file.cpp
+
 REM Check if cl.exe is available
 where cl.exe >nul 2>&1
 if %ERRORLEVEL% EQU 0 (
@@ -14,9 +19,9 @@ if %ERRORLEVEL% EQU 0 (
     echo [1/2] Building LatencyTester.exe...
     cl.exe /nologo /EHsc /O2 /MT /W4 ^
         /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_UNICODE" /D "UNICODE" ^
-        main.cpp ^
+        /I . main.cpp %CORE_SRC% ^
         /link /SUBSYSTEM:WINDOWS ^
-        d3d11.lib dxgi.lib d2d1.lib dwrite.lib user32.lib ^
+        d3d11.lib dxgi.lib d2d1.lib dwrite.lib user32.lib ole32.lib ^
         /OUT:LatencyTester.exe
 
     if !ERRORLEVEL! EQU 0 (
@@ -29,7 +34,7 @@ if %ERRORLEVEL% EQU 0 (
     echo [2/2] Building ReactionTester.exe...
     cl.exe /nologo /EHsc /O2 /MT /W4 ^
         /D "WIN32" /D "NDEBUG" /D "_WINDOWS" /D "_UNICODE" /D "UNICODE" ^
-        reaction.cpp ^
+        /I . reaction.cpp %CORE_SRC% ^
         /link /SUBSYSTEM:WINDOWS ^
         d3d11.lib dxgi.lib d2d1.lib dwrite.lib user32.lib ole32.lib ^
         /OUT:ReactionTester.exe
@@ -53,8 +58,8 @@ if %ERRORLEVEL% EQU 0 (
 
     echo.
     echo [1/2] Building LatencyTester.exe...
-    g++.exe -o LatencyTester.exe main.cpp ^
-        -O3 -Wall -mwindows -municode -static ^
+    g++.exe -o LatencyTester.exe main.cpp %CORE_SRC% -I. ^
+        -O3 -Wall -mwindows -municode -static -pthread ^
         -DWIN32 -DNDEBUG -D_WINDOWS -DUNICODE -D_UNICODE ^
         -ld3d11 -ldxgi -ld2d1 -ldwrite -luser32 -lole32 -luuid
 
@@ -66,8 +71,8 @@ if %ERRORLEVEL% EQU 0 (
 
     echo.
     echo [2/2] Building ReactionTester.exe...
-    g++.exe -o ReactionTester.exe reaction.cpp ^
-        -O3 -Wall -mwindows -municode -static ^
+    g++.exe -o ReactionTester.exe reaction.cpp %CORE_SRC% -I. ^
+        -O3 -Wall -mwindows -municode -static -pthread ^
         -DWIN32 -DNDEBUG -D_WINDOWS -DUNICODE -D_UNICODE ^
         -ld3d11 -ldxgi -ld2d1 -ldwrite -luser32 -lole32 -luuid
 
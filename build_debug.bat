@@ -4,11 +4,15 @@ REM Run from a Visual Studio Developer Command Prompt
 
 echo Building Latency Tester (Debug)...
 
+set CORE_SRC=core\audio_caps.cpp core\audio_clock.cpp core\audio_scheduler.cpp core\audio_stimulus.cpp core\audio_thread.cpp core\device_registry.cpp core\event_log.cpp core\file_path.cpp core\flash.cpp core\flash_pattern.cpp core\frame_times.cpp core\histogram.cpp core\input_filter.cpp core\input_thread.cpp core\latency_stages.cpp ^
+    core\latency_tester.cpp core\onset_detector.cpp core\overlay_text.cpp core\polling_rate.cpp core\raw_input.cpp ^
+    core\reaction_stats.cpp core\reaction_tester.cpp core\thread_policy.cpp core\timebase.cpp core\trace_file.cpp core\trial_store.cpp core\wait_strategy.cpp core\wav_file.cpp
+
 cl.exe /nologo /EHsc /Od /MTd /W4 /Zi ^
     /D "WIN32" /D "_DEBUG" /D "_WINDOWS" /D "_UNICODE" /D "UNICODE" ^
-    main.cpp ^
+    /I . main.cpp %CORE_SRC% ^
     /link /SUBSYSTEM:WINDOWS /DEBUG ^
-    d3d11.lib dxgi.lib d2d1.lib dwrite.lib user32.lib ^
+    d3d11.lib dxgi.lib d2d1.lib dwrite.lib user32.lib ole32.lib ^
     /OUT:LatencyTester_debug.exe
 
 if %ERRORLEVEL% EQU 0 (
@@ -0,0 +1,301 @@
+#include "audio_caps.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <tuple>
+#include "file_path.h"
+
+static const char CACHE_HEADER[] = "# audio device cache v1";
+
+const char *AudioShareModeName(AudioShareMode mode)
+{
+    switch (mode)
+    {
+    case AudioShareMode::Exclusive:
+        return "exclusive";
+    case AudioShareMode::SharedLowLatency:
+        return "shared-low-latency";
+    default:
+        return "shared";
+    }
+}
+
+const char *SampleFormatName(SampleFormat sample)
+{
+    return sample == SampleFormat::Float32 ? "float32" : "int16";
+}
+
+double AudioConfig::EstimatedLatencyMs() const
+{
+    return PeriodMs() * (mode == AudioShareMode::Exclusive ? 2.0 : 3.0);
+}
+
+// Frames covering at least `us` at the rate
+static uint32_t FramesAtLeast(uint64_t us, uint32_t rate)
+{
+    return (uint32_t)((us * rate + 999999) / 1000000);
+}
+
+std::vector<AudioConfig> RankAudioConfigs(const AudioDeviceCaps &caps, const AudioConfigPreference &preference)
+{
+    std::vector<AudioConfig> configs;
+    if (preference.allowExclusive && caps.exclusiveMinPeriodUs > 0)
+    {
+        uint32_t periodUs = std::max(caps.exclusiveMinPeriodUs, preference.minPeriodUs);
+        for (const AudioFormat &format : caps.exclusiveFormats)
+        {
+            AudioConfig config;
+            config.mode = AudioShareMode::Exclusive;
+            config.format = format;
+            config.periodFrames = FramesAtLeast(periodUs, format.sampleRate);
+            configs.push_back(config);
+        }
+    }
+    if (caps.mixUsable)
+    {
+        if (caps.sharedMinFrames > 0 && caps.sharedFundamentalFrames > 0)
+        {
+            // The smallest supported period (a multiple of the fundamental) above the floor
+            uint32_t frames = std::max(caps.sharedMinFrames,
+                                       FramesAtLeast(preference.minPeriodUs, caps.mixFormat.sampleRate));
+            uint32_t step = caps.sharedFundamentalFrames;
+            frames = (frames + step - 1) / step * step;
+            if (frames <= caps.sharedMaxFrames)
+            {
+                AudioConfig config;
+                config.mode = AudioShareMode::SharedLowLatency;
+                config.format = caps.mixFormat;
+                config.periodFrames = frames;
+                configs.push_back(config);
+            }
+        }
+        if (caps.sharedDefaultPeriodUs > 0)
+        {
+            // Always offered: the last resort, whatever the floor
+            AudioConfig config;
+            config.mode = AudioShareMode::Shared;
+            config.format = caps.mixFormat;
+            config.periodFrames = FramesAtLeast(caps.sharedDefaultPeriodUs, caps.mixFormat.sampleRate);
+            configs.push_back(config);
+        }
+    }
+
+    // Latency in 0.1 ms steps, so a rate that rounds the period up a few frames ties
+    auto key = [&](const AudioConfig &config) {
+        return std::make_tuple(std::llround(config.EstimatedLatencyMs() * 10.0), (int)config.mode,
+                               config.format.sampleRate == preference.preferredRate ? 0 : 1,
+                               config.format.sample == SampleFormat::Float32 ? 0 : 1);
+    };
+    std::stable_sort(configs.begin(), configs.end(),
+                     [&](const AudioConfig &a, const AudioConfig &b) { return key(a) < key(b); });
+    return configs;
+}
+
+void FormatAudioConfig(const AudioConfig &config, char *out, size_t size)
+{
+    snprintf(out, size, "%s %u Hz %u ch %s, %.2f ms period (~%.1f ms)", AudioShareModeName(config.mode),
+             config.format.sampleRate, config.format.channels, SampleFormatName(config.format.sample),
+             config.PeriodMs(), config.EstimatedLatencyMs());
+}
+
+std::string FormatAudioCaps(const AudioDeviceCaps &caps)
+{
+    char line[256];
+    std::string text;
+    if (caps.mixUsable)
+        snprintf(line, sizeof(line), "mix format: %u Hz %u ch %s\n", caps.mixFormat.sampleRate,
+                 caps.mixFormat.channels, SampleFormatName(caps.mixFormat.sample));
+    else
+        snprintf(line, sizeof(line), "mix format: not usable\n");
+    text += line;
+
+    if (caps.exclusiveMinPeriodUs > 0)
+    {
+        snprintf(line, sizeof(line), "exclusive: minimum period %.2f ms, %zu formats",
+                 caps.exclusiveMinPeriodUs / 1000.0, caps.exclusiveFormats.size());
+        text += line;
+        for (size_t i = 0; i < caps.exclusiveFormats.size(); ++i)
+        {
+            const AudioFormat &format = caps.exclusiveFormats[i];
+            snprintf(line, sizeof(line), "%s %u/%u/%s", i == 0 ? ":" : ",", format.sampleRate, format.channels,
+                     SampleFormatName(format.sample));
+            text += line;
+        }
+        text += "\n";
+    }
+    else
+    {
+        text += "exclusive: unavailable\n";
+    }
+
+    snprintf(line, sizeof(line), "shared: default period %.2f ms", caps.sharedDefaultPeriodUs / 1000.0);
+    text += line;
+    if (caps.sharedMinFrames > 0)
+        snprintf(line, sizeof(line), ", low-latency %u-%u frames in steps of %u\n", caps.sharedMinFrames,
+                 caps.sharedMaxFrames, caps.sharedFundamentalFrames);
+    else
+        snprintf(line, sizeof(line), ", no low-latency periods\n");
+    text += line;
+    return text;
+}
+
+const AudioCapsCache::Entry *AudioCapsCache::Lookup(const std::string &deviceId) const
+{
+    for (const Entry &entry : m_entries)
+    {
+        if (entry.deviceId == deviceId)
+            return &entry;
+    }
+    return nullptr;
+}
+
+AudioCapsCache::Entry &AudioCapsCache::Slot(const std::string &deviceId)
+{
+    for (Entry &entry : m_entries)
+    {
+        if (entry.deviceId == deviceId)
+            return entry;
+    }
+    m_entries.emplace_back();
+    m_entries.back().deviceId = deviceId;
+    return m_entries.back();
+}
+
+bool AudioCapsCache::Find(const std::string &deviceId, const AudioFormat &mixFormat, AudioConfig &config) const
+{
+    const Entry *entry = Lookup(deviceId);
+    if (!entry || entry->config.periodFrames == 0 || entry->mixFormat.sampleRate != mixFormat.sampleRate ||
+        entry->mixFormat.channels != mixFormat.channels || entry->mixFormat.sample != mixFormat.sample)
+        return false;
+    if (entry->config.PeriodMs() * 1000.0 < entry->floorUs)
+        return false;
+    config = entry->config;
+    return true;
+}
+
+void AudioCapsCache::Store(const std::string &deviceId, const AudioFormat &mixFormat, const AudioConfig &config)
+{
+    Entry &entry = Slot(deviceId);
+    entry.mixFormat = mixFormat;
+    entry.config = config;
+}
+
+void AudioCapsCache::SetPeriodFloor(const std::string &deviceId, uint32_t floorUs)
+{
+    Slot(deviceId).floorUs = floorUs;
+}
+
+uint32_t AudioCapsCache::PeriodFloor(const std::string &deviceId) const
+{
+    const Entry *entry = Lookup(deviceId);
+    return entry ? entry->floorUs : 0;
+}
+
+static bool ParseMode(const char *text, AudioShareMode &mode)
+{
+    const AudioShareMode modes[] = {AudioShareMode::Exclusive, AudioShareMode::SharedLowLatency,
+                                    AudioShareMode::Shared};
+    for (AudioShareMode candidate : modes)
+    {
+        if (strcmp(text, AudioShareModeName(candidate)) == 0)
+        {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseSample(const char *text, SampleFormat &sample)
+{
+    if (strcmp(text, "float32") == 0)
+        sample = SampleFormat::Float32;
+    else if (strcmp(text, "int16") == 0)
+        sample = SampleFormat::Int16;
+    else
+        return false;
+    return true;
+}
+
+// Splits a line on tabs in place; returns the field count
+static size_t SplitFields(char *line, char **fields, size_t maxFields)
+{
+    size_t count = 0;
+    char *p = line;
+    while (count < maxFields)
+    {
+        fields[count++] = p;
+        char *tab = strchr(p, '\t');
+        if (!tab)
+            break;
+        *tab = '\0';
+        p = tab + 1;
+    }
+    return count;
+}
+
+static bool ParseUnsigned(const char *text, uint32_t &value)
+{
+    char *end = nullptr;
+    unsigned long parsed = strtoul(text, &end, 10);
+    if (end == text || *end != '\0')
+        return false;
+    value = (uint32_t)parsed;
+    return true;
+}
+
+bool AudioCapsCache::Load(const std::string &path)
+{
+    m_entries.clear();
+    FILE *f = OpenUtf8File(path, "r");
+    if (!f)
+        return false;
+
+    char line[1024];
+    bool ok = fgets(line, sizeof(line), f) && strncmp(line, CACHE_HEADER, sizeof(CACHE_HEADER) - 1) == 0;
+    while (ok && fgets(line, sizeof(line), f))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *fields[11];
+        if (SplitFields(line, fields, 11) != 10 || fields[0][0] == '\0')
+            continue; // Malformed lines are dropped; the device is probed again
+
+        Entry entry;
+        entry.deviceId = fields[0];
+        uint32_t mixChannels = 0, channels = 0;
+        if (!ParseUnsigned(fields[1], entry.mixFormat.sampleRate) || !ParseUnsigned(fields[2], mixChannels) ||
+            !ParseSample(fields[3], entry.mixFormat.sample) || !ParseMode(fields[4], entry.config.mode) ||
+            !ParseUnsigned(fields[5], entry.config.format.sampleRate) || !ParseUnsigned(fields[6], channels) ||
+            !ParseSample(fields[7], entry.config.format.sample) ||
+            !ParseUnsigned(fields[8], entry.config.periodFrames) || !ParseUnsigned(fields[9], entry.floorUs))
+            continue;
+        entry.mixFormat.channels = (uint16_t)mixChannels;
+        entry.config.format.channels = (uint16_t)channels;
+        if (!Lookup(entry.deviceId))
+            m_entries.push_back(entry);
+    }
+    fclose(f);
+    if (!ok)
+        m_entries.clear();
+    return ok;
+}
+
+bool AudioCapsCache::Save(const std::string &path) const
+{
+    FILE *f = OpenUtf8File(path, "w");
+    if (!f)
+        return false;
+    bool ok = fprintf(f, "%s\n", CACHE_HEADER) > 0;
+    for (const Entry &entry : m_entries)
+    {
+        if (ok)
+            ok = fprintf(f, "%s\t%u\t%u\t%s\t%s\t%u\t%u\t%s\t%u\t%u\n", entry.deviceId.c_str(),
+                         entry.mixFormat.sampleRate, entry.mixFormat.channels, SampleFormatName(entry.mixFormat.sample),
+                         AudioShareModeName(entry.config.mode), entry.config.format.sampleRate,
+                         entry.config.format.channels, SampleFormatName(entry.config.format.sample),
+                         entry.config.periodFrames, entry.floorUs) > 0;
+    }
+    return fclose(f) == 0 && ok;
+}
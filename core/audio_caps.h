@@ -0,0 +1,101 @@
+// Audio endpoint capabilities and the choice of stream configuration
+// A backend probe (WASAPI: WasapiEndpoint::Probe) lists what an endpoint accepts: the
+// exclusive-mode formats and minimum device period, the shared-mode mix format and, where
+// the engine supports it (IAudioClient3), its low-latency period range. RankAudioConfigs
+// orders every usable configuration by estimated output latency so the backend can try
+// them in turn, and AudioCapsCache remembers per device the one that opened, so a later
+// start skips the probe. A device that underran at its chosen period gets a period floor
+// in the cache, and the next start re-ranks above it.
+//
+// Cache file: text, "# audio device cache v1" then one tab-separated line per device:
+//   id  mix-rate mix-channels mix-sample  mode rate channels sample period-frames  floor-us
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "audio_stimulus.h"
+
+enum class AudioShareMode : uint8_t
+{
+    Exclusive,        // Own the device at its minimum period (event-driven)
+    SharedLowLatency, // Engine running at a reduced period (IAudioClient3)
+    Shared            // Engine at its default period
+};
+
+const char *AudioShareModeName(AudioShareMode mode);
+const char *SampleFormatName(SampleFormat sample);
+
+struct AudioDeviceCaps
+{
+    bool mixUsable = false; // The mix format is one StimulusBuffer can render
+    AudioFormat mixFormat;
+    std::vector<AudioFormat> exclusiveFormats; // Usable formats accepted in exclusive mode
+    uint32_t exclusiveMinPeriodUs = 0;         // Minimum device period (0: exclusive unavailable)
+    uint32_t sharedDefaultPeriodUs = 0;        // Engine period of a regular shared stream
+    // Low-latency engine periods in mix-format frames (0: not supported)
+    uint32_t sharedMinFrames = 0;
+    uint32_t sharedMaxFrames = 0;
+    uint32_t sharedFundamentalFrames = 0; // Supported periods are multiples of this
+};
+
+struct AudioConfig
+{
+    AudioShareMode mode = AudioShareMode::Shared;
+    AudioFormat format;
+    uint32_t periodFrames = 0;
+
+    double PeriodMs() const { return format.sampleRate ? periodFrames * 1000.0 / format.sampleRate : 0.0; }
+    // Audio queued ahead of the DAC: two periods in exclusive mode, one more for the
+    // engine's mix in shared modes
+    double EstimatedLatencyMs() const;
+};
+
+struct AudioConfigPreference
+{
+    bool allowExclusive = true;
+    uint32_t preferredRate = 48000; // Between formats of equal latency
+    uint32_t minPeriodUs = 0;       // Period floor (set after underruns)
+};
+
+// Every configuration the caps allow, lowest estimated latency first; ties go to the
+// exclusive/low-latency/shared order, then the preferred rate, then float samples
+std::vector<AudioConfig> RankAudioConfigs(const AudioDeviceCaps &caps,
+                                          const AudioConfigPreference &preference = AudioConfigPreference());
+
+// "exclusive 48000 Hz 2 ch int16, 3.00 ms period (~6.0 ms)"
+void FormatAudioConfig(const AudioConfig &config, char *out, size_t size);
+// Multi-line summary of a probe, for reports
+std::string FormatAudioCaps(const AudioDeviceCaps &caps);
+
+class AudioCapsCache
+{
+public:
+    bool Load(const std::string &path); // false if missing or not a cache (the cache is then empty)
+    bool Save(const std::string &path) const;
+
+    // The configuration that last opened on the device, if its mix format is unchanged and
+    // the period is not below the device's floor
+    bool Find(const std::string &deviceId, const AudioFormat &mixFormat, AudioConfig &config) const;
+    void Store(const std::string &deviceId, const AudioFormat &mixFormat, const AudioConfig &config);
+    // Underruns at the stored period: later starts must pick a period of at least floorUs
+    void SetPeriodFloor(const std::string &deviceId, uint32_t floorUs);
+    uint32_t PeriodFloor(const std::string &deviceId) const; // 0 if none
+
+    size_t Count() const { return m_entries.size(); }
+
+private:
+    struct Entry
+    {
+        std::string deviceId;
+        AudioFormat mixFormat;
+        AudioConfig config;
+        uint32_t floorUs = 0;
+    };
+
+    const Entry *Lookup(const std::string &deviceId) const;
+    Entry &Slot(const std::string &deviceId); // Adds the device if missing
+
+    std::vector<Entry> m_entries;
+};
@@ -0,0 +1,114 @@
+#include "audio_clock.h"
+#include <cmath>
+
+bool AudioClockFit::Valid() const
+{
+    return samples >= AudioClockCorrelator::MIN_SAMPLES && nsPerFrame > 0.0 && sumSquares > 0.0;
+}
+
+bool AudioClockFit::FrameTime(uint64_t frame, TimePoint &at, double &errorNs) const
+{
+    if (!Valid())
+        return false;
+    double dx = (double)(int64_t)(frame - frameBase) - meanFrame;
+    double host = meanHostNs + nsPerFrame * dx;
+    at = TimePoint(Clock::duration(hostBase + (int64_t)std::llround(host)));
+    errorNs = residualNs * std::sqrt(1.0 / samples + dx * dx / sumSquares);
+    return true;
+}
+
+double AudioClockFit::DriftPpm(uint32_t nominalRate) const
+{
+    if (!Valid() || nominalRate == 0)
+        return 0.0;
+    return (1e9 / nsPerFrame / nominalRate - 1.0) * 1e6;
+}
+
+void AudioClockCorrelator::Reset()
+{
+    m_count = 0;
+    m_next = 0;
+    m_rejectRun = 0;
+    m_fit = AudioClockFit();
+    m_restarts++;
+}
+
+bool AudioClockCorrelator::Add(uint64_t frame, TimePoint at)
+{
+    int64_t host = at.time_since_epoch().count();
+    if (m_count > 0)
+    {
+        size_t last = (m_next + WINDOW - 1) % WINDOW;
+        if (frame == m_frames[last])
+            return false;
+    }
+
+    if (m_fit.Valid())
+    {
+        TimePoint predicted;
+        double errorNs = 0.0;
+        m_fit.FrameTime(frame, predicted, errorNs);
+        double deviation = std::fabs((double)(host - predicted.time_since_epoch().count()));
+        double limit = m_fit.residualNs * OUTLIER_RESIDUALS;
+        if (deviation > (limit > OUTLIER_FLOOR_NS ? limit : OUTLIER_FLOOR_NS))
+        {
+            m_rejected++;
+            if (++m_rejectRun < MAX_REJECTS)
+                return false;
+            // The stream moved, not the pairs: start over from this one
+            Reset();
+        }
+    }
+    m_rejectRun = 0;
+
+    m_frames[m_next] = frame;
+    m_hosts[m_next] = host;
+    m_next = (m_next + 1) % WINDOW;
+    if (m_count < WINDOW)
+        m_count++;
+    Refit();
+    return true;
+}
+
+void AudioClockCorrelator::Refit()
+{
+    AudioClockFit fit;
+    fit.samples = (uint32_t)m_count;
+    fit.frameBase = m_frames[(m_next + WINDOW - m_count) % WINDOW]; // Oldest pair
+    fit.hostBase = m_hosts[(m_next + WINDOW - m_count) % WINDOW];
+
+    // Two passes: centroid, then centered sums (no cancellation on long streams)
+    double sumX = 0.0, sumY = 0.0;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        sumX += (double)(int64_t)(m_frames[i] - fit.frameBase);
+        sumY += (double)(m_hosts[i] - fit.hostBase);
+    }
+    fit.meanFrame = sumX / m_count;
+    fit.meanHostNs = sumY / m_count;
+
+    double sxx = 0.0, sxy = 0.0;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        double dx = (double)(int64_t)(m_frames[i] - fit.frameBase) - fit.meanFrame;
+        double dy = (double)(m_hosts[i] - fit.hostBase) - fit.meanHostNs;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+    fit.sumSquares = sxx;
+    fit.nsPerFrame = sxx > 0.0 ? sxy / sxx : 0.0;
+
+    if (m_count > 2)
+    {
+        double sse = 0.0;
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            double dx = (double)(int64_t)(m_frames[i] - fit.frameBase) - fit.meanFrame;
+            double dy = (double)(m_hosts[i] - fit.hostBase) - fit.meanHostNs;
+            double r = dy - fit.nsPerFrame * dx;
+            sse += r * r;
+        }
+        fit.residualNs = std::sqrt(sse / (double)(m_count - 2));
+    }
+    m_fit = fit;
+}
@@ -0,0 +1,65 @@
+// Audio output clock correlation
+// The device reports its sample position together with the host time it was taken
+// (IAudioClock::GetPosition and its QPC value). A least-squares line through the most
+// recent pairs maps any stream frame to the host time it reaches the DAC: its slope
+// absorbs the drift between the audio crystal and the host timebase, and the scatter of
+// the pairs around it gives the error of each estimate. A pair far off the line (a
+// delayed read, a position glitch) is rejected; a run of rejections means the stream
+// jumped (underrun, device restart), so the fit starts over.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "timing.h"
+
+struct AudioClockFit
+{
+    uint32_t samples = 0;    // Pairs in the fit; no estimate below AudioClockCorrelator::MIN_SAMPLES
+    uint64_t frameBase = 0;  // Offsets below are relative to one pair of the window
+    int64_t hostBase = 0;    // ns
+    double meanFrame = 0.0;  // Centroid of the window (the line passes through it)
+    double meanHostNs = 0.0;
+    double nsPerFrame = 0.0; // Slope: 1e9 / the device's true sample rate
+    double sumSquares = 0.0; // Sum of squared frame deviations from meanFrame
+    double residualNs = 0.0; // RMS distance of the pairs from the line
+
+    bool Valid() const;
+
+    // Host time `frame` reaches the DAC, and one standard error of that estimate (grows
+    // with the distance from the window, so extrapolating far ahead is reported as such)
+    bool FrameTime(uint64_t frame, TimePoint &at, double &errorNs) const;
+
+    // Device rate against the host timebase, relative to the nominal rate
+    double DriftPpm(uint32_t nominalRate) const;
+};
+
+class AudioClockCorrelator
+{
+public:
+    static constexpr size_t WINDOW = 256;
+    static constexpr uint32_t MIN_SAMPLES = 8;
+    static constexpr uint32_t MAX_REJECTS = 8;         // In a row; then the fit restarts
+    static constexpr double OUTLIER_FLOOR_NS = 200e3;  // Never reject closer than this
+    static constexpr double OUTLIER_RESIDUALS = 8.0;   // Or than this many RMS residuals
+
+    // A pair with the same frame as the previous one (stalled position) is ignored.
+    // Returns false if the pair was rejected or ignored.
+    bool Add(uint64_t frame, TimePoint at);
+    void Reset();
+
+    const AudioClockFit &Fit() const { return m_fit; }
+    uint64_t Rejected() const { return m_rejected; }
+    uint64_t Restarts() const { return m_restarts; } // Reset() calls included
+
+private:
+    void Refit();
+
+    uint64_t m_frames[WINDOW];
+    int64_t m_hosts[WINDOW];
+    size_t m_count = 0;
+    size_t m_next = 0;
+    uint32_t m_rejectRun = 0;
+    uint64_t m_rejected = 0;
+    uint64_t m_restarts = 0;
+    AudioClockFit m_fit;
+};
@@ -0,0 +1,81 @@
+#include "audio_scheduler.h"
+#include <cstring>
+
+void AudioScheduler::Configure(const StimulusBuffer *stimulus)
+{
+    m_stimulus = stimulus;
+    m_frameBytes = stimulus ? stimulus->Format().FrameBytes() : 0;
+    m_pending = false;
+    m_playing = false;
+}
+
+uint32_t AudioScheduler::Arm(uint64_t frame, uint32_t sequence)
+{
+    m_pending = true;
+    m_requestedFrame = frame;
+    m_sequence = sequence != 0 ? sequence : m_sequence + 1;
+    return m_sequence;
+}
+
+void AudioScheduler::Cancel()
+{
+    m_pending = false;
+    m_playing = false;
+}
+
+void AudioScheduler::Render(void *dst, size_t frames)
+{
+    uint8_t *out = (uint8_t *)dst;
+    const uint64_t blockStart = m_writeFrame;
+    m_writeFrame += frames;
+
+    size_t done = 0;
+    while (done < frames && m_frameBytes != 0)
+    {
+        uint64_t cursor = blockStart + done;
+        size_t count = frames - done;
+        if (m_pending)
+        {
+            uint64_t at = m_requestedFrame == NEXT_BLOCK ? blockStart : m_requestedFrame;
+            if (at <= cursor)
+            {
+                m_lastStart.sequence = m_sequence;
+                m_lastStart.requestedFrame = m_requestedFrame;
+                m_lastStart.startFrame = cursor;
+                m_starts++;
+                if (at < cursor)
+                    m_late++;
+                m_pending = false;
+                m_playing = true;
+                m_playOffset = 0;
+            }
+            else if (at < blockStart + frames)
+            {
+                count = (size_t)(at - cursor); // Up to the onset
+            }
+        }
+
+        uint8_t *p = out + done * m_frameBytes;
+        if (m_playing)
+        {
+            size_t remaining = m_stimulus->Frames() - m_playOffset;
+            count = count < remaining ? count : remaining;
+            memcpy(p, m_stimulus->Data() + m_playOffset * m_frameBytes, count * m_frameBytes);
+            m_playOffset += count;
+            m_playing = m_playOffset < m_stimulus->Frames();
+        }
+        else
+        {
+            memset(p, 0, count * m_frameBytes);
+        }
+        done += count;
+    }
+}
+
+bool AudioScheduler::LastStart(AudioStimulusStart &start) const
+{
+    if (m_starts == 0)
+        return false;
+    start = m_lastStart;
+    return true;
+}
@@ -0,0 +1,65 @@
+// Continuous audio stream with sample-accurate stimulus injection
+// The endpoint runs for the whole session; whoever services the device buffer calls
+// Render() for every block it hands to the device, and the scheduler fills it with
+// silence or with the armed stimulus. Arming never touches the device: the stimulus
+// starts at the requested stream frame (or the first frame of the next block), and the
+// frame it actually started on is recorded so the onset can be timed from the device clock.
+//
+// Stream frames count every frame handed to the device since the stream started, so they
+// line up with the device's own sample position (IAudioClock).
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "audio_stimulus.h"
+
+struct AudioStimulusStart
+{
+    uint32_t sequence = 0;       // Arm() that produced this onset
+    uint64_t requestedFrame = 0; // AudioScheduler::NEXT_BLOCK if unspecified
+    uint64_t startFrame = 0;     // Stream frame of the stimulus' first sample
+};
+
+class AudioScheduler
+{
+public:
+    static constexpr uint64_t NEXT_BLOCK = ~0ull;
+
+    // The stimulus buffer must outlive the scheduler (or the next Configure)
+    void Configure(const StimulusBuffer *stimulus);
+
+    // Starts the stimulus at stream frame `frame`, or at the start of the next rendered block.
+    // A frame that is already rendered starts at once (counted as late). Re-arming replaces
+    // a pending or playing stimulus. Returns the arm sequence number (`sequence` if nonzero,
+    // for callers that number arms themselves).
+    uint32_t Arm(uint64_t frame = NEXT_BLOCK, uint32_t sequence = 0);
+    void Cancel(); // Drops a pending stimulus and silences a playing one
+
+    // Fills `frames` device frames at the write cursor and advances it
+    void Render(void *dst, size_t frames);
+
+    uint64_t WriteFrame() const { return m_writeFrame; } // Stream frame of the next Render
+    bool Pending() const { return m_pending; }
+    bool Playing() const { return m_playing; }
+
+    // Most recent onset placed by Render (false before the first)
+    bool LastStart(AudioStimulusStart &start) const;
+    uint64_t Starts() const { return m_starts; }
+    uint64_t LateStarts() const { return m_late; }
+
+private:
+    const StimulusBuffer *m_stimulus = nullptr;
+    size_t m_frameBytes = 0;
+    uint64_t m_writeFrame = 0;
+
+    bool m_pending = false;
+    uint32_t m_sequence = 0;
+    uint64_t m_requestedFrame = 0;
+
+    bool m_playing = false;
+    size_t m_playOffset = 0; // Stimulus frames already rendered
+
+    AudioStimulusStart m_lastStart;
+    uint64_t m_starts = 0;
+    uint64_t m_late = 0;
+};
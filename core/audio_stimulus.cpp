@@ -0,0 +1,352 @@
+#include "audio_stimulus.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STIMULUS_HAS_SSE2 1
+#endif
+
+bool ParseStimulusSpec(const char *text, StimulusSpec &spec)
+{
+    StimulusSpec parsed;
+    bool haveDuration = false;
+    const char *p = text;
+    while (*p)
+    {
+        while (*p == ',' || *p == ' ')
+            ++p;
+        if (!*p)
+            break;
+
+        char *end = nullptr;
+        if (strncmp(p, "tone", 4) == 0 || strncmp(p, "click", 5) == 0 || strncmp(p, "noise", 5) == 0)
+        {
+            parsed.shape = *p == 't' ? StimulusShape::Tone : (*p == 'c' ? StimulusShape::Click : StimulusShape::Noise);
+            end = (char *)p + (*p == 't' ? 4 : 5);
+        }
+        else if (strncmp(p, "linear", 6) == 0)
+        {
+            parsed.envelope = EnvelopeShape::Linear;
+            end = (char *)p + 6;
+        }
+        else if (strncmp(p, "attack", 6) == 0 || strncmp(p, "release", 7) == 0)
+        {
+            bool attack = *p == 'a';
+            const char *value = p + (attack ? 6 : 7);
+            float ms = strtof(value, &end);
+            if (end == value || ms < 0.0f)
+                return false;
+            (attack ? parsed.attackMs : parsed.releaseMs) = ms;
+        }
+        else if (*p == '@')
+        {
+            parsed.amplitude = strtof(p + 1, &end);
+            if (end == p + 1 || parsed.amplitude < 0.0f || parsed.amplitude > 1.0f)
+                return false;
+        }
+        else
+        {
+            float value = strtof(p, &end);
+            if (end == p || value <= 0.0f)
+                return false;
+            if (strncmp(end, "hz", 2) == 0)
+            {
+                parsed.frequencyHz = value;
+            }
+            else if (strncmp(end, "ms", 2) == 0)
+            {
+                parsed.durationMs = value;
+                haveDuration = true;
+            }
+            else
+            {
+                return false;
+            }
+            end += 2;
+        }
+        if (*end != '\0' && *end != ',' && *end != ' ')
+            return false;
+        p = end;
+    }
+
+    if (parsed.shape == StimulusShape::Click && !haveDuration)
+        parsed.durationMs = 1.0f;
+    spec = parsed;
+    return true;
+}
+
+// Four float lanes: SSE2 registers, or the same operations lane by lane
+namespace
+{
+#ifdef STIMULUS_HAS_SSE2
+struct F4
+{
+    __m128 v;
+};
+
+inline F4 Splat(float a) { return {_mm_set1_ps(a)}; }
+inline F4 Ramp(float base, float step) // base + {0, 1, 2, 3} * step
+{
+    return {_mm_add_ps(_mm_set1_ps(base), _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(step)))};
+}
+inline F4 Load(const float *p) { return {_mm_loadu_ps(p)}; }
+inline void Store(float *p, F4 a) { _mm_storeu_ps(p, a.v); }
+inline F4 operator+(F4 a, F4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline F4 operator-(F4 a, F4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline F4 operator*(F4 a, F4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline F4 Min(F4 a, F4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline F4 Max(F4 a, F4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline F4 Abs(F4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline F4 CopySign(F4 magnitude, F4 sign) // magnitude >= 0
+{
+    return {_mm_or_ps(magnitude.v, _mm_and_ps(_mm_set1_ps(-0.0f), sign.v))};
+}
+inline F4 Round(F4 a) { return {_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v))}; } // Nearest, |a| < 2^31
+#else
+struct F4
+{
+    float v[4];
+};
+
+inline F4 Splat(float a) { return {{a, a, a, a}}; }
+inline F4 Ramp(float base, float step)
+{
+    return {{base, base + step, base + 2.0f * step, base + 3.0f * step}};
+}
+inline F4 Load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void Store(float *p, F4 a) { memcpy(p, a.v, sizeof(a.v)); }
+template <typename Op>
+inline F4 Map(F4 a, F4 b, Op op)
+{
+    return {{op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3])}};
+}
+inline F4 operator+(F4 a, F4 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+inline F4 operator-(F4 a, F4 b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+inline F4 operator*(F4 a, F4 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+inline F4 Min(F4 a, F4 b) { return Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+inline F4 Max(F4 a, F4 b) { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+inline F4 Abs(F4 a) { return Map(a, a, [](float x, float) { return std::fabs(x); }); }
+inline F4 CopySign(F4 magnitude, F4 sign)
+{
+    return Map(magnitude, sign, [](float m, float s) { return std::copysign(m, s); });
+}
+inline F4 Round(F4 a) { return Map(a, a, [](float x, float) { return std::nearbyint(x); }); }
+#endif
+
+// sin(2 pi c): reduce to a quarter cycle, then an odd Taylor polynomial (|error| < 1e-6)
+inline F4 SinCycles(F4 c)
+{
+    F4 y = c - Round(c);                       // [-0.5, 0.5]
+    F4 a = Abs(y);
+    a = Min(a, Splat(0.5f) - a);               // sin(2 pi a) = sin(2 pi (0.5 - a)), a in [0, 0.25]
+    F4 x = a * Splat(6.28318530718f);
+    F4 x2 = x * x;
+    F4 p = Splat(-2.50521084e-8f);             // -1/11!
+    p = p * x2 + Splat(2.75573192e-6f);        // 1/9!
+    p = p * x2 + Splat(-1.98412698e-4f);       // -1/7!
+    p = p * x2 + Splat(8.33333333e-3f);        // 1/5!
+    p = p * x2 + Splat(-1.66666667e-1f);       // -1/3!
+    p = p * x2 + Splat(1.0f);
+    return CopySign(p * x, y);
+}
+
+// Ramp gain at positions t in [0, 1): linear t, or raised-cosine sin^2(pi t / 2)
+inline F4 RampGain(F4 t, EnvelopeShape shape)
+{
+    if (shape == EnvelopeShape::Linear)
+        return t;
+    F4 s = SinCycles(t * Splat(0.25f));
+    return s * s;
+}
+} // namespace
+
+void SynthesizeTone(float *out, size_t count, double frequencyHz, double sampleRate, float amplitude)
+{
+    // Phase in cycles, carried in double between blocks so long buffers do not drift
+    const double step = frequencyHz / sampleRate;
+    const F4 gain = Splat(amplitude);
+    double base = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        Store(out + i, SinCycles(Ramp((float)base, (float)step)) * gain);
+        base += 4.0 * step;
+        base -= (double)(int64_t)base; // base >= 0
+    }
+    if (i < count)
+    {
+        float tail[4];
+        Store(tail, SinCycles(Ramp((float)base, (float)step)) * gain);
+        memcpy(out + i, tail, (count - i) * sizeof(float));
+    }
+}
+
+void SynthesizeNoise(float *out, size_t count, uint32_t seed, float amplitude)
+{
+    // One xorshift32 generator per lane
+    uint32_t state[4];
+    for (uint32_t lane = 0; lane < 4; ++lane)
+        state[lane] = (seed + lane) * 2654435761u | 1u;
+    const float scale = amplitude / 2147483648.0f;
+
+    size_t i = 0;
+#ifdef STIMULUS_HAS_SSE2
+    __m128i x = _mm_loadu_si128((const __m128i *)state);
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 4 <= count; i += 4)
+    {
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(x), vscale));
+    }
+    _mm_storeu_si128((__m128i *)state, x);
+#endif
+    for (; i < count; i += 4)
+    {
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            uint32_t s = state[lane];
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            state[lane] = s;
+            if (i + lane < count)
+                out[i + lane] = (float)(int32_t)s * scale;
+        }
+    }
+}
+
+void ApplyEnvelope(float *samples, size_t count, size_t attack, size_t release, EnvelopeShape shape)
+{
+    attack = std::min(attack, count);
+    release = std::min(release, count - attack);
+
+    // Attack: gain t = i / attack rising from 0; release mirrors it onto the last samples
+    auto ramp = [&](size_t first, size_t length, bool rising) {
+        const float inverse = 1.0f / (float)length;
+        for (size_t k = 0; k < length; k += 4)
+        {
+            float position = rising ? (float)k : (float)(length - 1 - k);
+            F4 gain = RampGain(Ramp(position * inverse, (rising ? 1.0f : -1.0f) * inverse), shape);
+            float *p = samples + first + k;
+            if (k + 4 <= length)
+            {
+                Store(p, Load(p) * gain);
+            }
+            else
+            {
+                float g[4];
+                Store(g, gain);
+                for (size_t j = 0; k + j < length; ++j)
+                    p[j] *= g[j];
+            }
+        }
+    };
+    if (attack > 0)
+        ramp(0, attack, true);
+    if (release > 0)
+        ramp(count - release, release, false);
+}
+
+void InterleaveSamples(const float *in, size_t count, const AudioFormat &format, void *out)
+{
+    const size_t channels = format.channels;
+    size_t i = 0;
+    if (format.sample == SampleFormat::Float32)
+    {
+        float *dst = (float *)out;
+#ifdef STIMULUS_HAS_SSE2
+        if (channels == 2)
+        {
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 v = _mm_loadu_ps(in + i);
+                _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(v, v));
+                _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(v, v));
+            }
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            for (size_t ch = 0; ch < channels; ++ch)
+                dst[i * channels + ch] = in[i];
+        }
+        return;
+    }
+
+    int16_t *dst = (int16_t *)out;
+#ifdef STIMULUS_HAS_SSE2
+    if (channels == 1 || channels == 2)
+    {
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        const __m128 low = _mm_set1_ps(-1.0f);
+        const __m128 high = _mm_set1_ps(1.0f);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high);
+            __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), low), high);
+            __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(a, scale)),
+                                             _mm_cvtps_epi32(_mm_mul_ps(b, scale)));
+            if (channels == 1)
+            {
+                _mm_storeu_si128((__m128i *)(dst + i), packed);
+            }
+            else
+            {
+                _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi16(packed, packed));
+                _mm_storeu_si128((__m128i *)(dst + 2 * i + 8), _mm_unpackhi_epi16(packed, packed));
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        float clamped = in[i] < -1.0f ? -1.0f : (in[i] > 1.0f ? 1.0f : in[i]);
+        int16_t sample = (int16_t)std::lrint(clamped * 32767.0f);
+        for (size_t ch = 0; ch < channels; ++ch)
+            dst[i * channels + ch] = sample;
+    }
+}
+
+bool StimulusBuffer::Prepare(const StimulusSpec &spec, const AudioFormat &format)
+{
+    if (format.sampleRate == 0 || format.channels == 0 || spec.durationMs <= 0.0f)
+        return false;
+    if (spec.shape == StimulusShape::Tone && (spec.frequencyHz <= 0.0f || spec.frequencyHz * 2.0f > format.sampleRate))
+        return false;
+
+    auto toFrames = [&](float ms) { return (size_t)std::lround((double)ms * format.sampleRate / 1000.0); };
+    size_t frames = std::max<size_t>(toFrames(spec.durationMs), 1);
+
+    std::vector<float> mono(frames);
+    switch (spec.shape)
+    {
+    case StimulusShape::Tone:
+        SynthesizeTone(mono.data(), frames, spec.frequencyHz, format.sampleRate, spec.amplitude);
+        break;
+    case StimulusShape::Click:
+        std::fill(mono.begin(), mono.end(), spec.amplitude);
+        break;
+    case StimulusShape::Noise:
+        SynthesizeNoise(mono.data(), frames, spec.seed, spec.amplitude);
+        break;
+    }
+    ApplyEnvelope(mono.data(), frames, toFrames(spec.attackMs), toFrames(spec.releaseMs), spec.envelope);
+
+    m_format = format;
+    m_frames = frames;
+    m_data.resize(frames * format.FrameBytes());
+    InterleaveSamples(mono.data(), frames, format, m_data.data());
+    return true;
+}
+
+size_t StimulusBuffer::CopyFrames(void *dst, size_t maxFrames) const
+{
+    size_t frames = std::min(m_frames, maxFrames);
+    memcpy(dst, m_data.data(), frames * m_format.FrameBytes());
+    return frames;
+}
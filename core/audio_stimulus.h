@@ -0,0 +1,89 @@
+// Audio stimulus waveforms, synthesized once for the negotiated device format
+// A stimulus (tone, click or noise burst with an attack/release envelope) is rendered at
+// init into a buffer laid out exactly like the device's frames, so arming it at stimulus
+// onset is a plain copy. The synthesis kernels work four samples at a time (SSE2 where
+// available, the same arithmetic in scalar code otherwise).
+//
+// Text form (-stimulus=...): comma separated elements, shape first
+//   tone | click | noise      waveform (default tone)
+//   <n>hz                     tone frequency (default 800)
+//   <n>ms                     duration (default 80; click default 1)
+//   @<level>                  peak amplitude 0-1 (default 0.5)
+//   attack<n> | release<n>    envelope ramps in ms (default 0)
+//   linear                    linear ramps instead of raised-cosine
+// e.g. "tone,1000hz,50ms,release5" or "noise,30ms,@0.3,attack1"
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class SampleFormat : uint8_t
+{
+    Float32,
+    Int16
+};
+
+struct AudioFormat
+{
+    uint32_t sampleRate = 48000;
+    uint16_t channels = 2;
+    SampleFormat sample = SampleFormat::Float32;
+
+    size_t FrameBytes() const { return channels * (sample == SampleFormat::Float32 ? 4 : 2); }
+};
+
+enum class StimulusShape : uint8_t
+{
+    Tone,
+    Click, // Rectangular pulse
+    Noise  // White noise burst
+};
+
+enum class EnvelopeShape : uint8_t
+{
+    Cosine, // Raised-cosine ramps
+    Linear
+};
+
+struct StimulusSpec
+{
+    StimulusShape shape = StimulusShape::Tone;
+    float frequencyHz = 800.0f;
+    float durationMs = 80.0f;
+    float amplitude = 0.5f;
+    float attackMs = 0.0f;
+    float releaseMs = 0.0f;
+    EnvelopeShape envelope = EnvelopeShape::Cosine;
+    uint32_t seed = 1; // Noise
+};
+
+// Parses the text form; returns false (and leaves spec untouched) on a syntax error
+bool ParseStimulusSpec(const char *text, StimulusSpec &spec);
+
+// Kernels, mono float samples
+void SynthesizeTone(float *out, size_t count, double frequencyHz, double sampleRate, float amplitude);
+void SynthesizeNoise(float *out, size_t count, uint32_t seed, float amplitude);
+void ApplyEnvelope(float *samples, size_t count, size_t attack, size_t release, EnvelopeShape shape);
+// Duplicates mono samples into every channel, converting to the sample format (saturating)
+void InterleaveSamples(const float *in, size_t count, const AudioFormat &format, void *out);
+
+class StimulusBuffer
+{
+public:
+    // Renders the stimulus for the format; false if the format or spec is unusable
+    bool Prepare(const StimulusSpec &spec, const AudioFormat &format);
+
+    const AudioFormat &Format() const { return m_format; }
+    size_t Frames() const { return m_frames; }
+    size_t Bytes() const { return m_data.size(); }
+    const uint8_t *Data() const { return m_data.data(); }
+
+    // Copies up to maxFrames frames into a device buffer; returns the frames copied
+    size_t CopyFrames(void *dst, size_t maxFrames) const;
+
+private:
+    AudioFormat m_format;
+    size_t m_frames = 0;
+    std::vector<uint8_t> m_data;
+};
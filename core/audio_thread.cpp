@@ -0,0 +1,207 @@
+#include "audio_thread.h"
+#include <algorithm>
+#include <chrono>
+
+static int64_t NowNs()
+{
+    return Clock::now().time_since_epoch().count();
+}
+
+bool AudioRenderThread::Start(AudioEndpoint &endpoint, const StimulusBuffer &stimulus, Clock::duration period,
+                              const ThreadPolicy &policy)
+{
+    Stop();
+    m_endpoint = &endpoint;
+    m_scheduler = AudioScheduler();
+    m_scheduler.Configure(&stimulus);
+    m_clock = AudioClockCorrelator();
+    m_sampleRate = stimulus.Format().sampleRate;
+    m_period = period;
+    m_policy = policy;
+    m_counters = AudioThreadStats();
+    m_fill.Reset();
+    m_command.Reset();
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_snapshot = AudioThreadStats();
+    }
+    // Leftovers of a previous run (its thread has been joined)
+    AudioCommand staleCommands[COMMAND_CAPACITY];
+    m_commands.PopBatch(staleCommands, COMMAND_CAPACITY);
+    AudioOnset staleOnsets[ONSET_CAPACITY];
+    m_onsets.PopBatch(staleOnsets, ONSET_CAPACITY);
+    m_stop.store(false, std::memory_order_release);
+    m_state.store(0, std::memory_order_release);
+
+    m_thread = std::thread([this] { Run(); });
+
+    // Start-up only: device start on the audio thread
+    while (m_state.load(std::memory_order_acquire) == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    if (m_state.load(std::memory_order_acquire) < 0)
+    {
+        m_thread.join();
+        return false;
+    }
+    return true;
+}
+
+void AudioRenderThread::Stop()
+{
+    if (!m_thread.joinable())
+        return;
+    m_stop.store(true, std::memory_order_release);
+    m_endpoint->Wake();
+    m_thread.join();
+}
+
+uint32_t AudioRenderThread::Arm(uint64_t frame)
+{
+    AudioCommand command;
+    command.type = AudioCommandType::Arm;
+    command.sequence = m_nextSequence + 1;
+    command.frame = frame;
+    command.postedNs = NowNs();
+    if (!m_commands.TryPush(command))
+        return 0;
+    return ++m_nextSequence;
+}
+
+bool AudioRenderThread::Cancel()
+{
+    AudioCommand command;
+    command.type = AudioCommandType::Cancel;
+    command.postedNs = NowNs();
+    return m_commands.TryPush(command);
+}
+
+AudioThreadStats AudioRenderThread::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    AudioThreadStats stats = m_snapshot;
+    stats.droppedCommands = m_commands.Dropped();
+    return stats;
+}
+
+void AudioRenderThread::Publish()
+{
+    std::unique_lock<std::mutex> lock(m_snapshotMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return; // A reader holds it; the next period publishes
+    m_snapshot = m_counters;
+    m_snapshot.fillP50Us = m_fill.Percentile(50.0) / 1000.0;
+    m_snapshot.fillP99Us = m_fill.Percentile(99.0) / 1000.0;
+    m_snapshot.fillMaxUs = m_fill.Max() / 1000.0;
+    m_snapshot.commandP99Us = m_command.Percentile(99.0) / 1000.0;
+    m_snapshot.clockDriftPpm = m_clock.Fit().DriftPpm(m_sampleRate);
+    m_snapshot.clockResidualUs = m_clock.Fit().residualNs / 1000.0;
+    m_snapshot.clockRestarts = m_clock.Restarts();
+}
+
+void AudioRenderThread::Run()
+{
+    m_applied = ApplyThreadPolicy(ThreadRole::Audio, m_policy);
+
+    AudioEndpoint &endpoint = *m_endpoint;
+    if (!endpoint.Enter())
+    {
+        m_state.store(-1, std::memory_order_release);
+        return;
+    }
+
+    // The first buffer is silence, written before the stream starts
+    size_t frames = endpoint.Writable();
+    void *buffer = frames > 0 ? endpoint.Acquire(frames) : nullptr;
+    if (buffer)
+    {
+        m_scheduler.Render(buffer, frames);
+        endpoint.Release(frames);
+    }
+    if (!buffer || !endpoint.Start())
+    {
+        endpoint.Exit();
+        m_state.store(-1, std::memory_order_release);
+        return;
+    }
+    m_state.store(1, std::memory_order_release);
+
+    // Four periods without an event means the device stopped (or was removed)
+    const uint32_t timeoutMs =
+        (uint32_t)std::max<int64_t>(10, std::chrono::duration_cast<std::chrono::milliseconds>(m_period * 4).count());
+    const Clock::duration lateAfter = m_period + m_period / 2;
+    TimePoint lastWake = Clock::now();
+    uint64_t publishedStarts = 0;
+    AudioCommand commands[COMMAND_CAPACITY];
+
+    while (!m_stop.load(std::memory_order_acquire))
+    {
+        if (!endpoint.WaitPeriod(timeoutMs))
+        {
+            if (!m_stop.load(std::memory_order_acquire))
+                m_counters.timeouts++;
+            lastWake = Clock::now(); // A silent device is not a late fill
+            continue;
+        }
+        TimePoint wake = Clock::now();
+
+        // Commands posted before this period are rendered in it
+        size_t count = m_commands.PopBatch(commands, COMMAND_CAPACITY);
+        int64_t wakeNs = wake.time_since_epoch().count();
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (commands[i].type == AudioCommandType::Arm)
+                m_scheduler.Arm(commands[i].frame, commands[i].sequence);
+            else
+                m_scheduler.Cancel();
+            m_command.Record(std::max<int64_t>(0, wakeNs - commands[i].postedNs));
+        }
+        m_counters.commands += count;
+
+        if (wake - lastWake > lateAfter)
+            m_counters.lateFills++;
+        lastWake = wake;
+
+        frames = endpoint.Writable();
+        buffer = frames > 0 ? endpoint.Acquire(frames) : nullptr;
+        if (buffer)
+        {
+            // The device ran dry if it played everything queued before this block arrived
+            uint64_t queuedEnd = m_scheduler.WriteFrame();
+            m_scheduler.Render(buffer, frames);
+            uint64_t played = 0;
+            TimePoint playedAt;
+            if (endpoint.PlayedFrames(played, playedAt))
+            {
+                if (played >= queuedEnd)
+                {
+                    m_counters.underruns++;
+                    m_clock.Reset(); // Stream frames and device position may have slipped apart
+                }
+                else
+                {
+                    m_clock.Add(played, playedAt);
+                }
+            }
+            endpoint.Release(frames);
+            m_counters.periods++;
+            m_fill.Record((Clock::now() - wake).count());
+        }
+
+        if (m_scheduler.Starts() != publishedStarts)
+        {
+            AudioOnset onset;
+            m_scheduler.LastStart(onset.start);
+            double errorNs = 0.0;
+            onset.timed = m_clock.Fit().FrameTime(onset.start.startFrame, onset.dacTime, errorNs);
+            onset.errorUs = errorNs / 1000.0;
+            m_onsets.TryPush(onset);
+            publishedStarts = m_scheduler.Starts();
+        }
+        if (m_counters.periods % PUBLISH_PERIODS == 0)
+            Publish();
+    }
+
+    Publish();
+    endpoint.Exit();
+}
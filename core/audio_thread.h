@@ -0,0 +1,144 @@
+// Event-driven audio render thread
+// A dedicated, priority-boosted thread sleeps on the device's period event and fills each
+// period through an AudioScheduler, so the stream is serviced on the device's schedule
+// rather than whenever the render loop comes around. The reaction logic never touches the
+// device: it posts Arm/Cancel commands into a lock-free ring that the audio thread drains
+// at the start of every period, and it reads back the frame each onset landed on and when
+// that frame reaches the DAC (the device position is correlated with the host clock every
+// period, see audio_clock.h).
+// The backend supplies the device (AudioEndpoint); anything that signals periods and
+// accepts frames works, which is how the loop is tested without audio hardware.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "audio_clock.h"
+#include "audio_scheduler.h"
+#include "histogram.h"
+#include "spsc_ring.h"
+#include "thread_policy.h"
+#include "timing.h"
+
+// Backend device; every method except Wake() runs on the audio thread
+class AudioEndpoint
+{
+public:
+    virtual ~AudioEndpoint() = default;
+
+    virtual bool Enter() = 0;   // Thread start-up (COM, registration), before the first fill
+    virtual bool Start() = 0;   // Starts the stream once the first buffer is filled
+    virtual void Exit() = 0;    // Stops the stream; last call on the audio thread
+    virtual void Wake() = 0;    // Any thread: makes WaitPeriod() return (stop request)
+
+    // Blocks until the device asks for a period or timeoutMs passes; false on timeout/wake
+    virtual bool WaitPeriod(uint32_t timeoutMs) = 0;
+    // Frames that can be written now
+    virtual size_t Writable() = 0;
+    virtual void *Acquire(size_t frames) = 0;
+    virtual void Release(size_t frames) = 0;
+    // Frames the device has played since Start and the host time that position was taken
+    // (false if the device cannot tell)
+    virtual bool PlayedFrames(uint64_t &frames, TimePoint &at) = 0;
+};
+
+enum class AudioCommandType : uint8_t
+{
+    Arm,
+    Cancel
+};
+
+struct AudioCommand
+{
+    AudioCommandType type = AudioCommandType::Arm;
+    uint32_t sequence = 0;
+    uint64_t frame = AudioScheduler::NEXT_BLOCK;
+    int64_t postedNs = 0; // For the command latency statistic
+};
+
+// An onset placed by the audio thread, with its DAC time from the device clock
+struct AudioOnset
+{
+    AudioStimulusStart start;
+    bool timed = false;     // The clock fit had enough pairs
+    TimePoint dacTime;      // Estimated time the first sample reaches the DAC
+    double errorUs = 0.0;   // One standard error of dacTime
+};
+
+struct AudioThreadStats
+{
+    uint64_t periods = 0;         // Periods filled
+    uint64_t underruns = 0;       // The device had played everything queued when a block was released
+    uint64_t lateFills = 0;       // Woke more than half a period after the expected event
+    uint64_t timeouts = 0;        // No period event within the timeout
+    uint64_t commands = 0;
+    uint64_t droppedCommands = 0; // Command ring full
+    double fillP50Us = 0.0;       // Period event -> buffer released
+    double fillP99Us = 0.0;
+    double fillMaxUs = 0.0;
+    double commandP99Us = 0.0;    // Posted -> applied on the audio thread
+    double clockDriftPpm = 0.0;   // Device sample clock against the host timebase
+    double clockResidualUs = 0.0; // Scatter of the position/host pairs around the fit
+    uint64_t clockRestarts = 0;   // Fit restarted (underrun, stream jump)
+};
+
+class AudioRenderThread
+{
+public:
+    static constexpr size_t COMMAND_CAPACITY = 64;
+    static constexpr size_t ONSET_CAPACITY = 64;
+    static constexpr uint64_t PUBLISH_PERIODS = 16; // Stats snapshot interval
+
+    AudioRenderThread() = default;
+    ~AudioRenderThread() { Stop(); }
+    AudioRenderThread(const AudioRenderThread &) = delete;
+    AudioRenderThread &operator=(const AudioRenderThread &) = delete;
+
+    // Starts the thread and waits until the stream runs; the endpoint and the stimulus
+    // must outlive the thread. period: device period, for the late-fill statistic.
+    bool Start(AudioEndpoint &endpoint, const StimulusBuffer &stimulus, Clock::duration period,
+               const ThreadPolicy &policy);
+    void Stop();
+    bool Running() const { return m_thread.joinable(); }
+    const ThreadPolicyResult &Applied() const { return m_applied; } // Valid once Start() returned
+
+    // Reaction logic (one producer thread). Arm returns the onset's sequence, 0 if dropped.
+    uint32_t Arm(uint64_t frame = AudioScheduler::NEXT_BLOCK);
+    bool Cancel();
+
+    // Onsets placed by the audio thread since the last call, oldest first
+    size_t PollOnsets(AudioOnset *out, size_t maxOnsets) { return m_onsets.PopBatch(out, maxOnsets); }
+
+    AudioThreadStats Stats() const;
+
+private:
+    void Run();
+    void Publish(); // Audio thread: refreshes the stats snapshot
+
+    AudioEndpoint *m_endpoint = nullptr;
+    AudioScheduler m_scheduler;
+    AudioClockCorrelator m_clock; // Audio thread only
+    uint32_t m_sampleRate = 0;
+    Clock::duration m_period{0};
+    ThreadPolicy m_policy;
+    ThreadPolicyResult m_applied;
+
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::atomic<int> m_state{0}; // 0 starting, 1 running, -1 failed
+
+    SpscRing<AudioCommand, COMMAND_CAPACITY> m_commands;
+    SpscRing<AudioOnset, ONSET_CAPACITY> m_onsets;
+    uint32_t m_nextSequence = 0;
+
+    // Audio thread only
+    AudioThreadStats m_counters;
+    LogHistogram m_fill;    // ns
+    LogHistogram m_command; // ns
+
+    // Copy for other threads; the audio thread only try-locks it
+    mutable std::mutex m_snapshotMutex;
+    AudioThreadStats m_snapshot;
+};
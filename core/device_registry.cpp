@@ -0,0 +1,161 @@
+#include "device_registry.h"
+
+std::wstring ParseDeviceDisplayName(const std::wstring &path)
+{
+    size_t lastSlash = path.rfind(L'#');
+    if (lastSlash != std::wstring::npos && lastSlash > 0)
+    {
+        size_t prevSlash = path.rfind(L'#', lastSlash - 1);
+        if (prevSlash != std::wstring::npos)
+        {
+            return path.substr(prevSlash + 1, lastSlash - prevSlash - 1);
+        }
+    }
+
+    // Drop the terminator GetRawInputDeviceInfoW includes in its size
+    size_t end = path.find(L'\0');
+    return end == std::wstring::npos ? path : path.substr(0, end);
+}
+
+DeviceRegistry::DeviceRegistry(DeviceEnumerator &enumerator) : m_enumerator(enumerator)
+{
+    // Never reallocate so DeviceInfo pointers stay valid for readers
+    m_devices.reserve(MAX_DEVICES);
+}
+
+size_t DeviceRegistry::Hash(uint64_t handle)
+{
+    // Handles are pointer-like; mix the high bits down
+    return (size_t)((handle * 0x9E3779B97F4A7C15ull) >> 55) & (TABLE_SIZE - 1);
+}
+
+uint16_t DeviceRegistry::Find(uint64_t handle) const
+{
+    for (size_t i = Hash(handle);; i = (i + 1) & (TABLE_SIZE - 1))
+    {
+        if (m_table[i].id == 0)
+            return 0;
+        if (m_table[i].handle == handle)
+            return m_table[i].id;
+    }
+}
+
+uint16_t DeviceRegistry::LookupSlow(uint64_t handle)
+{
+    if (handle == 0)
+        return 0;
+
+    uint16_t id = Find(handle);
+    if (id == 0)
+        id = Insert(handle);
+
+    m_lastHandle = handle;
+    m_lastId = id;
+    return id;
+}
+
+uint16_t DeviceRegistry::Reconnect(uint64_t handle, const std::wstring &path)
+{
+    if (path.empty())
+        return 0;
+    for (size_t i = 0; i < m_devices.size(); ++i)
+    {
+        DeviceInfo &info = m_devices[i];
+        if (!info.connected && info.path == path)
+        {
+            info.handle = handle;
+            info.connected = true;
+            return (uint16_t)(i + 1);
+        }
+    }
+    return 0;
+}
+
+uint16_t DeviceRegistry::Insert(uint64_t handle)
+{
+    std::wstring path;
+    m_enumerator.GetDeviceName(handle, path);
+
+    // A device that comes back (wireless wake, hub reset) gets a new handle but keeps its
+    // path: it takes its old entry, so its id and per-device statistics carry on
+    uint16_t id = Reconnect(handle, path);
+    if (id == 0)
+    {
+        if (m_devices.size() >= MAX_DEVICES)
+            return 0;
+        DeviceInfo info;
+        info.handle = handle;
+        info.displayName = ParseDeviceDisplayName(path);
+        info.path = std::move(path);
+        m_devices.push_back(std::move(info));
+        id = (uint16_t)m_devices.size();
+        m_published.store(id, std::memory_order_release);
+    }
+
+    size_t i = Hash(handle);
+    while (m_table[i].id != 0)
+    {
+        i = (i + 1) & (TABLE_SIZE - 1);
+    }
+    m_table[i].handle = handle;
+    m_table[i].id = id;
+    return id;
+}
+
+void DeviceRegistry::Erase(uint64_t handle)
+{
+    size_t i = Hash(handle);
+    while (m_table[i].id != 0 && m_table[i].handle != handle)
+    {
+        i = (i + 1) & (TABLE_SIZE - 1);
+    }
+    if (m_table[i].id == 0)
+        return;
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    size_t hole = i;
+    for (size_t j = (hole + 1) & (TABLE_SIZE - 1); m_table[j].id != 0; j = (j + 1) & (TABLE_SIZE - 1))
+    {
+        size_t home = Hash(m_table[j].handle);
+        bool between = (hole <= j) ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!between)
+        {
+            m_table[hole] = m_table[j];
+            hole = j;
+        }
+    }
+    m_table[hole] = Slot{};
+}
+
+void DeviceRegistry::OnArrival(uint64_t handle)
+{
+    if (handle != 0 && Find(handle) == 0)
+        Insert(handle);
+}
+
+void DeviceRegistry::OnRemoval(uint64_t handle)
+{
+    uint16_t id = Find(handle);
+    if (id == 0)
+        return;
+
+    // The OS may hand the same handle to the next device; forget the mapping
+    m_devices[id - 1].connected = false;
+    Erase(handle);
+    if (m_lastHandle == handle)
+    {
+        m_lastHandle = 0;
+        m_lastId = 0;
+    }
+}
+
+const DeviceInfo *DeviceRegistry::Info(uint16_t id) const
+{
+    return (id > 0 && id <= m_published.load(std::memory_order_acquire)) ? &m_devices[id - 1] : nullptr;
+}
+
+const wchar_t *DeviceRegistry::DisplayName(uint16_t id) const
+{
+    const DeviceInfo *info = Info(id);
+    return info ? info->displayName.c_str() : L"";
+}
@@ -0,0 +1,77 @@
+// Interned input devices: native handle -> small id, names resolved and parsed once
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Resolves the device path of a native handle (GetRawInputDeviceInfoW on Windows)
+class DeviceEnumerator
+{
+public:
+    virtual ~DeviceEnumerator() = default;
+    virtual bool GetDeviceName(uint64_t handle, std::wstring &name) = 0;
+};
+
+// Extracts the part between the last two '#' of a device path for cleaner display
+// "\\?\HID#VID_046D&PID_C539&MI_01#7&2f3c&0&0000#{...}" -> "7&2f3c&0&0000"
+std::wstring ParseDeviceDisplayName(const std::wstring &path);
+
+struct DeviceInfo
+{
+    uint64_t handle = 0;
+    std::wstring path;
+    std::wstring displayName;
+    bool connected = true;
+};
+
+// Lookup and the change notifications belong to one thread (the one receiving input);
+// Info/DisplayName may be read from another thread for ids it received from that thread
+class DeviceRegistry
+{
+public:
+    static constexpr uint16_t MAX_DEVICES = 256;
+
+    explicit DeviceRegistry(DeviceEnumerator &enumerator);
+
+    // Returns the id of a handle, resolving it on first sight; 0 if unknown/full
+    uint16_t Lookup(uint64_t handle)
+    {
+        if (handle == m_lastHandle && handle != 0)
+            return m_lastId;
+        return LookupSlow(handle);
+    }
+
+    // Device change notifications (WM_INPUT_DEVICE_CHANGE)
+    void OnArrival(uint64_t handle);
+    void OnRemoval(uint64_t handle);
+
+    // Ids stay valid (and keep their name) after removal so old log rows still resolve; a
+    // device that arrives again under the same path gets its old id back
+    const DeviceInfo *Info(uint16_t id) const;
+    const wchar_t *DisplayName(uint16_t id) const;
+    size_t Count() const { return m_published.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t TABLE_SIZE = 512; // Power of two, at most half full
+    struct Slot
+    {
+        uint64_t handle;
+        uint16_t id;
+    };
+
+    static size_t Hash(uint64_t handle);
+    uint16_t LookupSlow(uint64_t handle);
+    uint16_t Find(uint64_t handle) const;
+    uint16_t Reconnect(uint64_t handle, const std::wstring &path);
+    uint16_t Insert(uint64_t handle);
+    void Erase(uint64_t handle);
+
+    DeviceEnumerator &m_enumerator;
+    Slot m_table[TABLE_SIZE] = {};
+    std::vector<DeviceInfo> m_devices; // Index id - 1, capacity reserved up front
+    std::atomic<uint16_t> m_published{0}; // Entries readers may see
+    uint64_t m_lastHandle = 0;
+    uint16_t m_lastId = 0;
+};
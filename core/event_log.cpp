@@ -0,0 +1,122 @@
+#include "event_log.h"
+#include <cwchar>
+
+size_t FormatLogEntry(double timeMs, double deltaMs, const wchar_t *inputInfo, const wchar_t *deviceInfo,
+                      wchar_t *out, size_t outSize)
+{
+    int written = swprintf(out, outSize, L"%.2fms %+.2f\u0394 | %ls | %ls", timeMs, deltaMs, inputInfo, deviceInfo);
+    if (written < 0)
+    {
+        if (outSize == 0)
+            return 0;
+        out[outSize - 1] = L'\0';
+        return wcslen(out);
+    }
+    return (size_t)written;
+}
+
+void EventLog::Reset(TimePoint appStartTime)
+{
+    Clear();
+    m_hasLast = false;
+    m_appStartTime = appStartTime;
+    m_rows.reset(); // Cached text is relative to the old start time
+}
+
+void EventLog::Clear()
+{
+    m_count = 0;
+    m_scroll = 0;
+}
+
+void EventLog::Add(const InputEvent &ev, InputAction action)
+{
+    if (m_capacity == 0)
+        return;
+    if (!m_records)
+        m_records.reset(new LogRecord[m_capacity]);
+
+    int64_t ticks = (int64_t)ev.time.time_since_epoch().count();
+    int64_t startTicks = (int64_t)m_appStartTime.time_since_epoch().count();
+
+    // Delta to the previous logged event (the first one counts from app start)
+    LogRecord &record = m_records[m_total % m_capacity];
+    record.ticks = ticks;
+    record.deltaMs = (float)ElapsedMs(TimePoint(Clock::duration(m_hasLast ? m_lastTicks : startTicks)), ev.time);
+    record.dx = ev.dx;
+    record.dy = ev.dy;
+    record.deviceId = ev.deviceId;
+    record.flags = ev.type == InputType::Keyboard ? ev.keyFlags : ev.buttonFlags;
+    record.buttonData = ev.buttonData;
+    record.vkey = ev.vkey;
+    record.makeCode = ev.makeCode;
+    record.type = ev.type;
+    record.action = action;
+
+    m_total++;
+    if (m_count < m_capacity)
+        m_count++;
+
+    // Keep a scrolled-back view on the same rows while new events arrive
+    if (m_scroll > 0 && m_scroll < m_count - 1)
+        m_scroll++;
+
+    m_lastTicks = ticks;
+    m_hasLast = true;
+}
+
+const LogRecord &EventLog::Record(size_t index) const
+{
+    return m_records[(m_total - 1 - index) % m_capacity];
+}
+
+void EventLog::ScrollBy(int64_t rows)
+{
+    int64_t maxScroll = m_count > 0 ? (int64_t)m_count - 1 : 0;
+    int64_t scroll = (int64_t)m_scroll + rows;
+    m_scroll = (size_t)(scroll < 0 ? 0 : (scroll > maxScroll ? maxScroll : scroll));
+}
+
+const wchar_t *EventLog::Row(size_t row, LogNameSource &names, size_t *length)
+{
+    if (!m_rows)
+        m_rows.reset(new CachedRow[CACHED_ROWS]);
+
+    size_t index = m_scroll + row;
+    uint64_t sequence = m_total - 1 - index;
+    CachedRow &cached = m_rows[sequence % CACHED_ROWS];
+    if (cached.sequence != sequence)
+    {
+        const LogRecord &record = Record(index);
+
+        InputEvent ev;
+        ev.time = TimePoint(Clock::duration(record.ticks));
+        ev.type = record.type;
+        ev.deviceId = record.deviceId;
+        if (record.type == InputType::Keyboard)
+            ev.keyFlags = record.flags;
+        else
+            ev.buttonFlags = record.flags;
+        ev.buttonData = record.buttonData;
+        ev.dx = record.dx;
+        ev.dy = record.dy;
+        ev.vkey = record.vkey;
+        ev.makeCode = record.makeCode;
+
+        wchar_t keyName[64] = {};
+        if (record.type == InputType::Keyboard)
+            names.KeyName(ev, keyName, 64);
+        wchar_t inputInfo[128];
+        DescribeInput(ev, record.action, keyName, inputInfo, 128);
+        wchar_t deviceInfo[256];
+        DescribeDevice(ev, names.DeviceName(record.deviceId), deviceInfo, 256);
+
+        cached.length = (uint32_t)FormatLogEntry(ElapsedMs(m_appStartTime, ev.time), record.deltaMs, inputInfo,
+                                                 deviceInfo, cached.text, ENTRY_CHARS);
+        cached.sequence = sequence;
+    }
+
+    if (length)
+        *length = cached.length;
+    return cached.text;
+}
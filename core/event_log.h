@@ -0,0 +1,84 @@
+// Input log of the latency tester (newest first)
+// Events are stored as compact binary records in a large ring (flat memory, a whole
+// session fits); text is only formatted for the rows that are drawn, once per row
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include "input_filter.h"
+#include "timing.h"
+
+// Formats "123.45ms +12.34Δ | InputInfo | Device"
+size_t FormatLogEntry(double timeMs, double deltaMs, const wchar_t *inputInfo, const wchar_t *deviceInfo,
+                      wchar_t *out, size_t outSize);
+
+// Resolves the names a row needs at format time (the backend owns devices and key names)
+class LogNameSource
+{
+public:
+    virtual ~LogNameSource() = default;
+    virtual const wchar_t *DeviceName(uint16_t deviceId) = 0;
+    virtual void KeyName(const InputEvent &ev, wchar_t *out, size_t outSize) = 0;
+};
+
+struct LogRecord
+{
+    int64_t ticks;      // Event time (Clock ticks)
+    int32_t dx;
+    int32_t dy;
+    float deltaMs;      // Since the previous logged event
+    uint16_t deviceId;
+    uint16_t flags;     // Button flags / key flags
+    int16_t buttonData;
+    uint16_t vkey;
+    uint16_t makeCode;
+    InputType type;
+    InputAction action;
+};
+
+static_assert(sizeof(LogRecord) == 32, "LogRecord layout");
+
+class EventLog
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20; // 32 MB of records
+    static constexpr size_t ENTRY_CHARS = 256;
+    static constexpr size_t CACHED_ROWS = 128;           // More than fit on screen
+
+    explicit EventLog(size_t capacity = DEFAULT_CAPACITY) : m_capacity(capacity) {}
+
+    void Reset(TimePoint appStartTime);
+    void Add(const InputEvent &ev, InputAction action); // Allocates the ring on first use
+    void Clear();
+
+    size_t Count() const { return m_count; }
+    size_t Capacity() const { return m_capacity; }
+    const LogRecord &Record(size_t index) const; // index 0 is the newest
+
+    // Rows as drawn: row 0 is the newest entry below the scroll offset
+    size_t Scroll() const { return m_scroll; }
+    void ScrollBy(int64_t rows); // Positive scrolls back in time
+    void ScrollToNewest() { m_scroll = 0; }
+    size_t RowCount() const { return m_count - m_scroll; }
+
+    // Formatted text of a visible row; formats only rows not already cached
+    const wchar_t *Row(size_t row, LogNameSource &names, size_t *length = nullptr);
+
+private:
+    struct CachedRow
+    {
+        uint64_t sequence = UINT64_MAX;
+        uint32_t length = 0;
+        wchar_t text[ENTRY_CHARS];
+    };
+
+    std::unique_ptr<LogRecord[]> m_records;
+    size_t m_capacity;
+    size_t m_count = 0;
+    uint64_t m_total = 0; // Records ever added; sequence of the next record
+    size_t m_scroll = 0;
+    std::unique_ptr<CachedRow[]> m_rows; // Indexed by sequence % CACHED_ROWS
+    TimePoint m_appStartTime = Clock::now();
+    int64_t m_lastTicks = 0;
+    bool m_hasLast = false;
+};
@@ -0,0 +1,31 @@
+#include "file_path.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <cwchar>
+
+std::wstring WidenPath(const std::string &path)
+{
+    int len = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring wide(len > 0 ? len : 0, L'\0');
+    if (len > 0)
+        MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], len);
+    wide.resize(wcslen(wide.c_str()));
+    return wide;
+}
+#endif
+
+FILE *OpenUtf8File(const std::string &path, const char *mode)
+{
+#ifdef _WIN32
+    return _wfopen(WidenPath(path).c_str(), WidenPath(mode).c_str());
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
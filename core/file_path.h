@@ -0,0 +1,14 @@
+// Files named by UTF-8 paths, as the Win32 command line helpers return them
+// Narrow fopen on Windows reads a path in the ANSI code page, so a non-ASCII path fails or
+// names another file; these widen it for the wide-character APIs instead.
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+std::wstring WidenPath(const std::string &path);
+#endif
+
+// fopen with a UTF-8 path (_wfopen on Windows)
+FILE *OpenUtf8File(const std::string &path, const char *mode);
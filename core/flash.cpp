@@ -0,0 +1,33 @@
+#include "flash.h"
+
+void FlashState::Trigger(TimePoint now)
+{
+    isFlashing = true;
+    flashStartTime = now;
+    m_sequencer.Start(m_hasPattern ? m_pattern : FlashPattern::Single(flashDuration), now);
+}
+
+bool FlashState::Update(TimePoint now)
+{
+    // Integer tick comparison; each step is presented for at least minFrames frames
+    level = m_sequencer.OnFrame(now);
+    isFlashing = m_sequencer.Active();
+    return isFlashing;
+}
+
+void FlashState::IncreaseDuration()
+{
+    flashDuration += std::chrono::milliseconds(10);
+}
+
+void FlashState::DecreaseDuration()
+{
+    constexpr Clock::duration step = std::chrono::milliseconds(10);
+    flashDuration = (flashDuration > step) ? flashDuration - step : step;
+}
+
+void FlashState::SetPattern(const FlashPattern &pattern)
+{
+    m_pattern = pattern;
+    m_hasPattern = true;
+}
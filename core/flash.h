@@ -0,0 +1,35 @@
+// Flash state of the latency tester (white screen on input)
+// A flash is a FlashPattern played per presented frame: by default one white step of
+// flashDuration, or a custom train set with SetPattern (-pattern=...)
+#pragma once
+
+#include "flash_pattern.h"
+#include "timing.h"
+
+struct FlashState
+{
+    bool isFlashing = false;
+    TimePoint flashStartTime;
+    Clock::duration flashDuration = std::chrono::milliseconds(50); // Adjustable with F5/F6
+    float level = 0.0f; // White level of the current frame
+
+    void Trigger(TimePoint now);
+
+    // Per presented frame: advances the pattern; returns isFlashing
+    bool Update(TimePoint now);
+
+    void IncreaseDuration(); // F5
+    void DecreaseDuration(); // F6
+
+    int DurationMs() const { return (int)std::chrono::duration_cast<std::chrono::milliseconds>(flashDuration).count(); }
+
+    void SetPattern(const FlashPattern &pattern);
+    void ClearPattern() { m_hasPattern = false; }
+    bool HasPattern() const { return m_hasPattern; }
+    const FlashPattern &Pattern() const { return m_pattern; }
+
+private:
+    FlashSequencer m_sequencer;
+    FlashPattern m_pattern;
+    bool m_hasPattern = false;
+};
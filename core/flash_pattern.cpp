@@ -0,0 +1,168 @@
+#include "flash_pattern.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+FlashPattern FlashPattern::Single(Clock::duration duration)
+{
+    FlashPattern pattern;
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    pattern.AddStep((uint32_t)(us > 0 ? us : 0), FlashUnit::Microseconds, 1.0f);
+    return pattern;
+}
+
+bool FlashPattern::AddStep(uint32_t duration, FlashUnit unit, float level)
+{
+    if (stepCount >= MAX_STEPS)
+        return false;
+    FlashStep &step = steps[stepCount++];
+    step.duration = duration;
+    step.unit = unit;
+    step.level = level > 0.0f ? (level < 1.0f ? level : 1.0f) : 0.0f; // NaN -> 0
+    return true;
+}
+
+// Unsigned count after a prefix; false if missing or above UINT32_MAX
+static bool ParseCount(const char *p, char *&end, uint32_t &value)
+{
+    if (*p < '0' || *p > '9')
+        return false;
+    unsigned long long parsed = strtoull(p, &end, 10);
+    if (parsed > UINT32_MAX)
+        return false;
+    value = (uint32_t)parsed;
+    return true;
+}
+
+bool ParseFlashPattern(const char *text, FlashPattern &pattern)
+{
+    FlashPattern parsed;
+    const char *p = text;
+    while (*p)
+    {
+        while (*p == ',' || *p == ' ')
+            ++p;
+        if (!*p)
+            break;
+
+        char *end = nullptr;
+        if (*p == 'x')
+        {
+            if (!ParseCount(p + 1, end, parsed.repeat) || parsed.repeat == 0)
+                return false;
+        }
+        else if (strncmp(p, "min", 3) == 0)
+        {
+            if (!ParseCount(p + 3, end, parsed.minFrames))
+                return false;
+        }
+        else
+        {
+            double value = strtod(p, &end);
+            if (end == p || !(value >= 0.0))
+                return false;
+
+            FlashUnit unit;
+            double scale;
+            if (strncmp(end, "us", 2) == 0)
+            {
+                unit = FlashUnit::Microseconds;
+                scale = 1.0;
+                end += 2;
+            }
+            else if (strncmp(end, "ms", 2) == 0)
+            {
+                unit = FlashUnit::Microseconds;
+                scale = 1000.0;
+                end += 2;
+            }
+            else if (*end == 'f')
+            {
+                unit = FlashUnit::Frames;
+                scale = 1.0;
+                end += 1;
+            }
+            else
+            {
+                return false;
+            }
+
+            float level = 1.0f;
+            if (*end == '@')
+            {
+                const char *levelText = end + 1;
+                level = strtof(levelText, &end);
+                if (end == levelText || !std::isfinite(level))
+                    return false;
+            }
+            double duration = std::floor(value * scale + 0.5);
+            if (duration > (double)UINT32_MAX || !parsed.AddStep((uint32_t)duration, unit, level))
+                return false;
+        }
+
+        if (*end && *end != ',' && *end != ' ')
+            return false;
+        p = end;
+    }
+
+    if (parsed.stepCount == 0)
+        return false;
+    // Without a frame minimum a zero-length step takes no frame at all; a train of them
+    // would spin through every repeat inside one frame
+    for (size_t i = 0; i < parsed.stepCount && parsed.minFrames == 0; ++i)
+    {
+        if (parsed.steps[i].duration == 0)
+            return false;
+    }
+    pattern = parsed;
+    return true;
+}
+
+void FlashSequencer::Start(const FlashPattern &pattern, TimePoint now)
+{
+    m_pattern = pattern;
+    m_active = pattern.stepCount > 0;
+    m_step = 0;
+    m_train = 0;
+    m_stepStart = now;
+    m_stepFrames = 0;
+}
+
+bool FlashSequencer::StepDone(TimePoint now) const
+{
+    const FlashStep &step = m_pattern.steps[m_step];
+    if (m_stepFrames < m_pattern.minFrames)
+        return false;
+    if (step.unit == FlashUnit::Frames)
+        return m_stepFrames >= step.duration;
+    return now - m_stepStart >= std::chrono::microseconds(step.duration);
+}
+
+float FlashSequencer::OnFrame(TimePoint now)
+{
+    // A step may end with zero frames only if minFrames is 0, so loop over empty steps;
+    // a whole train that passes without a frame would do so on every frame, so it ends
+    // the pattern instead
+    for (size_t skipped = 0; m_active && StepDone(now); ++skipped)
+    {
+        if (skipped >= m_pattern.stepCount)
+        {
+            m_active = false;
+            break;
+        }
+        m_stepStart = now;
+        m_stepFrames = 0;
+        if (++m_step >= m_pattern.stepCount)
+        {
+            m_step = 0;
+            if (++m_train >= m_pattern.repeat)
+                m_active = false;
+        }
+    }
+    if (!m_active)
+        return 0.0f;
+
+    m_stepFrames++;
+    return m_pattern.steps[m_step].level;
+}
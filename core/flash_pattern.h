@@ -0,0 +1,71 @@
+// Programmable flash patterns for sensor automation: trains of steps with a white
+// level each, durations in microseconds or presented frames, and a guaranteed
+// minimum number of presented frames per step
+//
+// Text form (-pattern=...): comma separated elements
+//   <n>us | <n>ms | <n>f [@level]   step of n microseconds / milliseconds / frames
+//   x<n>                            play the steps n times (train)
+//   min<n>                          every step lasts at least n presented frames
+// e.g. "2f@1,2f@0,x10" or "500us@1,16ms@0.5,min2"
+// Levels are clamped to [0, 1]; counts and durations must fit 32 bits, and with min0 no
+// step may be zero-length.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "timing.h"
+
+enum class FlashUnit : uint8_t
+{
+    Microseconds,
+    Frames
+};
+
+struct FlashStep
+{
+    uint32_t duration = 0;
+    FlashUnit unit = FlashUnit::Microseconds;
+    float level = 1.0f; // 0 = black, 1 = white
+};
+
+struct FlashPattern
+{
+    static constexpr size_t MAX_STEPS = 32;
+
+    FlashStep steps[MAX_STEPS];
+    size_t stepCount = 0;
+    uint32_t repeat = 1;    // Trains
+    uint32_t minFrames = 1; // Per step
+
+    static FlashPattern Single(Clock::duration duration); // One white step
+    bool AddStep(uint32_t duration, FlashUnit unit, float level);
+};
+
+// Parses the text form; returns false (and leaves pattern untouched) on a syntax or range
+// error
+bool ParseFlashPattern(const char *text, FlashPattern &pattern);
+
+// Plays a pattern one presented frame at a time
+class FlashSequencer
+{
+public:
+    void Start(const FlashPattern &pattern, TimePoint now);
+    void Stop() { m_active = false; }
+
+    // Call once per presented frame; returns the level to present (0 when idle)
+    float OnFrame(TimePoint now);
+
+    bool Active() const { return m_active; }
+    size_t Step() const { return m_step; }
+    uint32_t Train() const { return m_train; }
+
+private:
+    bool StepDone(TimePoint now) const;
+
+    FlashPattern m_pattern;
+    bool m_active = false;
+    size_t m_step = 0;
+    uint32_t m_train = 0;
+    TimePoint m_stepStart;
+    uint32_t m_stepFrames = 0;
+};
@@ -0,0 +1,134 @@
+#include "frame_times.h"
+#include <cstdio>
+#include "file_path.h"
+
+void FrameTimeRing::Reset()
+{
+    m_first = m_count = 0;
+    m_longFirst = m_longCount = 0;
+    m_total = 0;
+    m_hasLast = false;
+    m_lastUnits = m_oldestUnits = 0;
+    m_histogram.Reset();
+}
+
+void FrameTimeRing::Record(TimePoint time)
+{
+    int64_t units = time.time_since_epoch().count() / UNIT_NS;
+    if (!m_hasLast)
+    {
+        m_lastUnits = m_oldestUnits = units;
+        m_hasLast = true;
+        return;
+    }
+    if (!m_deltas)
+    {
+        m_longCapacity = m_capacity / LONG_FRAME_RATIO > 0 ? m_capacity / LONG_FRAME_RATIO : 1;
+        m_deltas.reset(new uint16_t[m_capacity]);
+        m_long.reset(new int64_t[m_longCapacity]);
+    }
+
+    // Deltas of the quantized times, so start times rebuild without drift
+    int64_t delta = units - m_lastUnits;
+    if (delta < 0)
+        delta = 0;
+    m_lastUnits = units;
+    PushDelta(delta);
+}
+
+void FrameTimeRing::PushDelta(int64_t delta)
+{
+    if (m_count == m_capacity)
+        DropOldest();
+
+    uint16_t stored = (uint16_t)delta;
+    if (delta >= ESCAPE)
+    {
+        if (m_longCount == m_longCapacity)
+        {
+            while (!DropOldest())
+            {
+            }
+        }
+        m_long[(m_longFirst + m_longCount) % m_longCapacity] = delta;
+        m_longCount++;
+        stored = ESCAPE;
+    }
+    m_deltas[(m_first + m_count) % m_capacity] = stored;
+    m_count++;
+    m_total++;
+    m_histogram.Record(delta * UNIT_NS);
+}
+
+bool FrameTimeRing::DropOldest()
+{
+    int64_t delta = m_deltas[m_first];
+    bool isLong = delta == ESCAPE;
+    if (isLong)
+    {
+        delta = m_long[m_longFirst];
+        m_longFirst = (m_longFirst + 1) % m_longCapacity;
+        m_longCount--;
+    }
+    m_first = (m_first + 1) % m_capacity;
+    m_count--;
+    m_oldestUnits += delta;
+    m_histogram.Remove(delta * UNIT_NS);
+    return isLong;
+}
+
+FrameTimeStats FrameTimeRing::Snapshot() const
+{
+    FrameTimeStats stats;
+    stats.frames = m_count;
+    if (m_count == 0)
+        return stats;
+    stats.meanMs = m_histogram.Mean() / 1e6;
+    stats.p50Ms = m_histogram.Percentile(50.0) / 1e6;
+    stats.p99Ms = m_histogram.Percentile(99.0) / 1e6;
+    stats.p999Ms = m_histogram.Percentile(99.9) / 1e6;
+    stats.maxMs = m_histogram.Max() / 1e6;
+    return stats;
+}
+
+uint32_t FrameTimeRing::Bins(int64_t highNs, uint32_t *counts, size_t bins) const
+{
+    for (size_t i = 0; i < bins; ++i)
+        counts[i] = 0;
+    if (bins == 0 || highNs <= 0)
+        return 0;
+
+    // Each histogram bucket goes to the bin holding its midpoint
+    for (size_t b = 0; b < LogHistogram::BUCKET_COUNT; ++b)
+    {
+        uint64_t count = m_histogram.BucketCount(b);
+        if (count == 0)
+            continue;
+        int64_t mid = (LogHistogram::BucketLow(b) + LogHistogram::BucketHigh(b)) / 2;
+        size_t bin = mid >= highNs ? bins - 1 : (size_t)(mid * (int64_t)bins / highNs);
+        uint64_t sum = counts[bin] + count;
+        counts[bin] = sum > UINT32_MAX ? UINT32_MAX : (uint32_t)sum;
+    }
+
+    uint32_t largest = 0;
+    for (size_t i = 0; i < bins; ++i)
+        largest = counts[i] > largest ? counts[i] : largest;
+    return largest;
+}
+
+bool FrameTimeRing::Export(const char *path) const
+{
+    FILE *f = OpenUtf8File(path, "w");
+    if (!f)
+        return false;
+    bool ok = fprintf(f, "frame,start_ms,frame_ms\n") > 0;
+    uint64_t frame = m_total - m_count;
+    int64_t originNs = m_oldestUnits * UNIT_NS;
+    ForEach([&](int64_t startNs, int64_t frameNs) {
+        if (ok)
+            ok = fprintf(f, "%llu,%.4f,%.4f\n", (unsigned long long)frame, (startNs - originNs) / 1e6,
+                         frameNs / 1e6) > 0;
+        frame++;
+    });
+    return fclose(f) == 0 && ok;
+}
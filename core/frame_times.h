@@ -0,0 +1,92 @@
+// Per-iteration frame times of the render loop in fixed memory
+// Each frame stores a 16-bit delta in 100 ns units (QPC resolution). Frames of 6.5 ms
+// or longer store an escape and their length goes into a side ring. The default
+// capacity holds 10 minutes at 10k fps (12 MB plus 3 MB of long frames), and a histogram over the ring
+// contents gives live percentiles without sorting.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "histogram.h"
+#include "timing.h"
+
+struct FrameTimeStats
+{
+    uint64_t frames = 0; // Frame times in the ring
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double p999Ms = 0.0;
+    double maxMs = 0.0; // Longest frame since Reset()
+};
+
+class FrameTimeRing
+{
+public:
+    static constexpr int64_t UNIT_NS = 100;
+    static constexpr uint16_t ESCAPE = 0xFFFF; // Delta is in the long-frame ring
+    static constexpr size_t DEFAULT_CAPACITY = 10 * 60 * 10000;
+    // Long frames live in a ring 1/16 the size; when it is full the oldest frames are
+    // dropped, so the ring spans fewer frames while most of them are 6.5 ms or longer
+    static constexpr size_t LONG_FRAME_RATIO = 16;
+
+    explicit FrameTimeRing(size_t capacity = DEFAULT_CAPACITY) : m_capacity(capacity) {}
+
+    // One call per loop iteration; the first only sets the start. Allocates on first use.
+    void Record(TimePoint time);
+    void Reset();
+
+    size_t Count() const { return m_count; }
+    size_t Capacity() const { return m_capacity; }
+    uint64_t Total() const { return m_total; } // Frame times recorded since Reset()
+
+    FrameTimeStats Snapshot() const;
+    const LogHistogram &Histogram() const { return m_histogram; }
+
+    // Folds the histogram into `bins` equal bins over [0, highNs); longer frames land in
+    // the last bin. Returns the largest bin count.
+    uint32_t Bins(int64_t highNs, uint32_t *counts, size_t bins) const;
+
+    // fn(startNs, frameNs) for every frame in the ring, oldest first
+    template <typename Fn>
+    void ForEach(Fn &&fn) const
+    {
+        int64_t units = m_oldestUnits;
+        size_t longIndex = m_longFirst;
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            int64_t delta = m_deltas[(m_first + i) % m_capacity];
+            if (delta == ESCAPE)
+            {
+                delta = m_long[longIndex];
+                longIndex = (longIndex + 1) % m_longCapacity;
+            }
+            fn(units * UNIT_NS, delta * UNIT_NS);
+            units += delta;
+        }
+    }
+
+    // CSV: frame, start_ms (since the oldest frame), frame_ms
+    bool Export(const char *path) const;
+
+private:
+    void PushDelta(int64_t delta);
+    bool DropOldest(); // Returns whether the dropped frame was a long one
+
+    std::unique_ptr<uint16_t[]> m_deltas;
+    std::unique_ptr<int64_t[]> m_long;
+    size_t m_capacity;
+    size_t m_longCapacity = 0;
+    size_t m_first = 0; // Oldest delta
+    size_t m_count = 0;
+    size_t m_longFirst = 0;
+    size_t m_longCount = 0;
+    uint64_t m_total = 0;
+
+    bool m_hasLast = false;
+    int64_t m_lastUnits = 0;   // Start of the next frame
+    int64_t m_oldestUnits = 0; // Start of the oldest frame in the ring
+
+    LogHistogram m_histogram; // ns, ring contents
+};
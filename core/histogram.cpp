@@ -0,0 +1,103 @@
+#include "histogram.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static int HighestBit(uint64_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+size_t LogHistogram::BucketIndex(int64_t value)
+{
+    if (value < 0)
+        value = 0;
+    if (value > MAX_VALUE)
+        value = MAX_VALUE;
+    if (value < 2 * SUB_COUNT)
+        return (size_t)value;
+
+    int shift = HighestBit((uint64_t)value) - SUB_BITS;
+    int64_t mantissa = value >> shift; // [SUB_COUNT, 2 * SUB_COUNT)
+    return (size_t)(2 * SUB_COUNT + (shift - 1) * SUB_COUNT + (mantissa - SUB_COUNT));
+}
+
+int64_t LogHistogram::BucketLow(size_t index)
+{
+    if (index < 2 * SUB_COUNT)
+        return (int64_t)index;
+    int64_t shift = (int64_t)(index - 2 * SUB_COUNT) / SUB_COUNT + 1;
+    int64_t mantissa = (int64_t)(index - 2 * SUB_COUNT) % SUB_COUNT + SUB_COUNT;
+    return mantissa << shift;
+}
+
+int64_t LogHistogram::BucketHigh(size_t index)
+{
+    if (index < 2 * SUB_COUNT)
+        return (int64_t)index + 1;
+    int64_t shift = (int64_t)(index - 2 * SUB_COUNT) / SUB_COUNT + 1;
+    return BucketLow(index) + ((int64_t)1 << shift);
+}
+
+void LogHistogram::Record(int64_t value)
+{
+    m_buckets[BucketIndex(value)]++;
+    m_count++;
+    m_sum += (double)value;
+    if (value < m_min)
+        m_min = value;
+    if (value > m_max)
+        m_max = value;
+}
+
+void LogHistogram::Remove(int64_t value)
+{
+    size_t index = BucketIndex(value);
+    if (m_buckets[index] == 0)
+        return;
+    m_buckets[index]--;
+    m_count--;
+    m_sum -= (double)value;
+}
+
+void LogHistogram::Reset()
+{
+    for (uint64_t &bucket : m_buckets)
+        bucket = 0;
+    m_count = 0;
+    m_sum = 0.0;
+    m_min = MAX_VALUE;
+    m_max = 0;
+}
+
+int64_t LogHistogram::Percentile(double p) const
+{
+    if (m_count == 0)
+        return 0;
+
+    uint64_t target = (uint64_t)(p / 100.0 * (double)m_count + 0.5);
+    if (target < 1)
+        target = 1;
+    if (target > m_count)
+        target = m_count;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += m_buckets[i];
+        if (seen >= target)
+        {
+            if (i < 2 * SUB_COUNT)
+                return (int64_t)i;
+            return (BucketLow(i) + BucketHigh(i)) / 2;
+        }
+    }
+    return Max();
+}
@@ -0,0 +1,42 @@
+// Fixed-memory log-linear histogram of non-negative integer values (e.g. nanoseconds)
+// 32 sub-buckets per power of two (<= 3.2% relative error), exact below 64,
+// values clamp at 2^40 (~18 minutes in ns). O(1) record/remove, O(buckets) percentile.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class LogHistogram
+{
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int64_t SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int MAX_BITS = 40;
+    static constexpr size_t BUCKET_COUNT = 2 * SUB_COUNT + (MAX_BITS - SUB_BITS - 1) * SUB_COUNT;
+    static constexpr int64_t MAX_VALUE = ((int64_t)1 << MAX_BITS) - 1;
+
+    void Record(int64_t value);
+    void Remove(int64_t value); // For sliding windows; value must have been recorded
+    void Reset();
+
+    uint64_t Count() const { return m_count; }
+    int64_t Min() const { return m_count ? m_min : 0; }
+    int64_t Max() const { return m_count ? m_max : 0; }
+    double Mean() const { return m_count ? m_sum / (double)m_count : 0.0; }
+
+    // Value at percentile p in [0, 100] (bucket midpoint, exact below 64)
+    int64_t Percentile(double p) const;
+
+    // Bucket access for export/drawing
+    static size_t BucketIndex(int64_t value);
+    static int64_t BucketLow(size_t index);
+    static int64_t BucketHigh(size_t index); // Exclusive
+    uint64_t BucketCount(size_t index) const { return m_buckets[index]; }
+
+private:
+    uint64_t m_buckets[BUCKET_COUNT] = {};
+    uint64_t m_count = 0;
+    double m_sum = 0.0;
+    int64_t m_min = MAX_VALUE;
+    int64_t m_max = 0; // Not lowered by Remove()
+};
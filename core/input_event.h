@@ -0,0 +1,71 @@
+// Platform-neutral input event decoded from a raw input report
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include "timing.h"
+
+// Mouse button flags (same values as RI_MOUSE_* in WinUser.h)
+constexpr uint16_t MOUSE_LEFT_DOWN = 0x0001;
+constexpr uint16_t MOUSE_LEFT_UP = 0x0002;
+constexpr uint16_t MOUSE_RIGHT_DOWN = 0x0004;
+constexpr uint16_t MOUSE_RIGHT_UP = 0x0008;
+constexpr uint16_t MOUSE_MIDDLE_DOWN = 0x0010;
+constexpr uint16_t MOUSE_MIDDLE_UP = 0x0020;
+constexpr uint16_t MOUSE_BUTTON4_DOWN = 0x0040;
+constexpr uint16_t MOUSE_BUTTON4_UP = 0x0080;
+constexpr uint16_t MOUSE_BUTTON5_DOWN = 0x0100;
+constexpr uint16_t MOUSE_BUTTON5_UP = 0x0200;
+constexpr uint16_t MOUSE_WHEEL = 0x0400;
+
+// Keyboard flags (same values as RI_KEY_* in WinUser.h)
+constexpr uint16_t KEY_BREAK = 0x0001;
+constexpr uint16_t KEY_E0 = 0x0002;
+constexpr uint16_t KEY_E1 = 0x0004;
+
+enum class InputType : uint8_t
+{
+    Mouse,
+    Keyboard,
+    Other
+};
+
+// Compact POD record (32 bytes, two per cache line) written by input decoding
+struct InputEvent
+{
+    TimePoint time;
+    int32_t dx = 0;
+    int32_t dy = 0;
+    uint16_t deviceId = 0;
+    InputType type = InputType::Other;
+    uint8_t reserved = 0;
+
+    // Mouse
+    uint16_t buttonFlags = 0;
+    int16_t buttonData = 0; // Wheel delta
+
+    // Keyboard
+    uint16_t vkey = 0;
+    uint16_t makeCode = 0;
+    uint16_t keyFlags = 0;
+
+    // Arrival to decoded, in DECODE_DELAY_UNIT_NS units (saturates); see SetDecodeTime()
+    uint16_t decodeDelay = 0;
+};
+
+constexpr int64_t DECODE_DELAY_UNIT_NS = 100;
+
+// Stamps when the backend finished decoding the report (for latency attribution)
+inline void SetDecodeTime(InputEvent &ev, TimePoint decoded)
+{
+    int64_t units = (decoded - ev.time).count() / DECODE_DELAY_UNIT_NS;
+    ev.decodeDelay = (uint16_t)(units < 0 ? 0 : (units > UINT16_MAX ? UINT16_MAX : units));
+}
+
+inline TimePoint DecodeTime(const InputEvent &ev)
+{
+    return ev.time + Clock::duration((int64_t)ev.decodeDelay * DECODE_DELAY_UNIT_NS);
+}
+
+static_assert(sizeof(InputEvent) == 32, "InputEvent should stay compact");
+static_assert(std::is_trivially_copyable<InputEvent>::value, "InputEvent must be POD");
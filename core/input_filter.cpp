@@ -0,0 +1,126 @@
+#include "input_filter.h"
+#include <cwchar>
+
+InputAction ClassifyInput(const InputEvent &ev, const InputFilter &filter)
+{
+    if (ev.type == InputType::Mouse)
+    {
+        bool isButtonEvent = (ev.buttonFlags != 0);
+        bool isDeltaEvent = IsMouseDelta(ev);
+
+        // Filter based on toggles
+        if (isButtonEvent && !filter.enableMouseButtons)
+            return InputAction::None;
+        if (isDeltaEvent && !isButtonEvent && !filter.enableMouseDelta)
+            return InputAction::None;
+
+        // Check what triggered this input
+        uint16_t flags = ev.buttonFlags;
+        if (flags & MOUSE_LEFT_DOWN)
+            return InputAction::LeftDown;
+        if (flags & MOUSE_LEFT_UP)
+            return filter.enableUpEvents ? InputAction::LeftUp : InputAction::None;
+        if (flags & MOUSE_RIGHT_DOWN)
+            return InputAction::RightDown;
+        if (flags & MOUSE_RIGHT_UP)
+            return filter.enableUpEvents ? InputAction::RightUp : InputAction::None;
+        if (flags & MOUSE_MIDDLE_DOWN)
+            return InputAction::MiddleDown;
+        if (flags & MOUSE_MIDDLE_UP)
+            return filter.enableUpEvents ? InputAction::MiddleUp : InputAction::None;
+        if (flags & MOUSE_BUTTON4_DOWN)
+            return InputAction::Button4Down;
+        if (flags & MOUSE_BUTTON4_UP)
+            return filter.enableUpEvents ? InputAction::Button4Up : InputAction::None;
+        if (flags & MOUSE_BUTTON5_DOWN)
+            return InputAction::Button5Down;
+        if (flags & MOUSE_BUTTON5_UP)
+            return filter.enableUpEvents ? InputAction::Button5Up : InputAction::None;
+        if (flags & MOUSE_WHEEL)
+            return InputAction::Wheel;
+        if (isDeltaEvent)
+            return InputAction::Move;
+        return InputAction::None; // No meaningful input
+    }
+
+    if (ev.type == InputType::Keyboard)
+    {
+        if (!filter.enableKeyboard)
+            return InputAction::None;
+
+        bool isDown = !(ev.keyFlags & KEY_BREAK);
+        if (!isDown && !filter.enableUpEvents)
+            return InputAction::None;
+        return isDown ? InputAction::KeyDown : InputAction::KeyUp;
+    }
+
+    return InputAction::None; // HID device, ignore for now
+}
+
+size_t DescribeInput(const InputEvent &ev, InputAction action, const wchar_t *keyName,
+                     wchar_t *out, size_t outSize)
+{
+    const wchar_t *text = nullptr;
+    switch (action)
+    {
+    case InputAction::LeftDown: text = L"Left Click DOWN"; break;
+    case InputAction::LeftUp: text = L"Left Click UP"; break;
+    case InputAction::RightDown: text = L"Right Click DOWN"; break;
+    case InputAction::RightUp: text = L"Right Click UP"; break;
+    case InputAction::MiddleDown: text = L"Middle Click DOWN"; break;
+    case InputAction::MiddleUp: text = L"Middle Click UP"; break;
+    case InputAction::Button4Down: text = L"Button 4 DOWN"; break;
+    case InputAction::Button4Up: text = L"Button 4 UP"; break;
+    case InputAction::Button5Down: text = L"Button 5 DOWN"; break;
+    case InputAction::Button5Up: text = L"Button 5 UP"; break;
+    default: break;
+    }
+
+    int written = 0;
+    if (text)
+    {
+        written = swprintf(out, outSize, L"%ls", text);
+    }
+    else if (action == InputAction::Wheel)
+    {
+        written = swprintf(out, outSize, L"Wheel: %d", (int)ev.buttonData);
+    }
+    else if (action == InputAction::Move)
+    {
+        written = swprintf(out, outSize, L"Move: dX=%d dY=%d", (int)ev.dx, (int)ev.dy);
+    }
+    else if (action == InputAction::KeyDown || action == InputAction::KeyUp)
+    {
+        written = swprintf(out, outSize, L"%ls (VK=%u SC=%u) %ls",
+                           keyName ? keyName : L"", (unsigned)ev.vkey, (unsigned)ev.makeCode,
+                           action == InputAction::KeyDown ? L"DOWN" : L"UP");
+    }
+    else if (outSize > 0)
+    {
+        out[0] = L'\0';
+    }
+
+    // swprintf returns -1 on truncation; report what fits
+    if (written < 0)
+    {
+        if (outSize == 0)
+            return 0;
+        out[outSize - 1] = L'\0';
+        return wcslen(out);
+    }
+    return (size_t)written;
+}
+
+size_t DescribeDevice(const InputEvent &ev, const wchar_t *deviceName, wchar_t *out, size_t outSize)
+{
+    int written = swprintf(out, outSize, L"%ls: %ls", ev.type == InputType::Mouse ? L"MOUSE" : L"KEYBOARD",
+                           deviceName ? deviceName : L"");
+    if (written < 0)
+    {
+        if (outSize == 0)
+            return 0;
+        out[outSize - 1] = L'\0';
+        return wcslen(out);
+    }
+    return (size_t)written;
+}
@@ -0,0 +1,48 @@
+// Input classification and filtering (F1-F3, F7 toggles of the latency tester)
+#pragma once
+
+#include <cstddef>
+#include "input_event.h"
+
+enum class InputAction : uint8_t
+{
+    None,
+    LeftDown,
+    LeftUp,
+    RightDown,
+    RightUp,
+    MiddleDown,
+    MiddleUp,
+    Button4Down,
+    Button4Up,
+    Button5Down,
+    Button5Up,
+    Wheel,
+    Move,
+    KeyDown,
+    KeyUp
+};
+
+struct InputFilter
+{
+    bool enableMouseButtons = true; // F1 toggles
+    bool enableKeyboard = true;     // F2 toggles
+    bool enableMouseDelta = true;   // F3 toggles
+    bool enableUpEvents = true;     // F7 toggles (when OFF, only DOWN events register)
+};
+
+inline bool IsMouseDelta(const InputEvent &ev)
+{
+    return ev.type == InputType::Mouse && (ev.dx != 0 || ev.dy != 0);
+}
+
+// Returns the action an event triggers, or None if it is filtered out
+InputAction ClassifyInput(const InputEvent &ev, const InputFilter &filter);
+
+// Writes a human readable description ("Left Click DOWN", "Move: dX=1 dY=0", ...)
+// keyName is only used for keyboard events and may be null
+size_t DescribeInput(const InputEvent &ev, InputAction action, const wchar_t *keyName,
+                     wchar_t *out, size_t outSize);
+
+// "MOUSE: <name>" / "KEYBOARD: <name>"
+size_t DescribeDevice(const InputEvent &ev, const wchar_t *deviceName, wchar_t *out, size_t outSize);
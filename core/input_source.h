@@ -0,0 +1,32 @@
+// Where the main loop gets decoded input from, one Poll per loop iteration
+#pragma once
+
+#include <cstddef>
+#include "input_event.h"
+#include "spsc_ring.h"
+
+class InputSource
+{
+public:
+    // Largest number of events a single Poll may need room for
+    static constexpr size_t MAX_POLL_EVENTS = 2048;
+
+    virtual ~InputSource() = default;
+
+    // Drains pending input into out; returns the number of events written
+    virtual size_t Poll(InputEvent *out, size_t maxEvents) = 0;
+};
+
+// Push-based path: a message handler decodes one report at a time into the ring
+class RingInputSource : public InputSource
+{
+public:
+    static constexpr size_t CAPACITY = 4096;
+
+    bool Push(const InputEvent &ev) { return m_ring.TryPush(ev); }
+    size_t Poll(InputEvent *out, size_t maxEvents) override { return m_ring.PopBatch(out, maxEvents); }
+    uint64_t Dropped() const { return m_ring.Dropped(); }
+
+private:
+    SpscRing<InputEvent, CAPACITY> m_ring;
+};
@@ -0,0 +1,45 @@
+#include "input_thread.h"
+#include <chrono>
+
+bool ThreadedInputSource::Start(std::function<void(ThreadedInputSource &)> body)
+{
+    Stop();
+    m_stop.store(false, std::memory_order_release);
+    m_state.store(0, std::memory_order_release);
+    m_wake = nullptr;
+
+    m_thread = std::thread([this, body] {
+        body(*this);
+        // A body that returned without calling Ready() failed to start
+        int starting = 0;
+        m_state.compare_exchange_strong(starting, -1, std::memory_order_release);
+    });
+
+    // Start-up only: window creation and device registration on the input thread
+    while (m_state.load(std::memory_order_acquire) == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    if (m_state.load(std::memory_order_acquire) < 0)
+    {
+        m_thread.join();
+        return false;
+    }
+    return true;
+}
+
+void ThreadedInputSource::Ready(bool ok, std::function<void()> wake)
+{
+    m_wake = std::move(wake);
+    m_state.store(ok ? 1 : -1, std::memory_order_release);
+}
+
+void ThreadedInputSource::Stop()
+{
+    if (!m_thread.joinable())
+        return;
+    m_stop.store(true, std::memory_order_release);
+    if (m_wake)
+        m_wake();
+    m_thread.join();
+    m_wake = nullptr;
+}
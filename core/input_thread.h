@@ -0,0 +1,78 @@
+// Input received on its own thread and handed to the render loop lock-free
+// The backend supplies the receive loop (the body). It timestamps and decodes reports
+// as they arrive and publishes them into an SPSC ring; the render thread drains the
+// ring with Poll() once per loop iteration. A slow Present() therefore delays only
+// when an event is handled, never when it is timestamped.
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include "input_source.h"
+
+class ThreadedInputSource : public InputSource
+{
+public:
+    static constexpr size_t CAPACITY = 8192; // ~250 ms of a 32 kHz stream while the render thread stalls
+
+    ThreadedInputSource() = default;
+    ~ThreadedInputSource() override { Stop(); }
+    ThreadedInputSource(const ThreadedInputSource &) = delete;
+    ThreadedInputSource &operator=(const ThreadedInputSource &) = delete;
+
+    // Runs body on a new thread and waits until it calls Ready(); returns Ready()'s result.
+    // The body receives input until StopRequested(); wake (given to Ready) unblocks its wait.
+    bool Start(std::function<void(ThreadedInputSource &)> body);
+    void Stop(); // Requests the stop, wakes the body and joins
+    bool Running() const { return m_thread.joinable(); }
+
+    // Input thread
+    void Ready(bool ok, std::function<void()> wake = nullptr);
+    bool StopRequested() const { return m_stop.load(std::memory_order_acquire); }
+    bool Publish(const InputEvent &ev)
+    {
+        if (!m_ring.TryPush(ev))
+            return false;
+        m_published.store(m_published.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (m_doorbell)
+        {
+            // Pairs with the fence in ArmDoorbell: either the render thread sees the event
+            // before it blocks, or this sees the armed flag and wakes it
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_armed.load(std::memory_order_relaxed) && m_armed.exchange(false, std::memory_order_relaxed))
+                m_doorbell();
+        }
+        return true;
+    }
+
+    // Render thread
+    size_t Poll(InputEvent *out, size_t maxEvents) override { return m_ring.PopBatch(out, maxEvents); }
+    bool HasPending() const { return !m_ring.Empty(); }
+
+    // Lets a render loop that blocks between frames be woken by input. Set before Start();
+    // doorbell runs on the input thread after a publish while the render thread is armed.
+    void SetDoorbell(std::function<void()> doorbell) { m_doorbell = std::move(doorbell); }
+    // Render thread, right before blocking; false if input is already queued (do not block)
+    bool ArmDoorbell()
+    {
+        m_armed.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_ring.Empty())
+            return true;
+        m_armed.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    void DisarmDoorbell() { m_armed.store(false, std::memory_order_relaxed); }
+    uint64_t Published() const { return m_published.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const { return m_ring.Dropped(); }
+
+private:
+    SpscRing<InputEvent, CAPACITY> m_ring;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::atomic<int> m_state{0}; // 0 starting, 1 ready, -1 failed
+    std::function<void()> m_wake;
+    std::atomic<uint64_t> m_published{0};
+    std::function<void()> m_doorbell;
+    std::atomic<bool> m_armed{false};
+};
@@ -0,0 +1,140 @@
+#include "latency_stages.h"
+#include <algorithm>
+#include <cstdio>
+#include "file_path.h"
+
+const char *LatencyStageName(LatencyStage stage)
+{
+    switch (stage)
+    {
+    case LatencyStage::Decode:
+        return "decode";
+    case LatencyStage::Trigger:
+        return "trigger";
+    case LatencyStage::Clear:
+        return "clear";
+    case LatencyStage::PresentCall:
+        return "present call";
+    case LatencyStage::PresentReturn:
+        return "present return";
+    case LatencyStage::Total:
+        return "total";
+    default:
+        return "?";
+    }
+}
+
+void LatencyAttribution::OnTrigger(uint32_t id, const InputEvent &ev, TimePoint now)
+{
+    if (m_count == MAX_IN_FLIGHT)
+    {
+        m_dropped++;
+        return;
+    }
+    InFlight &input = m_inFlight[m_count++];
+    input.id = id;
+    input.cleared = false;
+    input.arrival = ev.time;
+    input.decoded = DecodeTime(ev);
+    input.trigger = now;
+}
+
+void LatencyAttribution::OnClear(TimePoint now)
+{
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        if (!m_inFlight[i].cleared)
+        {
+            m_inFlight[i].clear = now;
+            m_inFlight[i].cleared = true;
+        }
+    }
+}
+
+void LatencyAttribution::OnPresent(TimePoint call, TimePoint ret, bool presented)
+{
+    if (!presented)
+    {
+        if (m_count > 0)
+            m_retries++;
+        for (size_t i = 0; i < m_count; ++i)
+            m_inFlight[i].cleared = false;
+        return;
+    }
+
+    // Inputs triggered after this frame's clear wait for the next frame
+    size_t kept = 0;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        const InFlight &input = m_inFlight[i];
+        if (!input.cleared)
+        {
+            m_inFlight[kept++] = input;
+            continue;
+        }
+
+        LatencyBreakdown &breakdown = m_last;
+        breakdown.id = input.id;
+        breakdown.stageNs[(size_t)LatencyStage::Decode] = (input.decoded - input.arrival).count();
+        breakdown.stageNs[(size_t)LatencyStage::Trigger] = (input.trigger - input.decoded).count();
+        breakdown.stageNs[(size_t)LatencyStage::Clear] = (input.clear - input.trigger).count();
+        breakdown.stageNs[(size_t)LatencyStage::PresentCall] = (call - input.clear).count();
+        breakdown.stageNs[(size_t)LatencyStage::PresentReturn] = (ret - call).count();
+        breakdown.stageNs[(size_t)LatencyStage::Total] = (ret - input.arrival).count();
+        for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; ++stage)
+        {
+            int64_t ns = breakdown.stageNs[stage];
+            m_histograms[stage].Record(ns > 0 ? ns : 0);
+        }
+        m_hasLast = true;
+    }
+    m_count = kept;
+}
+
+void LatencyAttribution::Reset()
+{
+    m_count = 0;
+    m_nextId = 0;
+    m_dropped = 0;
+    m_retries = 0;
+    m_hasLast = false;
+    m_last = LatencyBreakdown();
+    for (LogHistogram &histogram : m_histograms)
+        histogram.Reset();
+}
+
+LatencyStageStats LatencyAttribution::Stats(LatencyStage stage) const
+{
+    const LogHistogram &histogram = m_histograms[(size_t)stage];
+    LatencyStageStats stats;
+    stats.count = histogram.Count();
+    if (stats.count == 0)
+        return stats;
+    stats.meanUs = histogram.Mean() / 1000.0;
+    // Bucket midpoints can overshoot the exact maximum
+    stats.maxUs = histogram.Max() / 1000.0;
+    stats.p50Us = std::min(histogram.Percentile(50.0) / 1000.0, stats.maxUs);
+    stats.p99Us = std::min(histogram.Percentile(99.0) / 1000.0, stats.maxUs);
+    return stats;
+}
+
+bool LatencyAttribution::Export(const char *path) const
+{
+    FILE *f = OpenUtf8File(path, "w");
+    if (!f)
+        return false;
+    bool ok = fprintf(f, "stage,low_us,high_us,count\n") > 0;
+    for (size_t stage = 0; stage < LATENCY_STAGE_COUNT && ok; ++stage)
+    {
+        const LogHistogram &histogram = m_histograms[stage];
+        for (size_t b = 0; b < LogHistogram::BUCKET_COUNT && ok; ++b)
+        {
+            if (histogram.BucketCount(b) == 0)
+                continue;
+            ok = fprintf(f, "%s,%.3f,%.3f,%llu\n", LatencyStageName((LatencyStage)stage),
+                         LogHistogram::BucketLow(b) / 1000.0, LogHistogram::BucketHigh(b) / 1000.0,
+                         (unsigned long long)histogram.BucketCount(b)) > 0;
+        }
+    }
+    return fclose(f) == 0 && ok;
+}
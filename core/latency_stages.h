@@ -0,0 +1,96 @@
+// Input-to-present latency attribution: how much of click-to-photon is the app itself
+// Every handled input gets an id. Inputs that trigger a flash are followed through the
+// frame that shows it (arrival -> decode -> trigger -> clear -> Present call -> return),
+// and each completed input adds every stage's duration to that stage's histogram.
+// Fixed memory; backends only read the clock on frames that carry a pending input.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "histogram.h"
+#include "input_event.h"
+
+enum class LatencyStage : uint8_t
+{
+    Decode,        // Message arrival -> report decoded
+    Trigger,       // Decoded -> flash state changed
+    Clear,         // Trigger -> ClearRenderTargetView of the frame that is presented
+    PresentCall,   // Clear -> Present() called
+    PresentReturn, // Present() call -> return
+    Total,         // Arrival -> Present() return
+    Count
+};
+
+constexpr size_t LATENCY_STAGE_COUNT = (size_t)LatencyStage::Count;
+
+const char *LatencyStageName(LatencyStage stage);
+
+struct LatencyStageStats
+{
+    uint64_t count = 0;
+    double meanUs = 0.0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+// Stage durations of one completed input
+struct LatencyBreakdown
+{
+    uint32_t id = 0;
+    int64_t stageNs[LATENCY_STAGE_COUNT] = {};
+};
+
+class LatencyAttribution
+{
+public:
+    // Triggered inputs waiting for their frame; more than this between two frames are dropped
+    static constexpr size_t MAX_IN_FLIGHT = 256;
+
+    // Every handled input; returns its id
+    uint32_t OnInput() { return m_nextId++; }
+    // The input changed the flash state at `now`
+    void OnTrigger(uint32_t id, const InputEvent &ev, TimePoint now);
+
+    // True while a triggered input waits for its frame (the next frame needs stamps)
+    bool Pending() const { return m_count > 0; }
+    void OnClear(TimePoint now);
+    // A Present() that did not queue the frame (DXGI_ERROR_WAS_STILL_DRAWING) keeps the
+    // inputs pending; the frame that is finally presented restamps their clear
+    void OnPresent(TimePoint call, TimePoint ret, bool presented);
+
+    void Reset();
+
+    uint64_t Inputs() const { return m_nextId; }
+    uint64_t Completed() const { return m_histograms[0].Count(); }
+    uint64_t Dropped() const { return m_dropped; }
+    uint64_t PresentRetries() const { return m_retries; }
+    bool HasLast() const { return m_hasLast; }
+    const LatencyBreakdown &Last() const { return m_last; }
+
+    const LogHistogram &Histogram(LatencyStage stage) const { return m_histograms[(size_t)stage]; }
+    LatencyStageStats Stats(LatencyStage stage) const;
+
+    // CSV: stage, low_us, high_us, count (non-empty buckets of every stage)
+    bool Export(const char *path) const;
+
+private:
+    struct InFlight
+    {
+        uint32_t id;
+        bool cleared;
+        TimePoint arrival;
+        TimePoint decoded;
+        TimePoint trigger;
+        TimePoint clear;
+    };
+
+    InFlight m_inFlight[MAX_IN_FLIGHT];
+    size_t m_count = 0;
+    uint32_t m_nextId = 0;
+    uint64_t m_dropped = 0;
+    uint64_t m_retries = 0;
+    bool m_hasLast = false;
+    LatencyBreakdown m_last;
+    LogHistogram m_histograms[LATENCY_STAGE_COUNT]; // ns
+};
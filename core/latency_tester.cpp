@@ -0,0 +1,61 @@
+#include "latency_tester.h"
+#include <cwchar>
+
+// Truncating copy; returns the copied length
+template <size_t N>
+static size_t CopyText(wchar_t (&dest)[N], const wchar_t *src)
+{
+    size_t len = 0;
+    while (len < N - 1 && src[len])
+    {
+        dest[len] = src[len];
+        len++;
+    }
+    dest[len] = L'\0';
+    return len;
+}
+
+InputAction LatencyTester::OnInput(const InputEvent &ev, const wchar_t *deviceName, const wchar_t *keyName)
+{
+    InputAction action = ClassifyInput(ev, filter);
+    if (action == InputAction::None)
+        return action;
+
+    wchar_t inputInfo[128];
+    DescribeInput(ev, action, keyName, inputInfo, 128);
+
+    wchar_t deviceInfo[256];
+    DescribeDevice(ev, deviceName, deviceInfo, 256);
+
+    TriggerFlash(ev.time, inputInfo, deviceInfo);
+
+    // Binary record only; text is formatted when the row is drawn
+    if (enableLog)
+    {
+        log.Add(ev, action);
+    }
+    return action;
+}
+
+void LatencyTester::TriggerFlash(TimePoint now, const wchar_t *inputInfo, const wchar_t *deviceInfo)
+{
+    flash.Trigger(now);
+    lastInputLength = CopyText(lastInputText, inputInfo);
+    lastDeviceLength = CopyText(lastDeviceText, deviceInfo);
+}
+
+void LatencyTester::ToggleLog()
+{
+    enableLog = !enableLog;
+    if (!enableLog)
+    {
+        log.Clear(); // Clear log when disabled
+    }
+}
+
+void LatencyTester::GetClearColor(float color[4]) const
+{
+    // Grey level of the current flash step (white for the default flash), black otherwise
+    color[0] = color[1] = color[2] = flash.level;
+    color[3] = 1.0f;
+}
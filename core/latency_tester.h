@@ -0,0 +1,34 @@
+// Platform-neutral state of the click-to-photon latency tester
+// Backends decode their native input into InputEvent and present the clear color
+#pragma once
+
+#include "event_log.h"
+#include "flash.h"
+#include "input_filter.h"
+
+struct LatencyTester
+{
+    InputFilter filter;
+    FlashState flash;
+    EventLog log;
+    bool enableLog = false; // F4 toggles
+
+    // Last input info for display (fixed buffers: no allocation per event)
+    wchar_t lastInputText[128] = L"Waiting for input...";
+    wchar_t lastDeviceText[256] = L"";
+    size_t lastInputLength = 20;
+    size_t lastDeviceLength = 0;
+
+    // Classifies the event and triggers a flash if it passes the filter
+    // keyName is only needed for keyboard events; returns the triggering action
+    InputAction OnInput(const InputEvent &ev, const wchar_t *deviceName, const wchar_t *keyName);
+
+    // Flashes and updates the on-screen input/device text (the log is fed by OnInput)
+    void TriggerFlash(TimePoint now, const wchar_t *inputInfo, const wchar_t *deviceInfo);
+
+    // Per-frame update; returns true while the screen should be white
+    bool UpdateFrame(TimePoint now) { return flash.Update(now); }
+
+    void ToggleLog();
+    void GetClearColor(float color[4]) const;
+};
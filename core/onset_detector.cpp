@@ -0,0 +1,281 @@
+#include "onset_detector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "audio_clock.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ONSET_HAS_SSE2 1
+#endif
+
+namespace
+{
+// Mean square of `count` samples, count a multiple of 4: four running sums (SSE2 lanes or
+// the same sums in scalar code)
+float MeanSquare(const float *samples, size_t count)
+{
+#ifdef ONSET_HAS_SSE2
+    __m128 sum = _mm_setzero_ps();
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(samples + i);
+        sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+#else
+    float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < count; i += 4)
+    {
+        for (size_t lane = 0; lane < 4; ++lane)
+            lanes[lane] += samples[i + lane] * samples[i + lane];
+    }
+#endif
+    return (lanes[0] + lanes[1] + lanes[2] + lanes[3]) / (float)count;
+}
+
+float EnergyDb(float energy)
+{
+    return energy > 0.0f ? 10.0f * std::log10(energy) : -200.0f;
+}
+
+// An onset placed on the host timebase
+struct OnsetTime
+{
+    size_t index; // Into the onsets
+    TimePoint time;
+};
+
+// Maps every onset the sync points cover; the fit is centred on each onset (every pair
+// before it plus half a window after)
+bool MapOnsets(const std::vector<DetectedOnset> &onsets, const std::vector<AudioSyncPoint> &sync,
+               std::vector<OnsetTime> &times)
+{
+    times.clear();
+    if (sync.size() < AudioClockCorrelator::MIN_SAMPLES)
+        return false;
+    AudioClockCorrelator clock;
+    size_t next = 0;
+    for (size_t i = 0; i < onsets.size(); ++i)
+    {
+        auto after = std::upper_bound(sync.begin(), sync.end(), onsets[i].frame,
+                                      [](uint64_t frame, const AudioSyncPoint &point) { return frame < point.frame; });
+        size_t until = std::min(sync.size(), (size_t)(after - sync.begin()) + AudioClockCorrelator::WINDOW / 2);
+        for (; next < until; ++next)
+            clock.Add(sync[next].frame, TimePoint(Clock::duration(sync[next].hostNs)));
+
+        TimePoint at;
+        double errorNs = 0.0;
+        if (clock.Fit().FrameTime(onsets[i].frame, at, errorNs))
+            times.push_back({i, at});
+    }
+    return true;
+}
+
+// Index of the first sample with |x| > level, or count
+size_t FirstAbove(const float *samples, size_t count, float level)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (std::fabs(samples[i]) > level)
+            return i;
+    }
+    return count;
+}
+} // namespace
+
+OnsetDetectorConfig ClickDetectorConfig()
+{
+    OnsetDetectorConfig config;
+    config.hopMs = 0.125f;
+    config.thresholdDb = 20.0f;
+    config.minLevelDb = -70.0f;
+    config.holdoffMs = 25.0f; // Press and release clicks are further apart than this
+    config.floorRiseMs = 200.0f;
+    return config;
+}
+
+void EmphasizeTransients(float *samples, size_t count)
+{
+    // Each output needs the original sample before it; carry it across blocks of four
+    float carry = 0.0f;
+    size_t i = 0;
+#ifdef ONSET_HAS_SSE2
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(samples + i);
+        __m128 previous = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)); // {0, x0, x1, x2}
+        previous = _mm_move_ss(previous, _mm_set_ss(carry));
+        carry = _mm_cvtss_f32(_mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3)));
+        _mm_storeu_ps(samples + i, _mm_sub_ps(x, previous));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        float x = samples[i];
+        samples[i] = x - carry;
+        carry = x;
+    }
+}
+
+OnsetDetector::OnsetDetector(uint32_t sampleRate, const OnsetDetectorConfig &config)
+{
+    size_t quads = (size_t)std::lround(sampleRate * config.hopMs / 1000.0 / 4.0);
+    m_hop = std::max<size_t>(quads, 1) * 4;
+    m_threshold = std::pow(10.0f, config.thresholdDb / 10.0f);
+    m_minEnergy = std::pow(10.0f, config.minLevelDb / 10.0f);
+    m_floorRise = 1.0f - std::exp(-(float)m_hop * 1000.0f / (sampleRate * config.floorRiseMs));
+    m_holdoff = (uint64_t)(sampleRate * config.holdoffMs / 1000.0);
+    m_pending.reserve(m_hop);
+    m_previous.reserve(m_hop);
+}
+
+float OnsetDetector::NoiseFloorDb() const
+{
+    return EnergyDb(std::max(m_floor, 0.0f));
+}
+
+void OnsetDetector::ProcessHop(const float *hop, const float *previous, uint64_t start,
+                               std::vector<DetectedOnset> &onsets)
+{
+    const float energy = MeanSquare(hop, m_hop);
+    if (m_floor < 0.0f)
+        m_floor = energy;
+    const float threshold = std::max(m_floor * m_threshold, m_minEnergy);
+
+    if (m_active)
+    {
+        // A level that outlasts ten holdoffs is not a stimulus: take it as the new floor
+        if (energy < threshold && start >= m_lastOnset + m_holdoff)
+            m_active = false;
+        else if (start >= m_lastOnset + 10 * m_holdoff)
+        {
+            m_floor = energy;
+            m_active = false;
+        }
+        return;
+    }
+
+    if (energy > threshold && (!m_haveOnset || start >= m_lastOnset + m_holdoff))
+    {
+        const float level = std::sqrt(threshold);
+        uint64_t frame = start;
+        size_t index = previous ? FirstAbove(previous, m_hop, level) : m_hop;
+        if (index < m_hop)
+            frame = start - m_hop + index;
+        else
+            frame = start + std::min(FirstAbove(hop, m_hop, level), m_hop - 1);
+        onsets.push_back({frame, EnergyDb(energy)});
+        m_active = true;
+        m_haveOnset = true;
+        m_lastOnset = frame;
+        return;
+    }
+
+    // Quiet: down to a lower level quickly, up slowly
+    m_floor += (energy - m_floor) * (energy < m_floor ? 0.25f : m_floorRise);
+}
+
+size_t OnsetDetector::Process(const float *samples, size_t count, std::vector<DetectedOnset> &onsets)
+{
+    const size_t before = onsets.size();
+    const float *previous = m_havePrevious ? m_previous.data() : nullptr;
+    size_t i = 0;
+
+    // Complete the hop left over from the last call
+    if (!m_pending.empty())
+    {
+        size_t take = std::min(m_hop - m_pending.size(), count);
+        m_pending.insert(m_pending.end(), samples, samples + take);
+        i = take;
+        if (m_pending.size() < m_hop)
+            return 0;
+        ProcessHop(m_pending.data(), previous, m_position, onsets);
+        m_position += m_hop;
+        m_previous.swap(m_pending);
+        m_pending.clear();
+        m_havePrevious = true;
+        previous = m_previous.data();
+    }
+
+    for (; i + m_hop <= count; i += m_hop)
+    {
+        ProcessHop(samples + i, previous, m_position, onsets);
+        m_position += m_hop;
+        previous = samples + i;
+    }
+    if (previous && previous != m_previous.data())
+    {
+        m_previous.assign(previous, previous + m_hop);
+        m_havePrevious = true;
+    }
+    m_pending.insert(m_pending.end(), samples + i, samples + count);
+    return onsets.size() - before;
+}
+
+bool MatchLoopbackOnsets(const std::vector<DetectedOnset> &onsets, const std::vector<AudioSyncPoint> &sync,
+                         const std::vector<LoopbackTrigger> &triggers, double maxLatencyMs,
+                         std::vector<LoopbackMatch> &matches)
+{
+    matches.clear();
+    std::vector<OnsetTime> times;
+    if (!MapOnsets(onsets, sync, times))
+        return false;
+
+    size_t trigger = 0;
+    bool triggerMatched = false;
+    for (const OnsetTime &onset : times)
+    {
+        const TimePoint at = onset.time;
+        // The last trigger at or before the onset
+        while (trigger + 1 < triggers.size() && triggers[trigger + 1].trigger <= at)
+        {
+            ++trigger;
+            triggerMatched = false;
+        }
+        if (trigger >= triggers.size() || triggers[trigger].trigger > at || triggerMatched)
+            continue;
+        const LoopbackTrigger &t = triggers[trigger];
+        double latencyMs = ElapsedMs(t.trigger, at);
+        if (latencyMs > maxLatencyMs)
+            continue;
+
+        LoopbackMatch match;
+        match.sequence = t.sequence;
+        match.frame = onsets[onset.index].frame;
+        match.onset = at;
+        match.latencyMs = latencyMs;
+        match.hasDacEstimate = t.hasDacEstimate;
+        match.dacErrorMs = t.hasDacEstimate ? ElapsedMs(t.dacEstimate, at) : 0.0;
+        matches.push_back(match);
+        triggerMatched = true;
+    }
+    return true;
+}
+
+bool MatchClickOnsets(const std::vector<DetectedOnset> &onsets, const std::vector<AudioSyncPoint> &sync,
+                      const std::vector<ClickPress> &presses, double maxLatencyMs, std::vector<ClickMatch> &matches)
+{
+    matches.clear();
+    std::vector<OnsetTime> times;
+    if (!MapOnsets(onsets, sync, times))
+        return false;
+
+    size_t next = 0;              // First onset after the current press
+    size_t claimed = times.size(); // Onset taken by the last match (none yet)
+    for (const ClickPress &press : presses)
+    {
+        while (next < times.size() && times[next].time <= press.arrival)
+            ++next;
+        if (next == 0 || next - 1 == claimed)
+            continue;
+        const OnsetTime &click = times[next - 1];
+        double latencyMs = ElapsedMs(click.time, press.arrival);
+        if (latencyMs > maxLatencyMs)
+            continue;
+        matches.push_back({press.deviceId, click.time, latencyMs});
+        claimed = next - 1;
+    }
+    return true;
+}
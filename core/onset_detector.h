@@ -0,0 +1,124 @@
+// Stimulus onset detection in recorded audio (loopback or microphone captures)
+// The signal is cut into hops of a fraction of a millisecond whose mean-square energy is
+// computed four samples at a time (SSE2 where available). A hop whose energy rises a
+// threshold above the tracked noise floor (and above an absolute level, for the digital
+// silence of a loopback capture) starts an onset, which is then placed on the first
+// sample of that hop or the one before whose magnitude exceeds the threshold's RMS level.
+// The detector stays quiet until the energy falls back under the threshold and a holdoff
+// has passed, so one stimulus gives one onset; a level that outlasts ten holdoffs becomes
+// the new noise floor. Input arrives in blocks of any size.
+//
+// MatchLoopbackOnsets then maps each onset to the host timebase through the capture's sync
+// points (AudioClockCorrelator, so the capture clock's drift is absorbed) and pairs it
+// with the stimulus trigger before it: the trigger -> sound latency of that stimulus.
+// MatchClickOnsets does the reverse for a microphone next to a mouse: each button-down
+// event is paired with the switch click heard before it (click -> WM_INPUT latency).
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "timing.h"
+#include "wav_file.h"
+
+struct OnsetDetectorConfig
+{
+    float hopMs = 0.25f;        // Energy window (rounded to a multiple of 4 samples)
+    float thresholdDb = 20.0f;  // Above the noise floor
+    float minLevelDb = -60.0f;  // Threshold never below this RMS level (dBFS)
+    float holdoffMs = 150.0f;   // Minimum spacing of two onsets
+    float floorRiseMs = 500.0f; // Noise floor time constant upwards (it follows drops within hops)
+};
+
+// A mouse switch click: short, broadband, a few ms long, with a release click to follow.
+// Meant for samples passed through EmphasizeTransients first.
+OnsetDetectorConfig ClickDetectorConfig();
+
+// In-place first difference (a gentle high-pass): hum and other low-frequency room noise
+// drop out, click transients stand out
+void EmphasizeTransients(float *samples, size_t count);
+
+struct DetectedOnset
+{
+    uint64_t frame;  // First sample above the threshold level
+    float levelDb;   // RMS level of the hop that triggered (dBFS)
+};
+
+class OnsetDetector
+{
+public:
+    explicit OnsetDetector(uint32_t sampleRate = 48000, const OnsetDetectorConfig &config = OnsetDetectorConfig());
+
+    // Appends the onsets found in the next `count` samples; returns how many
+    size_t Process(const float *samples, size_t count, std::vector<DetectedOnset> &onsets);
+
+    uint64_t Position() const { return m_position; } // Samples analysed (whole hops)
+    size_t Hop() const { return m_hop; }
+    float NoiseFloorDb() const;
+
+private:
+    // One full hop starting at sample `start`; `previous` is the hop before it (or null)
+    void ProcessHop(const float *hop, const float *previous, uint64_t start, std::vector<DetectedOnset> &onsets);
+
+    size_t m_hop;
+    float m_threshold;  // Energy ratio above the floor
+    float m_minEnergy;  // Mean square of minLevelDb
+    float m_floorRise;  // Per-hop smoothing factor upwards
+    uint64_t m_holdoff; // Samples
+
+    float m_floor = -1.0f; // Noise floor energy (negative: not yet measured)
+    bool m_active = false; // Inside a stimulus
+    uint64_t m_lastOnset = 0;
+    bool m_haveOnset = false;
+    uint64_t m_position = 0;
+    std::vector<float> m_pending;  // Partial hop carried to the next call
+    std::vector<float> m_previous; // Last full hop of the previous call
+    bool m_havePrevious = false;
+};
+
+// Time-stamped stimulus from a trace: the trigger and, if the audio thread timed it, the
+// estimated DAC time of its first sample
+struct LoopbackTrigger
+{
+    uint32_t sequence;
+    TimePoint trigger;
+    TimePoint dacEstimate;
+    bool hasDacEstimate = false;
+};
+
+struct LoopbackMatch
+{
+    uint32_t sequence;
+    uint64_t frame;
+    TimePoint onset;         // Host time of the detected onset
+    double latencyMs;        // onset - trigger
+    double dacErrorMs;       // onset - DAC estimate (0 if none)
+    bool hasDacEstimate;
+};
+
+// Onsets in frame order, triggers in time order. An onset more than maxLatencyMs after
+// the last trigger (or with no sync point near it) is left out; so is the second onset of
+// a trigger. Returns false if the capture has too few sync points to map any frame.
+bool MatchLoopbackOnsets(const std::vector<DetectedOnset> &onsets, const std::vector<AudioSyncPoint> &sync,
+                         const std::vector<LoopbackTrigger> &triggers, double maxLatencyMs,
+                         std::vector<LoopbackMatch> &matches);
+
+// Button-down event from a trace
+struct ClickPress
+{
+    uint16_t deviceId;
+    TimePoint arrival; // WM_INPUT timestamp
+};
+
+struct ClickMatch
+{
+    uint16_t deviceId;
+    TimePoint sound;  // Host time of the click onset
+    double latencyMs; // arrival - sound
+};
+
+// Onsets in frame order, presses in time order. Each press takes the last unclaimed onset
+// at most maxLatencyMs before it; a press without one (a silent switch, a missed onset) is
+// left out. Returns false if the capture has too few sync points to map any frame.
+bool MatchClickOnsets(const std::vector<DetectedOnset> &onsets, const std::vector<AudioSyncPoint> &sync,
+                      const std::vector<ClickPress> &presses, double maxLatencyMs, std::vector<ClickMatch> &matches);
@@ -0,0 +1,93 @@
+#include "overlay_text.h"
+#include <cwchar>
+
+static size_t Terminate(int written, wchar_t *out, size_t outSize)
+{
+    if (written >= 0)
+        return (size_t)written;
+    if (outSize == 0)
+        return 0;
+    out[outSize - 1] = L'\0';
+    return wcslen(out);
+}
+
+const wchar_t *InstructionText::Update(const LatencyTester &tester, const OverlayToggles &toggles)
+{
+    const InputFilter &filter = tester.filter;
+    uint32_t key = (filter.enableMouseButtons ? 1u : 0u) | (filter.enableKeyboard ? 2u : 0u) |
+                   (filter.enableMouseDelta ? 4u : 0u) | (tester.enableLog ? 8u : 0u) |
+                   (filter.enableUpEvents ? 16u : 0u) | (toggles.mouseHz ? 32u : 0u) |
+                   (toggles.overlay ? 64u : 0u) | (toggles.fullscreen ? 128u : 0u) |
+                   (tester.flash.HasPattern() ? 256u : 0u) | ((uint32_t)toggles.statsView << 9) |
+                   ((uint32_t)toggles.wait << 11) | ((uint32_t)tester.flash.DurationMs() << 13);
+    if (key == m_key)
+        return m_text;
+
+    auto sign = [](bool on) { return on ? L"+" : L"-"; };
+    static const wchar_t *const VIEWS[] = {L"EMA", L"PCT", L"LAT"};
+    static const wchar_t *const WAITS[] = {L"SPIN", L"YIELD", L"HYB", L"WAIT"};
+    wchar_t flashText[16];
+    if (tester.flash.HasPattern())
+        swprintf(flashText, 16, L"PATTERN");
+    else
+        swprintf(flashText, 16, L"%dms", tester.flash.DurationMs());
+    int written = swprintf(m_text, sizeof(m_text) / sizeof(m_text[0]),
+                           L"ESC | F1=Mouse[%ls] F2=KB[%ls] F3=Dlt[%ls] F4=Log[%ls] F7=Up[%ls] F8=Hz[%ls] "
+                           L"F9=OL[%ls] F10=[%ls] F11=[%ls] F12=[%ls] F5/6=%ls",
+                           sign(filter.enableMouseButtons), sign(filter.enableKeyboard), sign(filter.enableMouseDelta),
+                           sign(tester.enableLog), sign(filter.enableUpEvents), sign(toggles.mouseHz),
+                           sign(toggles.overlay), toggles.fullscreen ? L"FSE" : L"WIN",
+                           VIEWS[(size_t)toggles.statsView], WAITS[(size_t)toggles.wait], flashText);
+    m_length = Terminate(written, m_text, sizeof(m_text) / sizeof(m_text[0]));
+    m_key = key;
+    return m_text;
+}
+
+size_t FormatFrameStats(float fps, float frameTimeMs, const FrameTimeStats *frames, const WaitStats *wait,
+                        const PollingRateStats *hz, wchar_t *out, size_t outSize)
+{
+    int written;
+    if (frames)
+    {
+        written = swprintf(out, outSize, L"%.1f FPS (mean)\np50/99 %.3f/%.3f ms\np99.9 %.3f ms\nmax %.3f ms",
+                           frames->meanMs > 0.0 ? 1000.0 / frames->meanMs : 0.0, frames->p50Ms, frames->p99Ms,
+                           frames->p999Ms, frames->maxMs);
+    }
+    else
+    {
+        written = swprintf(out, outSize, L"%.1f FPS\n%.2f ms", fps, frameTimeMs);
+    }
+    if (wait && written >= 0 && (size_t)written < outSize)
+    {
+        int more = swprintf(out + written, outSize - written,
+                            L"\nCPU %.0f%%, late p99 %.1f us\ninput handled p99 %.1f us",
+                            wait->cpuPercent, wait->lateP99Us, wait->inputP99Us);
+        written = more >= 0 ? written + more : -1;
+    }
+    if (hz && written >= 0 && (size_t)written < outSize)
+    {
+        int more = swprintf(out + written, outSize - written,
+                            L"\n%.0f Hz (%.0f)\np1/50/99 %.0f/%.0f/%.0f us\njitter %.1f us\ndropped %llu",
+                            hz->rateHz, hz->instantHz, hz->p1IntervalUs, hz->p50IntervalUs, hz->p99IntervalUs,
+                            hz->jitterUs, (unsigned long long)hz->droppedEstimate);
+        written = more >= 0 ? written + more : -1;
+    }
+    return Terminate(written, out, outSize);
+}
+
+size_t FormatStageStats(const LatencyAttribution &stages, wchar_t *out, size_t outSize)
+{
+    static const wchar_t *const NAMES[LATENCY_STAGE_COUNT] = {L"decode", L"trigger", L"clear", L"present call",
+                                                                L"present ret", L"total"};
+    int written = swprintf(out, outSize, L"%llu inputs attributed (%llu retries)\nstage  p50/p99/max us | last",
+                           (unsigned long long)stages.Completed(), (unsigned long long)stages.PresentRetries());
+    for (size_t stage = 0; stage < LATENCY_STAGE_COUNT && written >= 0 && (size_t)written < outSize; ++stage)
+    {
+        LatencyStageStats stats = stages.Stats((LatencyStage)stage);
+        double lastUs = stages.HasLast() ? stages.Last().stageNs[stage] / 1000.0 : 0.0;
+        int more = swprintf(out + written, outSize - written, L"\n%ls %.1f/%.1f/%.1f | %.1f", NAMES[stage],
+                            stats.p50Us, stats.p99Us, stats.maxUs, lastUs);
+        written = more >= 0 ? written + more : -1;
+    }
+    return Terminate(written, out, outSize);
+}
@@ -0,0 +1,50 @@
+// Overlay strings of the latency tester, formatted into fixed buffers
+// The instruction line only changes on a key press, so it is rebuilt only then
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "frame_times.h"
+#include "latency_stages.h"
+#include "latency_tester.h"
+#include "polling_rate.h"
+#include "wait_strategy.h"
+
+// Top-right statistics block (F11 cycles)
+enum class StatsView : uint8_t
+{
+    Smoothed,   // EMA of FPS and frame time
+    FrameTimes, // Frame time percentiles and histogram
+    Stages      // Input-to-present latency attribution
+};
+
+struct OverlayToggles
+{
+    bool mouseHz = false;
+    bool overlay = true;
+    bool fullscreen = false;
+    StatsView statsView = StatsView::Smoothed;
+    WaitStrategy wait = WaitStrategy::Spin;
+};
+
+class InstructionText
+{
+public:
+    // Returns the current line; reformats only if a toggle or the flash duration changed
+    const wchar_t *Update(const LatencyTester &tester, const OverlayToggles &toggles);
+    size_t Length() const { return m_length; }
+
+private:
+    uint32_t m_key = UINT32_MAX;
+    wchar_t m_text[192] = L"";
+    size_t m_length = 0;
+};
+
+// "FPS / frame time" block (smoothed, or percentiles when frames is set), the wait
+// strategy's CPU usage and wake lateness when wait is set, and the polling-rate lines
+// when hz is set
+size_t FormatFrameStats(float fps, float frameTimeMs, const FrameTimeStats *frames, const WaitStats *wait,
+                        const PollingRateStats *hz, wchar_t *out, size_t outSize);
+
+// Per-stage p50/p99/max of completed inputs and the newest input's breakdown
+size_t FormatStageStats(const LatencyAttribution &stages, wchar_t *out, size_t outSize);
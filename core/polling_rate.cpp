@@ -0,0 +1,89 @@
+#include "polling_rate.h"
+#include <cmath>
+
+static int64_t ToNs(TimePoint time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void PollingRateAnalyzer::AdvanceWindow(int64_t nowMs)
+{
+    if (nowMs <= m_windowMs)
+        return;
+
+    // Clear the buckets that fell out of the window (at most all of them)
+    int64_t steps = nowMs - m_windowMs;
+    if (steps > WINDOW_BUCKETS)
+        steps = WINDOW_BUCKETS;
+    for (int64_t i = 1; i <= steps; ++i)
+    {
+        uint32_t &bucket = m_window[(m_windowMs + i) % WINDOW_BUCKETS];
+        m_windowCount -= bucket;
+        bucket = 0;
+    }
+    m_windowMs = nowMs;
+}
+
+void PollingRateAnalyzer::Record(TimePoint time)
+{
+    int64_t ns = ToNs(time);
+    int64_t ms = ns / 1000000;
+
+    if (!m_hasLast)
+        m_windowMs = ms;
+    AdvanceWindow(ms);
+    if (ms > m_windowMs - WINDOW_BUCKETS)
+    {
+        m_window[((ms % WINDOW_BUCKETS) + WINDOW_BUCKETS) % WINDOW_BUCKETS]++;
+        m_windowCount++;
+    }
+    m_reports++;
+
+    if (m_hasLast)
+    {
+        int64_t interval = ns - m_lastNs;
+        if (interval >= 0 && interval < IDLE_GAP_NS)
+        {
+            // Long intervals while moving mean the device skipped reports
+            if (m_emaIntervalNs > 0.0 && interval > 1.5 * m_emaIntervalNs)
+            {
+                m_dropped += (uint64_t)std::llround(interval / m_emaIntervalNs) - 1;
+            }
+            else
+            {
+                m_emaIntervalNs = m_emaIntervalNs > 0.0 ? m_emaIntervalNs * 0.95 + interval * 0.05 : (double)interval;
+            }
+
+            m_intervals.Record(interval);
+            m_intervalCount++;
+            double delta = interval - m_mean;
+            m_mean += delta / (double)m_intervalCount;
+            m_m2 += delta * (interval - m_mean);
+        }
+    }
+    m_lastNs = ns;
+    m_hasLast = true;
+}
+
+PollingRateStats PollingRateAnalyzer::Snapshot(TimePoint now)
+{
+    if (m_hasLast)
+        AdvanceWindow(ToNs(now) / 1000000);
+
+    PollingRateStats stats;
+    stats.rateHz = (double)m_windowCount;
+    stats.instantHz = m_emaIntervalNs > 0.0 ? 1e9 / m_emaIntervalNs : 0.0;
+    stats.meanIntervalUs = m_mean / 1000.0;
+    stats.p1IntervalUs = m_intervals.Percentile(1.0) / 1000.0;
+    stats.p50IntervalUs = m_intervals.Percentile(50.0) / 1000.0;
+    stats.p99IntervalUs = m_intervals.Percentile(99.0) / 1000.0;
+    stats.jitterUs = m_intervalCount > 1 ? std::sqrt(m_m2 / (double)(m_intervalCount - 1)) / 1000.0 : 0.0;
+    stats.reports = m_reports;
+    stats.droppedEstimate = m_dropped;
+    return stats;
+}
+
+void PollingRateAnalyzer::Reset()
+{
+    *this = PollingRateAnalyzer();
+}
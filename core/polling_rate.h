@@ -0,0 +1,54 @@
+// Mouse polling-rate analyzer: fixed memory, O(1) per report
+// Inter-report intervals go into a histogram (percentiles) and running moments
+// (mean, jitter); a 1 ms bucket ring keeps the reports-in-the-last-second count.
+#pragma once
+
+#include <cstdint>
+#include "histogram.h"
+#include "timing.h"
+
+struct PollingRateStats
+{
+    double rateHz = 0.0;         // Reports in the last second
+    double instantHz = 0.0;      // From the smoothed recent interval
+    double meanIntervalUs = 0.0;
+    double p1IntervalUs = 0.0;
+    double p50IntervalUs = 0.0;
+    double p99IntervalUs = 0.0;
+    double jitterUs = 0.0;       // Standard deviation of the interval
+    uint64_t reports = 0;
+    uint64_t droppedEstimate = 0; // Missing reports inferred from long intervals
+};
+
+class PollingRateAnalyzer
+{
+public:
+    // Gaps longer than this are the mouse resting, not dropped reports
+    static constexpr int64_t IDLE_GAP_NS = 20000000; // 20 ms
+
+    void Record(TimePoint time);
+    PollingRateStats Snapshot(TimePoint now);
+    void Reset();
+
+private:
+    static constexpr int WINDOW_BUCKETS = 1000; // 1 ms each
+
+    void AdvanceWindow(int64_t nowMs);
+
+    LogHistogram m_intervals; // ns
+    int64_t m_lastNs = 0;
+    bool m_hasLast = false;
+    uint64_t m_reports = 0;
+
+    // Welford running mean/variance of the interval (ns)
+    uint64_t m_intervalCount = 0;
+    double m_mean = 0.0;
+    double m_m2 = 0.0;
+
+    double m_emaIntervalNs = 0.0;
+    uint64_t m_dropped = 0;
+
+    uint32_t m_window[WINDOW_BUCKETS] = {};
+    int64_t m_windowMs = 0; // Absolute ms of the newest bucket
+    uint32_t m_windowCount = 0;
+};
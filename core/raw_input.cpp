@@ -0,0 +1,115 @@
+#include "raw_input.h"
+#include <cstring>
+
+static_assert(sizeof(RawMouse) == 24, "RAWMOUSE layout");
+static_assert(sizeof(RawKeyboard) == 16, "RAWKEYBOARD layout");
+
+static size_t AlignRecord(size_t offset)
+{
+    return (offset + RAW_INPUT_ALIGNMENT - 1) & ~(RAW_INPUT_ALIGNMENT - 1);
+}
+
+bool DecodeRawInputRecord(const void *record, size_t bytes, TimePoint time, DeviceRegistry &devices,
+                          InputEvent &ev)
+{
+    if (bytes < sizeof(RawInputHeader))
+        return false;
+
+    RawInputHeader header;
+    memcpy(&header, record, sizeof(header));
+    const uint8_t *payload = (const uint8_t *)record + sizeof(RawInputHeader);
+
+    ev = InputEvent{};
+    ev.time = time;
+
+    if (header.type == RAW_TYPE_MOUSE)
+    {
+        if (bytes < sizeof(RawInputHeader) + sizeof(RawMouse))
+            return false;
+        RawMouse mouse;
+        memcpy(&mouse, payload, sizeof(mouse));
+        ev.type = InputType::Mouse;
+        ev.buttonFlags = mouse.buttonFlags;
+        ev.buttonData = (int16_t)mouse.buttonData;
+        ev.dx = mouse.lastX;
+        ev.dy = mouse.lastY;
+    }
+    else if (header.type == RAW_TYPE_KEYBOARD)
+    {
+        if (bytes < sizeof(RawInputHeader) + sizeof(RawKeyboard))
+            return false;
+        RawKeyboard kb;
+        memcpy(&kb, payload, sizeof(kb));
+        ev.type = InputType::Keyboard;
+        ev.vkey = kb.vkey;
+        ev.makeCode = kb.makeCode;
+        ev.keyFlags = kb.flags;
+    }
+    else
+    {
+        return false; // HID device, ignore for now
+    }
+
+    ev.deviceId = devices.Lookup((uint64_t)header.device);
+    return true;
+}
+
+size_t DecodeRawInputBatch(const void *buffer, size_t bytes, uint32_t count, TimePoint time,
+                           DeviceRegistry &devices, InputEvent *out, size_t maxEvents)
+{
+    const uint8_t *base = (const uint8_t *)buffer;
+    size_t offset = 0;
+    size_t written = 0;
+
+    for (uint32_t i = 0; i < count && written < maxEvents; ++i)
+    {
+        if (offset + sizeof(RawInputHeader) > bytes)
+            break;
+
+        uint32_t size;
+        memcpy(&size, base + offset + offsetof(RawInputHeader, size), sizeof(size));
+        if (size < sizeof(RawInputHeader) || offset + size > bytes)
+            break; // Truncated or corrupt batch
+
+        if (DecodeRawInputRecord(base + offset, size, time, devices, out[written]))
+            written++;
+
+        offset = AlignRecord(offset + size);
+    }
+    return written;
+}
+
+static void AppendRecord(std::vector<uint8_t> &batch, uint32_t type, uintptr_t device,
+                         const void *payload, size_t payloadSize)
+{
+    size_t offset = AlignRecord(batch.size());
+    RawInputHeader header = {};
+    header.type = type;
+    header.size = (uint32_t)(sizeof(RawInputHeader) + payloadSize);
+    header.device = device;
+
+    batch.resize(offset + header.size, 0);
+    memcpy(&batch[offset], &header, sizeof(header));
+    memcpy(&batch[offset + sizeof(header)], payload, payloadSize);
+}
+
+void AppendRawMouse(std::vector<uint8_t> &batch, uintptr_t device, uint16_t buttonFlags,
+                    int16_t buttonData, int32_t dx, int32_t dy)
+{
+    RawMouse mouse = {};
+    mouse.buttonFlags = buttonFlags;
+    mouse.buttonData = (uint16_t)buttonData;
+    mouse.lastX = dx;
+    mouse.lastY = dy;
+    AppendRecord(batch, RAW_TYPE_MOUSE, device, &mouse, sizeof(mouse));
+}
+
+void AppendRawKeyboard(std::vector<uint8_t> &batch, uintptr_t device, uint16_t vkey,
+                       uint16_t makeCode, uint16_t flags)
+{
+    RawKeyboard kb = {};
+    kb.vkey = vkey;
+    kb.makeCode = makeCode;
+    kb.flags = flags;
+    AppendRecord(batch, RAW_TYPE_KEYBOARD, device, &kb, sizeof(kb));
+}
@@ -0,0 +1,68 @@
+// Portable mirror of the Win32 RAWINPUT layout and decoders for single reports
+// and GetRawInputBuffer batches, so recorded raw buffers decode the same on Linux
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "device_registry.h"
+#include "input_event.h"
+
+// RIM_TYPE* values
+constexpr uint32_t RAW_TYPE_MOUSE = 0;
+constexpr uint32_t RAW_TYPE_KEYBOARD = 1;
+constexpr uint32_t RAW_TYPE_HID = 2;
+
+// RAWINPUTHEADER (handle-sized fields follow the process bitness)
+// Layouts are checked against the SDK in win32/raw_input.h
+struct RawInputHeader
+{
+    uint32_t type;
+    uint32_t size; // Whole record including header
+    uintptr_t device;
+    uintptr_t wParam;
+};
+
+// RAWMOUSE
+struct RawMouse
+{
+    uint16_t flags;
+    uint16_t padding; // ulButtons union is DWORD aligned
+    uint16_t buttonFlags;
+    uint16_t buttonData;
+    uint32_t rawButtons;
+    int32_t lastX;
+    int32_t lastY;
+    uint32_t extraInformation;
+};
+
+// RAWKEYBOARD
+struct RawKeyboard
+{
+    uint16_t makeCode;
+    uint16_t flags;
+    uint16_t reserved;
+    uint16_t vkey;
+    uint32_t message;
+    uint32_t extraInformation;
+};
+
+// Records in a GetRawInputBuffer batch are aligned like NEXTRAWINPUTBLOCK
+// (QWORD on 64-bit, DWORD on 32-bit). WOW64 processes get 64-bit headers and
+// are not supported by the batch decoder.
+constexpr size_t RAW_INPUT_ALIGNMENT = sizeof(void *);
+
+// Decodes one RAWINPUT record; returns false for HID and malformed records
+bool DecodeRawInputRecord(const void *record, size_t bytes, TimePoint time, DeviceRegistry &devices,
+                          InputEvent &ev);
+
+// Decodes up to count records of a GetRawInputBuffer batch in one tight loop
+// All events get the drain timestamp; returns the number of events written
+size_t DecodeRawInputBatch(const void *buffer, size_t bytes, uint32_t count, TimePoint time,
+                           DeviceRegistry &devices, InputEvent *out, size_t maxEvents);
+
+// Builders for recorded/synthetic batches (layout identical to GetRawInputBuffer output)
+void AppendRawMouse(std::vector<uint8_t> &batch, uintptr_t device, uint16_t buttonFlags,
+                    int16_t buttonData, int32_t dx, int32_t dy);
+void AppendRawKeyboard(std::vector<uint8_t> &batch, uintptr_t device, uint16_t vkey,
+                       uint16_t makeCode, uint16_t flags);
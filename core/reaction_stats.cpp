@@ -0,0 +1,119 @@
+#include "reaction_stats.h"
+#include <algorithm>
+#include <cmath>
+
+// Highest power of two <= BINS, the first step of a Fenwick descent
+static constexpr size_t TopStep()
+{
+    size_t step = 1;
+    while (step * 2 <= ReactionStats::BINS)
+        step *= 2;
+    return step;
+}
+
+void ReactionStats::Add(float reactionMs)
+{
+    if (m_countTree.empty())
+    {
+        m_countTree.assign(BINS + 1, 0);
+        m_sumTree.assign(BINS + 1, 0);
+        m_history.reserve(1024);
+    }
+
+    m_history.push_back(reactionMs);
+    size_t n = m_history.size();
+    double delta = reactionMs - m_mean;
+    m_mean += delta / (double)n;
+    m_m2 += delta * (reactionMs - m_mean);
+    if (n == 1 || reactionMs < m_best)
+        m_best = reactionMs;
+    if (n == 1 || reactionMs > m_worst)
+        m_worst = reactionMs;
+
+    double scaled = std::floor(reactionMs / BIN_MS + 0.5);
+    uint32_t bin = scaled <= 0.0 ? 0 : (scaled >= (double)(BINS - 1) ? (uint32_t)(BINS - 1) : (uint32_t)scaled);
+    for (size_t i = bin + 1; i <= BINS; i += i & (~i + 1))
+    {
+        m_countTree[i]++;
+        m_sumTree[i] += bin;
+    }
+
+    m_recent[m_recentHead] = reactionMs;
+    m_recentHead = (m_recentHead + 1) % DISPLAY_ENTRIES;
+    if (m_recentCount < DISPLAY_ENTRIES)
+        m_recentCount++;
+}
+
+void ReactionStats::Clear()
+{
+    m_history.clear();
+    m_mean = m_m2 = 0.0;
+    m_best = m_worst = 0.0f;
+    std::fill(m_countTree.begin(), m_countTree.end(), 0u);
+    std::fill(m_sumTree.begin(), m_sumTree.end(), 0ull);
+    m_recentHead = m_recentCount = 0;
+}
+
+double ReactionStats::StdDev() const
+{
+    return std::sqrt(Variance());
+}
+
+uint32_t ReactionStats::Bin(size_t rank) const
+{
+    size_t pos = 0;
+    size_t remaining = rank + 1;
+    for (size_t step = TopStep(); step > 0; step >>= 1)
+    {
+        if (pos + step <= BINS && m_countTree[pos + step] < remaining)
+        {
+            pos += step;
+            remaining -= m_countTree[pos];
+        }
+    }
+    return (uint32_t)pos; // 1-based tree index pos + 1 is bin pos
+}
+
+uint64_t ReactionStats::SumLowest(size_t count) const
+{
+    if (count == 0)
+        return 0;
+    size_t pos = 0;
+    size_t below = 0;
+    uint64_t sum = 0;
+    for (size_t step = TopStep(); step > 0; step >>= 1)
+    {
+        if (pos + step <= BINS && below + m_countTree[pos + step] < count)
+        {
+            pos += step;
+            below += m_countTree[pos];
+            sum += m_sumTree[pos];
+        }
+    }
+    // The remaining trials all sit in bin pos
+    return sum + (uint64_t)(count - below) * pos;
+}
+
+double ReactionStats::Percentile(double p) const
+{
+    size_t n = Count();
+    if (n == 0)
+        return 0.0;
+    p = p < 0.0 ? 0.0 : (p > 100.0 ? 100.0 : p);
+    double h = (double)(n - 1) * p / 100.0;
+    size_t low = (size_t)h;
+    double value = Bin(low);
+    if (low + 1 < n)
+        value += (h - (double)low) * ((double)Bin(low + 1) - value);
+    return value * BIN_MS;
+}
+
+double ReactionStats::TrimmedMean(double trimPercent) const
+{
+    size_t n = Count();
+    size_t trim = (size_t)((double)n * trimPercent / 100.0);
+    if (n == 0 || 2 * trim >= n)
+        return Median();
+    uint64_t sum = SumLowest(n - trim) - SumLowest(trim);
+    return (double)sum / (double)(n - 2 * trim) * BIN_MS;
+}
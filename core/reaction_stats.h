@@ -0,0 +1,61 @@
+// Reaction time statistics over the whole session, updated online
+// Mean and variance are Welford running sums (exact). Order statistics come from two
+// Fenwick trees over 0.1 ms bins (trial count and bin sum), so median, any percentile
+// and the trimmed mean cost O(log bins) per query and per trial, at display resolution.
+// Every trial is kept in order; the 25 newest are also kept as the on-screen list.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ReactionStats
+{
+public:
+    static constexpr size_t DISPLAY_ENTRIES = 25;
+    static constexpr double BIN_MS = 0.1;
+    static constexpr size_t BINS = 100001; // 0-10 s; slower trials count in the last bin
+
+    void Add(float reactionMs);
+    void Clear();
+
+    size_t Count() const { return m_history.size(); }
+    bool Empty() const { return m_history.empty(); }
+    float Last() const { return m_history.empty() ? 0.0f : m_history.back(); }
+    float Best() const { return m_best; }
+    float Worst() const { return m_worst; }
+    double Mean() const { return m_mean; }
+    double Variance() const { return Count() > 1 ? m_m2 / (double)(Count() - 1) : 0.0; } // Sample variance
+    double StdDev() const;
+
+    // Linear interpolation between the closest ranks, p in [0, 100]
+    double Percentile(double p) const;
+    double Median() const { return Percentile(50.0); }
+    // Mean without the fastest and slowest trimPercent % of trials
+    double TrimmedMean(double trimPercent) const;
+
+    // On-screen list, newest first
+    size_t RecentCount() const { return m_recentCount; }
+    float Recent(size_t i) const { return m_recent[(m_recentHead + DISPLAY_ENTRIES - 1 - i) % DISPLAY_ENTRIES]; }
+
+    // Every trial of the session in order
+    const std::vector<float> &History() const { return m_history; }
+
+private:
+    uint32_t Bin(size_t rank) const;       // Bin of the rank-th fastest trial (0-based)
+    uint64_t SumLowest(size_t count) const; // Sum of the bins of the `count` fastest trials
+
+    std::vector<float> m_history;
+    double m_mean = 0.0;
+    double m_m2 = 0.0;
+    float m_best = 0.0f;
+    float m_worst = 0.0f;
+
+    // Fenwick trees, 1-based, allocated on the first trial
+    std::vector<uint32_t> m_countTree;
+    std::vector<uint64_t> m_sumTree;
+
+    float m_recent[DISPLAY_ENTRIES] = {};
+    size_t m_recentHead = 0;
+    size_t m_recentCount = 0;
+};
@@ -0,0 +1,125 @@
+#include "reaction_tester.h"
+
+static int64_t SessionNs(TimePoint time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+Clock::duration ReactionTester::GetRandomDelay()
+{
+    // Whole microseconds: the delay is kept in integer ticks from here on
+    std::uniform_int_distribution<int64_t> dist((int64_t)(minDelayMs * 1000.0f), (int64_t)(maxDelayMs * 1000.0f));
+    return std::chrono::microseconds(dist(rng));
+}
+
+void ReactionTester::StartNewRound(TimePoint now)
+{
+    state = TestState::Waiting;
+    roundStartTime = now;
+    targetDelay = GetRandomDelay();
+    beepPlayed = false;
+    m_stimulusTimed = false;
+}
+
+void ReactionTester::Reset(TimePoint now)
+{
+    stats.Clear();
+    stimulusErrorUs = -1.0f;
+    StartNewRound(now);
+}
+
+void ReactionTester::ToggleAudioMode(TimePoint now)
+{
+    audioMode = !audioMode;
+    Reset(now);
+}
+
+ReactionEvent ReactionTester::Update(TimePoint now)
+{
+    if (state != TestState::Waiting)
+        return ReactionEvent::None;
+
+    if (now - roundStartTime < targetDelay)
+        return ReactionEvent::None;
+
+    state = TestState::Flashing;
+    flashStartTime = now;
+    if (audioMode)
+    {
+        beepPlayed = true;
+    }
+    return ReactionEvent::StimulusOnset;
+}
+
+ReactionEvent ReactionTester::OnInput(const InputEvent &ev)
+{
+    if (ev.type != InputType::Mouse)
+        return ReactionEvent::None;
+
+    // Check for any button down
+    bool buttonDown = (ev.buttonFlags & MOUSE_LEFT_DOWN) ||
+                      (ev.buttonFlags & MOUSE_RIGHT_DOWN) ||
+                      (ev.buttonFlags & MOUSE_MIDDLE_DOWN);
+    if (!buttonDown)
+        return ReactionEvent::None;
+
+    if (state == TestState::Waiting)
+    {
+        // Clicked too early!
+        RecordTrial(ev, TRIAL_FALSE_START);
+        state = TestState::TooEarly;
+        return ReactionEvent::FalseStart;
+    }
+    if (state == TestState::Flashing)
+    {
+        // Record reaction time
+        float reactionMs = (float)ElapsedMs(flashStartTime, ev.time);
+        stats.Add(reactionMs);
+        RecordTrial(ev, 0);
+        StartNewRound(ev.time);
+        return ReactionEvent::Response;
+    }
+
+    // Click to restart after false start
+    StartNewRound(ev.time);
+    return ReactionEvent::Restart;
+}
+
+bool ReactionTester::SetStimulusTime(TimePoint dacTime, float errorUs)
+{
+    if (state != TestState::Flashing || !audioMode)
+        return false;
+    flashStartTime = dacTime;
+    stimulusErrorUs = errorUs;
+    m_stimulusTimed = true;
+    return true;
+}
+
+void ReactionTester::RecordTrial(const InputEvent &ev, uint8_t flags)
+{
+    Trial trial;
+    trial.foreperiodNs = std::chrono::duration_cast<std::chrono::nanoseconds>(targetDelay).count();
+    trial.stimulusNs = (flags & TRIAL_FALSE_START) ? 0 : SessionNs(flashStartTime);
+    trial.responseNs = SessionNs(ev.time);
+    trial.device = ev.deviceId;
+    trial.mode = audioMode ? TrialMode::Audio : TrialMode::Visual;
+    trial.flags = flags | (m_stimulusTimed && !(flags & TRIAL_FALSE_START) ? TRIAL_DAC_TIMED : 0);
+    trials.Append(trial);
+}
+
+void ReactionTester::GetClearColor(float color[4]) const
+{
+    color[0] = color[1] = color[2] = 0.0f;
+    color[3] = 1.0f;
+    if (state == TestState::Flashing && !audioMode)
+    {
+        // Only flash white in visual mode
+        color[0] = color[1] = color[2] = 1.0f;
+    }
+    else if (state == TestState::TooEarly)
+    {
+        color[0] = 0.8f; // Red-ish for false start
+        color[1] = 0.1f;
+        color[2] = 0.1f;
+    }
+}
@@ -0,0 +1,73 @@
+// Platform-neutral state machine of the visual/audio reaction time tester
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include "input_event.h"
+#include "reaction_stats.h"
+#include "trial_store.h"
+
+// Test state
+enum class TestState
+{
+    Waiting,      // Black screen, waiting for random delay
+    Flashing,     // White screen, waiting for click
+    TooEarly      // Clicked before flash (false start)
+};
+
+enum class ReactionEvent
+{
+    None,
+    StimulusOnset, // Waiting -> Flashing this frame (play the beep in audio mode)
+    Response,      // Reaction time recorded
+    FalseStart,    // Clicked while waiting
+    Restart        // Clicked to retry after a false start
+};
+
+struct ReactionTester
+{
+    float minDelayMs = 1500.0f;  // Minimum wait before flash
+    float maxDelayMs = 5000.0f;  // Maximum wait before flash
+
+    TestState state = TestState::Waiting;
+    TimePoint roundStartTime;
+    TimePoint flashStartTime;
+    Clock::duration targetDelay{0};
+
+    ReactionStats stats;
+    TrialStore trials;             // Every response and false start, kept across resets
+
+    bool audioMode = false;        // F1 toggles: false=visual, true=audio
+    bool beepPlayed = false;       // Track if beep was played this round
+    float stimulusErrorUs = -1.0f; // Error of the last DAC-timed audio onset (negative: none yet)
+
+    uint32_t seed;                 // Kept so a trace can reproduce the delays
+    std::mt19937 rng;
+
+    explicit ReactionTester(uint32_t seed = std::random_device{}()) : seed(seed), rng(seed) {}
+
+    void StartNewRound(TimePoint now);
+
+    // Clears results and starts over (SPACE, F1)
+    void Reset(TimePoint now);
+    void ToggleAudioMode(TimePoint now);
+
+    // Waiting -> Flashing transition; call once per frame
+    ReactionEvent Update(TimePoint now);
+
+    // Only mouse button down events matter
+    ReactionEvent OnInput(const InputEvent &ev);
+
+    // Audio mode: the beep's first sample reaches the DAC at `dacTime` (estimated from the
+    // device clock), which replaces the frame time as this round's stimulus time. Ignored
+    // once the round has been answered; false then.
+    bool SetStimulusTime(TimePoint dacTime, float errorUs);
+
+    void GetClearColor(float color[4]) const;
+
+private:
+    bool m_stimulusTimed = false; // flashStartTime is the DAC estimate this round
+
+    Clock::duration GetRandomDelay();
+    void RecordTrial(const InputEvent &ev, uint8_t flags);
+};
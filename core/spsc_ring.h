@@ -0,0 +1,92 @@
+// Fixed-capacity lock-free single-producer/single-consumer ring
+// Head and tail live on separate cache lines, each side caches the other's index
+// so the common push/pop touches no shared line; nothing allocates after construction
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing holds POD records");
+
+public:
+    // Producer side; returns false (and counts a drop) when full
+    bool TryPush(const T &item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail >= Capacity)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail >= Capacity)
+            {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        m_slots[head & MASK] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool TryPop(T &item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead)
+                return false;
+        }
+        item = m_slots[tail & MASK];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: pops up to maxItems with a single index publish
+    size_t PopBatch(T *out, size_t maxItems)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        size_t count = m_cachedHead - tail;
+        if (count > maxItems)
+            count = maxItems;
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = m_slots[(tail + i) & MASK];
+        }
+        if (count)
+            m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Approximate when called from a third thread
+    size_t Size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+    bool Empty() const { return Size() == 0; }
+    static constexpr size_t CapacityValue() { return Capacity; }
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    // Producer-owned line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head{0};
+    size_t m_cachedTail = 0;
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Consumer-owned line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail{0};
+    size_t m_cachedHead = 0;
+
+    alignas(CACHE_LINE_SIZE) T m_slots[Capacity];
+};
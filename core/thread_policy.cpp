@@ -0,0 +1,342 @@
+#include "thread_policy.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+static const char *const ROLE_NAMES[THREAD_ROLE_COUNT] = {"render", "input", "audio"};
+
+const char *ThreadRoleName(ThreadRole role)
+{
+    return (size_t)role < THREAD_ROLE_COUNT ? ROLE_NAMES[(size_t)role] : "?";
+}
+
+const char *ThreadPriorityName(ThreadPriority priority)
+{
+    switch (priority)
+    {
+    case ThreadPriority::Normal:
+        return "normal";
+    case ThreadPriority::High:
+        return "high";
+    case ThreadPriority::Realtime:
+        return "realtime";
+    }
+    return "?";
+}
+
+SchedulerConfig DefaultSchedulerConfig()
+{
+    SchedulerConfig config;
+    config[ThreadRole::Input].priority = ThreadPriority::Realtime;
+    return config;
+}
+
+static bool ParseCpuSet(const char *&p, uint64_t &mask)
+{
+    mask = 0;
+    if (*p == '*')
+    {
+        ++p;
+        return true;
+    }
+    for (;;)
+    {
+        char *end = nullptr;
+        unsigned long first = strtoul(p, &end, 10);
+        if (end == p || first >= 64)
+            return false;
+        unsigned long last = first;
+        p = end;
+        if (*p == '-')
+        {
+            last = strtoul(p + 1, &end, 10);
+            if (end == p + 1 || last >= 64 || last < first)
+                return false;
+            p = end;
+        }
+        for (unsigned long cpu = first; cpu <= last; ++cpu)
+            mask |= 1ull << cpu;
+        if (*p != '+')
+            return true;
+        ++p;
+    }
+}
+
+static bool ParsePriority(const char *&p, ThreadPriority &priority)
+{
+    static const struct
+    {
+        const char *name;
+        ThreadPriority priority;
+    } NAMES[] = {{"normal", ThreadPriority::Normal},
+                 {"high", ThreadPriority::High},
+                 {"realtime", ThreadPriority::Realtime},
+                 {"rt", ThreadPriority::Realtime}};
+    for (const auto &entry : NAMES)
+    {
+        size_t length = strlen(entry.name);
+        if (strncmp(p, entry.name, length) == 0 && (p[length] == '\0' || p[length] == ',' || p[length] == ' '))
+        {
+            priority = entry.priority;
+            p += length;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseSchedulerConfig(const char *text, SchedulerConfig &config)
+{
+    SchedulerConfig parsed = config;
+    const char *p = text;
+    while (*p)
+    {
+        while (*p == ',' || *p == ' ')
+            ++p;
+        if (!*p)
+            break;
+
+        if (strncmp(p, "process=", 8) == 0)
+        {
+            p += 8;
+            if (strncmp(p, "high", 4) == 0)
+                parsed.highPriorityClass = true;
+            else if (strncmp(p, "normal", 6) == 0)
+                parsed.highPriorityClass = false;
+            else
+                return false;
+            p += parsed.highPriorityClass ? 4 : 6;
+        }
+        else
+        {
+            size_t role = 0;
+            while (role < THREAD_ROLE_COUNT && !(strncmp(p, ROLE_NAMES[role], strlen(ROLE_NAMES[role])) == 0 &&
+                                                  p[strlen(ROLE_NAMES[role])] == '='))
+                ++role;
+            if (role == THREAD_ROLE_COUNT)
+                return false;
+            p += strlen(ROLE_NAMES[role]) + 1;
+
+            ThreadPolicy &policy = parsed.roles[role];
+            if (!ParseCpuSet(p, policy.affinity))
+                return false;
+            if (*p == ':')
+            {
+                ++p;
+                if (!ParsePriority(p, policy.priority))
+                    return false;
+            }
+        }
+
+        if (*p && *p != ',' && *p != ' ')
+            return false;
+    }
+
+    config = parsed;
+    return true;
+}
+
+size_t CpuCount()
+{
+    unsigned count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+#ifdef _WIN32
+
+// avrt.dll is loaded on first use so the core library adds no link dependency
+typedef HANDLE(WINAPI *AvSetMmThreadCharacteristicsWFn)(LPCWSTR, LPDWORD);
+typedef BOOL(WINAPI *AvSetMmThreadPriorityFn)(HANDLE, int);
+static constexpr int AVRT_PRIORITY_HIGH = 1;
+static constexpr int AVRT_PRIORITY_CRITICAL = 2;
+
+static bool RegisterMmcss(ThreadRole role, ThreadPriority priority)
+{
+    static HMODULE avrt = LoadLibraryW(L"avrt.dll");
+    if (!avrt)
+        return false;
+    auto setCharacteristics =
+        (AvSetMmThreadCharacteristicsWFn)(void *)GetProcAddress(avrt, "AvSetMmThreadCharacteristicsW");
+    auto setPriority = (AvSetMmThreadPriorityFn)(void *)GetProcAddress(avrt, "AvSetMmThreadPriority");
+    if (!setCharacteristics || !setPriority)
+        return false;
+
+    DWORD taskIndex = 0;
+    HANDLE task = setCharacteristics(role == ThreadRole::Audio ? L"Pro Audio" : L"Games", &taskIndex);
+    if (!task)
+        return false;
+    setPriority(task, priority == ThreadPriority::Realtime ? AVRT_PRIORITY_CRITICAL : AVRT_PRIORITY_HIGH);
+    return true;
+}
+
+ThreadPolicyResult ApplyThreadPolicy(ThreadRole role, const ThreadPolicy &policy)
+{
+    ThreadPolicyResult result;
+    if (policy.affinity)
+        result.affinity = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)policy.affinity) != 0;
+
+    switch (policy.priority)
+    {
+    case ThreadPriority::Normal:
+        result.priority = true;
+        break;
+    case ThreadPriority::High:
+    case ThreadPriority::Realtime:
+        // MMCSS first: it boosts into the realtime range while the task is active, and
+        // SetThreadPriority is the fallback when the service is unavailable
+        result.mmcss = RegisterMmcss(role, policy.priority);
+        result.priority = SetThreadPriority(GetCurrentThread(), policy.priority == ThreadPriority::Realtime
+                                                                    ? THREAD_PRIORITY_TIME_CRITICAL
+                                                                    : THREAD_PRIORITY_HIGHEST) != FALSE;
+        break;
+    }
+    return result;
+}
+
+bool ApplyProcessPriority(const SchedulerConfig &config)
+{
+    // Never lowers a class the user chose when launching (e.g. start /realtime)
+    return !config.highPriorityClass || SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS) != FALSE;
+}
+
+#else
+
+// Linux nice values are per thread (the "process" argument of setpriority is a tid)
+static bool SetThreadNice(int nice)
+{
+#ifdef __linux__
+    return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice) == 0;
+#else
+    (void)nice;
+    return false;
+#endif
+}
+
+ThreadPolicyResult ApplyThreadPolicy(ThreadRole role, const ThreadPolicy &policy)
+{
+    ThreadPolicyResult result;
+#ifdef __linux__
+    if (policy.affinity)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < 64; ++cpu)
+        {
+            if (policy.affinity & (1ull << cpu))
+                CPU_SET(cpu, &set);
+        }
+        result.affinity = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+#endif
+
+    switch (policy.priority)
+    {
+    case ThreadPriority::Normal:
+        result.priority = true;
+        break;
+    case ThreadPriority::Realtime:
+    {
+        // Input above audio above render, well below the kernel's own FIFO threads
+        static const int FIFO_PRIORITY[THREAD_ROLE_COUNT] = {40, 60, 50};
+        sched_param param = {};
+        param.sched_priority = FIFO_PRIORITY[(size_t)role];
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+        {
+            result.priority = result.realtime = true;
+            break;
+        }
+        // Without CAP_SYS_NICE or an rtprio limit, settle for the best nice value allowed
+        SetThreadNice(-10);
+        break;
+    }
+    case ThreadPriority::High:
+        result.priority = SetThreadNice(-10);
+        break;
+    }
+    return result;
+}
+
+bool ApplyProcessPriority(const SchedulerConfig &config)
+{
+    return !config.highPriorityClass;
+}
+
+#endif
+
+void FormatThreadPolicy(ThreadRole role, const ThreadPolicy &policy, const ThreadPolicyResult &result, char *out,
+                        size_t size)
+{
+    char cpus[96] = "any";
+    if (policy.affinity)
+    {
+        size_t length = 0;
+        for (int cpu = 0; cpu < 64 && length < sizeof(cpus) - 4; ++cpu)
+        {
+            if (policy.affinity & (1ull << cpu))
+                length += (size_t)snprintf(cpus + length, sizeof(cpus) - length, length ? "+%d" : "%d", cpu);
+        }
+    }
+    snprintf(out, size, "%s: cpus %s%s, %s%s%s%s", ThreadRoleName(role), cpus,
+             policy.affinity && !result.affinity ? " (refused)" : "", ThreadPriorityName(policy.priority),
+             policy.priority != ThreadPriority::Normal && !result.priority ? " (refused)" : "",
+             result.mmcss ? " +MMCSS" : "", result.realtime ? " (SCHED_FIFO)" : "");
+}
+
+bool SchedulerRefused(const SchedulerConfig &config, const SchedulerResult &result)
+{
+    if (!result.processPriority)
+        return true;
+    for (size_t i = 0; i < THREAD_ROLE_COUNT; ++i)
+    {
+        const ThreadPolicy &policy = config.roles[i];
+        const ThreadPolicyResult &applied = result.roles[i];
+        if (result.started[i] && ((policy.affinity && !applied.affinity) ||
+                                  (policy.priority != ThreadPriority::Normal && !applied.priority)))
+            return true;
+    }
+    return false;
+}
+
+size_t FormatSchedulerResult(const SchedulerConfig &config, const SchedulerResult &result, char *out, size_t size)
+{
+    if (size == 0)
+        return 0;
+    out[0] = '\0';
+    size_t length = 0;
+    char line[192];
+    for (size_t i = 0; i < THREAD_ROLE_COUNT && length + 1 < size; ++i)
+    {
+        if (!result.started[i])
+            continue;
+        FormatThreadPolicy((ThreadRole)i, config.roles[i], result.roles[i], line, sizeof(line));
+        int written = snprintf(out + length, size - length, "%s%s", length ? "\n" : "", line);
+        length = written > 0 ? std::min(size - 1, length + (size_t)written) : length;
+    }
+    if (!result.processPriority && length + 1 < size)
+    {
+        int written = snprintf(out + length, size - length, "%sprocess: high priority class (refused)",
+                               length ? "\n" : "");
+        length = written > 0 ? std::min(size - 1, length + (size_t)written) : length;
+    }
+    return length;
+}
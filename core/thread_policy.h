@@ -0,0 +1,92 @@
+// CPU placement and scheduling priority for the render, input and audio threads
+// Each role gets an affinity mask and a priority level; a thread applies its role's
+// policy to itself when it starts. Windows maps the levels to thread priorities plus
+// MMCSS ("Games" / "Pro Audio"), Linux to SCHED_FIFO where the process may use it and
+// a negative nice value otherwise. Anything the OS refuses is reported, not fatal.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class ThreadRole : uint8_t
+{
+    Render,
+    Input,
+    Audio,
+    Count
+};
+
+constexpr size_t THREAD_ROLE_COUNT = (size_t)ThreadRole::Count;
+
+enum class ThreadPriority : uint8_t
+{
+    Normal,   // Leave the OS default
+    High,     // Windows: HIGHEST + MMCSS; Linux: nice -10
+    Realtime, // Windows: TIME_CRITICAL + MMCSS critical; Linux: SCHED_FIFO
+};
+
+const char *ThreadRoleName(ThreadRole role);
+const char *ThreadPriorityName(ThreadPriority priority);
+
+struct ThreadPolicy
+{
+    uint64_t affinity = 0; // Bit n = logical CPU n; 0 leaves the thread unpinned
+    ThreadPriority priority = ThreadPriority::Normal;
+};
+
+struct SchedulerConfig
+{
+    ThreadPolicy roles[THREAD_ROLE_COUNT];
+    bool highPriorityClass = false; // Windows: HIGH_PRIORITY_CLASS for the whole process
+
+    ThreadPolicy &operator[](ThreadRole role) { return roles[(size_t)role]; }
+    const ThreadPolicy &operator[](ThreadRole role) const { return roles[(size_t)role]; }
+};
+
+// The input thread has always run time-critical; render and audio keep OS defaults
+SchedulerConfig DefaultSchedulerConfig();
+
+// Comma-separated "<role>=<cpus>[:<priority>]" entries plus an optional "process=high".
+// cpus: '*' (any), a CPU index, a range "2-3", or indices joined with '+' ("1+3").
+// priority: normal, high or realtime (rt). Example: render=2:high,input=3:rt,audio=1:rt
+// Roles that are not named keep their value in `config`.
+bool ParseSchedulerConfig(const char *text, SchedulerConfig &config);
+
+// What the OS accepted when a policy was applied
+struct ThreadPolicyResult
+{
+    bool affinity = false; // Pinned to the requested CPUs
+    bool priority = false; // Requested priority level in effect
+    bool mmcss = false;    // Windows: registered with the multimedia class scheduler
+    bool realtime = false; // Linux: running SCHED_FIFO
+};
+
+size_t CpuCount();
+
+// Applies the policy to the calling thread. MMCSS registration lasts until the thread exits.
+ThreadPolicyResult ApplyThreadPolicy(ThreadRole role, const ThreadPolicy &policy);
+// Windows priority class; false where the OS has no equivalent and high was requested
+bool ApplyProcessPriority(const SchedulerConfig &config);
+
+// "render: cpus 2, realtime (SCHED_FIFO)" style summary for logs and the overlay
+void FormatThreadPolicy(ThreadRole role, const ThreadPolicy &policy, const ThreadPolicyResult &result, char *out,
+                        size_t size);
+
+// What the process got of its SchedulerConfig, filled in as each role's thread starts
+struct SchedulerResult
+{
+    bool processPriority = true; // ApplyProcessPriority
+    bool started[THREAD_ROLE_COUNT] = {};
+    ThreadPolicyResult roles[THREAD_ROLE_COUNT];
+
+    void Set(ThreadRole role, const ThreadPolicyResult &result)
+    {
+        started[(size_t)role] = true;
+        roles[(size_t)role] = result;
+    }
+};
+
+// True if the OS refused part of a started role's policy or the priority class
+bool SchedulerRefused(const SchedulerConfig &config, const SchedulerResult &result);
+// One FormatThreadPolicy line per started role, then the priority class if it was refused
+size_t FormatSchedulerResult(const SchedulerConfig &config, const SchedulerResult &result, char *out, size_t size);
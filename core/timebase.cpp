@@ -0,0 +1,172 @@
+#include "timebase.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TIMEBASE_HAS_TSC 1
+#endif
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+uint64_t Timebase::MulShift(uint64_t value, uint64_t mult, uint32_t shift)
+{
+#if defined(__SIZEOF_INT128__)
+    return (uint64_t)(((unsigned __int128)value * mult) >> shift);
+#else
+    uint64_t high, low;
+#if defined(_MSC_VER) && defined(_M_X64)
+    low = _umul128(value, mult, &high);
+#else
+    // 64x64 -> 128 from 32-bit halves
+    uint64_t a = value >> 32, b = value & 0xFFFFFFFFull;
+    uint64_t c = mult >> 32, d = mult & 0xFFFFFFFFull;
+    uint64_t bd = b * d, ad = a * d, bc = b * c;
+    uint64_t mid = (bd >> 32) + (ad & 0xFFFFFFFFull) + (bc & 0xFFFFFFFFull);
+    low = (mid << 32) | (bd & 0xFFFFFFFFull);
+    high = a * c + (ad >> 32) + (bc >> 32) + (mid >> 32);
+#endif
+    if (shift >= 64)
+        return high >> (shift - 64);
+    return shift == 0 ? low : (high << (64 - shift)) | (low >> shift);
+#endif
+}
+
+// numerator/denominator as mult * 2^-shift with the top bit of mult at bit 62,
+// computed exactly in integers (long division, one bit at a time)
+static void MakeRatio(uint64_t numerator, uint64_t denominator, uint64_t &mult, uint32_t &shift)
+{
+    uint64_t quotient = numerator / denominator;
+    uint64_t remainder = numerator % denominator;
+    shift = 0;
+    mult = quotient;
+    while (mult < (1ull << 62) && shift < 127)
+    {
+        remainder <<= 1;
+        mult <<= 1;
+        if (remainder >= denominator)
+        {
+            remainder -= denominator;
+            mult |= 1;
+        }
+        shift++;
+    }
+    // Round to nearest
+    if (remainder * 2 >= denominator)
+        mult++;
+}
+
+void Timebase::SetFrequency(TimebaseSource newSource, int64_t frequency)
+{
+    source = newSource;
+    ticksPerSecond = frequency;
+    MakeRatio(1000000000ull, (uint64_t)frequency, nsPerTickMult, nsPerTickShift);
+    MakeRatio((uint64_t)frequency, 1000000000ull, ticksPerNsMult, ticksPerNsShift);
+}
+
+static Timebase InitTimebase()
+{
+    Timebase timebase;
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    timebase.SetFrequency(TimebaseSource::Qpc, frequency.QuadPart);
+#else
+    timebase.SetFrequency(TimebaseSource::Monotonic, 1000000000);
+#endif
+    return timebase;
+}
+
+static Timebase &MutableTimebase()
+{
+    static Timebase timebase = InitTimebase();
+    return timebase;
+}
+
+const Timebase &GetTimebase()
+{
+    return MutableTimebase();
+}
+
+#ifndef _WIN32
+static int64_t MonotonicNs(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+
+Ticks ReadTicks()
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+#else
+#ifdef TIMEBASE_HAS_TSC
+    if (MutableTimebase().source == TimebaseSource::Tsc)
+        return (Ticks)__rdtsc();
+#endif
+    return MonotonicNs(CLOCK_MONOTONIC);
+#endif
+}
+
+TickClock::time_point TickClock::now()
+{
+    const Timebase &timebase = MutableTimebase();
+    return time_point(duration(timebase.ToNs(ReadTicks())));
+}
+
+const char *TimebaseSourceName(TimebaseSource source)
+{
+    switch (source)
+    {
+    case TimebaseSource::Qpc:
+        return "QPC";
+    case TimebaseSource::Monotonic:
+        return "CLOCK_MONOTONIC";
+    case TimebaseSource::Tsc:
+        return "TSC";
+    }
+    return "?";
+}
+
+bool UseTscTimebase(int calibrationMs)
+{
+#ifdef TIMEBASE_HAS_TSC
+    // Invariant TSC: CPUID.80000007H:EDX[8]
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 8)))
+        return false;
+
+    // Count TSC ticks across a spin of calibrationMs on the raw monotonic clock
+    int64_t ns0 = MonotonicNs(CLOCK_MONOTONIC_RAW);
+    uint64_t tsc0 = __rdtsc();
+    int64_t ns1 = ns0;
+    while (ns1 - ns0 < (int64_t)calibrationMs * 1000000)
+        ns1 = MonotonicNs(CLOCK_MONOTONIC_RAW);
+    uint64_t tsc1 = __rdtsc();
+
+    double frequency = (double)(tsc1 - tsc0) * 1e9 / (double)(ns1 - ns0);
+    if (frequency < 1e6)
+        return false;
+    MutableTimebase().SetFrequency(TimebaseSource::Tsc, (int64_t)(frequency + 0.5));
+    return true;
+#else
+    (void)calibrationMs;
+    return false;
+#endif
+}
@@ -0,0 +1,57 @@
+// Calibrated high-resolution timebase
+// Raw counter ticks (QPC on Windows; CLOCK_MONOTONIC or the invariant TSC on Linux)
+// are converted to integer nanoseconds with a precomputed multiplier and shift
+// (63 significant bits, 128-bit product), so a clock read never divides and never
+// goes through floating point
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+using Ticks = int64_t;
+
+enum class TimebaseSource : uint8_t
+{
+    Qpc,       // QueryPerformanceCounter (Windows)
+    Monotonic, // clock_gettime(CLOCK_MONOTONIC), already in ns
+    Tsc        // rdtsc, calibrated against CLOCK_MONOTONIC_RAW
+};
+
+struct Timebase
+{
+    TimebaseSource source = TimebaseSource::Monotonic;
+    int64_t ticksPerSecond = 1000000000;
+    uint64_t nsPerTickMult = 1ull << 62; // ns = ticks * mult >> shift
+    uint32_t nsPerTickShift = 62;
+    uint64_t ticksPerNsMult = 1ull << 62;
+    uint32_t ticksPerNsShift = 62;
+
+    int64_t ToNs(Ticks ticks) const { return (int64_t)MulShift((uint64_t)ticks, nsPerTickMult, nsPerTickShift); }
+    Ticks FromNs(int64_t ns) const { return (Ticks)MulShift((uint64_t)ns, ticksPerNsMult, ticksPerNsShift); }
+
+    // Sets both conversions for a counter frequency
+    void SetFrequency(TimebaseSource newSource, int64_t frequency);
+
+    // (value * mult) >> shift with a 128-bit intermediate
+    static uint64_t MulShift(uint64_t value, uint64_t mult, uint32_t shift);
+};
+
+const Timebase &GetTimebase();
+Ticks ReadTicks();
+const char *TimebaseSourceName(TimebaseSource source);
+
+// Switches to the invariant TSC (x86 Linux only) after calibrating it for calibrationMs.
+// Call before any timestamp is taken; returns false and keeps the current source otherwise
+bool UseTscTimebase(int calibrationMs = 100);
+
+// std::chrono clock over the timebase: integer nanoseconds, steady
+struct TickClock
+{
+    using rep = int64_t;
+    using period = std::nano;
+    using duration = std::chrono::nanoseconds;
+    using time_point = std::chrono::time_point<TickClock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now();
+};
@@ -0,0 +1,15 @@
+// Shared clock types for the portable timing core
+// Time points are integer nanoseconds of the calibrated timebase (see timebase.h)
+#pragma once
+
+#include <chrono>
+#include "timebase.h"
+
+using Clock = TickClock;
+using TimePoint = Clock::time_point;
+
+// Milliseconds elapsed between two time points (fractional, for display only)
+inline double ElapsedMs(TimePoint from, TimePoint to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
@@ -0,0 +1,403 @@
+#include "trace_file.h"
+#include <cstring>
+#include "file_path.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char TRACE_MAGIC[8] = {'L', 'T', 'T', 'R', 'A', 'C', 'E', '\0'};
+constexpr uint32_t TRACE_VERSION = 1;
+
+static_assert(TraceWriter::CHUNK_BYTES % sizeof(TraceRecord) == 0, "records must not straddle chunks");
+static_assert(sizeof(TraceHeader) % sizeof(TraceRecord) == 0, "records must not straddle chunks");
+
+int64_t TraceTicks(TimePoint time)
+{
+    return (int64_t)time.time_since_epoch().count();
+}
+
+TimePoint TraceTimePoint(int64_t ticks)
+{
+    return TimePoint(Clock::duration(ticks));
+}
+
+TraceRecord MakeInputRecord(const InputEvent &ev)
+{
+    TraceRecord record = {};
+    record.ticks = TraceTicks(ev.time);
+    record.type = TraceRecordType::Input;
+    record.inputType = ev.type;
+    record.deviceId = ev.deviceId;
+    record.flags = ev.type == InputType::Keyboard ? ev.keyFlags : ev.buttonFlags;
+    record.data = ev.buttonData;
+    record.dx = ev.dx;
+    record.dy = ev.dy;
+    record.vkey = ev.vkey;
+    record.makeCode = ev.makeCode;
+    record.sequence = ev.decodeDelay;
+    return record;
+}
+
+TraceRecord MakeFlashRecord(TimePoint time, bool on, uint32_t sequence)
+{
+    TraceRecord record = {};
+    record.ticks = TraceTicks(time);
+    record.type = TraceRecordType::Flash;
+    record.flags = on ? 1 : 0;
+    record.sequence = sequence;
+    return record;
+}
+
+TraceRecord MakeAudioOnsetRecord(TimePoint dacTime, float errorUs, uint32_t sequence)
+{
+    TraceRecord record = MakeFlashRecord(dacTime, false, sequence);
+    record.flags = TRACE_FLASH_DAC;
+    record.dx = (int32_t)(errorUs * 1000.0f);
+    return record;
+}
+
+TraceRecord MakePresentRecord(TimePoint frameTime, TimePoint callTime, TimePoint returnTime, bool white,
+                              uint32_t frame)
+{
+    TraceRecord record = {};
+    record.ticks = TraceTicks(callTime);
+    record.type = TraceRecordType::Present;
+    record.flags = white ? 1 : 0;
+    record.dx = (int32_t)(TraceTicks(returnTime) - record.ticks);
+    record.dy = (int32_t)(record.ticks - TraceTicks(frameTime));
+    record.sequence = frame;
+    return record;
+}
+
+TraceRecord MakeControlRecord(TimePoint time, TraceControl control)
+{
+    TraceRecord record = {};
+    record.ticks = TraceTicks(time);
+    record.type = TraceRecordType::Control;
+    record.data = (int16_t)control;
+    return record;
+}
+
+size_t MakeFlashPatternRecords(TimePoint time, const FlashPattern &pattern, TraceRecord *out)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < pattern.stepCount; ++i)
+    {
+        const FlashStep &step = pattern.steps[i];
+        TraceRecord &record = out[count++];
+        record = MakeControlRecord(time, TraceControl::PatternStep);
+        record.deviceId = (uint16_t)i;
+        record.flags = (uint16_t)step.unit;
+        record.sequence = step.duration;
+        memcpy(&record.dx, &step.level, sizeof(step.level));
+    }
+    TraceRecord &record = out[count++];
+    record = MakeControlRecord(time, TraceControl::Pattern);
+    record.flags = (uint16_t)pattern.stepCount;
+    record.sequence = pattern.repeat;
+    record.dx = (int32_t)pattern.minFrames;
+    return count;
+}
+
+bool ReadFlashPatternRecord(const TraceRecord &record, FlashPattern &pattern)
+{
+    if (record.type != TraceRecordType::Control)
+        return false;
+    if (record.data == (int16_t)TraceControl::PatternStep)
+    {
+        if (record.deviceId == 0)
+            pattern = FlashPattern();
+        float level;
+        memcpy(&level, &record.dx, sizeof(level));
+        if (record.deviceId == pattern.stepCount)
+            pattern.AddStep(record.sequence, (FlashUnit)record.flags, level);
+        return false;
+    }
+    if (record.data != (int16_t)TraceControl::Pattern || pattern.stepCount == 0 ||
+        pattern.stepCount != record.flags || record.sequence == 0)
+        return false;
+    pattern.repeat = record.sequence;
+    pattern.minFrames = (uint32_t)record.dx;
+    return true;
+}
+
+static_assert(sizeof(TraceRecord) - offsetof(TraceRecord, dx) == TRACE_NAME_UNITS * sizeof(uint16_t),
+              "a name part fills the record after flags/data");
+
+size_t MakeDeviceNameRecords(TimePoint time, uint16_t deviceId, const wchar_t *name, TraceRecord *out)
+{
+    size_t length = 0;
+    while (name[length] != L'\0' && length < TRACE_NAME_UNITS * TRACE_NAME_RECORDS)
+        length++;
+    size_t count = 0;
+    for (size_t start = 0; count < TRACE_NAME_RECORDS && start <= length; start += TRACE_NAME_UNITS)
+    {
+        uint16_t units[TRACE_NAME_UNITS] = {};
+        for (size_t i = 0; i < TRACE_NAME_UNITS && start + i < length; ++i)
+            units[i] = (uint16_t)name[start + i];
+        TraceRecord &record = out[count];
+        record = MakeControlRecord(time, TraceControl::DeviceName);
+        record.deviceId = deviceId;
+        record.flags = (uint16_t)count++;
+        memcpy(&record.dx, units, sizeof(units));
+    }
+    return count;
+}
+
+bool ReadDeviceNameRecord(const TraceRecord &record, std::wstring &name)
+{
+    if (record.type != TraceRecordType::Control || record.data != (int16_t)TraceControl::DeviceName)
+        return false;
+    if (record.flags == 0)
+        name.clear();
+    else if (name.size() != record.flags * TRACE_NAME_UNITS)
+        return false; // A part is missing, or the name already ended
+    uint16_t units[TRACE_NAME_UNITS];
+    memcpy(units, &record.dx, sizeof(units));
+    for (size_t i = 0; i < TRACE_NAME_UNITS; ++i)
+    {
+        if (units[i] == 0)
+            return true;
+        name.push_back((wchar_t)units[i]);
+    }
+    return record.flags + 1u == TRACE_NAME_RECORDS;
+}
+
+InputEvent InputEventFromRecord(const TraceRecord &record)
+{
+    InputEvent ev;
+    ev.time = TraceTimePoint(record.ticks);
+    ev.type = record.inputType;
+    ev.deviceId = record.deviceId;
+    if (record.inputType == InputType::Keyboard)
+        ev.keyFlags = record.flags;
+    else
+        ev.buttonFlags = record.flags;
+    ev.buttonData = record.data;
+    ev.dx = record.dx;
+    ev.dy = record.dy;
+    ev.vkey = record.vkey;
+    ev.makeCode = record.makeCode;
+    ev.decodeDelay = (uint16_t)record.sequence;
+    return ev;
+}
+
+bool TraceWriter::Open(const std::string &path, TimePoint start, uint32_t seed)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(WidenPath(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    m_file = (intptr_t)file;
+#else
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    m_file = fd;
+#endif
+
+    m_viewOffset = 0;
+    m_count = 0;
+    if (!MapNextChunk())
+    {
+        Close();
+        return false;
+    }
+
+    // The header occupies the start of the first chunk
+    TraceHeader *header = (TraceHeader *)m_view;
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header->version = TRACE_VERSION;
+    header->recordSize = sizeof(TraceRecord);
+    header->ticksPerSecond = (int64_t)(Clock::period::den / Clock::period::num);
+    header->startTicks = TraceTicks(start);
+    header->seed = seed;
+    m_cursor = (TraceRecord *)(header + 1);
+    return true;
+}
+
+bool TraceWriter::MapNextChunk()
+{
+    if (m_view)
+    {
+        Unmap();
+        m_viewOffset += CHUNK_BYTES;
+    }
+    uint64_t fileSize = m_viewOffset + CHUNK_BYTES;
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingW((HANDLE)m_file, nullptr, PAGE_READWRITE, (DWORD)(fileSize >> 32),
+                                        (DWORD)fileSize, nullptr);
+    if (!mapping)
+        return false;
+    m_view = MapViewOfFile(mapping, FILE_MAP_WRITE, (DWORD)(m_viewOffset >> 32), (DWORD)m_viewOffset, CHUNK_BYTES);
+    if (!m_view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_mapping = (intptr_t)mapping;
+#else
+    if (ftruncate((int)m_file, (off_t)fileSize) != 0)
+        return false;
+    void *view = mmap(nullptr, CHUNK_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, (int)m_file, (off_t)m_viewOffset);
+    if (view == MAP_FAILED)
+        return false;
+    m_view = view;
+#endif
+
+    m_cursor = (TraceRecord *)m_view;
+    m_chunkEnd = (TraceRecord *)((uint8_t *)m_view + CHUNK_BYTES);
+    return true;
+}
+
+void TraceWriter::Unmap()
+{
+    if (!m_view)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_view);
+    CloseHandle((HANDLE)m_mapping);
+    m_mapping = 0;
+#else
+    munmap(m_view, CHUNK_BYTES);
+#endif
+    m_view = nullptr;
+    m_cursor = m_chunkEnd = nullptr;
+}
+
+void TraceWriter::Close()
+{
+    if (m_file == INVALID_FILE)
+        return;
+
+    Unmap();
+
+    // Trim the unused tail of the last chunk and publish the record count
+    uint64_t size = sizeof(TraceHeader) + m_count * sizeof(TraceRecord);
+    uint64_t count = m_count;
+#ifdef _WIN32
+    HANDLE file = (HANDLE)m_file;
+    LARGE_INTEGER pos;
+    pos.QuadPart = (LONGLONG)size;
+    SetFilePointerEx(file, pos, nullptr, FILE_BEGIN);
+    SetEndOfFile(file);
+    pos.QuadPart = offsetof(TraceHeader, recordCount);
+    SetFilePointerEx(file, pos, nullptr, FILE_BEGIN);
+    DWORD written = 0;
+    WriteFile(file, &count, sizeof(count), &written, nullptr);
+    CloseHandle(file);
+#else
+    if (ftruncate((int)m_file, (off_t)size) == 0)
+    {
+        ssize_t written = pwrite((int)m_file, &count, sizeof(count), offsetof(TraceHeader, recordCount));
+        (void)written;
+    }
+    close((int)m_file);
+#endif
+    m_file = INVALID_FILE;
+}
+
+bool TraceReader::Open(const std::string &path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(WidenPath(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(TraceHeader))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+    m_view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_mapping = (intptr_t)mapping;
+    m_viewBytes = (size_t)size.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(TraceHeader))
+    {
+        close(fd);
+        return false;
+    }
+    void *view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+    m_view = view;
+    m_viewBytes = (size_t)st.st_size;
+#endif
+
+    m_header = (const TraceHeader *)m_view;
+    if (memcmp(m_header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        m_header->version != TRACE_VERSION || m_header->recordSize != sizeof(TraceRecord))
+    {
+        Close();
+        return false;
+    }
+
+    m_records = (const TraceRecord *)(m_header + 1);
+    size_t available = (m_viewBytes - sizeof(TraceHeader)) / sizeof(TraceRecord);
+    if (m_header->recordCount != 0 && m_header->recordCount <= available)
+    {
+        m_count = (size_t)m_header->recordCount;
+    }
+    else
+    {
+        // Writer did not close: records run until the first unwritten slot
+        m_count = 0;
+        while (m_count < available && m_records[m_count].type != TraceRecordType::Empty)
+            m_count++;
+    }
+    return true;
+}
+
+void TraceReader::Close()
+{
+    if (m_view)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_view);
+        CloseHandle((HANDLE)m_mapping);
+#else
+        munmap((void *)m_view, m_viewBytes);
+#endif
+    }
+    m_view = nullptr;
+    m_viewBytes = 0;
+    m_mapping = 0;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_count = 0;
+}
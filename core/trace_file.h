@@ -0,0 +1,178 @@
+// Binary session trace: fixed-size records stamped in timebase nanoseconds (the Clock's
+// integer ns, converted from the counter when they were taken, not raw counter ticks),
+// written through a memory-mapped append-only file (no formatting, no syscalls per
+// record) and read back zero-copy by mapping the file. "Ticks" below are those ns.
+//
+// Layout: TraceHeader (64 bytes) followed by TraceRecord[recordCount] (32 bytes each)
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "flash_pattern.h"
+#include "input_event.h"
+
+enum class TraceRecordType : uint8_t
+{
+    Empty = 0, // Unwritten space after a crash
+    Input = 1,
+    Flash = 2,   // Stimulus start (latency flash, reaction onset)
+    Present = 3,
+    Control = 4  // Keyboard command that changes tester state
+};
+
+// Control record commands (TraceRecord::data)
+enum class TraceControl : uint16_t
+{
+    RoundStart,         // Reaction: StartNewRound
+    Reset,              // Reaction: SPACE
+    ToggleAudio,        // Reaction: F1
+    ToggleMouseButtons, // Latency: F1
+    ToggleKeyboard,     // Latency: F2
+    ToggleMouseDelta,   // Latency: F3
+    ToggleLog,          // Latency: F4
+    FlashLonger,        // Latency: F5
+    FlashShorter,       // Latency: F6
+    ToggleUpEvents,     // Latency: F7
+    PatternStep,        // Latency: one step of the -pattern flash train
+    Pattern,            // Latency: the steps before it form the -pattern train
+    DeviceName          // Latency: part of an input device's display name
+};
+
+constexpr uint16_t TRACE_FLASH_DAC = 2; // Flash record flags: DAC time of an audio onset
+
+struct TraceHeader
+{
+    char magic[8];          // "LTTRACE\0"
+    uint32_t version;
+    uint32_t recordSize;
+    int64_t ticksPerSecond; // Always 1e9: ticks are timebase ns
+    int64_t startTicks;
+    uint64_t recordCount;   // 0 if the writer did not close cleanly
+    uint32_t seed;          // Reaction delay RNG seed
+    uint8_t reserved[20];
+};
+
+// Input:   ticks = arrival, fields mirror InputEvent, sequence = decodeDelay
+// Flash:   ticks = trigger time, flags = 1 on, 0 off, sequence = flash number;
+//          flags = TRACE_FLASH_DAC: audio onset at the DAC (estimated), dx = error in ns,
+//          sequence = the onset's flash number
+// Present: ticks = Present() call, dx = call duration in ticks, dy = ticks since the frame's
+//          update time, flags = 1 if white, sequence = frame
+// Control: ticks = command time, data = TraceControl
+//          PatternStep: deviceId = step index, flags = FlashUnit, sequence = duration,
+//          dx = level (float bits); Pattern: flags = step count, sequence = repeat,
+//          dx = minimum frames
+//          DeviceName: deviceId = registry id, flags = part, dx..sequence = the part's
+//          TRACE_NAME_UNITS UTF-16 units, zero-padded (the terminator ends the name)
+struct TraceRecord
+{
+    int64_t ticks;
+    TraceRecordType type;
+    InputType inputType;
+    uint16_t deviceId;
+    uint16_t flags;      // Mouse button flags / key flags / record specific
+    int16_t data;        // Wheel delta
+    int32_t dx;
+    int32_t dy;
+    uint16_t vkey;
+    uint16_t makeCode;
+    uint32_t sequence;
+};
+
+static_assert(sizeof(TraceHeader) == 64, "TraceHeader layout");
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord layout");
+
+constexpr size_t TRACE_NAME_UNITS = 8;   // Name units per DeviceName record
+constexpr size_t TRACE_NAME_RECORDS = 4; // Longer names are cut
+
+// TimePoint <-> record ticks (timebase ns since the clock's epoch)
+int64_t TraceTicks(TimePoint time);
+TimePoint TraceTimePoint(int64_t ticks);
+
+TraceRecord MakeInputRecord(const InputEvent &ev);
+TraceRecord MakeFlashRecord(TimePoint time, bool on, uint32_t sequence);
+TraceRecord MakeAudioOnsetRecord(TimePoint dacTime, float errorUs, uint32_t sequence);
+TraceRecord MakePresentRecord(TimePoint frameTime, TimePoint callTime, TimePoint returnTime, bool white,
+                              uint32_t frame);
+TraceRecord MakeControlRecord(TimePoint time, TraceControl control);
+InputEvent InputEventFromRecord(const TraceRecord &record);
+
+// A flash pattern as stepCount PatternStep records and a closing Pattern record;
+// `out` holds FlashPattern::MAX_STEPS + 1 records. Returns the record count.
+size_t MakeFlashPatternRecords(TimePoint time, const FlashPattern &pattern, TraceRecord *out);
+// Feed the Control records of a trace in order; true once a Pattern record completed
+// `pattern` (which holds the steps read so far in between)
+bool ReadFlashPatternRecord(const TraceRecord &record, FlashPattern &pattern);
+// A device's display name as DeviceName records, written before its first input so a
+// trace can be tied to the physical devices; `out` holds TRACE_NAME_RECORDS records.
+// Returns the record count.
+size_t MakeDeviceNameRecords(TimePoint time, uint16_t deviceId, const wchar_t *name, TraceRecord *out);
+// Feed the DeviceName records of one device in order; `name` holds the name read so far
+// (part 0 restarts it). True once the name is complete.
+bool ReadDeviceNameRecord(const TraceRecord &record, std::wstring &name);
+
+class TraceWriter
+{
+public:
+    // Records per mapped chunk; the file grows (and remaps) once per chunk
+    static constexpr size_t CHUNK_BYTES = 64 * 1024 * 1024;
+
+    TraceWriter() = default;
+    ~TraceWriter() { Close(); }
+    TraceWriter(const TraceWriter &) = delete;
+    TraceWriter &operator=(const TraceWriter &) = delete;
+
+    bool Open(const std::string &path, TimePoint start, uint32_t seed = 0);
+    void Close(); // Truncates to the written size and stores the record count
+    bool IsOpen() const { return m_file != INVALID_FILE; }
+
+    void Append(const TraceRecord &record)
+    {
+        if (m_cursor == m_chunkEnd && !MapNextChunk())
+            return;
+        *m_cursor++ = record;
+        m_count++;
+    }
+
+    uint64_t Count() const { return m_count; }
+
+private:
+    static constexpr intptr_t INVALID_FILE = -1;
+
+    bool MapNextChunk();
+    void Unmap();
+
+    intptr_t m_file = INVALID_FILE;
+    intptr_t m_mapping = 0; // Windows file mapping handle
+    void *m_view = nullptr;
+    uint64_t m_viewOffset = 0;
+    TraceRecord *m_cursor = nullptr;
+    TraceRecord *m_chunkEnd = nullptr;
+    uint64_t m_count = 0;
+};
+
+class TraceReader
+{
+public:
+    TraceReader() = default;
+    ~TraceReader() { Close(); }
+    TraceReader(const TraceReader &) = delete;
+    TraceReader &operator=(const TraceReader &) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    const TraceHeader &Header() const { return *m_header; }
+    const TraceRecord *begin() const { return m_records; }
+    const TraceRecord *end() const { return m_records + m_count; }
+    size_t Count() const { return m_count; }
+
+private:
+    const void *m_view = nullptr;
+    size_t m_viewBytes = 0;
+    intptr_t m_mapping = 0;
+    const TraceHeader *m_header = nullptr;
+    const TraceRecord *m_records = nullptr;
+    size_t m_count = 0;
+};
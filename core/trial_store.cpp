@@ -0,0 +1,333 @@
+#include "trial_store.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include "file_path.h"
+
+static const char TRIALS_MAGIC[8] = {'L', 'T', 'T', 'R', 'I', 'A', 'L', 'S'};
+constexpr uint32_t TRIALS_VERSION = 1;
+constexpr size_t NAME_OFFSET = offsetof(TrialJournalRecord, values);
+
+static_assert(TrialJournal::MAX_NAME * sizeof(uint16_t) == sizeof(TrialJournalRecord) - NAME_OFFSET,
+              "device name fills the record after the id");
+
+void TrialStore::Append(const Trial &trial)
+{
+    if (m_responseNs.capacity() == 0)
+        Reserve(INITIAL_CAPACITY);
+
+    m_foreperiodNs.push_back(trial.foreperiodNs);
+    m_stimulusNs.push_back(trial.stimulusNs);
+    m_responseNs.push_back(trial.responseNs);
+    m_session.push_back(trial.session);
+    m_device.push_back(trial.device);
+    m_mode.push_back(trial.mode);
+    m_flags.push_back(trial.flags);
+}
+
+void TrialStore::Clear()
+{
+    m_foreperiodNs.clear();
+    m_stimulusNs.clear();
+    m_responseNs.clear();
+    m_session.clear();
+    m_device.clear();
+    m_mode.clear();
+    m_flags.clear();
+    m_sessions.clear();
+    m_deviceNames.clear();
+}
+
+void TrialStore::Reserve(size_t trials)
+{
+    m_foreperiodNs.reserve(trials);
+    m_stimulusNs.reserve(trials);
+    m_responseNs.reserve(trials);
+    m_session.reserve(trials);
+    m_device.reserve(trials);
+    m_mode.reserve(trials);
+    m_flags.reserve(trials);
+}
+
+Trial TrialStore::Row(size_t i) const
+{
+    Trial trial;
+    trial.foreperiodNs = m_foreperiodNs[i];
+    trial.stimulusNs = m_stimulusNs[i];
+    trial.responseNs = m_responseNs[i];
+    trial.session = m_session[i];
+    trial.device = m_device[i];
+    trial.mode = m_mode[i];
+    trial.flags = m_flags[i];
+    return trial;
+}
+
+uint32_t TrialStore::AddSession(const TrialSession &session)
+{
+    m_sessions.push_back(session);
+    return (uint32_t)(m_sessions.size() - 1);
+}
+
+void TrialStore::NameDevice(uint32_t session, uint16_t device, const std::wstring &name)
+{
+    for (NamedDevice &named : m_deviceNames)
+    {
+        if (named.session == session && named.device == device)
+        {
+            named.name = name;
+            return;
+        }
+    }
+    m_deviceNames.push_back({session, device, name});
+}
+
+const wchar_t *TrialStore::DeviceName(uint32_t session, uint16_t device) const
+{
+    for (const NamedDevice &named : m_deviceNames)
+    {
+        if (named.session == session && named.device == device)
+            return named.name.c_str();
+    }
+    return L"";
+}
+
+static TrialJournalRecord MakeSessionRecord(const TrialSession &session)
+{
+    TrialJournalRecord record = {};
+    record.type = TrialRecordType::Session;
+    record.seed = session.seed;
+    record.values[0] = session.wallNs;
+    record.values[1] = session.startNs;
+    return record;
+}
+
+static TrialJournalRecord MakeDeviceRecord(uint16_t device, const wchar_t *name)
+{
+    TrialJournalRecord record = {};
+    record.type = TrialRecordType::Device;
+    record.device = device;
+    uint16_t units[TrialJournal::MAX_NAME] = {};
+    for (size_t i = 0; i < TrialJournal::MAX_NAME && name[i] != L'\0'; ++i)
+        units[i] = (uint16_t)name[i];
+    memcpy((uint8_t *)&record + NAME_OFFSET, units, sizeof(units));
+    return record;
+}
+
+static TrialJournalRecord MakeTrialRecord(const Trial &trial)
+{
+    TrialJournalRecord record = {};
+    record.type = TrialRecordType::Trial;
+    record.mode = trial.mode;
+    record.flags = trial.flags;
+    record.device = trial.device;
+    record.values[0] = trial.foreperiodNs;
+    record.values[1] = trial.stimulusNs;
+    record.values[2] = trial.responseNs;
+    return record;
+}
+
+static std::wstring DeviceNameFromRecord(const TrialJournalRecord &record)
+{
+    uint16_t units[TrialJournal::MAX_NAME];
+    memcpy(units, (const uint8_t *)&record + NAME_OFFSET, sizeof(units));
+    std::wstring name;
+    for (size_t i = 0; i < TrialJournal::MAX_NAME && units[i] != 0; ++i)
+        name.push_back((wchar_t)units[i]);
+    return name;
+}
+
+static bool ValidHeader(const TrialJournalHeader &header)
+{
+    return memcmp(header.magic, TRIALS_MAGIC, sizeof(TRIALS_MAGIC)) == 0 && header.version == TRIALS_VERSION &&
+           header.recordSize == sizeof(TrialJournalRecord);
+}
+
+// Size of an open file, leaving the position at the end
+static int64_t FileSize(FILE *f)
+{
+#ifdef _WIN32
+    if (_fseeki64(f, 0, SEEK_END) != 0)
+        return -1;
+    return _ftelli64(f);
+#else
+    if (fseeko(f, 0, SEEK_END) != 0)
+        return -1;
+    return (int64_t)ftello(f);
+#endif
+}
+
+bool TrialJournal::Open(const std::string &path, const TrialSession &session)
+{
+    Close();
+
+    // An existing journal must match this layout; a record torn by a crash becomes padding
+    FILE *f = OpenUtf8File(path, "r+b");
+    if (f)
+    {
+        int64_t size = FileSize(f);
+        TrialJournalHeader header;
+        bool valid = size >= (int64_t)sizeof(header) && fseek(f, 0, SEEK_SET) == 0 &&
+                     fread(&header, sizeof(header), 1, f) == 1 && ValidHeader(header);
+        int64_t torn = valid ? (size - (int64_t)sizeof(header)) % (int64_t)sizeof(TrialJournalRecord) : 0;
+        if (valid && torn != 0)
+        {
+            // The torn record's type byte may have been written: overwrite the whole record
+            static const TrialJournalRecord empty = {};
+            int64_t start = size - torn;
+#ifdef _WIN32
+            valid = _fseeki64(f, start, SEEK_SET) == 0;
+#else
+            valid = fseeko(f, (off_t)start, SEEK_SET) == 0;
+#endif
+            valid = valid && fwrite(&empty, sizeof(empty), 1, f) == 1;
+        }
+        fclose(f);
+        if (!valid && size != 0)
+            return false;
+    }
+
+    m_file = OpenUtf8File(path, "ab");
+    if (!m_file)
+        return false;
+    if (FileSize(m_file) == 0)
+    {
+        TrialJournalHeader header = {};
+        memcpy(header.magic, TRIALS_MAGIC, sizeof(TRIALS_MAGIC));
+        header.version = TRIALS_VERSION;
+        header.recordSize = sizeof(TrialJournalRecord);
+        if (fwrite(&header, sizeof(header), 1, m_file) != 1)
+        {
+            fclose(m_file);
+            m_file = nullptr;
+            return false;
+        }
+    }
+
+    std::fill(std::begin(m_named), std::end(m_named), false);
+    m_stop = false;
+    m_queue.TryPush(MakeSessionRecord(session));
+    m_writer = std::thread(&TrialJournal::Run, this);
+    return true;
+}
+
+void TrialJournal::Close()
+{
+    if (!m_file)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_writer.joinable())
+        m_writer.join();
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+void TrialJournal::Append(const Trial &trial, const wchar_t *deviceName)
+{
+    if (!m_file)
+        return;
+    if (trial.device < 256 && !m_named[trial.device] && deviceName && deviceName[0] != L'\0')
+    {
+        if (m_queue.TryPush(MakeDeviceRecord(trial.device, deviceName)))
+            m_named[trial.device] = true;
+    }
+    m_queue.TryPush(MakeTrialRecord(trial));
+}
+
+void TrialJournal::Run()
+{
+    TrialJournalRecord batch[256];
+    bool stop = false;
+    while (!stop)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this] { return m_stop; });
+            stop = m_stop;
+        }
+
+        // Drain everything queued so far, then one flush per interval
+        size_t total = 0;
+        while (size_t n = m_queue.PopBatch(batch, sizeof(batch) / sizeof(batch[0])))
+        {
+            if (fwrite(batch, sizeof(TrialJournalRecord), n, m_file) != n)
+                break;
+            total += n;
+        }
+        if (total > 0)
+        {
+            fflush(m_file);
+            m_written.fetch_add(total, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool TrialJournal::Load(const std::string &path, TrialStore &store)
+{
+    FILE *f = OpenUtf8File(path, "rb");
+    if (!f)
+        return false;
+
+    // One read for the whole file; a torn record at the end is ignored
+    int64_t size = FileSize(f);
+    TrialJournalHeader header;
+    bool ok = size >= (int64_t)sizeof(header) && fseek(f, 0, SEEK_SET) == 0 &&
+              fread(&header, sizeof(header), 1, f) == 1 && ValidHeader(header);
+    std::vector<TrialJournalRecord> records;
+    if (ok)
+    {
+        records.resize((size_t)((size - (int64_t)sizeof(header)) / (int64_t)sizeof(TrialJournalRecord)));
+        ok = records.empty() || fread(records.data(), sizeof(TrialJournalRecord), records.size(), f) == records.size();
+    }
+    fclose(f);
+    if (!ok)
+        return false;
+
+    size_t trials = 0;
+    for (const TrialJournalRecord &record : records)
+        trials += record.type == TrialRecordType::Trial ? 1 : 0;
+    store.Reserve(store.Count() + trials);
+
+    // Trials before the first session record (none from this writer) get an empty session
+    uint32_t session = 0;
+    bool haveSession = false;
+    auto current = [&]() {
+        if (!haveSession)
+            session = store.AddSession(TrialSession());
+        haveSession = true;
+        return session;
+    };
+    for (const TrialJournalRecord &record : records)
+    {
+        switch (record.type)
+        {
+        case TrialRecordType::Session:
+            session = store.AddSession({record.values[0], record.values[1], record.seed});
+            haveSession = true;
+            break;
+        case TrialRecordType::Device:
+            store.NameDevice(current(), record.device, DeviceNameFromRecord(record));
+            break;
+        case TrialRecordType::Trial:
+        {
+            Trial trial;
+            trial.foreperiodNs = record.values[0];
+            trial.stimulusNs = record.values[1];
+            trial.responseNs = record.values[2];
+            trial.session = current();
+            trial.device = record.device;
+            trial.mode = record.mode;
+            trial.flags = record.flags;
+            store.Append(trial);
+            break;
+        }
+        default:
+            break; // Padding over a torn record, or a newer record type
+        }
+    }
+    return true;
+}
@@ -0,0 +1,173 @@
+// Reaction trials in column arrays, persisted to an append-only journal
+// TrialStore keeps one vector per field so per-column scans (all reaction times of a
+// mode, all foreperiods) touch only that column. TrialJournal appends sessions, device
+// names and trials to a file of fixed 64-byte records: the render thread pushes records
+// into a lock-free ring and a writer thread drains it in batches, so the render loop
+// never waits on disk. Load() reads a whole journal back in one pass.
+//
+// Layout: TrialJournalHeader (64 bytes) followed by TrialJournalRecord[] (64 bytes each);
+// sessions append to the same file. A torn record at the end is padded over on reopen.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_ring.h"
+
+enum class TrialMode : uint8_t
+{
+    Visual,
+    Audio
+};
+
+constexpr uint8_t TRIAL_FALSE_START = 1; // Clicked during the foreperiod; no stimulus
+constexpr uint8_t TRIAL_DAC_TIMED = 2;   // Audio: stimulusNs is the estimated DAC time of the first sample
+
+struct Trial
+{
+    int64_t foreperiodNs = 0; // Random delay before the stimulus
+    int64_t stimulusNs = 0;   // Stimulus onset on the session clock (0 for a false start)
+    int64_t responseNs = 0;   // Button-down arrival on the session clock
+    uint32_t session = 0;     // Index into Sessions() (0 for the live session)
+    uint16_t device = 0;      // DeviceRegistry id within the session
+    TrialMode mode = TrialMode::Visual;
+    uint8_t flags = 0;
+
+    bool FalseStart() const { return (flags & TRIAL_FALSE_START) != 0; }
+    double ReactionMs() const { return FalseStart() ? 0.0 : (responseNs - stimulusNs) / 1e6; }
+};
+
+struct TrialSession
+{
+    int64_t wallNs = 0;  // Unix time when the session started
+    int64_t startNs = 0; // Session clock at that moment
+    uint32_t seed = 0;   // Foreperiod RNG seed
+};
+
+class TrialStore
+{
+public:
+    static constexpr size_t INITIAL_CAPACITY = 4096; // Reserved on the first trial
+
+    void Append(const Trial &trial);
+    void Clear();
+    void Reserve(size_t trials);
+
+    size_t Count() const { return m_responseNs.size(); }
+    Trial Row(size_t i) const;
+
+    // Columns, index = trial
+    const std::vector<int64_t> &ForeperiodNs() const { return m_foreperiodNs; }
+    const std::vector<int64_t> &StimulusNs() const { return m_stimulusNs; }
+    const std::vector<int64_t> &ResponseNs() const { return m_responseNs; }
+    const std::vector<uint32_t> &Session() const { return m_session; }
+    const std::vector<uint16_t> &Device() const { return m_device; }
+    const std::vector<TrialMode> &Mode() const { return m_mode; }
+    const std::vector<uint8_t> &Flags() const { return m_flags; }
+
+    // Journal metadata (empty for a live store)
+    uint32_t AddSession(const TrialSession &session);
+    const std::vector<TrialSession> &Sessions() const { return m_sessions; }
+    void NameDevice(uint32_t session, uint16_t device, const std::wstring &name);
+    const wchar_t *DeviceName(uint32_t session, uint16_t device) const; // L"" if unnamed
+
+private:
+    struct NamedDevice
+    {
+        uint32_t session;
+        uint16_t device;
+        std::wstring name;
+    };
+
+    std::vector<int64_t> m_foreperiodNs;
+    std::vector<int64_t> m_stimulusNs;
+    std::vector<int64_t> m_responseNs;
+    std::vector<uint32_t> m_session;
+    std::vector<uint16_t> m_device;
+    std::vector<TrialMode> m_mode;
+    std::vector<uint8_t> m_flags;
+    std::vector<TrialSession> m_sessions;
+    std::vector<NamedDevice> m_deviceNames;
+};
+
+enum class TrialRecordType : uint8_t
+{
+    Empty = 0, // Padding over a torn record
+    Session = 1,
+    Device = 2,
+    Trial = 3
+};
+
+struct TrialJournalHeader
+{
+    char magic[8]; // "LTTRIALS"
+    uint32_t version;
+    uint32_t recordSize;
+    uint8_t reserved[48];
+};
+
+// Session: values = wall ns, session clock ns, 0; seed = RNG seed
+// Device:  device = id; bytes 16-63 hold the display name, up to 24 UTF-16 units
+// Trial:   values = foreperiod, stimulus, response (ns); mode, flags, device
+struct TrialJournalRecord
+{
+    TrialRecordType type;
+    TrialMode mode;
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t device;
+    uint16_t reserved2;
+    uint32_t seed;
+    uint32_t reserved3;
+    int64_t values[3];
+    uint16_t tail[12];
+};
+
+static_assert(sizeof(TrialJournalHeader) == 64, "TrialJournalHeader layout");
+static_assert(sizeof(TrialJournalRecord) == 64, "TrialJournalRecord layout");
+
+class TrialJournal
+{
+public:
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+    static constexpr int FLUSH_INTERVAL_MS = 250;
+    static constexpr size_t MAX_NAME = 24;
+
+    TrialJournal() = default;
+    ~TrialJournal() { Close(); }
+    TrialJournal(const TrialJournal &) = delete;
+    TrialJournal &operator=(const TrialJournal &) = delete;
+
+    // Opens (or creates) the journal for appending, queues the session record and
+    // starts the writer thread
+    bool Open(const std::string &path, const TrialSession &session);
+    void Close(); // Writes everything queued and joins the writer
+    bool IsOpen() const { return m_file != nullptr; }
+
+    // Render thread; queues the device's name first if this session has not named it yet
+    void Append(const Trial &trial, const wchar_t *deviceName);
+
+    uint64_t Written() const { return m_written.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const { return m_queue.Dropped(); }
+
+    // Appends every record of the journal to store (sessions renumbered after existing ones)
+    static bool Load(const std::string &path, TrialStore &store);
+
+private:
+    void Run();
+
+    FILE *m_file = nullptr;
+    SpscRing<TrialJournalRecord, QUEUE_CAPACITY> m_queue;
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+    std::atomic<uint64_t> m_written{0};
+    bool m_named[256] = {}; // Device ids (DeviceRegistry::MAX_DEVICES) named this session
+};
@@ -0,0 +1,273 @@
+#include "wait_strategy.h"
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define WAIT_HAS_PAUSE 1
+#endif
+
+static const char *const STRATEGY_NAMES[WAIT_STRATEGY_COUNT] = {"spin", "yield", "hybrid", "waitable"};
+
+// Unpaced Hybrid still needs a deadline so flashes end on time
+static constexpr Clock::duration HYBRID_DEFAULT_PERIOD = std::chrono::milliseconds(1);
+// Waitable only times out if the swap chain never signals (occluded, lost device)
+static constexpr Clock::duration WAITABLE_TIMEOUT = std::chrono::milliseconds(100);
+
+const char *WaitStrategyName(WaitStrategy strategy)
+{
+    return (size_t)strategy < WAIT_STRATEGY_COUNT ? STRATEGY_NAMES[(size_t)strategy] : "?";
+}
+
+bool ParseWaitConfig(const char *text, WaitConfig &config)
+{
+    WaitConfig parsed = config;
+    size_t strategy = 0;
+    size_t length = 0;
+    while (strategy < WAIT_STRATEGY_COUNT)
+    {
+        length = strlen(STRATEGY_NAMES[strategy]);
+        if (strncmp(text, STRATEGY_NAMES[strategy], length) == 0 &&
+            (text[length] == '\0' || text[length] == ':' || text[length] == ','))
+            break;
+        ++strategy;
+    }
+    if (strategy == WAIT_STRATEGY_COUNT)
+        return false;
+    parsed.strategy = (WaitStrategy)strategy;
+    parsed.period = Clock::duration(0);
+
+    const char *p = text + length;
+    if (*p == ':')
+    {
+        char *end = nullptr;
+        double fps = strtod(p + 1, &end);
+        if (end == p + 1 || fps <= 0.0 || fps > 1e6)
+            return false;
+        parsed.period = Clock::duration((int64_t)(1e9 / fps + 0.5));
+        p = end;
+    }
+    while (*p == ',')
+    {
+        ++p;
+        if (strncmp(p, "pause", 5) != 0)
+            return false;
+        parsed.pauseUnfocused = true;
+        p += 5;
+    }
+    if (*p)
+        return false;
+
+    config = parsed;
+    return true;
+}
+
+int64_t ThreadCpuTimeNs()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+    uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (int64_t)(k + u) * 100;
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+// One polite spin round: pause hints keep the sibling hyperthread fed, the yield lets
+// any ready thread on this core run
+static void Backoff()
+{
+#ifdef WAIT_HAS_PAUSE
+    for (int i = 0; i < 32; ++i)
+        _mm_pause();
+#endif
+    std::this_thread::yield();
+}
+
+void FrameWaiter::Configure(const WaitConfig &config, TimePoint now)
+{
+    Sample(now);
+    m_config = config;
+    Clock::duration period = config.strategy == WaitStrategy::Hybrid && config.period.count() == 0
+                                 ? HYBRID_DEFAULT_PERIOD
+                                 : config.period;
+    m_next = now + period;
+    m_lastReason = WakeReason::None;
+}
+
+TimePoint FrameWaiter::Spin(WaitTarget &target, TimePoint deadline, bool yield, WakeReason &reason)
+{
+    for (;;)
+    {
+        TimePoint now = Clock::now();
+        if (now >= deadline)
+        {
+            reason = WakeReason::Deadline;
+            return now;
+        }
+        if (target.Pending())
+        {
+            reason = WakeReason::Input;
+            return now;
+        }
+        if (yield)
+            Backoff();
+    }
+}
+
+WakeReason FrameWaiter::Wait(WaitTarget &target)
+{
+    Counters &counters = m_counters[(size_t)m_config.strategy];
+    counters.waits++;
+
+    if (!m_focused && m_config.pauseUnfocused)
+    {
+        TimePoint start = Clock::now();
+        WakeReason reason = target.Block(TimePoint::max(), false);
+        TimePoint now = Clock::now();
+        counters.pausedNs += (now - start).count();
+        counters.wakes[(size_t)reason]++;
+        BalanceFrame(target, reason);
+        m_next = now; // Resume pacing from here instead of catching up
+        m_lastReason = reason;
+        return reason;
+    }
+
+    Clock::duration period = m_config.period;
+    if (m_config.strategy == WaitStrategy::Hybrid && period.count() == 0)
+        period = HYBRID_DEFAULT_PERIOD;
+
+    WakeReason reason = WakeReason::None;
+    TimePoint now;
+    switch (m_config.strategy)
+    {
+    case WaitStrategy::Spin:
+    case WaitStrategy::SpinYield:
+        if (period.count() == 0)
+        {
+            // Unpaced: the loop itself is the spin (Spin never reads the clock here)
+            if (m_config.strategy == WaitStrategy::SpinYield)
+                Backoff();
+            counters.wakes[(size_t)WakeReason::None]++;
+            return WakeReason::None;
+        }
+        now = Spin(target, m_next, m_config.strategy == WaitStrategy::SpinYield, reason);
+        break;
+
+    case WaitStrategy::Hybrid:
+    {
+        // Sleep until the margin, then spin: OS timers wake late by up to their resolution
+        TimePoint wake = m_next - m_config.spinMargin;
+        if (Clock::now() < wake)
+            reason = target.Block(wake, false);
+        if (reason == WakeReason::Input)
+            now = Clock::now();
+        else
+            now = Spin(target, m_next, false, reason);
+        break;
+    }
+
+    case WaitStrategy::Waitable:
+        reason = target.Block(Clock::now() + WAITABLE_TIMEOUT, true);
+        now = Clock::now();
+        BalanceFrame(target, reason);
+        break;
+
+    default:
+        return WakeReason::None;
+    }
+
+    counters.wakes[(size_t)reason]++;
+    m_lastReason = reason;
+    if (m_config.strategy != WaitStrategy::Waitable && reason == WakeReason::Deadline)
+    {
+        counters.lateness.Record((now - m_next).count());
+        m_next += period;
+        if (m_next <= now) // Missed whole periods: restart pacing instead of bursting
+            m_next = now + period;
+    }
+    return reason;
+}
+
+// Waitable: every Present must take one frame-latency signal, or the semaphore's count
+// creeps up with each input-woken frame until the wait stops blocking. An input wake only
+// polls for it here so the input is handled at once; a miss becomes debt that
+// BeforePresent pays. A timed-out wait has nothing to balance (the object never signalled).
+void FrameWaiter::BalanceFrame(WaitTarget &target, WakeReason reason)
+{
+    if (m_config.strategy != WaitStrategy::Waitable || reason == WakeReason::Frame || reason == WakeReason::Deadline)
+        return;
+    if (!target.AcquireFrame(TimePoint()))
+        m_frameDebt++;
+}
+
+void FrameWaiter::BeforePresent(WaitTarget &target)
+{
+    if (m_frameDebt == 0)
+        return;
+    if (target.AcquireFrame(Clock::now() + WAITABLE_TIMEOUT))
+        m_frameDebt--;
+    while (m_frameDebt > 0 && target.AcquireFrame(TimePoint()))
+        m_frameDebt--;
+}
+
+void FrameWaiter::OnInput(TimePoint arrival)
+{
+    if (m_lastReason != WakeReason::Input)
+        return;
+    m_lastReason = WakeReason::None;
+    TimePoint now = Clock::now();
+    if (arrival <= now)
+        m_counters[(size_t)m_config.strategy].input.Record((now - arrival).count());
+}
+
+void FrameWaiter::Sample(TimePoint now)
+{
+    int64_t cpu = ThreadCpuTimeNs();
+    if (m_sampleWall != TimePoint())
+    {
+        Counters &counters = m_counters[(size_t)m_config.strategy];
+        counters.cpuNs += cpu - m_sampleCpu;
+        counters.wallNs += (now - m_sampleWall).count();
+    }
+    m_sampleWall = now;
+    m_sampleCpu = cpu;
+}
+
+WaitStats FrameWaiter::Stats(WaitStrategy strategy) const
+{
+    const Counters &counters = m_counters[(size_t)strategy];
+    WaitStats stats;
+    stats.waits = counters.waits;
+    stats.inputWakes = counters.wakes[(size_t)WakeReason::Input];
+    stats.frameWakes = counters.wakes[(size_t)WakeReason::Frame];
+    stats.deadlineWakes = counters.wakes[(size_t)WakeReason::Deadline];
+    stats.cpuPercent = counters.wallNs > 0 ? 100.0 * (double)counters.cpuNs / (double)counters.wallNs : 0.0;
+    stats.lateP50Us = counters.lateness.Percentile(50.0) / 1000.0;
+    stats.lateP99Us = counters.lateness.Percentile(99.0) / 1000.0;
+    stats.lateMaxUs = counters.lateness.Max() / 1000.0;
+    stats.inputSamples = counters.input.Count();
+    stats.inputP50Us = counters.input.Percentile(50.0) / 1000.0;
+    stats.inputP99Us = counters.input.Percentile(99.0) / 1000.0;
+    stats.pausedMs = counters.pausedNs / 1e6;
+    return stats;
+}
@@ -0,0 +1,129 @@
+// Main-loop wait strategies: what the render loop does between frames
+// Spin re-runs the loop at once (lowest wake latency, one core at 100%). The others
+// back off, sleep or wait for the swap chain until a frame deadline, and every one of
+// them ends the wait as soon as input arrives, so a click still starts a frame at once.
+// The backend supplies the blocking primitive (WaitTarget); FrameWaiter applies the
+// strategy and keeps wake-latency and CPU-usage statistics per strategy.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "histogram.h"
+#include "timing.h"
+
+enum class WaitStrategy : uint8_t
+{
+    Spin,      // Re-run immediately (or spin to the deadline when paced)
+    SpinYield, // Spin with CPU pause hints, yielding the core between polls
+    Hybrid,    // OS sleep until shortly before the deadline, then spin
+    Waitable,  // Block until the swap chain can queue a frame (frame-latency waitable object)
+    Count
+};
+
+constexpr size_t WAIT_STRATEGY_COUNT = (size_t)WaitStrategy::Count;
+
+const char *WaitStrategyName(WaitStrategy strategy);
+
+enum class WakeReason : uint8_t
+{
+    None,     // Spin: the wait returned without blocking
+    Deadline, // The frame deadline passed
+    Input,    // Input or a window message arrived
+    Frame,    // The swap chain can take a frame
+};
+
+struct WaitConfig
+{
+    WaitStrategy strategy = WaitStrategy::Spin;
+    Clock::duration period{0}; // Frame pacing; 0 = unpaced (Hybrid uses 1 ms)
+    Clock::duration spinMargin = std::chrono::microseconds(300); // Hybrid: spin the last part of the period
+    bool pauseUnfocused = false; // Block on messages while the window is inactive
+};
+
+// "<strategy>[:<fps>][,pause]" with strategy spin, yield, hybrid or waitable,
+// e.g. "hybrid:2000,pause" (sleep-then-spin at 2000 FPS, paused while unfocused)
+bool ParseWaitConfig(const char *text, WaitConfig &config);
+
+// Backend blocking primitive
+class WaitTarget
+{
+public:
+    virtual ~WaitTarget() = default;
+
+    // True when input or window messages are queued (polled while spinning)
+    virtual bool Pending() = 0;
+    // Sleeps until `deadline` (TimePoint::max() = no timeout) or until input arrives;
+    // with `frame` set, also until the swap chain can take a frame
+    virtual WakeReason Block(TimePoint deadline, bool frame) = 0;
+    // Takes one signal of the frame-latency object (a counting semaphore: one per frame the
+    // swap chain can queue), waiting until `deadline` at most; a past deadline only polls.
+    // True if taken or if there is no such object.
+    virtual bool AcquireFrame(TimePoint deadline) = 0;
+};
+
+struct WaitStats
+{
+    uint64_t waits = 0;
+    uint64_t inputWakes = 0;
+    uint64_t frameWakes = 0;
+    uint64_t deadlineWakes = 0;
+    double cpuPercent = 0.0; // Calling thread's CPU time over wall time while the strategy was active
+    double lateP50Us = 0.0;  // Wake after the deadline
+    double lateP99Us = 0.0;
+    double lateMaxUs = 0.0;
+    uint64_t inputSamples = 0; // Input arrival -> handled (arrivals stamped on another thread)
+    double inputP50Us = 0.0;
+    double inputP99Us = 0.0;
+    double pausedMs = 0.0; // Blocked while unfocused
+};
+
+// CPU time consumed by the calling thread
+int64_t ThreadCpuTimeNs();
+
+class FrameWaiter
+{
+public:
+    // Switching strategy starts a new CPU-usage sample for the new strategy
+    void Configure(const WaitConfig &config, TimePoint now);
+    const WaitConfig &Config() const { return m_config; }
+    void SetFocused(bool focused) { m_focused = focused; }
+
+    // Returns when the loop should pump messages and render; call on the render thread
+    WakeReason Wait(WaitTarget &target);
+
+    // Arrival time of the first input handled after an input wake (ignored otherwise); call
+    // where the input is handled, so the sample covers everything between arrival and there
+    void OnInput(TimePoint arrival);
+
+    // Call right before Present: Waitable takes the frame-latency signal an input-woken
+    // frame could not take without blocking (no-op otherwise)
+    void BeforePresent(WaitTarget &target);
+
+    // Folds the CPU time since the last sample into the active strategy (render thread)
+    void Sample(TimePoint now);
+    WaitStats Stats(WaitStrategy strategy) const;
+
+private:
+    struct Counters
+    {
+        uint64_t waits = 0;
+        uint64_t wakes[4] = {}; // By WakeReason
+        int64_t cpuNs = 0;
+        int64_t wallNs = 0;
+        int64_t pausedNs = 0;
+        LogHistogram lateness; // ns
+        LogHistogram input;    // ns
+    };
+
+    TimePoint Spin(WaitTarget &target, TimePoint deadline, bool yield, WakeReason &reason);
+    void BalanceFrame(WaitTarget &target, WakeReason reason);
+
+    WaitConfig m_config;
+    Counters m_counters[WAIT_STRATEGY_COUNT];
+    TimePoint m_next{};
+    WakeReason m_lastReason = WakeReason::None;
+    bool m_focused = true;
+    uint32_t m_frameDebt = 0; // Waitable: frames presented without taking a frame-latency signal
+    TimePoint m_sampleWall{};
+    int64_t m_sampleCpu = 0;
+};
@@ -0,0 +1,252 @@
+#include "wav_file.h"
+#include <cstring>
+#include "file_path.h"
+
+// Chunk headers and fields are little-endian, as on every platform the tools run on
+namespace
+{
+constexpr uint16_t WAV_PCM = 1;
+constexpr uint16_t WAV_FLOAT = 3;
+constexpr uint16_t WAV_EXTENSIBLE = 0xFFFE;
+
+struct ChunkHeader
+{
+    char id[4];
+    uint32_t size;
+};
+
+struct FmtChunk
+{
+    uint16_t tag;
+    uint16_t channels;
+    uint32_t sampleRate;
+    uint32_t byteRate;
+    uint16_t blockAlign;
+    uint16_t bitsPerSample;
+};
+
+static_assert(sizeof(ChunkHeader) == 8, "ChunkHeader layout");
+static_assert(sizeof(FmtChunk) == 16, "FmtChunk layout");
+
+bool WriteChunkHeader(FILE *f, const char *id, uint32_t size)
+{
+    ChunkHeader header;
+    memcpy(header.id, id, 4);
+    header.size = size;
+    return fwrite(&header, sizeof(header), 1, f) == 1;
+}
+
+bool PatchU32(FILE *f, long offset, uint32_t value)
+{
+    return fseek(f, offset, SEEK_SET) == 0 && fwrite(&value, sizeof(value), 1, f) == 1;
+}
+
+template <typename T>
+T ReadLE(const uint8_t *p)
+{
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// Averages the channels of interleaved frames into mono floats
+template <typename Sample>
+void Downmix(const uint8_t *data, size_t frames, uint16_t channels, float scale, float *out)
+{
+    const float gain = scale / channels;
+    for (size_t i = 0; i < frames; ++i)
+    {
+        float sum = 0.0f;
+        for (uint16_t c = 0; c < channels; ++c)
+            sum += (float)ReadLE<Sample>(data + (i * channels + c) * sizeof(Sample));
+        out[i] = sum * gain;
+    }
+}
+
+void Downmix24(const uint8_t *data, size_t frames, uint16_t channels, float *out)
+{
+    const float gain = 1.0f / (8388608.0f * channels);
+    for (size_t i = 0; i < frames; ++i)
+    {
+        float sum = 0.0f;
+        for (uint16_t c = 0; c < channels; ++c)
+        {
+            const uint8_t *p = data + (i * channels + c) * 3;
+            int32_t value = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+            sum += (float)value;
+        }
+        out[i] = sum * gain;
+    }
+}
+} // namespace
+
+bool ReadWav(const std::string &path, WavData &wav)
+{
+    wav = WavData();
+    FILE *f = OpenUtf8File(path, "rb");
+    if (!f)
+        return false;
+    std::vector<uint8_t> file;
+    long length = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (length > 0 && fseek(f, 0, SEEK_SET) == 0)
+    {
+        file.resize((size_t)length);
+        file.resize(fread(file.data(), 1, file.size(), f));
+    }
+    fclose(f);
+    if (file.size() < 12 || memcmp(file.data(), "RIFF", 4) != 0 || memcmp(file.data() + 8, "WAVE", 4) != 0)
+        return false;
+
+    FmtChunk fmt = {};
+    bool haveFmt = false;
+    const uint8_t *data = nullptr;
+    size_t dataBytes = 0;
+    for (size_t pos = 12; pos + sizeof(ChunkHeader) <= file.size();)
+    {
+        ChunkHeader header;
+        memcpy(&header, file.data() + pos, sizeof(header));
+        pos += sizeof(header);
+        size_t available = file.size() - pos;
+        // An unpatched data size (capture not closed) runs to the end of the file
+        bool unpatched = header.size == 0 && memcmp(header.id, "data", 4) == 0;
+        size_t size = unpatched || header.size > available ? available : header.size;
+        const uint8_t *body = file.data() + pos;
+        if (memcmp(header.id, "fmt ", 4) == 0 && size >= sizeof(FmtChunk))
+        {
+            memcpy(&fmt, body, sizeof(fmt));
+            if (fmt.tag == WAV_EXTENSIBLE && size >= 26)
+                fmt.tag = ReadLE<uint16_t>(body + 24); // First bytes of the subformat GUID
+            haveFmt = true;
+        }
+        else if (memcmp(header.id, "data", 4) == 0)
+        {
+            data = body;
+            dataBytes = size;
+        }
+        else if (memcmp(header.id, "sync", 4) == 0)
+        {
+            for (size_t i = 0; i + sizeof(AudioSyncPoint) <= size; i += sizeof(AudioSyncPoint))
+                wav.sync.push_back({ReadLE<uint64_t>(body + i), ReadLE<int64_t>(body + i + 8)});
+        }
+        pos += size + (size & 1); // Chunks are word aligned
+    }
+    if (!haveFmt || !data || fmt.channels == 0 || fmt.sampleRate == 0)
+        return false;
+
+    const size_t sampleBytes = fmt.bitsPerSample / 8;
+    if (fmt.tag != WAV_PCM && fmt.tag != WAV_FLOAT)
+        return false;
+    if (sampleBytes == 0 || fmt.bitsPerSample % 8 != 0)
+        return false;
+    const size_t frames = dataBytes / (sampleBytes * fmt.channels);
+    wav.sampleRate = fmt.sampleRate;
+    wav.channels = fmt.channels;
+    wav.mono.resize(frames);
+    if (fmt.tag == WAV_FLOAT && fmt.bitsPerSample == 32)
+        Downmix<float>(data, frames, fmt.channels, 1.0f, wav.mono.data());
+    else if (fmt.tag == WAV_PCM && fmt.bitsPerSample == 16)
+        Downmix<int16_t>(data, frames, fmt.channels, 1.0f / 32768.0f, wav.mono.data());
+    else if (fmt.tag == WAV_PCM && fmt.bitsPerSample == 24)
+        Downmix24(data, frames, fmt.channels, wav.mono.data());
+    else if (fmt.tag == WAV_PCM && fmt.bitsPerSample == 32)
+        Downmix<int32_t>(data, frames, fmt.channels, 1.0f / 2147483648.0f, wav.mono.data());
+    else
+    {
+        wav = WavData();
+        return false;
+    }
+    return true;
+}
+
+bool WavWriter::Open(const std::string &path, const AudioFormat &format)
+{
+    Close();
+    m_file = OpenUtf8File(path, "wb");
+    if (!m_file)
+        return false;
+    m_format = format;
+    m_frames = 0;
+    m_sync.clear();
+
+    const bool isFloat = format.sample == SampleFormat::Float32;
+    FmtChunk fmt;
+    fmt.tag = isFloat ? WAV_FLOAT : WAV_PCM;
+    fmt.channels = format.channels;
+    fmt.sampleRate = format.sampleRate;
+    fmt.blockAlign = (uint16_t)format.FrameBytes();
+    fmt.byteRate = format.sampleRate * fmt.blockAlign;
+    fmt.bitsPerSample = isFloat ? 32 : 16;
+    const uint16_t extension = 0; // Non-PCM formats carry an (empty) extension size
+
+    // Sizes stay 0 until Close, so a reader of an unfinished capture takes the whole file
+    bool ok = WriteChunkHeader(m_file, "RIFF", 0) && fwrite("WAVE", 4, 1, m_file) == 1 &&
+              WriteChunkHeader(m_file, "fmt ", isFloat ? 18 : 16) && fwrite(&fmt, sizeof(fmt), 1, m_file) == 1;
+    if (ok && isFloat)
+    {
+        uint32_t frames = 0;
+        ok = fwrite(&extension, sizeof(extension), 1, m_file) == 1 && WriteChunkHeader(m_file, "fact", 4);
+        m_factOffset = ftell(m_file);
+        ok = ok && fwrite(&frames, sizeof(frames), 1, m_file) == 1;
+    }
+    ok = ok && WriteChunkHeader(m_file, "data", 0);
+    m_dataSizeOffset = ftell(m_file) - 4;
+    if (!ok)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    return ok;
+}
+
+bool WavWriter::Write(const void *frames, size_t count)
+{
+    if (!m_file)
+        return false;
+    if (count > 0 && fwrite(frames, m_format.FrameBytes(), count, m_file) != count)
+        return false;
+    m_frames += count;
+    return true;
+}
+
+bool WavWriter::WriteSilence(size_t count)
+{
+    static const uint8_t zeros[4096] = {};
+    const size_t frameBytes = m_format.FrameBytes();
+    const size_t perWrite = sizeof(zeros) / frameBytes;
+    while (count > 0)
+    {
+        size_t n = count < perWrite ? count : perWrite;
+        if (!Write(zeros, n))
+            return false;
+        count -= n;
+    }
+    return true;
+}
+
+void WavWriter::AddSync(uint64_t frame, TimePoint time)
+{
+    m_sync.push_back({frame, (int64_t)time.time_since_epoch().count()});
+}
+
+bool WavWriter::Close()
+{
+    if (!m_file)
+        return false;
+    const uint64_t dataBytes = m_frames * m_format.FrameBytes();
+    bool ok = true;
+    if (dataBytes & 1)
+        ok = fputc(0, m_file) != EOF;
+    const uint32_t syncBytes = (uint32_t)(m_sync.size() * sizeof(AudioSyncPoint));
+    ok = ok && WriteChunkHeader(m_file, "sync", syncBytes) &&
+         (m_sync.empty() || fwrite(m_sync.data(), sizeof(AudioSyncPoint), m_sync.size(), m_file) == m_sync.size());
+    const long fileBytes = ftell(m_file);
+    ok = ok && PatchU32(m_file, m_dataSizeOffset, (uint32_t)dataBytes) &&
+         PatchU32(m_file, 4, (uint32_t)(fileBytes - 8));
+    if (m_factOffset > 0)
+        ok = ok && PatchU32(m_file, m_factOffset, (uint32_t)m_frames);
+    ok = fclose(m_file) == 0 && ok;
+    m_file = nullptr;
+    m_factOffset = 0;
+    m_sync.clear();
+    return ok;
+}
@@ -0,0 +1,65 @@
+// WAV files for audio captures (loopback or microphone recordings)
+// WavWriter streams interleaved frames in the capture's format (float32 or int16) and, on
+// Close, appends a "sync" chunk of (frame, host time) pairs taken from the capture
+// device's position reports: they map any frame of the recording to the host timebase
+// (trace ticks, which are timebase ns) despite the drift of the capture clock. ReadWav
+// loads a whole file as mono float samples; it also accepts 24/32-bit PCM and extensible
+// headers from other tools.
+//
+// Sync chunk: "sync", size, then pairs of little-endian { uint64 frame, int64 host ns }
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "audio_stimulus.h"
+#include "timing.h"
+
+struct AudioSyncPoint
+{
+    uint64_t frame;
+    int64_t hostNs; // TraceTicks of the time the frame was captured
+};
+
+struct WavData
+{
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    std::vector<float> mono; // Channels averaged
+    std::vector<AudioSyncPoint> sync;
+
+    double Seconds() const { return sampleRate ? (double)mono.size() / sampleRate : 0.0; }
+};
+
+// False if the file is missing or not a PCM/float WAV. A capture that was not closed
+// cleanly (sizes unpatched) is read up to the end of the file, without sync points.
+bool ReadWav(const std::string &path, WavData &wav);
+
+class WavWriter
+{
+public:
+    WavWriter() = default;
+    ~WavWriter() { Close(); }
+    WavWriter(const WavWriter &) = delete;
+    WavWriter &operator=(const WavWriter &) = delete;
+
+    bool Open(const std::string &path, const AudioFormat &format);
+    bool Close(); // Appends the sync chunk and patches the chunk sizes
+    bool IsOpen() const { return m_file != nullptr; }
+
+    bool Write(const void *frames, size_t count); // Interleaved, in the format given to Open
+    bool WriteSilence(size_t count);
+    void AddSync(uint64_t frame, TimePoint time);
+
+    uint64_t Frames() const { return m_frames; }
+
+private:
+    FILE *m_file = nullptr;
+    AudioFormat m_format;
+    uint64_t m_frames = 0;
+    long m_dataSizeOffset = 0;
+    long m_factOffset = 0; // Float files: frame count in the "fact" chunk
+    std::vector<AudioSyncPoint> m_sync;
+};
@@ -0,0 +1,30 @@
+// Fake device enumerator for the headless backend and benchmarks
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "core/device_registry.h"
+
+class FakeDeviceEnumerator : public DeviceEnumerator
+{
+public:
+    void AddDevice(uint64_t handle, const std::wstring &path) { m_paths[handle] = path; }
+    void RemoveDevice(uint64_t handle) { m_paths.erase(handle); }
+
+    bool GetDeviceName(uint64_t handle, std::wstring &name) override
+    {
+        m_queries++;
+        auto it = m_paths.find(handle);
+        if (it == m_paths.end())
+            return false;
+        name = it->second;
+        return true;
+    }
+
+    uint64_t QueryCount() const { return m_queries; }
+
+private:
+    std::unordered_map<uint64_t, std::wstring> m_paths;
+    uint64_t m_queries = 0;
+};
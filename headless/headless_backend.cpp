@@ -0,0 +1,51 @@
+#include "headless_backend.h"
+
+InputAction HeadlessLatencyBackend::Input(const InputEvent &ev, const wchar_t *deviceName)
+{
+    return Input(ev, DecodeTime(ev), deviceName);
+}
+
+InputAction HeadlessLatencyBackend::Input(const InputEvent &ev, TimePoint handled, const wchar_t *deviceName)
+{
+    uint32_t id = stages.OnInput();
+    InputAction action = tester.OnInput(ev, deviceName, L"KEY");
+    if (action != InputAction::None)
+    {
+        m_flashCount++;
+        stages.OnTrigger(id, ev, handled);
+    }
+    return action;
+}
+
+const HeadlessFrame &HeadlessLatencyBackend::Render(TimePoint now, TimePoint clear)
+{
+    bool flashing = tester.UpdateFrame(now);
+    m_frame.index = m_frameCount++;
+    m_frame.time = now;
+    tester.GetClearColor(m_frame.clearColor);
+    if (stages.Pending())
+        stages.OnClear(clear);
+    if (flashing)
+        m_flashFrameCount++;
+    return m_frame;
+}
+
+void HeadlessLatencyBackend::Present(TimePoint call, TimePoint ret, bool presented)
+{
+    if (stages.Pending())
+        stages.OnPresent(call, ret, presented);
+}
+
+const HeadlessFrame &HeadlessReactionBackend::Render(TimePoint now)
+{
+    if (tester.Update(now) == ReactionEvent::StimulusOnset)
+    {
+        m_stimulusCount++;
+        if (tester.beepPlayed)
+            m_beepCount++;
+    }
+    m_frame.index = m_frameCount++;
+    m_frame.time = now;
+    tester.GetClearColor(m_frame.clearColor);
+    return m_frame;
+}
@@ -0,0 +1,60 @@
+// Headless backend: drives the portable testers with caller-supplied time
+// instead of a window, swap chain and wall clock
+#pragma once
+
+#include <cstdint>
+#include "core/latency_stages.h"
+#include "core/latency_tester.h"
+#include "core/reaction_tester.h"
+
+struct HeadlessFrame
+{
+    uint64_t index = 0;
+    TimePoint time;
+    float clearColor[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+};
+
+class HeadlessLatencyBackend
+{
+public:
+    LatencyTester tester;
+    LatencyAttribution stages;
+
+    // Handled when decoded unless a later handling time is given
+    InputAction Input(const InputEvent &ev, const wchar_t *deviceName = L"HEADLESS");
+    InputAction Input(const InputEvent &ev, TimePoint handled, const wchar_t *deviceName = L"HEADLESS");
+    const HeadlessFrame &Render(TimePoint now) { return Render(now, now); }
+    const HeadlessFrame &Render(TimePoint now, TimePoint clear);
+    void Present(TimePoint call, TimePoint ret, bool presented = true);
+
+    uint64_t FrameCount() const { return m_frameCount; }
+    uint64_t FlashFrameCount() const { return m_flashFrameCount; }
+    uint64_t FlashCount() const { return m_flashCount; }
+
+private:
+    HeadlessFrame m_frame;
+    uint64_t m_frameCount = 0;
+    uint64_t m_flashFrameCount = 0;
+    uint64_t m_flashCount = 0;
+};
+
+class HeadlessReactionBackend
+{
+public:
+    ReactionTester tester;
+
+    explicit HeadlessReactionBackend(uint32_t seed) : tester(seed) {}
+
+    ReactionEvent Input(const InputEvent &ev) { return tester.OnInput(ev); }
+    const HeadlessFrame &Render(TimePoint now);
+
+    uint64_t FrameCount() const { return m_frameCount; }
+    uint64_t BeepCount() const { return m_beepCount; }
+    uint64_t StimulusCount() const { return m_stimulusCount; }
+
+private:
+    HeadlessFrame m_frame;
+    uint64_t m_frameCount = 0;
+    uint64_t m_beepCount = 0;
+    uint64_t m_stimulusCount = 0;
+};
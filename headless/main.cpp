@@ -0,0 +1,603 @@
+// Headless runner for the portable timing core
+// Simulates a session against a synthetic clock and input stream and prints a summary
+//
+// Usage: LatencyHeadless [latency|reaction] [seconds] [fps]
+//        LatencyHeadless replay <latency|reaction> <trace> [transitions]
+//        LatencyHeadless dump <trace> [records]
+//        LatencyHeadless pattern <pattern> [fps] [jitter us]
+//        LatencyHeadless trials <journal>
+//        LatencyHeadless loopback <capture.wav> [trace]
+//        LatencyHeadless clicks <capture.wav> <trace>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include "core/onset_detector.h"
+#include "core/reaction_stats.h"
+#include "core/wav_file.h"
+#include "replay.h"
+
+static InputEvent MakeClick(TimePoint time)
+{
+    InputEvent ev;
+    ev.time = time;
+    ev.type = InputType::Mouse;
+    ev.buttonFlags = MOUSE_LEFT_DOWN;
+    return ev;
+}
+
+static void PrintReplayResult(const ReplayResult &result, TimePoint start, size_t maxTransitions)
+{
+    printf("frames %llu (%llu white), inputs %llu, stimuli %llu, %zu state changes, hash %016llx\n",
+           (unsigned long long)result.frames, (unsigned long long)result.whiteFrames,
+           (unsigned long long)result.inputs, (unsigned long long)result.stimuli, result.transitions.size(),
+           (unsigned long long)result.hash);
+
+    size_t shown = result.transitions.size() < maxTransitions ? result.transitions.size() : maxTransitions;
+    for (size_t i = 0; i < shown; ++i)
+    {
+        const ReplayTransition &transition = result.transitions[i];
+        printf("  frame %10llu  %12.4f ms  state %u\n", (unsigned long long)transition.frame,
+               ElapsedMs(start, transition.time), transition.state);
+    }
+}
+
+static void PrintStages(const LatencyAttribution &stages)
+{
+    printf("%llu inputs, %llu attributed, %llu dropped, %llu present retries\n",
+           (unsigned long long)stages.Inputs(), (unsigned long long)stages.Completed(),
+           (unsigned long long)stages.Dropped(), (unsigned long long)stages.PresentRetries());
+    printf("  %-15s %10s %10s %10s %10s\n", "stage (us)", "mean", "p50", "p99", "max");
+    for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; ++stage)
+    {
+        LatencyStageStats stats = stages.Stats((LatencyStage)stage);
+        printf("  %-15s %10.2f %10.2f %10.2f %10.2f\n", LatencyStageName((LatencyStage)stage), stats.meanUs,
+               stats.p50Us, stats.p99Us, stats.maxUs);
+    }
+}
+
+static int RunLatency(double seconds, double fps)
+{
+    LatencyReplay replay;
+    replay.backend.tester.filter.enableUpEvents = false;
+
+    // Synthetic session: one click every 250 ms
+    const auto frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+    const auto clickInterval = std::chrono::milliseconds(250);
+    const TimePoint start{};
+    const TimePoint end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    // Synthetic stage costs (us): decode, handling, clear, overlay draw, Present(); one
+    // Present in 8 finds the queue full and the frame is redone
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> jitter(0.5, 1.5);
+    auto cost = [&](double us) { return Clock::duration((int64_t)(us * jitter(rng) * 1000.0)); };
+
+    // Clicks land between frames and are handled once decoded, at the start of a frame
+    auto wallStart = std::chrono::steady_clock::now();
+    TimePoint nextClick = start + clickInterval + frameTime / 3;
+    InputEvent click = MakeClick(nextClick);
+    SetDecodeTime(click, nextClick + cost(2.0));
+    for (TimePoint now = start; now < end; now += frameTime)
+    {
+        while (DecodeTime(click) <= now)
+        {
+            replay.Input(click, now + cost(0.5));
+            nextClick += clickInterval;
+            click = MakeClick(nextClick);
+            SetDecodeTime(click, nextClick + cost(2.0));
+        }
+        TimePoint clear = now + std::chrono::microseconds(1) + cost(1.0);
+        replay.Frame(now, clear);
+        TimePoint call = clear + cost(20.0);
+        replay.backend.Present(call, call + cost(50.0), rng() % 8 != 0);
+    }
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    const ReplayResult &result = replay.Result();
+    printf("latency: %llu frames, %llu flashes, %llu white frames\n", (unsigned long long)result.frames,
+           (unsigned long long)result.stimuli, (unsigned long long)result.whiteFrames);
+    printf("state sequence: %zu changes, hash %016llx\n", result.transitions.size(),
+           (unsigned long long)result.hash);
+    printf("simulated %.1f s in %.3f s wall (%.0fx real time)\n", seconds, wallSec,
+           wallSec > 0.0 ? seconds / wallSec : 0.0);
+    PrintStages(replay.backend.stages);
+    return 0;
+}
+
+static int RunReaction(double seconds, double fps)
+{
+    ReactionReplay replay(1234);
+
+    // Synthetic subject: responds 200 ms after each stimulus onset
+    const auto frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+    const auto responseDelay = std::chrono::milliseconds(200);
+    const TimePoint start{};
+    const TimePoint end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    auto wallStart = std::chrono::steady_clock::now();
+    replay.Control(TraceControl::RoundStart, start);
+    uint64_t trials = 0;
+    for (TimePoint now = start; now < end; now += frameTime)
+    {
+        const ReactionTester &tester = replay.backend.tester;
+        if (tester.state == TestState::Flashing && now - tester.flashStartTime >= responseDelay)
+        {
+            if (replay.Input(MakeClick(now)) == ReactionEvent::Response)
+                trials++;
+        }
+        replay.Frame(now);
+    }
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    const ReplayResult &result = replay.Result();
+    const ReactionStats &stats = replay.backend.tester.stats;
+    printf("reaction: %llu frames, %llu trials, avg %.2f ms (sd %.2f), median %.2f ms, p90 %.2f ms, best %.2f ms\n",
+           (unsigned long long)result.frames, (unsigned long long)trials, stats.Mean(), stats.StdDev(),
+           stats.Median(), stats.Percentile(90.0), stats.Best());
+    printf("state sequence: %zu changes, hash %016llx\n", result.transitions.size(),
+           (unsigned long long)result.hash);
+    printf("simulated %.1f s in %.3f s wall (%.0fx real time)\n", seconds, wallSec,
+           wallSec > 0.0 ? seconds / wallSec : 0.0);
+    return 0;
+}
+
+template <class Replay>
+static int ReplayTrace(Replay &replay, const TraceReader &reader, size_t maxTransitions)
+{
+    auto wallStart = std::chrono::steady_clock::now();
+    for (const TraceRecord &record : reader)
+        replay.Apply(record);
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    const ReplayResult &result = replay.Result();
+    const TimePoint start = TraceTimePoint(reader.Header().startTicks);
+    PrintReplayResult(result, start, maxTransitions);
+
+    double recordedSec = reader.Count() > 0 ? ElapsedMs(start, TraceTimePoint((reader.end() - 1)->ticks)) / 1000.0
+                                            : 0.0;
+    printf("recorded %llu stimuli, replayed %llu; %llu frames differ from the recording\n",
+           (unsigned long long)result.recordedStimuli, (unsigned long long)result.stimuli,
+           (unsigned long long)result.mismatchedFrames);
+    printf("replayed %.1f s in %.3f s wall (%.0fx real time)\n", recordedSec, wallSec,
+           wallSec > 0.0 ? recordedSec / wallSec : 0.0);
+    return result.mismatchedFrames == 0 && result.recordedStimuli == result.stimuli ? 0 : 2;
+}
+
+static int RunReplay(const char *mode, const char *path, size_t maxTransitions)
+{
+    TraceReader reader;
+    if (!reader.Open(path))
+    {
+        fprintf(stderr, "Failed to open trace %s\n", path);
+        return 1;
+    }
+
+    if (strcmp(mode, "latency") == 0)
+    {
+        LatencyReplay replay;
+        int result = ReplayTrace(replay, reader, maxTransitions);
+        PrintStages(replay.backend.stages);
+        return result;
+    }
+    if (strcmp(mode, "reaction") == 0)
+    {
+        ReactionReplay replay(reader.Header().seed);
+        return ReplayTrace(replay, reader, maxTransitions);
+    }
+    fprintf(stderr, "Unknown replay mode %s\n", mode);
+    return 1;
+}
+
+// Plays a flash pattern once against a virtual frame source (fixed rate plus optional
+// uniform jitter) and prints every run of frames that stayed on one step
+static int RunPattern(const char *text, double fps, double jitterUs)
+{
+    FlashPattern pattern;
+    if (!ParseFlashPattern(text, pattern))
+    {
+        fprintf(stderr, "Invalid pattern %s\n", text);
+        return 1;
+    }
+
+    const auto frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> jitter(-jitterUs, jitterUs);
+
+    const TimePoint start{};
+    FlashSequencer sequencer;
+    sequencer.Start(pattern, start);
+
+    printf("%zu steps x%u, min %u frames, %.0f fps +-%.0f us\n", pattern.stepCount, pattern.repeat,
+           pattern.minFrames, fps, jitterUs);
+    TimePoint runStart = start;
+    uint64_t runFrames = 0;
+    size_t runStep = 0;
+    uint32_t runTrain = 0;
+    float runLevel = 0.0f;
+    uint64_t frames = 0;
+    uint64_t shortRuns = 0;
+    for (TimePoint now = start; frames < 100000000; ++frames)
+    {
+        size_t step = sequencer.Step();
+        uint32_t train = sequencer.Train();
+        float level = sequencer.OnFrame(now);
+        bool changed = !sequencer.Active() || sequencer.Step() != step || sequencer.Train() != train;
+        if (runFrames > 0 && changed)
+        {
+            printf("  train %u step %zu level %.2f: %llu frames, %.3f ms\n", runTrain, runStep, runLevel,
+                   (unsigned long long)runFrames, ElapsedMs(runStart, now));
+            if (runFrames < pattern.minFrames)
+                shortRuns++;
+            runFrames = 0;
+        }
+        if (!sequencer.Active())
+            break;
+        if (runFrames == 0)
+        {
+            runStart = now;
+            runStep = sequencer.Step();
+            runTrain = sequencer.Train();
+            runLevel = level;
+        }
+        runFrames++;
+
+        auto next = frameTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(jitter(rng)));
+        now += next > Clock::duration::zero() ? next : Clock::duration(1);
+    }
+    printf("%llu frames, %llu steps shorter than the minimum\n", (unsigned long long)frames,
+           (unsigned long long)shortRuns);
+    return shortRuns == 0 ? 0 : 2;
+}
+
+static const char *TraceTypeName(TraceRecordType type)
+{
+    switch (type)
+    {
+    case TraceRecordType::Input:
+        return "input";
+    case TraceRecordType::Flash:
+        return "flash";
+    case TraceRecordType::Present:
+        return "present";
+    case TraceRecordType::Control:
+        return "control";
+    default:
+        return "empty";
+    }
+}
+
+static int DumpTrace(const char *path, size_t maxRecords)
+{
+    TraceReader reader;
+    if (!reader.Open(path))
+    {
+        fprintf(stderr, "Failed to open trace %s\n", path);
+        return 1;
+    }
+
+    const TraceHeader &header = reader.Header();
+    const double msPerTick = 1000.0 / (double)header.ticksPerSecond;
+    printf("trace %s: version %u, %zu records, %lld ticks/s, seed %u%s\n", path, header.version, reader.Count(),
+           (long long)header.ticksPerSecond, header.seed, header.recordCount == 0 ? " (not closed cleanly)" : "");
+
+    size_t counts[5] = {};
+    size_t shown = 0;
+    for (const TraceRecord &record : reader)
+    {
+        if ((size_t)record.type < 5)
+            counts[(size_t)record.type]++;
+        if (shown++ >= maxRecords)
+            continue;
+
+        double timeMs = (record.ticks - header.startTicks) * msPerTick;
+        switch (record.type)
+        {
+        case TraceRecordType::Input:
+            printf("%12.4f ms  input   dev %u flags 0x%04x data %d dx %d dy %d vkey 0x%02x\n", timeMs,
+                   record.deviceId, record.flags, record.data, record.dx, record.dy, record.vkey);
+            break;
+        case TraceRecordType::Flash:
+            if (record.flags == TRACE_FLASH_DAC)
+                printf("%12.4f ms  flash   #%u audio at DAC +-%.1f us\n", timeMs, record.sequence, record.dx / 1000.0);
+            else
+                printf("%12.4f ms  flash   #%u %s\n", timeMs, record.sequence, record.flags ? "on" : "off");
+            break;
+        case TraceRecordType::Present:
+            printf("%12.4f ms  present frame %u %s, update %.4f ms earlier, call %.4f ms\n", timeMs, record.sequence,
+                   record.flags ? "white" : "black", record.dy * msPerTick, record.dx * msPerTick);
+            break;
+        case TraceRecordType::Control:
+            printf("%12.4f ms  control %d\n", timeMs, record.data);
+            break;
+        default:
+            printf("%12.4f ms  %s\n", timeMs, TraceTypeName(record.type));
+            break;
+        }
+    }
+    printf("input %zu, flash %zu, present %zu, control %zu\n", counts[(size_t)TraceRecordType::Input],
+           counts[(size_t)TraceRecordType::Flash], counts[(size_t)TraceRecordType::Present],
+           counts[(size_t)TraceRecordType::Control]);
+    return 0;
+}
+
+// Loads a trial journal and summarizes each session
+static int SummarizeTrials(const char *path)
+{
+    auto wallStart = std::chrono::steady_clock::now();
+    TrialStore store;
+    if (!TrialJournal::Load(path, store))
+    {
+        fprintf(stderr, "Failed to load trial journal %s\n", path);
+        return 1;
+    }
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    printf("journal %s: %zu sessions, %zu trials, loaded in %.2f ms\n", path, store.Sessions().size(), store.Count(),
+           loadMs);
+
+    const std::vector<uint32_t> &sessions = store.Session();
+    size_t begin = 0;
+    for (uint32_t session = 0; session < store.Sessions().size(); ++session)
+    {
+        ReactionStats visual;
+        ReactionStats audio;
+        size_t falseStarts = 0;
+        size_t dacTimed = 0;
+        size_t end = begin;
+        while (end < store.Count() && sessions[end] == session)
+        {
+            Trial trial = store.Row(end++);
+            if (trial.flags & TRIAL_DAC_TIMED)
+                dacTimed++;
+            if (trial.FalseStart())
+                falseStarts++;
+            else
+                (trial.mode == TrialMode::Audio ? audio : visual).Add((float)trial.ReactionMs());
+        }
+        printf("  session %u: seed %u, %zu trials, %zu false starts", session, store.Sessions()[session].seed,
+               end - begin, falseStarts);
+        if (!visual.Empty())
+            printf(", visual median %.1f ms (n=%zu)", visual.Median(), visual.Count());
+        if (!audio.Empty())
+            printf(", audio median %.1f ms (n=%zu, %zu timed at the DAC)", audio.Median(), audio.Count(), dacTimed);
+        printf("\n");
+        begin = end;
+    }
+    return 0;
+}
+
+// Device names for the console: ASCII as is, anything else as '?'
+static std::string NarrowName(const std::wstring &name)
+{
+    std::string narrow;
+    for (wchar_t c : name)
+        narrow.push_back(c > 0 && c < 0x80 ? (char)c : '?');
+    return narrow;
+}
+
+static void PrintLatencyDistribution(const char *name, const ReactionStats &stats)
+{
+    printf("  %-22s n=%zu  min %.2f  p5 %.2f  median %.2f  p95 %.2f  max %.2f  mean %.2f (sd %.2f) ms\n", name,
+           stats.Count(), stats.Best(), stats.Percentile(5.0), stats.Median(), stats.Percentile(95.0), stats.Worst(),
+           stats.Mean(), stats.StdDev());
+}
+
+// Finds the stimulus onsets in a loopback or microphone capture (-capture in the reaction
+// tester) and, given the session's trace, the trigger -> sound latency of every stimulus
+static int AnalyzeLoopback(const char *wavPath, const char *tracePath)
+{
+    auto wallStart = std::chrono::steady_clock::now();
+    WavData wav;
+    if (!ReadWav(wavPath, wav))
+    {
+        fprintf(stderr, "Failed to read capture %s\n", wavPath);
+        return 1;
+    }
+    std::vector<DetectedOnset> onsets;
+    OnsetDetector detector(wav.sampleRate);
+    detector.Process(wav.mono.data(), wav.mono.size(), onsets);
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    printf("capture %s: %.1f s, %u Hz, %u ch, %zu sync points; %zu onsets, noise floor %.1f dBFS\n", wavPath,
+           wav.Seconds(), wav.sampleRate, wav.channels, wav.sync.size(), onsets.size(), detector.NoiseFloorDb());
+    printf("read and analysed in %.3f s wall (%.0fx real time)\n", wallSec,
+           wallSec > 0.0 ? wav.Seconds() / wallSec : 0.0);
+    if (!tracePath)
+    {
+        for (const DetectedOnset &onset : onsets)
+            printf("  %12.4f ms  onset %.1f dBFS\n", onset.frame * 1000.0 / wav.sampleRate, onset.levelDb);
+        return 0;
+    }
+
+    TraceReader reader;
+    if (!reader.Open(tracePath))
+    {
+        fprintf(stderr, "Failed to open trace %s\n", tracePath);
+        return 1;
+    }
+    // Stimulus triggers, each with the DAC time the audio thread estimated for it
+    std::vector<LoopbackTrigger> triggers;
+    for (const TraceRecord &record : reader)
+    {
+        if (record.type != TraceRecordType::Flash)
+            continue;
+        if (record.flags == 1)
+        {
+            LoopbackTrigger trigger;
+            trigger.sequence = record.sequence;
+            trigger.trigger = TraceTimePoint(record.ticks);
+            triggers.push_back(trigger);
+        }
+        else if (record.flags == TRACE_FLASH_DAC && !triggers.empty() && triggers.back().sequence == record.sequence)
+        {
+            triggers.back().dacEstimate = TraceTimePoint(record.ticks);
+            triggers.back().hasDacEstimate = true;
+        }
+    }
+
+    std::vector<LoopbackMatch> matches;
+    if (!MatchLoopbackOnsets(onsets, wav.sync, triggers, 1000.0, matches))
+    {
+        fprintf(stderr, "Capture has no sync points; it cannot be aligned with the trace\n");
+        return 1;
+    }
+    ReactionStats latency;
+    ReactionStats dacError;
+    for (const LoopbackMatch &match : matches)
+    {
+        latency.Add((float)match.latencyMs);
+        if (match.hasDacEstimate)
+            dacError.Add((float)match.dacErrorMs);
+    }
+    printf("%zu triggers, %zu matched onsets, %zu onsets without a trigger\n", triggers.size(), matches.size(),
+           onsets.size() - matches.size());
+    if (!latency.Empty())
+        PrintLatencyDistribution("trigger -> sound", latency);
+    if (!dacError.Empty())
+        PrintLatencyDistribution("DAC estimate -> sound", dacError);
+    return 0;
+}
+
+// Finds the mouse switch clicks in a microphone capture (-capture in the latency tester)
+// and pairs each with its button-down event from the session's trace: the click ->
+// WM_INPUT latency of every device, switch debounce and polling included
+static int AnalyzeClicks(const char *wavPath, const char *tracePath)
+{
+    const uint16_t downMask =
+        MOUSE_LEFT_DOWN | MOUSE_RIGHT_DOWN | MOUSE_MIDDLE_DOWN | MOUSE_BUTTON4_DOWN | MOUSE_BUTTON5_DOWN;
+    TraceReader reader;
+    if (!reader.Open(tracePath))
+    {
+        fprintf(stderr, "Failed to open trace %s\n", tracePath);
+        return 1;
+    }
+    std::vector<ClickPress> presses;
+    std::map<uint16_t, std::wstring> names;
+    for (const TraceRecord &record : reader)
+    {
+        if (record.type == TraceRecordType::Input && record.inputType == InputType::Mouse && (record.flags & downMask))
+            presses.push_back({record.deviceId, TraceTimePoint(record.ticks)});
+        else if (record.type == TraceRecordType::Control && record.data == (int16_t)TraceControl::DeviceName)
+            ReadDeviceNameRecord(record, names[record.deviceId]);
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    WavData wav;
+    if (!ReadWav(wavPath, wav))
+    {
+        fprintf(stderr, "Failed to read capture %s\n", wavPath);
+        return 1;
+    }
+    std::vector<DetectedOnset> onsets;
+    OnsetDetector detector(wav.sampleRate, ClickDetectorConfig());
+    EmphasizeTransients(wav.mono.data(), wav.mono.size());
+    detector.Process(wav.mono.data(), wav.mono.size(), onsets);
+    std::vector<ClickMatch> matches;
+    if (!MatchClickOnsets(onsets, wav.sync, presses, 50.0, matches))
+    {
+        fprintf(stderr, "Capture has no sync points; it cannot be aligned with the trace\n");
+        return 1;
+    }
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    printf("capture %s: %.1f s, %u Hz, %u ch, %zu sync points; %zu clicks, noise floor %.1f dBFS\n", wavPath,
+           wav.Seconds(), wav.sampleRate, wav.channels, wav.sync.size(), onsets.size(), detector.NoiseFloorDb());
+    printf("read, analysed and paired in %.3f s wall (%.0fx real time)\n", wallSec,
+           wallSec > 0.0 ? wav.Seconds() / wallSec : 0.0);
+    printf("%zu button presses, %zu paired with a click, %zu presses not heard, %zu clicks without a press\n",
+           presses.size(), matches.size(), presses.size() - matches.size(), onsets.size() - matches.size());
+
+    std::map<uint16_t, ReactionStats> devices;
+    for (const ClickMatch &match : matches)
+        devices[match.deviceId].Add((float)match.latencyMs);
+    if (!devices.empty())
+        printf("click -> WM_INPUT latency by device:\n");
+    for (const auto &device : devices)
+    {
+        // Traces from before device names were recorded only have the id
+        std::string name = "device " + std::to_string(device.first);
+        auto named = names.find(device.first);
+        if (named != names.end() && !named->second.empty())
+            name += " " + NarrowName(named->second);
+        PrintLatencyDistribution(name.c_str(), device.second);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *mode = argc > 1 ? argv[1] : "latency";
+    if (strcmp(mode, "dump") == 0)
+    {
+        if (argc < 3)
+        {
+            fprintf(stderr, "Usage: %s dump <trace> [records]\n", argv[0]);
+            return 1;
+        }
+        return DumpTrace(argv[2], argc > 3 ? (size_t)atol(argv[3]) : 20);
+    }
+    if (strcmp(mode, "pattern") == 0)
+    {
+        if (argc < 3)
+        {
+            fprintf(stderr, "Usage: %s pattern <pattern> [fps] [jitter us]\n", argv[0]);
+            return 1;
+        }
+        return RunPattern(argv[2], argc > 3 ? atof(argv[3]) : 240.0, argc > 4 ? atof(argv[4]) : 0.0);
+    }
+    if (strcmp(mode, "trials") == 0)
+    {
+        if (argc < 3)
+        {
+            fprintf(stderr, "Usage: %s trials <journal>\n", argv[0]);
+            return 1;
+        }
+        return SummarizeTrials(argv[2]);
+    }
+    if (strcmp(mode, "loopback") == 0)
+    {
+        if (argc < 3)
+        {
+            fprintf(stderr, "Usage: %s loopback <capture.wav> [trace]\n", argv[0]);
+            return 1;
+        }
+        return AnalyzeLoopback(argv[2], argc > 3 ? argv[3] : nullptr);
+    }
+    if (strcmp(mode, "clicks") == 0)
+    {
+        if (argc < 4)
+        {
+            fprintf(stderr, "Usage: %s clicks <capture.wav> <trace>\n", argv[0]);
+            return 1;
+        }
+        return AnalyzeClicks(argv[2], argv[3]);
+    }
+    if (strcmp(mode, "replay") == 0)
+    {
+        if (argc < 4)
+        {
+            fprintf(stderr, "Usage: %s replay <latency|reaction> <trace> [transitions]\n", argv[0]);
+            return 1;
+        }
+        return RunReplay(argv[2], argv[3], argc > 4 ? (size_t)atol(argv[4]) : 20);
+    }
+
+    double seconds = argc > 2 ? atof(argv[2]) : 60.0;
+    double fps = argc > 3 ? atof(argv[3]) : 10000.0;
+
+    if (seconds <= 0.0 || fps <= 0.0)
+    {
+        fprintf(stderr, "Usage: %s [latency|reaction] [seconds] [fps]\n", argv[0]);
+        return 1;
+    }
+
+    if (strcmp(mode, "latency") == 0)
+        return RunLatency(seconds, fps);
+    if (strcmp(mode, "reaction") == 0)
+        return RunReaction(seconds, fps);
+
+    fprintf(stderr, "Usage: %s [latency|reaction] [seconds] [fps]\n", argv[0]);
+    return 1;
+}
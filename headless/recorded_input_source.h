@@ -0,0 +1,80 @@
+// Plays recorded GetRawInputBuffer batches through the portable batch decoder
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "core/input_source.h"
+#include "core/raw_input.h"
+
+struct RawBatch
+{
+    TimePoint time;            // When the batch was drained
+    uint32_t count = 0;        // Records in the batch
+    std::vector<uint8_t> data; // GetRawInputBuffer layout
+};
+
+class RecordedInputSource : public InputSource
+{
+public:
+    RecordedInputSource(const std::vector<RawBatch> &batches, DeviceRegistry &devices)
+        : m_batches(batches), m_devices(devices) {}
+
+    // Decodes the next recorded batch (one batch per loop iteration)
+    size_t Poll(InputEvent *out, size_t maxEvents) override
+    {
+        if (m_next >= m_batches.size())
+            return 0;
+        const RawBatch &batch = m_batches[m_next++];
+        return DecodeRawInputBatch(batch.data.data(), batch.data.size(), batch.count, batch.time,
+                                   m_devices, out, maxEvents);
+    }
+
+    bool Finished() const { return m_next >= m_batches.size(); }
+
+private:
+    const std::vector<RawBatch> &m_batches;
+    DeviceRegistry &m_devices;
+    size_t m_next = 0;
+};
+
+// File format: per batch [int64 time ns][uint32 count][uint32 bytes][bytes]
+inline bool SaveRawBatches(const char *path, const std::vector<RawBatch> &batches)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    bool ok = true;
+    for (const RawBatch &batch : batches)
+    {
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(batch.time.time_since_epoch()).count();
+        uint32_t bytes = (uint32_t)batch.data.size();
+        ok = ok && fwrite(&ns, sizeof(ns), 1, f) == 1 && fwrite(&batch.count, sizeof(batch.count), 1, f) == 1 &&
+             fwrite(&bytes, sizeof(bytes), 1, f) == 1 && (bytes == 0 || fwrite(batch.data.data(), bytes, 1, f) == 1);
+    }
+    fclose(f);
+    return ok;
+}
+
+inline bool LoadRawBatches(const char *path, std::vector<RawBatch> &batches)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    batches.clear();
+    int64_t ns;
+    while (fread(&ns, sizeof(ns), 1, f) == 1)
+    {
+        RawBatch batch;
+        uint32_t bytes = 0;
+        if (fread(&batch.count, sizeof(batch.count), 1, f) != 1 || fread(&bytes, sizeof(bytes), 1, f) != 1)
+            break;
+        batch.time = TimePoint(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(ns)));
+        batch.data.resize(bytes);
+        if (bytes && fread(batch.data.data(), bytes, 1, f) != 1)
+            break;
+        batches.push_back(std::move(batch));
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,170 @@
+#include "replay.h"
+
+static void HashBytes(uint64_t &hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+void ReplayRecorder::OnFrame(TimePoint time, uint8_t state, bool white)
+{
+    int64_t ticks = TraceTicks(time);
+    HashBytes(m_result.hash, &ticks, sizeof(ticks));
+    HashBytes(m_result.hash, &state, sizeof(state));
+
+    if (!m_hasState || state != m_lastState)
+    {
+        ReplayTransition transition;
+        transition.frame = m_result.frames;
+        transition.time = time;
+        transition.state = state;
+        m_result.transitions.push_back(transition);
+        m_lastState = state;
+        m_hasState = true;
+    }
+
+    m_result.frames++;
+    if (white)
+        m_result.whiteFrames++;
+}
+
+void ReplayRecorder::CheckRecordedFrame(const TraceRecord &present, bool white)
+{
+    if ((present.flags != 0) != white)
+        m_result.mismatchedFrames++;
+}
+
+void LatencyReplay::Input(const InputEvent &ev, TimePoint handled)
+{
+    m_result.inputs++;
+    if (backend.Input(ev, handled) != InputAction::None)
+        m_result.stimuli++;
+}
+
+void LatencyReplay::Control(TraceControl control)
+{
+    LatencyTester &tester = backend.tester;
+    switch (control)
+    {
+    case TraceControl::ToggleMouseButtons:
+        tester.filter.enableMouseButtons = !tester.filter.enableMouseButtons;
+        break;
+    case TraceControl::ToggleKeyboard:
+        tester.filter.enableKeyboard = !tester.filter.enableKeyboard;
+        break;
+    case TraceControl::ToggleMouseDelta:
+        tester.filter.enableMouseDelta = !tester.filter.enableMouseDelta;
+        break;
+    case TraceControl::ToggleLog:
+        tester.ToggleLog();
+        break;
+    case TraceControl::FlashLonger:
+        tester.flash.IncreaseDuration();
+        break;
+    case TraceControl::FlashShorter:
+        tester.flash.DecreaseDuration();
+        break;
+    case TraceControl::ToggleUpEvents:
+        tester.filter.enableUpEvents = !tester.filter.enableUpEvents;
+        break;
+    default:
+        break;
+    }
+}
+
+bool LatencyReplay::Frame(TimePoint now, TimePoint clear)
+{
+    const HeadlessFrame &frame = backend.Render(now, clear);
+    bool white = frame.clearColor[0] > 0.0f;
+    OnFrame(now, backend.tester.flash.isFlashing ? 1 : 0, white);
+    return white;
+}
+
+void LatencyReplay::Apply(const TraceRecord &record)
+{
+    switch (record.type)
+    {
+    case TraceRecordType::Input:
+        Input(InputEventFromRecord(record));
+        break;
+    case TraceRecordType::Control:
+        if (ReadFlashPatternRecord(record, m_pattern))
+            backend.tester.flash.SetPattern(m_pattern);
+        else
+            Control((TraceControl)record.data);
+        break;
+    case TraceRecordType::Flash:
+        m_result.recordedStimuli++;
+        break;
+    case TraceRecordType::Present:
+        CheckRecordedFrame(record, Frame(TraceFrameTime(record)));
+        backend.Present(TraceTimePoint(record.ticks), TraceTimePoint(record.ticks + record.dx));
+        break;
+    default:
+        break;
+    }
+}
+
+ReactionEvent ReactionReplay::Input(const InputEvent &ev)
+{
+    m_result.inputs++;
+    return backend.Input(ev);
+}
+
+void ReactionReplay::Control(TraceControl control, TimePoint now)
+{
+    ReactionTester &tester = backend.tester;
+    switch (control)
+    {
+    case TraceControl::RoundStart:
+        tester.StartNewRound(now);
+        break;
+    case TraceControl::Reset:
+        tester.Reset(now);
+        break;
+    case TraceControl::ToggleAudio:
+        tester.ToggleAudioMode(now);
+        break;
+    default:
+        break;
+    }
+}
+
+bool ReactionReplay::Frame(TimePoint now)
+{
+    uint64_t onsetsBefore = backend.StimulusCount();
+    const HeadlessFrame &frame = backend.Render(now);
+    if (backend.StimulusCount() != onsetsBefore)
+        m_result.stimuli++;
+    bool white = frame.clearColor[0] == 1.0f;
+    OnFrame(now, (uint8_t)backend.tester.state, white);
+    return white;
+}
+
+void ReactionReplay::Apply(const TraceRecord &record)
+{
+    switch (record.type)
+    {
+    case TraceRecordType::Input:
+        Input(InputEventFromRecord(record));
+        break;
+    case TraceRecordType::Control:
+        Control((TraceControl)record.data, TraceTimePoint(record.ticks));
+        break;
+    case TraceRecordType::Flash:
+        if (record.flags == TRACE_FLASH_DAC)
+            backend.tester.SetStimulusTime(TraceTimePoint(record.ticks), record.dx / 1000.0f);
+        else
+            m_result.recordedStimuli++;
+        break;
+    case TraceRecordType::Present:
+        CheckRecordedFrame(record, Frame(TraceFrameTime(record)));
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,85 @@
+// Deterministic replay: drives the headless backends from recorded trace records or
+// synthetic input on a virtual clock and captures the frame-by-frame state sequence
+//
+// Each frame is folded into a hash, so two runs (or a run and a recording) can be
+// compared exactly without keeping every frame; state changes are kept in full
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "core/trace_file.h"
+#include "headless_backend.h"
+
+struct ReplayTransition
+{
+    uint64_t frame = 0;
+    TimePoint time;
+    uint8_t state = 0; // Latency: 1 while flashing; reaction: TestState
+};
+
+struct ReplayResult
+{
+    uint64_t frames = 0;
+    uint64_t whiteFrames = 0;
+    uint64_t inputs = 0;
+    uint64_t stimuli = 0;          // Flashes triggered / stimulus onsets
+    uint64_t recordedStimuli = 0;  // Flash records seen in the trace
+    uint64_t mismatchedFrames = 0; // Replayed colour differs from the recorded Present
+    uint64_t hash = 14695981039346656037ull; // FNV-1a over (frame time, state)
+    std::vector<ReplayTransition> transitions;
+};
+
+// Shared bookkeeping of the per-frame state sequence
+class ReplayRecorder
+{
+public:
+    const ReplayResult &Result() const { return m_result; }
+
+protected:
+    void OnFrame(TimePoint time, uint8_t state, bool white);
+    void CheckRecordedFrame(const TraceRecord &present, bool white);
+
+    ReplayResult m_result;
+    bool m_hasState = false;
+    uint8_t m_lastState = 0;
+};
+
+class LatencyReplay : public ReplayRecorder
+{
+public:
+    HeadlessLatencyBackend backend;
+
+    void Input(const InputEvent &ev) { Input(ev, DecodeTime(ev)); }
+    void Input(const InputEvent &ev, TimePoint handled);
+    void Control(TraceControl control);
+    bool Frame(TimePoint now) { return Frame(now, now); } // Returns true if the frame is white
+    bool Frame(TimePoint now, TimePoint clear);
+
+    // Input, Control and Present records, in file order. Stage attribution sees the
+    // recorded decode and Present times; trigger and clear fall on the decode and frame times.
+    // A recorded -pattern applies as the session's did.
+    void Apply(const TraceRecord &record);
+
+private:
+    FlashPattern m_pattern; // PatternStep records read so far
+};
+
+class ReactionReplay : public ReplayRecorder
+{
+public:
+    HeadlessReactionBackend backend;
+
+    explicit ReactionReplay(uint32_t seed) : backend(seed) {}
+
+    ReactionEvent Input(const InputEvent &ev);
+    void Control(TraceControl control, TimePoint now);
+    bool Frame(TimePoint now);
+
+    void Apply(const TraceRecord &record);
+};
+
+// Recorded frame start time of a Present record
+inline TimePoint TraceFrameTime(const TraceRecord &present)
+{
+    return TraceTimePoint(present.ticks - present.dy);
+}
@@ -5,29 +5,42 @@
 #define NOMINMAX
 #include <windows.h>
 #include <d3d11.h>
-#include <dxgi1_2.h>
+#include <dxgi1_3.h>
 #include <dwrite.h>
 #include <d2d1_1.h>
 #include <wrl/client.h>
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cmath>
 #include <hidusage.h>
+#include "core/frame_times.h"
+#include "core/latency_stages.h"
+#include "core/latency_tester.h"
+#include "core/overlay_text.h"
+#include "core/polling_rate.h"
+#include "core/thread_policy.h"
+#include "core/trace_file.h"
+#include "core/wait_strategy.h"
+#include "win32/command_line.h"
+#include "win32/input_thread.h"
+#include "win32/raw_input.h"
+#include "win32/wait_target.h"
+#include "win32/wasapi_capture.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d2d1.lib")
 #pragma comment(lib, "dwrite.lib")
+#pragma comment(lib, "ole32.lib")
 
 using Microsoft::WRL::ComPtr;
-using Clock = std::chrono::high_resolution_clock;
 
 // Forward declarations
 void ToggleFullscreen();
 
 // Configuration
 constexpr bool VSYNC_ENABLED = false;  // Disable for lowest latency
-constexpr size_t MAX_LOG_ENTRIES = 30; // Max log entries to display
 
 // Global state
 struct AppState
@@ -46,18 +59,52 @@ struct AppState
     ComPtr<IDWriteTextFormat> textFormatRight; // Right-aligned for FPS
     ComPtr<ID2D1SolidColorBrush> textBrush;
 
-    // Flash state
-    bool isFlashing = false;
-    Clock::time_point flashStartTime;
-    float flashDurationMs = 50.0f; // Adjustable with F5/F6
-
-    // Timing for log timestamps
-    Clock::time_point appStartTime = Clock::now();
-    double lastEventTimeMs = 0.0;
-
-    // Last input info for display
-    std::wstring lastInputText = L"Waiting for input...";
-    std::wstring lastDeviceText = L"";
+    // Flash state, input filter toggles and log (portable core)
+    LatencyTester tester;
+
+    // Raw input devices (names resolved once per device)
+    Win32DeviceEnumerator deviceEnumerator;
+    DeviceRegistry devices{deviceEnumerator};
+
+    // Decoded raw input: WM_INPUT -> ring by default, GetRawInputBuffer with -batchinput,
+    // received on a dedicated thread with -inputthread (either way)
+    RingInputSource messageInput;
+    BufferedRawInputSource bufferedInput{devices};
+    bool batchInput = false;
+    ThreadedInputSource threadedInput;
+    RawInputThread inputThread{threadedInput, devices};
+    bool useInputThread = false;
+    InputEvent inputBatch[InputSource::MAX_POLL_EVENTS];
+
+    // What the loop does between frames (-wait, F12 cycles); stats refreshed with the snapshot
+    WaitConfig waitConfig;
+    FrameWaiter waiter;
+    Win32WaitTarget waitTarget;
+    WaitStats waitStats;
+    UINT swapChainFlags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+
+    // CPU placement and priority of the render and input threads (-sched); whatever the OS
+    // refused stays on screen above the instructions
+    SchedulerConfig sched = DefaultSchedulerConfig();
+    SchedulerResult schedResult;
+    wchar_t schedText[512] = L"";
+    size_t schedLength = 0;
+
+    // Rebuilt only when a toggle changes
+    InstructionText instructions;
+
+    // Log rows are formatted on draw; names resolved through the registry
+    Win32LogNames logNames{devices};
+    size_t logPageRows = 1;
+
+    // Binary session trace (-trace=<path>)
+    TraceWriter trace;
+
+    // Microphone recording of the mouse switch clicks (-capture=<wav>)
+    WasapiCapture capture;
+    uint32_t flashCount = 0;
+    uint32_t frameIndex = 0;
+    size_t namedDevices = 0; // Registry ids whose names are in the trace
 
     // Frame timing
     Clock::time_point lastFrameTime = Clock::now();
@@ -66,23 +113,30 @@ struct AppState
     // Smoothing for display (optional, keeps numbers readable)
     float smoothedFrameTimeMs = 0.0f;
     float smoothedFps = 0.0f;
-
-    // Input toggles (F1-F4, F7-F8)
-    bool enableMouseButtons = true; // F1 toggles
-    bool enableKeyboard = true;     // F2 toggles
-    bool enableMouseDelta = true;   // F3 toggles
-    bool enableLog = false;         // F4 toggles
-    bool enableUpEvents = true;     // F7 toggles (when OFF, only DOWN events register)
+    // Every loop iteration (both paths); percentiles refreshed with the mouse Hz stats
+    FrameTimeRing frameTimes;
+    FrameTimeStats frameTimeStats;
+    static constexpr size_t FRAME_BINS = 48;
+    uint32_t frameBins[FRAME_BINS] = {};
+    uint32_t frameBinsMax = 0;
+    std::string frameTimesPath; // -frametimes=<path>: CSV written on exit
+
+    // Input-to-present attribution; the clock is only read on frames with a pending input
+    LatencyAttribution stages;
+    wchar_t stageText[512] = L"";
+    size_t stageLength = 0;
+    std::string stagesPath; // -stages=<path>: per-stage histograms as CSV on exit
+
+    // Display toggles (F1-F4 and F7 live in tester)
     bool enableMouseHz = false;     // F8 toggles mouse polling rate display
     bool enableOverlay = true;      // F9 toggles text overlay (disable for minimal latency)
     bool isFullscreen = true;       // F10 toggles FSE/Windowed
+    StatsView statsView = StatsView::Smoothed; // F11 cycles smoothed FPS / frame times / stages
 
-    // Mouse Hz tracking
-    std::vector<Clock::time_point> mouseDeltaTimes;
-    float mouseHz = 0.0f;
-
-    // Log history (newest first)
-    std::vector<std::wstring> logEntries;
+    // Mouse Hz tracking (fixed memory, O(1) per report)
+    PollingRateAnalyzer mouseRate;
+    PollingRateStats mouseRateStats;
+    TimePoint lastStatsSnapshot;
 
     // Window
     HWND hwnd = nullptr;
@@ -91,173 +145,84 @@ struct AppState
     bool running = true;
 } g_app;
 
-void TriggerFlash(const std::wstring &inputInfo, const std::wstring &deviceInfo)
+void ProcessRawInput(LPARAM lParam)
 {
-    auto now = Clock::now();
-    g_app.isFlashing = true;
-    g_app.flashStartTime = now;
-    g_app.lastInputText = inputInfo;
-    g_app.lastDeviceText = deviceInfo;
-
-    // Add to log (newest first) with timestamp and delta
-    if (g_app.enableLog)
-    {
-        double currentTimeMs = std::chrono::duration<double, std::milli>(now - g_app.appStartTime).count();
-        double deltaMs = currentTimeMs - g_app.lastEventTimeMs;
-
-        // Format: "123.45ms +12.34Δ | InputInfo | Device"
-        wchar_t timeStr[64];
-        swprintf_s(timeStr, L"%.2fms %+.2f\u0394", currentTimeMs, deltaMs);
+    // Timestamp on arrival, handle after the message pump
+    InputEvent ev;
+    if (!ReadRawInput(lParam, Clock::now(), g_app.devices, ev))
+        return; // HID device, ignore for now
 
-        std::wstring logEntry = std::wstring(timeStr) + L" | " + inputInfo + L" | " + deviceInfo;
-        g_app.logEntries.insert(g_app.logEntries.begin(), logEntry);
-        if (g_app.logEntries.size() > MAX_LOG_ENTRIES)
-        {
-            g_app.logEntries.pop_back();
-        }
+    g_app.messageInput.Push(ev);
+}
 
-        g_app.lastEventTimeMs = currentTimeMs;
+// Names every device registered since the last call, so its inputs in the trace can be
+// tied to a physical device (ids are handed out in order and never reused)
+void TraceDeviceNames(TimePoint now)
+{
+    size_t count = g_app.devices.Count();
+    for (; g_app.namedDevices < count; ++g_app.namedDevices)
+    {
+        uint16_t id = (uint16_t)(g_app.namedDevices + 1);
+        TraceRecord records[TRACE_NAME_RECORDS];
+        size_t written = MakeDeviceNameRecords(now, id, g_app.devices.DisplayName(id), records);
+        for (size_t i = 0; i < written; ++i)
+            g_app.trace.Append(records[i]);
     }
 }
 
-void ProcessRawInput(LPARAM lParam)
+void HandleInputEvent(const InputEvent &ev)
 {
-    UINT size = 0;
-    GetRawInputData((HRAWINPUT)lParam, RID_INPUT, nullptr, &size, sizeof(RAWINPUTHEADER));
+    uint32_t inputId = g_app.stages.OnInput();
+    if (g_app.trace.IsOpen())
+    {
+        TraceDeviceNames(ev.time); // Devices the input thread registered
+        g_app.trace.Append(MakeInputRecord(ev));
+    }
 
-    if (size == 0)
-        return;
+    // Track mouse Hz if enabled (track all delta events regardless of filter)
+    if (IsMouseDelta(ev) && g_app.enableMouseHz)
+    {
+        g_app.mouseRate.Record(ev.time);
+    }
 
-    std::vector<BYTE> buffer(size);
-    if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, buffer.data(), &size, sizeof(RAWINPUTHEADER)) != size)
+    if (ClassifyInput(ev, g_app.tester.filter) == InputAction::None)
         return;
 
-    RAWINPUT *raw = (RAWINPUT *)buffer.data();
-
-    // Get device name
-    UINT deviceNameSize = 0;
-    GetRawInputDeviceInfoW(raw->header.hDevice, RIDI_DEVICENAME, nullptr, &deviceNameSize);
-    std::wstring deviceName(deviceNameSize, L'\0');
-    GetRawInputDeviceInfoW(raw->header.hDevice, RIDI_DEVICENAME, &deviceName[0], &deviceNameSize);
-
-    // Extract just the device part for cleaner display
-    size_t lastSlash = deviceName.rfind(L'#');
-    if (lastSlash != std::wstring::npos && lastSlash > 0)
+    // Get key name
+    wchar_t keyName[64] = {};
+    if (ev.type == InputType::Keyboard)
     {
-        size_t prevSlash = deviceName.rfind(L'#', lastSlash - 1);
-        if (prevSlash != std::wstring::npos)
-        {
-            deviceName = deviceName.substr(prevSlash + 1, lastSlash - prevSlash - 1);
-        }
+        GetRawKeyName(ev, keyName, 64);
     }
 
-    std::wstring inputInfo;
-    std::wstring deviceType;
-
-    if (raw->header.dwType == RIM_TYPEMOUSE)
+    if (g_app.tester.OnInput(ev, g_app.devices.DisplayName(ev.deviceId), keyName) != InputAction::None)
     {
-        deviceType = L"MOUSE";
-        RAWMOUSE &mouse = raw->data.mouse;
-
-        bool isButtonEvent = (mouse.usButtonFlags != 0);
-        bool isDeltaEvent = (mouse.lLastX != 0 || mouse.lLastY != 0);
-
-        // Track mouse Hz if enabled (track all delta events regardless of filter)
-        if (isDeltaEvent && g_app.enableMouseHz)
-        {
-            g_app.mouseDeltaTimes.push_back(Clock::now());
-        }
-
-        // Filter based on toggles
-        if (isButtonEvent && !g_app.enableMouseButtons)
-            return;
-        if (isDeltaEvent && !isButtonEvent && !g_app.enableMouseDelta)
-            return;
-
-        // Check what triggered this input
-        if (mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_DOWN)
-            inputInfo = L"Left Click DOWN";
-        else if (mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_UP)
-        {
-            if (!g_app.enableUpEvents)
-                return;
-            inputInfo = L"Left Click UP";
-        }
-        else if (mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_DOWN)
-            inputInfo = L"Right Click DOWN";
-        else if (mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_UP)
-        {
-            if (!g_app.enableUpEvents)
-                return;
-            inputInfo = L"Right Click UP";
-        }
-        else if (mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_DOWN)
-            inputInfo = L"Middle Click DOWN";
-        else if (mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_UP)
-        {
-            if (!g_app.enableUpEvents)
-                return;
-            inputInfo = L"Middle Click UP";
-        }
-        else if (mouse.usButtonFlags & RI_MOUSE_BUTTON_4_DOWN)
-            inputInfo = L"Button 4 DOWN";
-        else if (mouse.usButtonFlags & RI_MOUSE_BUTTON_4_UP)
-        {
-            if (!g_app.enableUpEvents)
-                return;
-            inputInfo = L"Button 4 UP";
-        }
-        else if (mouse.usButtonFlags & RI_MOUSE_BUTTON_5_DOWN)
-            inputInfo = L"Button 5 DOWN";
-        else if (mouse.usButtonFlags & RI_MOUSE_BUTTON_5_UP)
-        {
-            if (!g_app.enableUpEvents)
-                return;
-            inputInfo = L"Button 5 UP";
-        }
-        else if (mouse.usButtonFlags & RI_MOUSE_WHEEL)
-            inputInfo = L"Wheel: " + std::to_wstring((SHORT)mouse.usButtonData);
-        else if (isDeltaEvent)
-            inputInfo = L"Move: dX=" + std::to_wstring(mouse.lLastX) + L" dY=" + std::to_wstring(mouse.lLastY);
-        else
-            return; // No meaningful input
+        g_app.stages.OnTrigger(inputId, ev, Clock::now());
+        if (g_app.trace.IsOpen())
+            g_app.trace.Append(MakeFlashRecord(ev.time, true, ++g_app.flashCount));
     }
-    else if (raw->header.dwType == RIM_TYPEKEYBOARD)
-    {
-        // Filter keyboard if disabled
-        if (!g_app.enableKeyboard)
-            return;
-
-        deviceType = L"KEYBOARD";
-        RAWKEYBOARD &kb = raw->data.keyboard;
-
-        bool isDown = !(kb.Flags & RI_KEY_BREAK);
-
-        // Filter UP events if disabled
-        if (!isDown && !g_app.enableUpEvents)
-            return;
-
-        UINT vk = kb.VKey;
-        UINT sc = kb.MakeCode;
-
-        // Get key name
-        UINT scanCode = sc;
-        if (kb.Flags & RI_KEY_E0)
-            scanCode |= 0x100;
-
-        wchar_t keyName[64] = {};
-        GetKeyNameTextW(scanCode << 16, keyName, 64);
+}
 
-        inputInfo = std::wstring(keyName) + L" (VK=" + std::to_wstring(vk) +
-                    L" SC=" + std::to_wstring(sc) + L") " + (isDown ? L"DOWN" : L"UP");
-    }
-    else
+void ProcessInputEvents()
+{
+    InputSource &source = g_app.useInputThread ? (InputSource &)g_app.threadedInput
+                          : g_app.batchInput   ? (InputSource &)g_app.bufferedInput
+                                               : (InputSource &)g_app.messageInput;
+    size_t count = source.Poll(g_app.inputBatch, InputSource::MAX_POLL_EVENTS);
+    // Only the input thread stamps arrivals before the loop wakes, so only it measures arrival -> handled
+    if (count > 0 && g_app.useInputThread)
+        g_app.waiter.OnInput(g_app.inputBatch[0].time);
+    for (size_t i = 0; i < count; ++i)
     {
-        return; // HID device, ignore for now
+        HandleInputEvent(g_app.inputBatch[i]);
     }
+}
 
-    std::wstring deviceInfo = deviceType + L": " + deviceName;
-    TriggerFlash(inputInfo, deviceInfo);
+// Keyboard commands go into the trace so a replay sees the same tester state
+void TraceControlEvent(TimePoint now, TraceControl control)
+{
+    if (g_app.trace.IsOpen())
+        g_app.trace.Append(MakeControlRecord(now, control));
 }
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -268,6 +233,20 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         ProcessRawInput(lParam);
         return 0;
 
+    case WM_INPUT_DEVICE_CHANGE:
+        // Keep the device registry current so WM_INPUT never resolves names
+        if (wParam == GIDC_ARRIVAL)
+        {
+            g_app.devices.OnArrival(DeviceHandleKey((HANDLE)lParam));
+            if (g_app.trace.IsOpen())
+                TraceDeviceNames(Clock::now());
+        }
+        else if (wParam == GIDC_REMOVAL)
+        {
+            g_app.devices.OnRemoval(DeviceHandleKey((HANDLE)lParam));
+        }
+        return 0;
+
     case WM_KEYDOWN:
         if (wParam == VK_ESCAPE)
         {
@@ -275,49 +254,77 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         }
         else if (wParam == VK_F1)
         {
-            g_app.enableMouseButtons = !g_app.enableMouseButtons;
+            g_app.tester.filter.enableMouseButtons = !g_app.tester.filter.enableMouseButtons;
+            TraceControlEvent(Clock::now(), TraceControl::ToggleMouseButtons);
         }
         else if (wParam == VK_F2)
         {
-            g_app.enableKeyboard = !g_app.enableKeyboard;
+            g_app.tester.filter.enableKeyboard = !g_app.tester.filter.enableKeyboard;
+            TraceControlEvent(Clock::now(), TraceControl::ToggleKeyboard);
         }
         else if (wParam == VK_F3)
         {
-            g_app.enableMouseDelta = !g_app.enableMouseDelta;
+            g_app.tester.filter.enableMouseDelta = !g_app.tester.filter.enableMouseDelta;
+            TraceControlEvent(Clock::now(), TraceControl::ToggleMouseDelta);
         }
         else if (wParam == VK_F4)
         {
-            g_app.enableLog = !g_app.enableLog;
-            if (!g_app.enableLog)
-            {
-                g_app.logEntries.clear(); // Clear log when disabled
-            }
+            g_app.tester.ToggleLog();
+            TraceControlEvent(Clock::now(), TraceControl::ToggleLog);
         }
         else if (wParam == VK_F5)
         {
-            g_app.flashDurationMs += 10.0f;
+            g_app.tester.flash.IncreaseDuration();
+            TraceControlEvent(Clock::now(), TraceControl::FlashLonger);
         }
         else if (wParam == VK_F6)
         {
-            g_app.flashDurationMs = (g_app.flashDurationMs > 10.0f) ? g_app.flashDurationMs - 10.0f : 10.0f;
+            g_app.tester.flash.DecreaseDuration();
+            TraceControlEvent(Clock::now(), TraceControl::FlashShorter);
         }
         else if (wParam == VK_F7)
         {
-            g_app.enableUpEvents = !g_app.enableUpEvents;
+            g_app.tester.filter.enableUpEvents = !g_app.tester.filter.enableUpEvents;
+            TraceControlEvent(Clock::now(), TraceControl::ToggleUpEvents);
         }
         else if (wParam == VK_F8)
         {
             g_app.enableMouseHz = !g_app.enableMouseHz;
             if (!g_app.enableMouseHz)
             {
-                g_app.mouseDeltaTimes.clear();
-                g_app.mouseHz = 0.0f;
+                g_app.mouseRate.Reset();
+                g_app.mouseRateStats = PollingRateStats();
             }
         }
         else if (wParam == VK_F9)
         {
             g_app.enableOverlay = !g_app.enableOverlay;
         }
+        else if (wParam == VK_F11)
+        {
+            g_app.statsView = (StatsView)(((int)g_app.statsView + 1) % 3);
+        }
+        else if (wParam == VK_F12)
+        {
+            // Waitable needs the swap chain to be created for it (-wait=waitable)
+            size_t count = g_app.waitTarget.HasFrameLatencyObject() ? WAIT_STRATEGY_COUNT : WAIT_STRATEGY_COUNT - 1;
+            g_app.waitConfig.strategy = (WaitStrategy)(((size_t)g_app.waitConfig.strategy + 1) % count);
+            g_app.waiter.Configure(g_app.waitConfig, Clock::now());
+        }
+        else if (wParam == VK_PRIOR || wParam == VK_NEXT)
+        {
+            // Scroll the log a page at a time (PgUp = older)
+            int64_t page = (int64_t)g_app.logPageRows;
+            g_app.tester.log.ScrollBy(wParam == VK_PRIOR ? page : -page);
+        }
+        else if (wParam == VK_HOME)
+        {
+            g_app.tester.log.ScrollBy((int64_t)g_app.tester.log.Count());
+        }
+        else if (wParam == VK_END)
+        {
+            g_app.tester.log.ScrollToNewest();
+        }
         return 0;
 
     case WM_SYSKEYDOWN:
@@ -329,6 +336,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         }
         break;
 
+    case WM_ACTIVATEAPP:
+        g_app.waiter.SetFocused(wParam != FALSE);
+        break;
+
     case WM_DESTROY:
         g_app.running = false;
         PostQuitMessage(0);
@@ -367,19 +378,27 @@ bool InitWindow()
     if (!g_app.hwnd)
         return false;
 
+    // The input thread registers its own message-only window instead
+    if (g_app.useInputThread)
+    {
+        ShowWindow(g_app.hwnd, SW_SHOW);
+        UpdateWindow(g_app.hwnd);
+        return g_app.inputThread.Start(g_app.batchInput, g_app.sched[ThreadRole::Input]);
+    }
+
     // Register for raw input
     RAWINPUTDEVICE rid[2] = {};
 
     // Mouse - no RIDEV_INPUTSINK to avoid background coalescing
     rid[0].usUsagePage = HID_USAGE_PAGE_GENERIC;
     rid[0].usUsage = HID_USAGE_GENERIC_MOUSE;
-    rid[0].dwFlags = 0; // Foreground only, no coalescing
+    rid[0].dwFlags = RIDEV_DEVNOTIFY; // Foreground only, no coalescing; arrival/removal notifications
     rid[0].hwndTarget = g_app.hwnd;
 
     // Keyboard - no RIDEV_INPUTSINK to avoid background coalescing
     rid[1].usUsagePage = HID_USAGE_PAGE_GENERIC;
     rid[1].usUsage = HID_USAGE_GENERIC_KEYBOARD;
-    rid[1].dwFlags = 0; // Foreground only, no coalescing
+    rid[1].dwFlags = RIDEV_DEVNOTIFY; // Foreground only, no coalescing; arrival/removal notifications
     rid[1].hwndTarget = g_app.hwnd;
 
     if (!RegisterRawInputDevices(rid, 2, sizeof(RAWINPUTDEVICE)))
@@ -441,7 +460,9 @@ bool InitD3D11()
     scDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     scDesc.BufferCount = 2;
     scDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    scDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+    if (g_app.waitConfig.strategy == WaitStrategy::Waitable)
+        g_app.swapChainFlags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+    scDesc.Flags = g_app.swapChainFlags;
 
     // Fullscreen exclusive for lowest latency
     DXGI_SWAP_CHAIN_FULLSCREEN_DESC fsDesc = {};
@@ -460,6 +481,19 @@ bool InitD3D11()
     if (FAILED(hr))
         return false;
 
+    // Waitable swap chains take the frame latency limit from the swap chain, not the device
+    ComPtr<IDXGISwapChain2> swapChain2;
+    if ((g_app.swapChainFlags & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT) &&
+        SUCCEEDED(g_app.swapChain.As(&swapChain2)))
+    {
+        swapChain2->SetMaximumFrameLatency(1);
+        g_app.waitTarget.SetFrameLatencyObject(swapChain2->GetFrameLatencyWaitableObject());
+    }
+    else if (g_app.waitConfig.strategy == WaitStrategy::Waitable)
+    {
+        g_app.waitConfig.strategy = WaitStrategy::Hybrid; // No DXGI 1.3: nearest strategy that still sleeps
+    }
+
     // Disable Alt+Enter handling by DXGI (we handle fullscreen ourselves)
     factory->MakeWindowAssociation(g_app.hwnd, DXGI_MWA_NO_ALT_ENTER);
 
@@ -597,7 +631,7 @@ void ToggleFullscreen()
     }
 
     // Resize swap chain buffers
-    hr = g_app.swapChain->ResizeBuffers(0, g_app.width, g_app.height, DXGI_FORMAT_UNKNOWN, DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH);
+    hr = g_app.swapChain->ResizeBuffers(0, g_app.width, g_app.height, DXGI_FORMAT_UNKNOWN, g_app.swapChainFlags);
 
     // Recreate render target view
     ComPtr<ID3D11Texture2D> backBuffer;
@@ -616,40 +650,49 @@ void ToggleFullscreen()
     g_app.d2dRT->CreateSolidColorBrush(D2D1::ColorF(0.0f, 1.0f, 0.0f, 1.0f), &g_app.textBrush);
 }
 
+// Presents and stamps the trace and the latency attribution (reads the clock only if either needs it)
+void PresentFrame(TimePoint frameTime, bool white, UINT syncInterval, UINT flags)
+{
+    g_app.waiter.BeforePresent(g_app.waitTarget);
+    bool stamp = g_app.trace.IsOpen() || g_app.stages.Pending();
+    TimePoint callTime = stamp ? Clock::now() : TimePoint();
+    HRESULT hr = g_app.swapChain->Present(syncInterval, flags);
+    if (!stamp)
+        return;
+
+    TimePoint returnTime = Clock::now();
+    if (g_app.stages.Pending())
+        g_app.stages.OnPresent(callTime, returnTime, hr != DXGI_ERROR_WAS_STILL_DRAWING);
+    if (g_app.trace.IsOpen())
+        g_app.trace.Append(MakePresentRecord(frameTime, callTime, returnTime, white, g_app.frameIndex++));
+}
+
 void Render()
 {
     // MINIMAL PATH: When overlay is disabled, skip ALL unnecessary computation for lowest latency
     if (!g_app.enableOverlay)
     {
         // Only check flash state - minimal work
-        if (g_app.isFlashing)
-        {
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                               Clock::now() - g_app.flashStartTime)
-                               .count();
-            if (elapsed >= g_app.flashDurationMs)
-            {
-                g_app.isFlashing = false;
-            }
-        }
+        TimePoint frameTime = Clock::now();
+        g_app.frameTimes.Record(frameTime);
+        g_app.tester.UpdateFrame(frameTime);
 
         // Direct clear and present - no D2D, no frame timing overhead
-        float clearColor[4] = {0.0f, 0.0f, 0.0f, 1.0f};
-        if (g_app.isFlashing)
-        {
-            clearColor[0] = clearColor[1] = clearColor[2] = 1.0f;
-        }
+        float clearColor[4];
+        g_app.tester.GetClearColor(clearColor);
         g_app.context->ClearRenderTargetView(g_app.rtv.Get(), clearColor);
+        if (g_app.stages.Pending())
+            g_app.stages.OnClear(Clock::now());
 
         // Use DO_NOT_WAIT to avoid blocking - spin instead for lower latency
-        HRESULT hr = g_app.swapChain->Present(0, DXGI_PRESENT_DO_NOT_WAIT);
         // If queue is full (WAS_STILL_DRAWING), that's fine - we'll try again next iteration
-        (void)hr;
+        PresentFrame(frameTime, clearColor[0] > 0.0f, 0, DXGI_PRESENT_DO_NOT_WAIT);
         return;
     }
 
     // FULL PATH: With overlay enabled, do all the work
     auto now = Clock::now();
+    g_app.frameTimes.Record(now);
     g_app.frameTimeMs = std::chrono::duration<float, std::milli>(now - g_app.lastFrameTime).count();
     g_app.lastFrameTime = now;
     g_app.fps = (g_app.frameTimeMs > 0.0f) ? 1000.0f / g_app.frameTimeMs : 0.0f;
@@ -659,45 +702,38 @@ void Render()
     g_app.smoothedFrameTimeMs = g_app.smoothedFrameTimeMs * smoothing + g_app.frameTimeMs * (1.0f - smoothing);
     g_app.smoothedFps = g_app.smoothedFps * smoothing + g_app.fps * (1.0f - smoothing);
 
-    // Calculate mouse Hz (events in last 1 second)
-    if (g_app.enableMouseHz)
+    // Refresh mouse Hz stats (events in last 1 second, interval percentiles) and frame time
+    // percentiles 10 times a second
+    if ((g_app.enableMouseHz || g_app.statsView != StatsView::Smoothed) &&
+        now - g_app.lastStatsSnapshot >= std::chrono::milliseconds(100))
     {
-        auto oneSecondAgo = now - std::chrono::seconds(1);
-        // Remove events older than 1 second
-        while (!g_app.mouseDeltaTimes.empty() && g_app.mouseDeltaTimes.front() < oneSecondAgo)
+        if (g_app.enableMouseHz)
+            g_app.mouseRateStats = g_app.mouseRate.Snapshot(now);
+        g_app.waiter.Sample(now);
+        g_app.waitStats = g_app.waiter.Stats(g_app.waitConfig.strategy);
+        if (g_app.statsView == StatsView::Stages)
+            g_app.stageLength = FormatStageStats(g_app.stages, g_app.stageText, 512);
+        if (g_app.statsView == StatsView::FrameTimes)
         {
-            g_app.mouseDeltaTimes.erase(g_app.mouseDeltaTimes.begin());
+            // Histogram spans twice the p99 frame time; anything longer piles into the last bar
+            g_app.frameTimeStats = g_app.frameTimes.Snapshot();
+            int64_t highNs = (int64_t)(g_app.frameTimeStats.p99Ms * 2e6);
+            g_app.frameBinsMax = g_app.frameTimes.Bins(highNs, g_app.frameBins, AppState::FRAME_BINS);
         }
-        g_app.mouseHz = static_cast<float>(g_app.mouseDeltaTimes.size());
+        g_app.lastStatsSnapshot = now;
     }
 
     // Check if flash should end
-    if (g_app.isFlashing)
-    {
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                           Clock::now() - g_app.flashStartTime)
-                           .count();
-
-        if (elapsed >= g_app.flashDurationMs)
-        {
-            g_app.isFlashing = false;
-        }
-    }
+    TimePoint frameTime = Clock::now();
+    g_app.tester.UpdateFrame(frameTime);
 
     // Clear to white if flashing, black otherwise
     float clearColor[4];
-    if (g_app.isFlashing)
-    {
-        clearColor[0] = clearColor[1] = clearColor[2] = 1.0f;
-        clearColor[3] = 1.0f;
-    }
-    else
-    {
-        clearColor[0] = clearColor[1] = clearColor[2] = 0.0f;
-        clearColor[3] = 1.0f;
-    }
+    g_app.tester.GetClearColor(clearColor);
 
     g_app.context->ClearRenderTargetView(g_app.rtv.Get(), clearColor);
+    if (g_app.stages.Pending())
+        g_app.stages.OnClear(Clock::now());
 
     // Draw text overlay with D2D (skip if overlay disabled for minimal latency)
     if (g_app.enableOverlay)
@@ -707,8 +743,8 @@ void Render()
         // Draw input info in top-left corner
         D2D1_RECT_F textRect = D2D1::RectF(20.0f, 20.0f, (float)g_app.width - 20.0f, 100.0f);
         g_app.d2dRT->DrawText(
-            g_app.lastInputText.c_str(),
-            (UINT32)g_app.lastInputText.length(),
+            g_app.tester.lastInputText,
+            (UINT32)g_app.tester.lastInputLength,
             g_app.textFormat.Get(),
             textRect,
             g_app.textBrush.Get());
@@ -717,62 +753,118 @@ void Render()
         textRect.top = 50.0f;
         textRect.bottom = 130.0f;
         g_app.d2dRT->DrawText(
-            g_app.lastDeviceText.c_str(),
-            (UINT32)g_app.lastDeviceText.length(),
+            g_app.tester.lastDeviceText,
+            (UINT32)g_app.tester.lastDeviceLength,
             g_app.textFormat.Get(),
             textRect,
             g_app.textBrush.Get());
 
         // Draw FPS counter in top-right corner (and mouse Hz if enabled)
-        wchar_t fpsBuffer[128];
-        if (g_app.enableMouseHz)
-        {
-            swprintf_s(fpsBuffer, L"%.1f FPS\n%.2f ms\n%.0f Hz", g_app.smoothedFps, g_app.smoothedFrameTimeMs, g_app.mouseHz);
-        }
-        else
-        {
-            swprintf_s(fpsBuffer, L"%.1f FPS\n%.2f ms", g_app.smoothedFps, g_app.smoothedFrameTimeMs);
-        }
-        D2D1_RECT_F fpsRect = D2D1::RectF((float)g_app.width - 200.0f, 20.0f, (float)g_app.width - 20.0f, 110.0f);
+        bool showFrameTimes = g_app.statsView == StatsView::FrameTimes;
+        wchar_t fpsBuffer[256];
+        size_t fpsLength = FormatFrameStats(g_app.smoothedFps, g_app.smoothedFrameTimeMs,
+                                            showFrameTimes ? &g_app.frameTimeStats : nullptr,
+                                            showFrameTimes ? &g_app.waitStats : nullptr,
+                                            g_app.enableMouseHz ? &g_app.mouseRateStats : nullptr, fpsBuffer, 256);
+        float fpsWidth = g_app.enableMouseHz ? 420.0f : (showFrameTimes ? 300.0f : 200.0f);
+        float fpsHeight = (showFrameTimes ? 175.0f : 90.0f) + (g_app.enableMouseHz ? 90.0f : 0.0f);
+        D2D1_RECT_F fpsRect = D2D1::RectF((float)g_app.width - fpsWidth, 20.0f, (float)g_app.width - 20.0f, 20.0f + fpsHeight);
         g_app.d2dRT->DrawText(
             fpsBuffer,
-            (UINT32)wcslen(fpsBuffer),
+            (UINT32)fpsLength,
             g_app.textFormatRight.Get(),
             fpsRect,
             g_app.textBrush.Get());
 
+        // Frame time histogram under the stats; bar heights are log-scaled so rare stalls show
+        if (showFrameTimes && g_app.frameBinsMax > 0)
+        {
+            const float barWidth = 5.0f;
+            const float graphHeight = 80.0f;
+            float right = (float)g_app.width - 20.0f;
+            float left = right - barWidth * AppState::FRAME_BINS;
+            float bottom = fpsRect.bottom + 10.0f + graphHeight;
+            float scale = graphHeight / log2f(1.0f + (float)g_app.frameBinsMax);
+            for (size_t i = 0; i < AppState::FRAME_BINS; ++i)
+            {
+                if (g_app.frameBins[i] == 0)
+                    continue;
+                float height = log2f(1.0f + (float)g_app.frameBins[i]) * scale;
+                float x = left + barWidth * i;
+                g_app.d2dRT->FillRectangle(D2D1::RectF(x, bottom - height, x + barWidth - 1.0f, bottom),
+                                           g_app.textBrush.Get());
+            }
+        }
+
+        // Stage attribution under the stats (text refreshed with the snapshot)
+        if (g_app.statsView == StatsView::Stages)
+        {
+            D2D1_RECT_F stageRect = D2D1::RectF((float)g_app.width - 520.0f, fpsRect.bottom + 10.0f,
+                                                (float)g_app.width - 20.0f, fpsRect.bottom + 250.0f);
+            g_app.d2dRT->DrawText(
+                g_app.stageText,
+                (UINT32)g_app.stageLength,
+                g_app.textFormatRight.Get(),
+                stageRect,
+                g_app.textBrush.Get());
+        }
+
         // Draw log if enabled (left side, below device info)
-        if (g_app.enableLog && !g_app.logEntries.empty())
+        EventLog &log = g_app.tester.log;
+        if (g_app.tester.enableLog && log.Count() > 0)
         {
             float logY = 100.0f;
-            for (size_t i = 0; i < g_app.logEntries.size() && logY < g_app.height - 80.0f; ++i)
+            size_t rows = 0;
+            if (log.Scroll() > 0)
+            {
+                // Scrolled back: show where we are in the session
+                wchar_t position[96];
+                int len = swprintf_s(position, L"-- %zu newer of %zu (PgUp/PgDn, Home/End) --", log.Scroll(),
+                                     log.Count());
+                D2D1_RECT_F posRect = D2D1::RectF(20.0f, logY, (float)g_app.width / 2.0f, logY + 24.0f);
+                g_app.d2dRT->DrawText(position, (UINT32)(len > 0 ? len : 0), g_app.textFormat.Get(), posRect,
+                                      g_app.textBrush.Get());
+                logY += 26.0f;
+            }
+            for (size_t i = 0; i < log.RowCount() && logY < g_app.height - 80.0f; ++i)
             {
+                size_t length = 0;
+                const wchar_t *row = log.Row(i, g_app.logNames, &length);
                 D2D1_RECT_F logRect = D2D1::RectF(20.0f, logY, (float)g_app.width / 2.0f, logY + 24.0f);
                 g_app.d2dRT->DrawText(
-                    g_app.logEntries[i].c_str(),
-                    (UINT32)g_app.logEntries[i].length(),
+                    row,
+                    (UINT32)length,
                     g_app.textFormat.Get(),
                     logRect,
                     g_app.textBrush.Get());
                 logY += 26.0f;
+                rows++;
             }
+            g_app.logPageRows = rows > 1 ? rows : 1;
+        }
+
+        // Refused -sched requests, one line per thread, above the instructions
+        if (g_app.schedLength > 0)
+        {
+            D2D1_RECT_F schedRect = D2D1::RectF(20.0f, (float)g_app.height - 160.0f, (float)g_app.width - 20.0f,
+                                                (float)g_app.height - 50.0f);
+            g_app.d2dRT->DrawText(g_app.schedText, (UINT32)g_app.schedLength, g_app.textFormat.Get(), schedRect,
+                                  g_app.textBrush.Get());
         }
 
         // Draw instructions at bottom with toggle states
-        std::wstring instructions = L"ESC | F1=Mouse[" + std::wstring(g_app.enableMouseButtons ? L"+" : L"-") +
-                                    L"] F2=KB[" + std::wstring(g_app.enableKeyboard ? L"+" : L"-") +
-                                    L"] F3=Dlt[" + std::wstring(g_app.enableMouseDelta ? L"+" : L"-") +
-                                    L"] F4=Log[" + std::wstring(g_app.enableLog ? L"+" : L"-") +
-                                    L"] F7=Up[" + std::wstring(g_app.enableUpEvents ? L"+" : L"-") +
-                                    L"] F8=Hz[" + std::wstring(g_app.enableMouseHz ? L"+" : L"-") +
-                                    L"] F9=OL[" + std::wstring(g_app.enableOverlay ? L"+" : L"-") +
-                                    L"] F10=[" + std::wstring(g_app.isFullscreen ? L"FSE" : L"WIN") +
-                                    L"] F5/6=" + std::to_wstring((int)g_app.flashDurationMs) + L"ms";
+        OverlayToggles toggles;
+        toggles.mouseHz = g_app.enableMouseHz;
+        toggles.overlay = g_app.enableOverlay;
+        toggles.fullscreen = g_app.isFullscreen;
+        toggles.statsView = g_app.statsView;
+        toggles.wait = g_app.waitConfig.strategy;
+        const wchar_t *instructions = g_app.instructions.Update(g_app.tester, toggles);
         textRect.top = (float)g_app.height - 50.0f;
         textRect.bottom = (float)g_app.height - 10.0f;
         g_app.d2dRT->DrawText(
-            instructions.c_str(),
-            (UINT32)instructions.length(),
+            instructions,
+            (UINT32)g_app.instructions.Length(),
             g_app.textFormat.Get(),
             textRect,
             g_app.textBrush.Get());
@@ -781,22 +873,103 @@ void Render()
     }
 
     // Present - use DO_NOT_WAIT to avoid blocking for lower latency
-    g_app.swapChain->Present(VSYNC_ENABLED ? 1 : 0, VSYNC_ENABLED ? 0 : DXGI_PRESENT_DO_NOT_WAIT);
+    PresentFrame(frameTime, clearColor[0] > 0.0f, VSYNC_ENABLED ? 1 : 0, VSYNC_ENABLED ? 0 : DXGI_PRESENT_DO_NOT_WAIT);
 }
 
 void Cleanup()
 {
+    // Join the input thread before anything it publishes into goes away
+    g_app.threadedInput.Stop();
+
     // Exit fullscreen before releasing swap chain
     if (g_app.swapChain)
     {
         g_app.swapChain->SetFullscreenState(FALSE, nullptr);
     }
 
+    // Flush the trace (truncates to the written size) and finish the click recording
+    g_app.trace.Close();
+    g_app.capture.Stop();
+
+    if (!g_app.frameTimesPath.empty())
+        g_app.frameTimes.Export(g_app.frameTimesPath.c_str());
+    if (!g_app.stagesPath.empty())
+        g_app.stages.Export(g_app.stagesPath.c_str());
+
     // ComPtr handles release automatically
 }
 
-int WINAPI wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
+int WINAPI wWinMain(HINSTANCE, HINSTANCE, LPWSTR cmdLine, int)
 {
+    // -batchinput: drain raw input with GetRawInputBuffer once per loop (4-8 kHz mice)
+    g_app.batchInput = HasCommandLineFlag(cmdLine, L"-batchinput");
+
+    // -inputthread: receive and timestamp raw input on a time-critical thread, so a slow
+    // Present or EndDraw never delays a timestamp
+    g_app.useInputThread = HasCommandLineFlag(cmdLine, L"-inputthread");
+
+    // -sched=<spec>: pin and prioritize the render and input threads (see core/thread_policy.h),
+    // e.g. -sched=render=2:high,input=3:rt,process=high
+    std::string schedText;
+    if (GetCommandLineValue(cmdLine, L"-sched", schedText) && !ParseSchedulerConfig(schedText.c_str(), g_app.sched))
+    {
+        MessageBoxW(nullptr, L"Invalid -sched (e.g. -sched=render=2:high,input=3:rt)", L"Error", MB_OK);
+        return 1;
+    }
+    g_app.schedResult.processPriority = ApplyProcessPriority(g_app.sched);
+    g_app.schedResult.Set(ThreadRole::Render, ApplyThreadPolicy(ThreadRole::Render, g_app.sched[ThreadRole::Render]));
+
+    // -wait=<strategy>[:<fps>][,pause]: spin (default), yield, hybrid or waitable between
+    // frames; input always ends the wait (see core/wait_strategy.h)
+    std::string waitText;
+    if (GetCommandLineValue(cmdLine, L"-wait", waitText) && !ParseWaitConfig(waitText.c_str(), g_app.waitConfig))
+    {
+        MessageBoxW(nullptr, L"Invalid -wait (e.g. -wait=hybrid:2000,pause)", L"Error", MB_OK);
+        return 1;
+    }
+    if (!g_app.waitTarget.Init())
+    {
+        MessageBoxW(nullptr, L"Failed to create wait timer", L"Error", MB_OK);
+        return 1;
+    }
+    if (g_app.useInputThread)
+        g_app.waitTarget.AttachInputThread(g_app.threadedInput);
+
+    // -pattern=<steps>: flash trains instead of a single flash (see core/flash_pattern.h)
+    std::string patternText;
+    if (GetCommandLineValue(cmdLine, L"-pattern", patternText))
+    {
+        FlashPattern pattern;
+        if (!ParseFlashPattern(patternText.c_str(), pattern))
+        {
+            MessageBoxW(nullptr, L"Invalid -pattern (e.g. -pattern=2f@1,2f@0,x10)", L"Error", MB_OK);
+            return 1;
+        }
+        g_app.tester.flash.SetPattern(pattern);
+    }
+
+    // -frametimes=<path>: export every frame time of the last 10 minutes as CSV on exit
+    GetCommandLineValue(cmdLine, L"-frametimes", g_app.frameTimesPath);
+
+    // -stages=<path>: export the input-to-present stage histograms as CSV on exit
+    GetCommandLineValue(cmdLine, L"-stages", g_app.stagesPath);
+
+    // -trace=<path>: capture every input, flash and present to a binary trace
+    std::string tracePath;
+    if (GetCommandLineValue(cmdLine, L"-trace", tracePath) && !g_app.trace.Open(tracePath, Clock::now()))
+    {
+        MessageBoxW(nullptr, L"Failed to create trace file", L"Error", MB_OK);
+        return 1;
+    }
+    // The pattern goes in first so a replay flashes the same trains
+    if (g_app.trace.IsOpen() && g_app.tester.flash.HasPattern())
+    {
+        TraceRecord records[FlashPattern::MAX_STEPS + 1];
+        size_t count = MakeFlashPatternRecords(Clock::now(), g_app.tester.flash.Pattern(), records);
+        for (size_t i = 0; i < count; ++i)
+            g_app.trace.Append(records[i]);
+    }
+
     if (!InitWindow())
     {
         MessageBoxW(nullptr, L"Failed to create window", L"Error", MB_OK);
@@ -815,25 +988,65 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
         return 1;
     }
 
+    // -capture=<wav>: record the microphone next to the mouse; with -trace, LatencyHeadless
+    // clicks <wav> <trace> pairs every switch click with its button-down event. Started once
+    // the window and devices are up, so no failure above leaves the capture thread running.
+    std::string capturePath;
+    if (GetCommandLineValue(cmdLine, L"-capture", capturePath))
+    {
+        CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        if (!g_app.capture.Start(capturePath, false))
+        {
+            MessageBoxW(nullptr, L"Failed to start the microphone capture", L"Error", MB_OK);
+            Cleanup();
+            CoUninitialize();
+            return 1;
+        }
+    }
+
+    if (g_app.useInputThread)
+        g_app.schedResult.Set(ThreadRole::Input, g_app.inputThread.Applied());
+    if (SchedulerRefused(g_app.sched, g_app.schedResult))
+    {
+        char text[512];
+        FormatSchedulerResult(g_app.sched, g_app.schedResult, text, sizeof(text));
+        int length = swprintf_s(g_app.schedText, L"%hs", text);
+        g_app.schedLength = length > 0 ? (size_t)length : 0;
+    }
+
     // Main loop - minimal overhead
+    g_app.waiter.Configure(g_app.waitConfig, Clock::now());
     MSG msg = {};
     while (g_app.running)
     {
+        g_app.waiter.Wait(g_app.waitTarget);
+
         // Process all pending messages immediately (non-blocking)
-        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE))
+        if (g_app.batchInput && !g_app.useInputThread)
         {
-            if (msg.message == WM_QUIT)
-            {
+            if (!PumpMessagesExceptRawInput())
                 g_app.running = false;
-                break;
+        }
+        else
+        {
+            while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE))
+            {
+                if (msg.message == WM_QUIT)
+                {
+                    g_app.running = false;
+                    break;
+                }
+                TranslateMessage(&msg);
+                DispatchMessageW(&msg);
             }
-            TranslateMessage(&msg);
-            DispatchMessageW(&msg);
         }
 
+        ProcessInputEvents();
         Render();
     }
 
     Cleanup();
+    if (!capturePath.empty())
+        CoUninitialize();
     return 0;
 }
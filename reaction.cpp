@@ -1,6 +1,6 @@
 // DX11 Visual Reaction Time Tester
 // Measures visual reaction time with minimal input-to-photon latency
-// Uses WASAPI exclusive mode for low-latency audio
+// Uses WASAPI event-driven audio in the lowest-latency mode the device accepts
 
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
@@ -15,9 +15,18 @@
 #include <chrono>
 #include <random>
 #include <hidusage.h>
-#include <mmdeviceapi.h>
-#include <audioclient.h>
 #include <cmath>
+#include <algorithm>
+#include "core/audio_caps.h"
+#include "core/audio_stimulus.h"
+#include "core/audio_thread.h"
+#include "core/reaction_tester.h"
+#include "core/thread_policy.h"
+#include "core/trace_file.h"
+#include "win32/command_line.h"
+#include "win32/raw_input.h"
+#include "win32/wasapi_capture.h"
+#include "win32/wasapi_endpoint.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -26,32 +35,15 @@
 #pragma comment(lib, "ole32.lib")
 
 using Microsoft::WRL::ComPtr;
-using Clock = std::chrono::high_resolution_clock;
 
 // Forward declarations
 void ToggleFullscreen();
-void StartNewRound();
 
-// Configuration
-constexpr float MIN_DELAY_MS = 1500.0f;  // Minimum wait before flash
-constexpr float MAX_DELAY_MS = 5000.0f;  // Maximum wait before flash
-constexpr size_t MAX_LOG_ENTRIES = 25;   // Max reaction times to display
-
-// Audio configuration
-constexpr float TONE_FREQ_HZ = 800.0f;   // Beep frequency
-constexpr float TONE_DURATION_MS = 80.0f; // Beep duration
+// Audio configuration (the stimulus itself defaults to an 800 Hz, 80 ms tone; see -stimulus)
 constexpr UINT32 AUDIO_SAMPLE_RATE = 48000;
 constexpr UINT32 AUDIO_CHANNELS = 2;
 constexpr UINT32 AUDIO_BITS = 16;
 
-// Test state
-enum class TestState
-{
-    Waiting,      // Black screen, waiting for random delay
-    Flashing,     // White screen, waiting for click
-    TooEarly      // Clicked before flash (false start)
-};
-
 // Global state
 struct AppState
 {
@@ -70,20 +62,22 @@ struct AppState
     ComPtr<ID2D1SolidColorBrush> textBrush;
     ComPtr<ID2D1SolidColorBrush> redBrush;
 
-    // Test state
-    TestState state = TestState::Waiting;
-    Clock::time_point roundStartTime;
-    Clock::time_point flashStartTime;
-    float targetDelayMs = 0.0f;
+    // Test state machine, results and mode (portable core)
+    ReactionTester tester;
+
+    // Raw input devices and decoded events (WndProc -> main loop)
+    Win32DeviceEnumerator deviceEnumerator;
+    DeviceRegistry devices{deviceEnumerator};
+    RingInputSource input;
+    InputEvent inputBatch[InputSource::MAX_POLL_EVENTS];
 
-    // Results
-    std::vector<float> reactionTimes;
-    float lastReactionTime = 0.0f;
-    float averageTime = 0.0f;
-    float bestTime = 0.0f;
+    // Binary session trace (-trace=<path>)
+    TraceWriter trace;
+    uint32_t stimulusCount = 0;
+    uint32_t frameIndex = 0;
 
-    // Random number generator
-    std::mt19937 rng{std::random_device{}()};
+    // Trial journal (-trials=<path>), appended to across sessions
+    TrialJournal journal;
 
     // Window
     HWND hwnd = nullptr;
@@ -92,270 +86,156 @@ struct AppState
     bool running = true;
     bool isFullscreen = true;
 
-    // Mode
-    bool audioMode = false;        // F1 toggles: false=visual, true=audio
-    bool beepPlayed = false;       // Track if beep was played this round
-
-    // WASAPI audio (low-latency)
-    IMMDeviceEnumerator* audioEnumerator = nullptr;
-    IMMDevice* audioDevice = nullptr;
-    IAudioClient* audioClient = nullptr;
-    IAudioRenderClient* audioRenderClient = nullptr;
-    WAVEFORMATEX* audioFormat = nullptr;
-    UINT32 audioBufferFrames = 0;
+    // WASAPI audio, serviced by its own event-driven thread
+    WasapiEndpoint audioEndpoint;
+    AudioRenderThread audioThread;
+    AudioOnset audioOnsets[AudioRenderThread::ONSET_CAPACITY];
+    uint32_t beepSequence = 0; // Arm of this round's beep (0: none pending)
     bool audioInitialized = false;
-    float audioLatencyMs = 0.0f;   // Reported latency for display
-} g_app;
 
-float GetRandomDelay()
-{
-    std::uniform_real_distribution<float> dist(MIN_DELAY_MS, MAX_DELAY_MS);
-    return dist(g_app.rng);
-}
+    // Per-device stream configuration (-audiocache=<path>, -shared), see core/audio_caps.h
+    AudioCapsCache audioCache;
+    std::string audioCachePath;
+    AudioConfigPreference audioPreference;
+    bool audioFromCache = false; // Opened the cached configuration without probing
 
-void StartNewRound()
-{
-    g_app.state = TestState::Waiting;
-    g_app.roundStartTime = Clock::now();
-    g_app.targetDelayMs = GetRandomDelay();
-    g_app.beepPlayed = false;
-}
+    // Loopback or microphone recording of the stimuli (-capture=<wav>, -capturemic)
+    WasapiCapture capture;
+    std::string capturePath;
+    bool captureMic = false;
 
-void UpdateStats()
-{
-    if (g_app.reactionTimes.empty()) return;
+    // Stimulus waveform, rendered for the device format at init (-stimulus=<spec>)
+    StimulusSpec stimulusSpec;
+    StimulusBuffer stimulus;
 
-    float sum = 0.0f;
-    float best = g_app.reactionTimes[0];
-    for (float t : g_app.reactionTimes)
-    {
-        sum += t;
-        if (t < best) best = t;
-    }
-    g_app.averageTime = sum / g_app.reactionTimes.size();
-    g_app.bestTime = best;
-}
+    // What the OS refused of -sched (render and audio threads), shown above the instructions
+    wchar_t schedText[512] = L"";
+    size_t schedLength = 0;
+} g_app;
 
-// Initialize WASAPI in exclusive mode for lowest latency
-bool InitWASAPI()
+// Opens the default endpoint in the lowest-latency configuration it accepts: the one cached
+// for the device if it still opens, otherwise the first of the probed configurations that does
+bool OpenAudioEndpoint()
 {
-    HRESULT hr;
-
-    // Create device enumerator
-    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
-                          __uuidof(IMMDeviceEnumerator), (void**)&g_app.audioEnumerator);
-    if (FAILED(hr)) return false;
-
-    // Get default audio output device
-    hr = g_app.audioEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &g_app.audioDevice);
-    if (FAILED(hr)) return false;
-
-    // Activate audio client
-    hr = g_app.audioDevice->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&g_app.audioClient);
-    if (FAILED(hr)) return false;
-
-    // Get device's mix format as starting point
-    hr = g_app.audioClient->GetMixFormat(&g_app.audioFormat);
-    if (FAILED(hr)) return false;
-
-    // Try exclusive mode with smallest buffer
-    // Request 3ms buffer (30000 * 100ns = 3ms)
-    REFERENCE_TIME requestedDuration = 30000; // 3ms in 100ns units
-
-    // First try exclusive mode
-    hr = g_app.audioClient->Initialize(
-        AUDCLNT_SHAREMODE_EXCLUSIVE,
-        AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-        requestedDuration,
-        requestedDuration,
-        g_app.audioFormat,
-        nullptr);
-
-    // If exclusive fails, fall back to shared mode with low latency
-    if (FAILED(hr))
+    WasapiEndpoint &endpoint = g_app.audioEndpoint;
+    if (!endpoint.SelectDefaultDevice())
+        return false;
+    const std::string &deviceId = endpoint.DeviceId();
+    AudioConfig config;
+    g_app.audioFromCache = g_app.audioCache.Find(deviceId, endpoint.MixFormat(), config) &&
+                           (g_app.audioPreference.allowExclusive || config.mode != AudioShareMode::Exclusive) &&
+                           endpoint.Open(config);
+    if (g_app.audioFromCache)
+        return true;
+
+    AudioDeviceCaps caps;
+    if (!endpoint.Probe(caps))
+        return false;
+    AudioConfigPreference preference = g_app.audioPreference;
+    preference.minPeriodUs = std::max(preference.minPeriodUs, g_app.audioCache.PeriodFloor(deviceId));
+    for (const AudioConfig &candidate : RankAudioConfigs(caps, preference))
     {
-        // Release and reactivate for shared mode
-        g_app.audioClient->Release();
-        g_app.audioDevice->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&g_app.audioClient);
-
-        // Shared mode with auto-convert for compatibility
-        DWORD streamFlags = AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM | AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY;
-        requestedDuration = 100000; // 10ms fallback
-
-        hr = g_app.audioClient->Initialize(
-            AUDCLNT_SHAREMODE_SHARED,
-            streamFlags,
-            requestedDuration,
-            0,
-            g_app.audioFormat,
-            nullptr);
-
-        if (FAILED(hr)) return false;
+        if (!endpoint.Open(candidate))
+            continue;
+        g_app.audioCache.Store(deviceId, caps.mixFormat, endpoint.Config());
+        g_app.audioCache.Save(g_app.audioCachePath);
+        return true;
     }
+    return false;
+}
 
-    // Get buffer size
-    hr = g_app.audioClient->GetBufferSize(&g_app.audioBufferFrames);
-    if (FAILED(hr)) return false;
-
-    // Calculate latency
-    REFERENCE_TIME latency;
-    g_app.audioClient->GetStreamLatency(&latency);
-    g_app.audioLatencyMs = (float)latency / 10000.0f;
-
-    // Get render client
-    hr = g_app.audioClient->GetService(__uuidof(IAudioRenderClient), (void**)&g_app.audioRenderClient);
-    if (FAILED(hr)) return false;
+// Opens the audio endpoint, renders the stimulus for its format and starts the audio
+// thread, which keeps the stream running (silence between stimuli) until cleanup
+bool InitWASAPI(const ThreadPolicy &policy)
+{
+    if (!OpenAudioEndpoint())
+        return false;
 
-    g_app.audioInitialized = true;
-    return true;
+    // Render the stimulus now so playing it is only a copy
+    if (!g_app.stimulus.Prepare(g_app.stimulusSpec, g_app.audioEndpoint.Format()))
+        return false;
+    g_app.audioInitialized =
+        g_app.audioThread.Start(g_app.audioEndpoint, g_app.stimulus, g_app.audioEndpoint.Period(), policy);
+    return g_app.audioInitialized;
 }
 
-// Play a low-latency beep using WASAPI
+// Play a low-latency beep: the audio thread starts it on the first frame of the next period
 void PlayBeepWASAPI()
 {
     if (!g_app.audioInitialized) return;
 
-    // Stop any previous playback
-    g_app.audioClient->Stop();
-    g_app.audioClient->Reset();
-
-    // Calculate samples needed for tone
-    UINT32 sampleRate = g_app.audioFormat->nSamplesPerSec;
-    UINT32 channels = g_app.audioFormat->nChannels;
-    UINT32 toneSamples = (UINT32)(sampleRate * TONE_DURATION_MS / 1000.0f);
-
-    // Clamp to buffer size
-    if (toneSamples > g_app.audioBufferFrames)
-        toneSamples = g_app.audioBufferFrames;
-
-    // Get buffer
-    BYTE* buffer;
-    HRESULT hr = g_app.audioRenderClient->GetBuffer(toneSamples, &buffer);
-    if (FAILED(hr)) return;
+    g_app.beepSequence = g_app.audioThread.Arm();
+}
 
-    // Generate sine wave
-    float phaseIncrement = 2.0f * 3.14159265f * TONE_FREQ_HZ / sampleRate;
-    float phase = 0.0f;
+// Times this round's beep from the moment its first sample reaches the DAC, once the
+// audio thread has placed it
+void ProcessAudioOnsets()
+{
+    if (!g_app.audioInitialized) return;
 
-    if (g_app.audioFormat->wBitsPerSample == 32)
+    size_t count = g_app.audioThread.PollOnsets(g_app.audioOnsets, AudioRenderThread::ONSET_CAPACITY);
+    for (size_t i = 0; i < count; ++i)
     {
-        // 32-bit float format (common for WASAPI)
-        float* fBuffer = (float*)buffer;
-        for (UINT32 i = 0; i < toneSamples; i++)
-        {
-            float sample = sinf(phase) * 0.5f; // 50% volume
-            for (UINT32 ch = 0; ch < channels; ch++)
-            {
-                *fBuffer++ = sample;
-            }
-            phase += phaseIncrement;
-        }
-    }
-    else if (g_app.audioFormat->wBitsPerSample == 16)
-    {
-        // 16-bit PCM
-        INT16* iBuffer = (INT16*)buffer;
-        for (UINT32 i = 0; i < toneSamples; i++)
-        {
-            INT16 sample = (INT16)(sinf(phase) * 16000.0f);
-            for (UINT32 ch = 0; ch < channels; ch++)
-            {
-                *iBuffer++ = sample;
-            }
-            phase += phaseIncrement;
-        }
+        const AudioOnset &onset = g_app.audioOnsets[i];
+        if (onset.start.sequence != g_app.beepSequence || !onset.timed)
+            continue;
+        g_app.beepSequence = 0;
+        if (g_app.tester.SetStimulusTime(onset.dacTime, (float)onset.errorUs) && g_app.trace.IsOpen())
+            g_app.trace.Append(MakeAudioOnsetRecord(onset.dacTime, (float)onset.errorUs, g_app.stimulusCount));
     }
-
-    // Release buffer and start playback immediately
-    g_app.audioRenderClient->ReleaseBuffer(toneSamples, 0);
-    g_app.audioClient->Start();
 }
 
 void CleanupWASAPI()
 {
-    if (g_app.audioClient)
-    {
-        g_app.audioClient->Stop();
-    }
-    if (g_app.audioRenderClient)
-    {
-        g_app.audioRenderClient->Release();
-        g_app.audioRenderClient = nullptr;
-    }
-    if (g_app.audioFormat)
+    // Underruns in more than 0.1% of the periods: the next start picks a longer period
+    AudioThreadStats stats = g_app.audioThread.Stats();
+    if (g_app.audioInitialized && stats.periods > 1000 && stats.underruns * 1000 > stats.periods)
     {
-        CoTaskMemFree(g_app.audioFormat);
-        g_app.audioFormat = nullptr;
-    }
-    if (g_app.audioClient)
-    {
-        g_app.audioClient->Release();
-        g_app.audioClient = nullptr;
-    }
-    if (g_app.audioDevice)
-    {
-        g_app.audioDevice->Release();
-        g_app.audioDevice = nullptr;
-    }
-    if (g_app.audioEnumerator)
-    {
-        g_app.audioEnumerator->Release();
-        g_app.audioEnumerator = nullptr;
+        uint32_t periodUs = (uint32_t)(std::chrono::duration_cast<std::chrono::microseconds>(
+                                           g_app.audioEndpoint.Period()).count());
+        g_app.audioCache.SetPeriodFloor(g_app.audioEndpoint.DeviceId(), periodUs + periodUs / 2);
+        g_app.audioCache.Save(g_app.audioCachePath);
     }
+    g_app.audioThread.Stop();
+    g_app.audioEndpoint.Close();
+    g_app.audioInitialized = false;
 }
 
 void ProcessRawInput(LPARAM lParam)
 {
-    UINT size = 0;
-    GetRawInputData((HRAWINPUT)lParam, RID_INPUT, nullptr, &size, sizeof(RAWINPUTHEADER));
-    if (size == 0) return;
-
-    std::vector<BYTE> buffer(size);
-    if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, buffer.data(), &size, sizeof(RAWINPUTHEADER)) != size)
+    // Timestamp on arrival, handle after the message pump
+    InputEvent ev;
+    if (!ReadRawInput(lParam, Clock::now(), g_app.devices, ev))
         return;
 
-    RAWINPUT *raw = (RAWINPUT *)buffer.data();
+    g_app.input.Push(ev);
+}
 
-    // Only care about mouse button down events
-    if (raw->header.dwType == RIM_TYPEMOUSE)
+void ProcessInputEvents()
+{
+    // Only mouse button down events matter to the state machine
+    size_t count = g_app.input.Poll(g_app.inputBatch, InputSource::MAX_POLL_EVENTS);
+    for (size_t i = 0; i < count; ++i)
     {
-        RAWMOUSE &mouse = raw->data.mouse;
-
-        // Check for any button down
-        bool buttonDown = (mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_DOWN) ||
-                         (mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_DOWN) ||
-                         (mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_DOWN);
-
-        if (!buttonDown) return;
-
-        auto now = Clock::now();
-
-        if (g_app.state == TestState::Waiting)
+        if (g_app.trace.IsOpen())
+            g_app.trace.Append(MakeInputRecord(g_app.inputBatch[i]));
+        ReactionEvent event = g_app.tester.OnInput(g_app.inputBatch[i]);
+        if ((event == ReactionEvent::Response || event == ReactionEvent::FalseStart) && g_app.journal.IsOpen())
         {
-            // Clicked too early!
-            g_app.state = TestState::TooEarly;
-        }
-        else if (g_app.state == TestState::Flashing)
-        {
-            // Record reaction time
-            float reactionMs = std::chrono::duration<float, std::milli>(now - g_app.flashStartTime).count();
-            g_app.lastReactionTime = reactionMs;
-            g_app.reactionTimes.insert(g_app.reactionTimes.begin(), reactionMs);
-            if (g_app.reactionTimes.size() > MAX_LOG_ENTRIES)
-            {
-                g_app.reactionTimes.pop_back();
-            }
-            UpdateStats();
-            StartNewRound();
-        }
-        else if (g_app.state == TestState::TooEarly)
-        {
-            // Click to restart after false start
-            StartNewRound();
+            const TrialStore &trials = g_app.tester.trials;
+            Trial trial = trials.Row(trials.Count() - 1);
+            g_app.journal.Append(trial, g_app.devices.DisplayName(trial.device));
         }
     }
 }
 
+// Keyboard commands go into the trace so a replay sees the same tester state
+void TraceControlEvent(TimePoint now, TraceControl control)
+{
+    if (g_app.trace.IsOpen())
+        g_app.trace.Append(MakeControlRecord(now, control));
+}
+
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
     switch (msg)
@@ -364,6 +244,13 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         ProcessRawInput(lParam);
         return 0;
 
+    case WM_INPUT_DEVICE_CHANGE:
+        if (wParam == GIDC_ARRIVAL)
+            g_app.devices.OnArrival(DeviceHandleKey((HANDLE)lParam));
+        else if (wParam == GIDC_REMOVAL)
+            g_app.devices.OnRemoval(DeviceHandleKey((HANDLE)lParam));
+        return 0;
+
     case WM_KEYDOWN:
         if (wParam == VK_ESCAPE)
         {
@@ -372,21 +259,16 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         else if (wParam == VK_SPACE)
         {
             // Space to restart/clear
-            g_app.reactionTimes.clear();
-            g_app.averageTime = 0.0f;
-            g_app.bestTime = 0.0f;
-            g_app.lastReactionTime = 0.0f;
-            StartNewRound();
+            TimePoint now = Clock::now();
+            g_app.tester.Reset(now);
+            TraceControlEvent(now, TraceControl::Reset);
         }
         else if (wParam == VK_F1)
         {
             // F1 to toggle audio/visual mode and clear
-            g_app.audioMode = !g_app.audioMode;
-            g_app.reactionTimes.clear();
-            g_app.averageTime = 0.0f;
-            g_app.bestTime = 0.0f;
-            g_app.lastReactionTime = 0.0f;
-            StartNewRound();
+            TimePoint now = Clock::now();
+            g_app.tester.ToggleAudioMode(now);
+            TraceControlEvent(now, TraceControl::ToggleAudio);
         }
         return 0;
 
@@ -438,7 +320,7 @@ bool InitWindow()
     RAWINPUTDEVICE rid = {};
     rid.usUsagePage = HID_USAGE_PAGE_GENERIC;
     rid.usUsage = HID_USAGE_GENERIC_MOUSE;
-    rid.dwFlags = 0;
+    rid.dwFlags = RIDEV_DEVNOTIFY;
     rid.hwndTarget = g_app.hwnd;
 
     if (!RegisterRawInputDevices(&rid, 1, sizeof(RAWINPUTDEVICE)))
@@ -613,39 +495,25 @@ void ToggleFullscreen()
 
 void Render()
 {
-    auto now = Clock::now();
+    const ReactionTester &tester = g_app.tester;
 
     // Check if we should transition from Waiting to Flashing
-    if (g_app.state == TestState::Waiting)
+    TimePoint frameTime = Clock::now();
+    if (g_app.tester.Update(frameTime) == ReactionEvent::StimulusOnset)
     {
-        float elapsed = std::chrono::duration<float, std::milli>(now - g_app.roundStartTime).count();
-        if (elapsed >= g_app.targetDelayMs)
-        {
-            g_app.state = TestState::Flashing;
-            g_app.flashStartTime = Clock::now();
+        if (g_app.trace.IsOpen())
+            g_app.trace.Append(MakeFlashRecord(tester.flashStartTime, true, ++g_app.stimulusCount));
 
-            // Play beep in audio mode (do it right after capturing time for accuracy)
-            if (g_app.audioMode && !g_app.beepPlayed)
-            {
-                g_app.beepPlayed = true;
-                PlayBeepWASAPI(); // Low-latency WASAPI beep
-            }
+        // Play beep in audio mode (do it right after capturing time for accuracy)
+        if (tester.beepPlayed)
+        {
+            PlayBeepWASAPI(); // Low-latency WASAPI beep
         }
     }
 
     // Determine background color
-    float clearColor[4] = {0.0f, 0.0f, 0.0f, 1.0f};
-    if (g_app.state == TestState::Flashing && !g_app.audioMode)
-    {
-        // Only flash white in visual mode
-        clearColor[0] = clearColor[1] = clearColor[2] = 1.0f;
-    }
-    else if (g_app.state == TestState::TooEarly)
-    {
-        clearColor[0] = 0.8f; // Red-ish for false start
-        clearColor[1] = 0.1f;
-        clearColor[2] = 0.1f;
-    }
+    float clearColor[4];
+    tester.GetClearColor(clearColor);
 
     g_app.context->ClearRenderTargetView(g_app.rtv.Get(), clearColor);
 
@@ -656,24 +524,26 @@ void Render()
     float logY = 80.0f;
 
     // Header with mode indicator
-    std::wstring headerText = g_app.audioMode ? L"AUDIO REACTION" : L"VISUAL REACTION";
+    const wchar_t *headerText = tester.audioMode ? L"AUDIO REACTION" : L"VISUAL REACTION";
     D2D1_RECT_F headerRect = D2D1::RectF(20.0f, 20.0f, 400.0f, 60.0f);
-    g_app.d2dRT->DrawText(headerText.c_str(), (UINT32)headerText.length(), g_app.textFormat.Get(), headerRect, g_app.textBrush.Get());
+    g_app.d2dRT->DrawText(headerText, (UINT32)wcslen(headerText), g_app.textFormat.Get(), headerRect, g_app.textBrush.Get());
 
     // Stats
-    if (!g_app.reactionTimes.empty())
+    if (!tester.stats.Empty())
     {
-        wchar_t statsBuffer[128];
-        swprintf_s(statsBuffer, L"Avg: %.1f ms  Best: %.1f ms", g_app.averageTime, g_app.bestTime);
-        D2D1_RECT_F statsRect = D2D1::RectF(20.0f, 45.0f, 600.0f, 80.0f);
+        const ReactionStats &stats = tester.stats;
+        wchar_t statsBuffer[160];
+        swprintf_s(statsBuffer, L"n=%zu  Avg: %.1f \u00B1 %.1f ms  Median: %.1f ms  Trim10: %.1f ms  Best: %.1f ms",
+                   stats.Count(), stats.Mean(), stats.StdDev(), stats.Median(), stats.TrimmedMean(10.0), stats.Best());
+        D2D1_RECT_F statsRect = D2D1::RectF(20.0f, 45.0f, 1000.0f, 80.0f);
         g_app.d2dRT->DrawText(statsBuffer, (UINT32)wcslen(statsBuffer), g_app.textFormat.Get(), statsRect, g_app.textBrush.Get());
     }
 
     // Log entries
-    for (size_t i = 0; i < g_app.reactionTimes.size(); ++i)
+    for (size_t i = 0; i < tester.stats.RecentCount(); ++i)
     {
         wchar_t buffer[64];
-        swprintf_s(buffer, L"%2zu. %.1f ms", i + 1, g_app.reactionTimes[i]);
+        swprintf_s(buffer, L"%2zu. %.1f ms", i + 1, tester.stats.Recent(i));
         D2D1_RECT_F logRect = D2D1::RectF(20.0f, logY, 250.0f, logY + 26.0f);
         g_app.d2dRT->DrawText(buffer, (UINT32)wcslen(buffer), g_app.textFormat.Get(), logRect, g_app.textBrush.Get());
         logY += 26.0f;
@@ -682,46 +552,67 @@ void Render()
     // Center message based on state
     D2D1_RECT_F centerRect = D2D1::RectF(0.0f, 0.0f, (float)g_app.width, (float)g_app.height);
 
-    if (g_app.state == TestState::Waiting)
+    if (tester.state == TestState::Waiting)
     {
         g_app.d2dRT->DrawText(L"Wait for it...", 14, g_app.textFormatLarge.Get(), centerRect, g_app.textBrush.Get());
     }
-    else if (g_app.state == TestState::Flashing)
+    else if (tester.state == TestState::Flashing)
     {
         // Use darker color on white background (visual mode), green on black (audio mode)
-        auto brush = g_app.audioMode ? g_app.textBrush.Get() : g_app.redBrush.Get();
+        auto brush = tester.audioMode ? g_app.textBrush.Get() : g_app.redBrush.Get();
         g_app.d2dRT->DrawText(L"CLICK!", 6, g_app.textFormatLarge.Get(), centerRect, brush);
     }
-    else if (g_app.state == TestState::TooEarly)
+    else if (tester.state == TestState::TooEarly)
     {
         g_app.d2dRT->DrawText(L"TOO EARLY!\nClick to retry", 24, g_app.textFormatLarge.Get(), centerRect, g_app.textBrush.Get());
     }
 
+    // Refused -sched requests, one line per thread, above the instructions
+    if (g_app.schedLength > 0)
+    {
+        D2D1_RECT_F schedRect = D2D1::RectF(20.0f, (float)g_app.height - 150.0f, (float)g_app.width - 20.0f,
+                                            (float)g_app.height - 40.0f);
+        g_app.d2dRT->DrawText(g_app.schedText, (UINT32)g_app.schedLength, g_app.textFormat.Get(), schedRect,
+                              g_app.redBrush.Get());
+    }
+
     // Instructions at bottom
-    std::wstring modeStr = g_app.audioMode ? L"AUDIO" : L"VISUAL";
-    if (g_app.audioMode && g_app.audioInitialized)
+    wchar_t modeStr[96] = L"VISUAL";
+    if (tester.audioMode && g_app.audioInitialized)
     {
-        wchar_t latencyStr[32];
-        swprintf_s(latencyStr, L"AUDIO ~%.1fms", g_app.audioLatencyMs);
-        modeStr = latencyStr;
+        // Onsets are timed at the DAC; the error is the clock fit's for the last one
+        const AudioConfig &config = g_app.audioEndpoint.Config();
+        int length = swprintf_s(modeStr, L"AUDIO %hs %.2fms ~%.1fms (%ls), %llu underruns",
+                                AudioShareModeName(config.mode), config.PeriodMs(), g_app.audioEndpoint.LatencyMs(),
+                                g_app.audioFromCache ? L"cached" : L"probed",
+                                (unsigned long long)g_app.audioThread.Stats().underruns);
+        if (tester.stimulusErrorUs >= 0.0f && length > 0)
+            swprintf_s(modeStr + length, _countof(modeStr) - length, L", DAC +-%.0fus", tester.stimulusErrorUs);
     }
-    else if (g_app.audioMode && !g_app.audioInitialized)
+    else if (tester.audioMode && !g_app.audioInitialized)
     {
-        modeStr = L"AUDIO (N/A)";
+        wcscpy_s(modeStr, L"AUDIO (N/A)");
     }
-    std::wstring instructions = L"ESC=Exit | SPACE=Clear | F1=[" + modeStr +
-                                L"] | F10=" + std::wstring(g_app.isFullscreen ? L"FSE" : L"WIN");
+    wchar_t instructions[192];
+    swprintf_s(instructions, L"ESC=Exit | SPACE=Clear | F1=[%ls] | F10=%ls", modeStr, g_app.isFullscreen ? L"FSE" : L"WIN");
     D2D1_RECT_F instrRect = D2D1::RectF(20.0f, (float)g_app.height - 40.0f, (float)g_app.width - 20.0f, (float)g_app.height - 10.0f);
-    g_app.d2dRT->DrawText(instructions.c_str(), (UINT32)instructions.length(), g_app.textFormat.Get(), instrRect, g_app.textBrush.Get());
+    g_app.d2dRT->DrawText(instructions, (UINT32)wcslen(instructions), g_app.textFormat.Get(), instrRect, g_app.textBrush.Get());
 
     g_app.d2dRT->EndDraw();
 
+    TimePoint presentTime = g_app.trace.IsOpen() ? Clock::now() : TimePoint();
     g_app.swapChain->Present(0, DXGI_PRESENT_DO_NOT_WAIT);
+    if (g_app.trace.IsOpen())
+        g_app.trace.Append(MakePresentRecord(frameTime, presentTime, Clock::now(), clearColor[0] == 1.0f,
+                                             g_app.frameIndex++));
 }
 
 void Cleanup()
 {
+    g_app.capture.Stop();
     CleanupWASAPI();
+    g_app.trace.Close();
+    g_app.journal.Close();
 
     if (g_app.swapChain)
     {
@@ -729,11 +620,80 @@ void Cleanup()
     }
 }
 
-int WINAPI wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
+int WINAPI wWinMain(HINSTANCE, HINSTANCE, LPWSTR cmdLine, int)
 {
     // Initialize COM for WASAPI
     CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 
+    // -sched=<spec>: pin and prioritize the render and audio threads (see core/thread_policy.h)
+    // The audio thread must meet every device period, so it defaults to realtime (MMCSS Pro Audio).
+    SchedulerConfig sched = DefaultSchedulerConfig();
+    sched[ThreadRole::Audio].priority = ThreadPriority::Realtime;
+    std::string schedText;
+    if (GetCommandLineValue(cmdLine, L"-sched", schedText) && !ParseSchedulerConfig(schedText.c_str(), sched))
+    {
+        MessageBoxW(nullptr, L"Invalid -sched (e.g. -sched=render=2:high,process=high)", L"Error", MB_OK);
+        return 1;
+    }
+    SchedulerResult schedResult;
+    schedResult.processPriority = ApplyProcessPriority(sched);
+    schedResult.Set(ThreadRole::Render, ApplyThreadPolicy(ThreadRole::Render, sched[ThreadRole::Render]));
+
+    // -stimulus=<spec>: audio stimulus waveform (see core/audio_stimulus.h)
+    std::string stimulusText;
+    if (GetCommandLineValue(cmdLine, L"-stimulus", stimulusText) &&
+        !ParseStimulusSpec(stimulusText.c_str(), g_app.stimulusSpec))
+    {
+        MessageBoxW(nullptr, L"Invalid -stimulus (e.g. -stimulus=tone,800hz,80ms,release5)", L"Error", MB_OK);
+        return 1;
+    }
+
+    // -audiocache=<path>: per-device audio configuration (default: next to the executable);
+    // -shared: never take the device in exclusive mode
+    if (!GetCommandLineValue(cmdLine, L"-audiocache", g_app.audioCachePath))
+    {
+        char exePath[MAX_PATH];
+        DWORD length = GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+        std::string dir(exePath, length);
+        size_t slash = dir.find_last_of("\\/");
+        g_app.audioCachePath = (slash == std::string::npos ? std::string() : dir.substr(0, slash + 1)) +
+                               "audio_devices.cache";
+    }
+    g_app.audioCache.Load(g_app.audioCachePath);
+    g_app.audioPreference.allowExclusive = !HasCommandLineFlag(cmdLine, L"-shared");
+
+    // -capture=<wav>: record the output loopback (or with -capturemic, the microphone) to
+    // measure trigger -> sound latency offline against the trace. Loopback cannot see an
+    // exclusive stream, so it implies -shared.
+    g_app.captureMic = HasCommandLineFlag(cmdLine, L"-capturemic");
+    if (GetCommandLineValue(cmdLine, L"-capture", g_app.capturePath) && !g_app.captureMic)
+        g_app.audioPreference.allowExclusive = false;
+
+    // -trace=<path>: capture every input, stimulus and present to a binary trace
+    std::string tracePath;
+    if (GetCommandLineValue(cmdLine, L"-trace", tracePath) &&
+        !g_app.trace.Open(tracePath, Clock::now(), g_app.tester.seed))
+    {
+        MessageBoxW(nullptr, L"Failed to create trace file", L"Error", MB_OK);
+        return 1;
+    }
+
+    // -trials=<path>: append every trial to a journal (written off the render thread)
+    std::string trialsPath;
+    if (GetCommandLineValue(cmdLine, L"-trials", trialsPath))
+    {
+        TrialSession session;
+        session.wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::system_clock::now().time_since_epoch()).count();
+        session.startNs = TraceTicks(Clock::now());
+        session.seed = g_app.tester.seed;
+        if (!g_app.journal.Open(trialsPath, session))
+        {
+            MessageBoxW(nullptr, L"Failed to open trial journal", L"Error", MB_OK);
+            return 1;
+        }
+    }
+
     if (!InitWindow())
     {
         MessageBoxW(nullptr, L"Failed to create window", L"Error", MB_OK);
@@ -753,13 +713,30 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
     }
 
     // Initialize WASAPI for low-latency audio (non-fatal if fails)
-    if (!InitWASAPI())
+    if (!InitWASAPI(sched[ThreadRole::Audio]))
     {
         // Audio won't work but visual mode still will
         g_app.audioInitialized = false;
     }
+    if (g_app.audioInitialized)
+        schedResult.Set(ThreadRole::Audio, g_app.audioThread.Applied());
+    if (SchedulerRefused(sched, schedResult))
+    {
+        char text[512];
+        FormatSchedulerResult(sched, schedResult, text, sizeof(text));
+        int length = swprintf_s(g_app.schedText, L"%hs", text);
+        g_app.schedLength = length > 0 ? (size_t)length : 0;
+    }
+    if (!g_app.capturePath.empty() && !g_app.capture.Start(g_app.capturePath, !g_app.captureMic))
+    {
+        MessageBoxW(nullptr, L"Failed to start the audio capture", L"Error", MB_OK);
+        Cleanup();
+        return 1;
+    }
 
-    StartNewRound();
+    TimePoint start = Clock::now();
+    g_app.tester.StartNewRound(start);
+    TraceControlEvent(start, TraceControl::RoundStart);
 
     MSG msg = {};
     while (g_app.running)
@@ -775,6 +752,8 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
             DispatchMessageW(&msg);
         }
 
+        ProcessAudioOnsets();
+        ProcessInputEvents();
         Render();
     }
 
@@ -0,0 +1,63 @@
+// Win32 backend: minimal "-flag" / "-name=value" parsing of the wWinMain command line
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <cwchar>
+#include <string>
+
+// Finds "-name" as a whole word; returns a pointer just past it or nullptr
+inline const wchar_t *FindCommandLineOption(const wchar_t *cmdLine, const wchar_t *name)
+{
+    if (!cmdLine)
+        return nullptr;
+    size_t len = wcslen(name);
+    for (const wchar_t *p = wcsstr(cmdLine, name); p; p = wcsstr(p + 1, name))
+    {
+        bool startOk = (p == cmdLine) || iswspace(p[-1]);
+        wchar_t next = p[len];
+        if (startOk && (next == L'\0' || next == L'=' || iswspace(next)))
+            return p + len;
+    }
+    return nullptr;
+}
+
+inline bool HasCommandLineFlag(const wchar_t *cmdLine, const wchar_t *name)
+{
+    return FindCommandLineOption(cmdLine, name) != nullptr;
+}
+
+// "-name=value" (value may be quoted); returns the value as UTF-8
+inline bool GetCommandLineValue(const wchar_t *cmdLine, const wchar_t *name, std::string &value)
+{
+    const wchar_t *p = FindCommandLineOption(cmdLine, name);
+    if (!p || *p != L'=')
+        return false;
+    ++p;
+
+    std::wstring wide;
+    if (*p == L'"')
+    {
+        const wchar_t *end = wcschr(++p, L'"');
+        wide.assign(p, end ? end : p + wcslen(p));
+    }
+    else
+    {
+        const wchar_t *end = p;
+        while (*end && !iswspace(*end))
+            ++end;
+        wide.assign(p, end);
+    }
+    if (wide.empty())
+        return false;
+
+    int len = WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), (int)wide.size(), nullptr, 0, nullptr, nullptr);
+    value.assign(len, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), (int)wide.size(), &value[0], len, nullptr, nullptr);
+    return true;
+}
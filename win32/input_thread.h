@@ -0,0 +1,135 @@
+// Win32 backend: raw input on a dedicated high-priority thread
+// A message-only window on the input thread owns the mouse/keyboard raw input
+// registration and the device notifications. RIDEV_INPUTSINK is required because a
+// message-only window is never the foreground window; the process still is, so input
+// is not throttled like a background app's. Reports are timestamped as the thread
+// wakes and published to the render loop through ThreadedInputSource.
+#pragma once
+
+#include <hidusage.h>
+#include "core/input_thread.h"
+#include "core/thread_policy.h"
+#include "raw_input.h"
+
+class RawInputThread
+{
+public:
+    RawInputThread(ThreadedInputSource &source, DeviceRegistry &devices) : m_source(source), m_devices(devices) {}
+
+    // batch: drain with GetRawInputBuffer on every wake-up instead of one WM_INPUT per report
+    // policy: CPU placement and priority of the thread (time-critical by default)
+    bool Start(bool batch, const ThreadPolicy &policy)
+    {
+        m_batch = batch;
+        m_policy = policy;
+        return m_source.Start([this](ThreadedInputSource &source) { Run(source); });
+    }
+
+    // What the OS accepted of the policy; valid once Start() returned
+    const ThreadPolicyResult &Applied() const { return m_applied; }
+
+private:
+    static constexpr UINT WM_STOP_INPUT = WM_APP + 1;
+
+    static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+    {
+        RawInputThread *self = (RawInputThread *)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+        if (self)
+        {
+            switch (msg)
+            {
+            case WM_INPUT:
+            {
+                InputEvent ev;
+                if (ReadRawInput(lParam, Clock::now(), self->m_devices, ev))
+                    self->m_source.Publish(ev);
+                return 0;
+            }
+            case WM_INPUT_DEVICE_CHANGE:
+                if (wParam == GIDC_ARRIVAL)
+                    self->m_devices.OnArrival(DeviceHandleKey((HANDLE)lParam));
+                else if (wParam == GIDC_REMOVAL)
+                    self->m_devices.OnRemoval(DeviceHandleKey((HANDLE)lParam));
+                return 0;
+            }
+        }
+        return DefWindowProcW(hwnd, msg, wParam, lParam);
+    }
+
+    bool Register(HWND target, DWORD flags)
+    {
+        RAWINPUTDEVICE rid[2] = {};
+        rid[0].usUsagePage = HID_USAGE_PAGE_GENERIC;
+        rid[0].usUsage = HID_USAGE_GENERIC_MOUSE;
+        rid[0].dwFlags = flags;
+        rid[0].hwndTarget = target;
+        rid[1] = rid[0];
+        rid[1].usUsage = HID_USAGE_GENERIC_KEYBOARD;
+        return RegisterRawInputDevices(rid, 2, sizeof(RAWINPUTDEVICE)) != FALSE;
+    }
+
+    void Run(ThreadedInputSource &source)
+    {
+        m_applied = ApplyThreadPolicy(ThreadRole::Input, m_policy);
+
+        WNDCLASSEXW wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.lpfnWndProc = WndProc;
+        wc.hInstance = GetModuleHandleW(nullptr);
+        wc.lpszClassName = L"LatencyInputSink";
+        RegisterClassExW(&wc); // Fails harmlessly if a previous start registered it
+
+        HWND hwnd = CreateWindowExW(0, wc.lpszClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr,
+                                    wc.hInstance, nullptr);
+        if (!hwnd)
+        {
+            source.Ready(false);
+            return;
+        }
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)this);
+        if (!Register(hwnd, RIDEV_INPUTSINK | RIDEV_DEVNOTIFY))
+        {
+            DestroyWindow(hwnd);
+            source.Ready(false);
+            return;
+        }
+
+        DWORD threadId = GetCurrentThreadId();
+        source.Ready(true, [threadId] { PostThreadMessageW(threadId, WM_STOP_INPUT, 0, 0); });
+
+        BufferedRawInputSource buffered(m_devices);
+        InputEvent batch[InputSource::MAX_POLL_EVENTS];
+        while (!source.StopRequested())
+        {
+            if (m_batch)
+            {
+                // Sleep until raw input or a posted message arrives, then drain everything
+                MsgWaitForMultipleObjectsEx(0, nullptr, INFINITE, QS_RAWINPUT | QS_POSTMESSAGE | QS_SENDMESSAGE,
+                                            MWMO_INPUTAVAILABLE);
+                size_t count;
+                while ((count = buffered.Poll(batch, InputSource::MAX_POLL_EVENTS)) > 0)
+                {
+                    for (size_t i = 0; i < count; ++i)
+                        source.Publish(batch[i]);
+                }
+                PumpMessagesExceptRawInput();
+            }
+            else
+            {
+                MSG msg;
+                if (GetMessageW(&msg, nullptr, 0, 0) <= 0)
+                    break;
+                DispatchMessageW(&msg);
+            }
+        }
+
+        Register(nullptr, RIDEV_REMOVE);
+        DestroyWindow(hwnd);
+    }
+
+    ThreadedInputSource &m_source;
+    DeviceRegistry &m_devices;
+    bool m_batch = false;
+    ThreadPolicy m_policy;
+    ThreadPolicyResult m_applied;
+};
@@ -0,0 +1,148 @@
+// Win32 backend: raw input reading shared by both testers
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <cstddef>
+#include "core/device_registry.h"
+#include "core/event_log.h"
+#include "core/input_event.h"
+#include "core/input_source.h"
+#include "core/raw_input.h"
+
+static_assert(MOUSE_LEFT_DOWN == RI_MOUSE_LEFT_BUTTON_DOWN, "mouse flag mismatch");
+static_assert(MOUSE_BUTTON5_UP == RI_MOUSE_BUTTON_5_UP, "mouse flag mismatch");
+static_assert(MOUSE_WHEEL == RI_MOUSE_WHEEL, "mouse flag mismatch");
+static_assert(KEY_BREAK == RI_KEY_BREAK && KEY_E0 == RI_KEY_E0, "keyboard flag mismatch");
+static_assert(RAW_TYPE_MOUSE == RIM_TYPEMOUSE && RAW_TYPE_KEYBOARD == RIM_TYPEKEYBOARD, "raw type mismatch");
+static_assert(sizeof(RawInputHeader) == sizeof(RAWINPUTHEADER), "RAWINPUTHEADER layout");
+static_assert(sizeof(RawMouse) == sizeof(RAWMOUSE), "RAWMOUSE layout");
+static_assert(offsetof(RawMouse, buttonFlags) == offsetof(RAWMOUSE, usButtonFlags), "RAWMOUSE layout");
+static_assert(offsetof(RawMouse, lastX) == offsetof(RAWMOUSE, lLastX), "RAWMOUSE layout");
+static_assert(sizeof(RawKeyboard) == sizeof(RAWKEYBOARD), "RAWKEYBOARD layout");
+
+// Resolves device paths through GetRawInputDeviceInfoW (only on a registry miss)
+class Win32DeviceEnumerator : public DeviceEnumerator
+{
+public:
+    bool GetDeviceName(uint64_t handle, std::wstring &name) override
+    {
+        UINT size = 0;
+        GetRawInputDeviceInfoW((HANDLE)(uintptr_t)handle, RIDI_DEVICENAME, nullptr, &size);
+        if (size == 0)
+            return false;
+
+        name.assign(size, L'\0');
+        if (GetRawInputDeviceInfoW((HANDLE)(uintptr_t)handle, RIDI_DEVICENAME, &name[0], &size) == (UINT)-1)
+        {
+            name.clear();
+            return false;
+        }
+        name.resize(wcslen(name.c_str()));
+        return true;
+    }
+};
+
+inline uint64_t DeviceHandleKey(HANDLE device)
+{
+    return (uint64_t)(uintptr_t)device;
+}
+
+// Localized key name from the scan code ("A", "Right Ctrl", ...)
+inline void GetRawKeyName(const InputEvent &ev, wchar_t *out, size_t outSize)
+{
+    UINT scanCode = ev.makeCode;
+    if (ev.keyFlags & RI_KEY_E0)
+        scanCode |= 0x100;
+    if (GetKeyNameTextW(scanCode << 16, out, (int)outSize) == 0 && outSize > 0)
+        out[0] = L'\0';
+}
+
+// Names for log rows, resolved only when a row is formatted for drawing
+class Win32LogNames : public LogNameSource
+{
+public:
+    explicit Win32LogNames(DeviceRegistry &devices) : m_devices(devices) {}
+
+    const wchar_t *DeviceName(uint16_t deviceId) override { return m_devices.DisplayName(deviceId); }
+    void KeyName(const InputEvent &ev, wchar_t *out, size_t outSize) override { GetRawKeyName(ev, out, outSize); }
+
+private:
+    DeviceRegistry &m_devices;
+};
+
+// Reads one WM_INPUT report into a stack buffer and decodes it (no heap allocation)
+// Mouse and keyboard reports always fit in a RAWINPUT; larger HID reports are skipped
+inline bool ReadRawInput(LPARAM lParam, TimePoint time, DeviceRegistry &devices, InputEvent &ev)
+{
+    alignas(8) BYTE buffer[sizeof(RAWINPUT)];
+    UINT size = sizeof(buffer);
+    UINT result = GetRawInputData((HRAWINPUT)lParam, RID_INPUT, buffer, &size, sizeof(RAWINPUTHEADER));
+    if (result == (UINT)-1 || result == 0)
+        return false;
+
+    if (!DecodeRawInputRecord(buffer, result, time, devices, ev))
+        return false;
+    SetDecodeTime(ev, Clock::now());
+    return true;
+}
+
+// Batched path: drains every queued raw input report with GetRawInputBuffer once
+// per loop iteration instead of dispatching one WM_INPUT message per report.
+// The main loop must leave WM_INPUT in the queue (see PumpMessagesExceptRawInput).
+class BufferedRawInputSource : public InputSource
+{
+public:
+    explicit BufferedRawInputSource(DeviceRegistry &devices) : m_devices(devices) {}
+
+    size_t Poll(InputEvent *out, size_t maxEvents) override
+    {
+        size_t total = 0;
+        TimePoint now = Clock::now();
+
+        // Only read when a full call's worth of records fits in out
+        while (maxEvents - total >= MAX_RECORDS_PER_CALL)
+        {
+            UINT size = BATCH_BYTES;
+            UINT count = GetRawInputBuffer((PRAWINPUT)m_buffer, &size, sizeof(RAWINPUTHEADER));
+            if (count == 0 || count == (UINT)-1)
+                break;
+
+            total += DecodeRawInputBatch(m_buffer, BATCH_BYTES, count, now, m_devices,
+                                         out + total, maxEvents - total);
+        }
+        TimePoint decoded = Clock::now();
+        for (size_t i = 0; i < total; ++i)
+            SetDecodeTime(out[i], decoded);
+        return total;
+    }
+
+private:
+    static constexpr UINT BATCH_BYTES = 32 * 1024;
+    static constexpr size_t MAX_RECORDS_PER_CALL = BATCH_BYTES / (sizeof(RAWINPUTHEADER) + sizeof(RAWKEYBOARD)) + 1;
+    static_assert(MAX_RECORDS_PER_CALL <= InputSource::MAX_POLL_EVENTS, "batch buffer too large for one poll");
+
+    DeviceRegistry &m_devices;
+    alignas(8) BYTE m_buffer[BATCH_BYTES];
+};
+
+// Pumps every message except WM_INPUT, which GetRawInputBuffer reads from the queue
+// Returns false once WM_QUIT is seen
+inline bool PumpMessagesExceptRawInput()
+{
+    MSG msg;
+    while (PeekMessageW(&msg, nullptr, 0, WM_INPUT - 1, PM_REMOVE) ||
+           PeekMessageW(&msg, nullptr, WM_INPUT + 1, 0xFFFFFFFF, PM_REMOVE))
+    {
+        if (msg.message == WM_QUIT)
+            return false;
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+// Win32 backend of the main-loop wait strategies
+// Blocks in MsgWaitForMultipleObjectsEx, so any window message or raw input ends the
+// wait, on a high-resolution waitable timer for the deadline (Windows 10 1803+; a
+// regular waitable timer elsewhere), the swap chain's frame-latency waitable object,
+// and the input thread's doorbell when input is received on its own thread.
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include "core/input_thread.h"
+#include "core/wait_strategy.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+class Win32WaitTarget : public WaitTarget
+{
+public:
+    Win32WaitTarget() = default;
+    ~Win32WaitTarget() override
+    {
+        if (m_timer)
+            CloseHandle(m_timer);
+        if (m_doorbell)
+            CloseHandle(m_doorbell);
+    }
+    Win32WaitTarget(const Win32WaitTarget &) = delete;
+    Win32WaitTarget &operator=(const Win32WaitTarget &) = delete;
+
+    bool Init()
+    {
+        m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!m_timer)
+            m_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        return m_timer != nullptr;
+    }
+
+    // Input received on another thread rings an auto-reset event; call before source.Start()
+    void AttachInputThread(ThreadedInputSource &source)
+    {
+        m_input = &source;
+        m_doorbell = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        HANDLE doorbell = m_doorbell;
+        source.SetDoorbell([doorbell] { SetEvent(doorbell); });
+    }
+
+    // IDXGISwapChain2::GetFrameLatencyWaitableObject (owned by the swap chain)
+    void SetFrameLatencyObject(HANDLE frameLatency) { m_frameLatency = frameLatency; }
+    bool HasFrameLatencyObject() const { return m_frameLatency != nullptr; }
+
+    bool Pending() override
+    {
+        return HIWORD(GetQueueStatus(QS_ALLINPUT)) != 0 || (m_input && m_input->HasPending());
+    }
+
+    WakeReason Block(TimePoint deadline, bool frame) override
+    {
+        if (m_input && !m_input->ArmDoorbell())
+            return WakeReason::Input;
+
+        HANDLE handles[3];
+        DWORD count = 0;
+        DWORD timerIndex = MAXDWORD, frameIndex = MAXDWORD;
+        if (deadline != TimePoint::max())
+        {
+            TimePoint now = Clock::now();
+            if (deadline <= now)
+            {
+                if (m_input)
+                    m_input->DisarmDoorbell();
+                return WakeReason::Deadline;
+            }
+            LARGE_INTEGER due;
+            due.QuadPart = -(LONGLONG)((deadline - now).count() / 100); // Relative, 100 ns units
+            if (due.QuadPart == 0)
+                due.QuadPart = -1;
+            SetWaitableTimer(m_timer, &due, 0, nullptr, nullptr, FALSE);
+            timerIndex = count;
+            handles[count++] = m_timer;
+        }
+        if (frame && m_frameLatency)
+        {
+            frameIndex = count;
+            handles[count++] = m_frameLatency;
+        }
+        if (m_input)
+            handles[count++] = m_doorbell;
+
+        DWORD result = MsgWaitForMultipleObjectsEx(count, handles, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+        if (timerIndex != MAXDWORD && result != WAIT_OBJECT_0 + timerIndex)
+            CancelWaitableTimer(m_timer);
+        if (m_input)
+            m_input->DisarmDoorbell();
+
+        if (result == WAIT_OBJECT_0 + timerIndex)
+            return WakeReason::Deadline;
+        if (result == WAIT_OBJECT_0 + frameIndex)
+            return WakeReason::Frame;
+        return WakeReason::Input;
+    }
+
+    bool AcquireFrame(TimePoint deadline) override
+    {
+        if (!m_frameLatency)
+            return true;
+        Clock::duration remaining = deadline - Clock::now();
+        DWORD ms = remaining.count() > 0 ? (DWORD)std::chrono::ceil<std::chrono::milliseconds>(remaining).count() : 0;
+        return WaitForSingleObjectEx(m_frameLatency, ms, TRUE) == WAIT_OBJECT_0;
+    }
+
+private:
+    HANDLE m_timer = nullptr;
+    HANDLE m_doorbell = nullptr;
+    HANDLE m_frameLatency = nullptr;
+    ThreadedInputSource *m_input = nullptr;
+};
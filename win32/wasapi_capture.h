@@ -0,0 +1,134 @@
+// WASAPI capture for measuring the real output latency of the audio stimulus
+// Records either the render endpoint's loopback (the engine's mix as it leaves for the
+// device) or the default microphone into a WAV file on its own thread. Every packet's
+// device position and QPC time go into the file's sync chunk, so the onsets found in the
+// recording can be placed on the trace timebase (LatencyHeadless loopback <wav> <trace>).
+// Loopback only sees shared-mode streams; an exclusive stream bypasses the engine.
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <wrl/client.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "core/wav_file.h"
+#include "wasapi_endpoint.h"
+
+class WasapiCapture
+{
+public:
+    WasapiCapture() = default;
+    ~WasapiCapture() { Stop(); }
+    WasapiCapture(const WasapiCapture &) = delete;
+    WasapiCapture &operator=(const WasapiCapture &) = delete;
+
+    // Caller has COM initialized (MTA). loopback: the default render endpoint's output;
+    // otherwise the default capture endpoint.
+    bool Start(const std::string &path, bool loopback)
+    {
+        Stop();
+        Microsoft::WRL::ComPtr<IMMDeviceEnumerator> enumerator;
+        Microsoft::WRL::ComPtr<IMMDevice> device;
+        WAVEFORMATEX *mixFormat = nullptr;
+        AudioFormat format;
+        bool ok = SUCCEEDED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+                                             IID_PPV_ARGS(&enumerator))) &&
+                  SUCCEEDED(enumerator->GetDefaultAudioEndpoint(loopback ? eRender : eCapture, eConsole, &device)) &&
+                  SUCCEEDED(device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void **)&m_client)) &&
+                  SUCCEEDED(m_client->GetMixFormat(&mixFormat)) && ParseWasapiFormat(mixFormat, format);
+
+        // 100 ms of buffer: the thread drains it every few milliseconds
+        const DWORD flags = loopback ? AUDCLNT_STREAMFLAGS_LOOPBACK : 0;
+        ok = ok && SUCCEEDED(m_client->Initialize(AUDCLNT_SHAREMODE_SHARED, flags, 1000000, 0, mixFormat, nullptr)) &&
+             SUCCEEDED(m_client->GetService(IID_PPV_ARGS(&m_capture))) && m_writer.Open(path, format);
+        if (mixFormat)
+            CoTaskMemFree(mixFormat);
+        if (!ok)
+        {
+            m_writer.Close();
+            m_capture.Reset();
+            m_client.Reset();
+            return false;
+        }
+
+        m_stop.store(false);
+        m_frames.store(0);
+        m_thread = std::thread([this] { Run(); });
+        return true;
+    }
+
+    // Stops recording and finishes the file
+    void Stop()
+    {
+        if (m_thread.joinable())
+        {
+            m_stop.store(true);
+            m_thread.join();
+        }
+        m_capture.Reset();
+        m_client.Reset();
+    }
+
+    bool Running() const { return m_thread.joinable(); }
+    uint64_t Frames() const { return m_frames.load(std::memory_order_relaxed); }
+
+private:
+    void Run()
+    {
+        bool comEntered = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+        bool started = SUCCEEDED(m_client->Start());
+        bool haveBase = false;
+        UINT64 basePosition = 0;
+        while (started && !m_stop.load())
+        {
+            Sleep(2);
+            UINT32 packet = 0;
+            while (SUCCEEDED(m_capture->GetNextPacketSize(&packet)) && packet > 0)
+            {
+                BYTE *data = nullptr;
+                UINT32 frames = 0;
+                DWORD flags = 0;
+                UINT64 position = 0, qpcPosition = 0;
+                if (FAILED(m_capture->GetBuffer(&data, &frames, &flags, &position, &qpcPosition)))
+                    break;
+                if (!haveBase)
+                {
+                    basePosition = position;
+                    haveBase = true;
+                }
+                // Frames lost to a glitch are filled with silence, so file frame = device position
+                uint64_t frame = position - basePosition;
+                if (frame > m_writer.Frames())
+                    m_writer.WriteSilence((size_t)(frame - m_writer.Frames()));
+                if (flags & AUDCLNT_BUFFERFLAGS_SILENT)
+                    m_writer.WriteSilence(frames);
+                else
+                    m_writer.Write(data, frames);
+                // The QPC value comes in 100 ns units; on Windows the timebase is QPC in ns
+                m_writer.AddSync(frame, TimePoint(std::chrono::nanoseconds((int64_t)qpcPosition * 100)));
+                m_capture->ReleaseBuffer(frames);
+                m_frames.store(m_writer.Frames(), std::memory_order_relaxed);
+            }
+        }
+        if (started)
+            m_client->Stop();
+        m_writer.Close();
+        if (comEntered)
+            CoUninitialize();
+    }
+
+    Microsoft::WRL::ComPtr<IAudioClient> m_client;
+    Microsoft::WRL::ComPtr<IAudioCaptureClient> m_capture;
+    WavWriter m_writer; // Owned by the capture thread while it runs
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::atomic<uint64_t> m_frames{0};
+};
@@ -0,0 +1,359 @@
+// WASAPI backend of the audio render thread
+// Selects the default render endpoint, probes what it accepts (exclusive formats and
+// minimum period, the shared engine's low-latency periods through IAudioClient3) and opens
+// an event-driven stream in the configuration chosen from that probe (core/audio_caps.h),
+// so the audio thread is woken by the device once per period instead of polling.
+// SelectDefaultDevice(), Probe() and Open() run on the main thread; everything the
+// AudioEndpoint interface declares runs on the audio thread, which joins the MTA.
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <mmsystem.h>
+#include <mmreg.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <wrl/client.h>
+#include <string>
+#include "core/audio_caps.h"
+#include "core/audio_stimulus.h"
+#include "core/audio_thread.h"
+
+// Rate, channels and sample format of a WASAPI format: float if tagged IEEE float (directly
+// or as the extensible subformat), int16 if 16-bit PCM; false for anything else
+inline bool ParseWasapiFormat(const WAVEFORMATEX *wave, AudioFormat &format)
+{
+    WORD tag = wave->wFormatTag;
+    if (tag == WAVE_FORMAT_EXTENSIBLE && wave->cbSize >= 22)
+        tag = (WORD)reinterpret_cast<const WAVEFORMATEXTENSIBLE *>(wave)->SubFormat.Data1;
+    if (tag == WAVE_FORMAT_IEEE_FLOAT && wave->wBitsPerSample == 32)
+        format.sample = SampleFormat::Float32;
+    else if (tag == WAVE_FORMAT_PCM && wave->wBitsPerSample == 16)
+        format.sample = SampleFormat::Int16;
+    else
+        return false;
+    format.sampleRate = wave->nSamplesPerSec;
+    format.channels = wave->nChannels;
+    return true;
+}
+
+class WasapiEndpoint : public AudioEndpoint
+{
+public:
+    WasapiEndpoint() = default;
+    ~WasapiEndpoint() override { Close(); }
+    WasapiEndpoint(const WasapiEndpoint &) = delete;
+    WasapiEndpoint &operator=(const WasapiEndpoint &) = delete;
+
+    // Caller has COM initialized (MTA). Reads the endpoint id and shared-mode mix format.
+    bool SelectDefaultDevice()
+    {
+        Close();
+        Microsoft::WRL::ComPtr<IMMDeviceEnumerator> enumerator;
+        LPWSTR id = nullptr;
+        if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+                                    IID_PPV_ARGS(&enumerator))) ||
+            FAILED(enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &m_device)) ||
+            FAILED(m_device->GetId(&id)) || !Activate() || FAILED(m_client->GetMixFormat(&m_mixFormat)))
+        {
+            if (id)
+                CoTaskMemFree(id);
+            Close();
+            return false;
+        }
+        int len = WideCharToMultiByte(CP_UTF8, 0, id, -1, nullptr, 0, nullptr, nullptr);
+        m_deviceId.assign(len > 0 ? len - 1 : 0, '\0');
+        if (len > 1)
+            WideCharToMultiByte(CP_UTF8, 0, id, -1, &m_deviceId[0], len, nullptr, nullptr);
+        CoTaskMemFree(id);
+        AudioFormat mix;
+        m_mixUsable = ParseWasapiFormat(m_mixFormat, mix);
+        m_mixSample = mix.sample;
+        return true;
+    }
+
+    const std::string &DeviceId() const { return m_deviceId; }
+    AudioFormat MixFormat() const
+    {
+        AudioFormat format;
+        if (m_mixFormat)
+        {
+            format.sampleRate = m_mixFormat->nSamplesPerSec;
+            format.channels = m_mixFormat->nChannels;
+            format.sample = m_mixSample;
+        }
+        return format;
+    }
+
+    // What the selected endpoint accepts. Exclusive formats are asked for one by one (the
+    // common rates, mix and stereo channel counts, both sample formats StimulusBuffer renders).
+    bool Probe(AudioDeviceCaps &caps)
+    {
+        caps = AudioDeviceCaps();
+        if (!m_mixFormat || !Activate())
+            return false;
+        caps.mixUsable = m_mixUsable;
+        caps.mixFormat = MixFormat();
+
+        REFERENCE_TIME defaultPeriod = 0, minimumPeriod = 0;
+        if (SUCCEEDED(m_client->GetDevicePeriod(&defaultPeriod, &minimumPeriod)))
+        {
+            caps.exclusiveMinPeriodUs = (uint32_t)(minimumPeriod / 10);
+            caps.sharedDefaultPeriodUs = (uint32_t)(defaultPeriod / 10);
+        }
+
+        const uint32_t rates[] = {44100, 48000, 88200, 96000, 176400, 192000};
+        const SampleFormat samples[] = {SampleFormat::Float32, SampleFormat::Int16};
+        const uint16_t channelCounts[] = {m_mixFormat->nChannels, 2};
+        for (uint32_t rate : rates)
+        {
+            for (size_t c = 0; c < 2; ++c)
+            {
+                if (c == 1 && channelCounts[1] == channelCounts[0])
+                    continue;
+                for (SampleFormat sample : samples)
+                {
+                    AudioFormat format;
+                    format.sampleRate = rate;
+                    format.channels = channelCounts[c];
+                    format.sample = sample;
+                    WAVEFORMATEXTENSIBLE wave = MakeFormat(format);
+                    if (m_client->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &wave.Format, nullptr) == S_OK)
+                        caps.exclusiveFormats.push_back(format);
+                }
+            }
+        }
+
+        // Low-latency shared periods (Windows 10+); absent on older engines and drivers
+        Microsoft::WRL::ComPtr<IAudioClient3> client3;
+        UINT32 defaultFrames = 0, fundamental = 0, minFrames = 0, maxFrames = 0;
+        if (SUCCEEDED(m_client.As(&client3)) &&
+            SUCCEEDED(client3->GetSharedModeEnginePeriod(m_mixFormat, &defaultFrames, &fundamental, &minFrames,
+                                                         &maxFrames)))
+        {
+            caps.sharedMinFrames = minFrames;
+            caps.sharedMaxFrames = maxFrames;
+            caps.sharedFundamentalFrames = fundamental;
+        }
+        return true;
+    }
+
+    // Opens the selected endpoint in one configuration from RankAudioConfigs; on failure the
+    // device stays selected, so the caller can try the next one
+    bool Open(const AudioConfig &config)
+    {
+        CloseStream();
+        if (!m_mixFormat || (config.mode != AudioShareMode::Exclusive && !m_mixUsable) || !Activate())
+            return false;
+
+        const DWORD eventFlag = AUDCLNT_STREAMFLAGS_EVENTCALLBACK;
+        REFERENCE_TIME period = 0;
+        HRESULT hr = E_FAIL;
+        if (config.mode == AudioShareMode::Exclusive)
+        {
+            // One buffer of one period, refilled whole on every event. A period the driver
+            // cannot align is rounded to its buffer size and the client re-created.
+            WAVEFORMATEXTENSIBLE wave = MakeFormat(config.format);
+            period = (REFERENCE_TIME)(10000000.0 * config.periodFrames / config.format.sampleRate + 0.5);
+            hr = m_client->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, eventFlag, period, period, &wave.Format, nullptr);
+            if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED)
+            {
+                UINT32 alignedFrames = 0;
+                m_client->GetBufferSize(&alignedFrames);
+                period = (REFERENCE_TIME)(10000000.0 * alignedFrames / config.format.sampleRate + 0.5);
+                hr = Activate() ? m_client->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, eventFlag, period, period,
+                                                       &wave.Format, nullptr)
+                                : E_FAIL;
+            }
+            m_format = config.format;
+        }
+        else if (config.mode == AudioShareMode::SharedLowLatency)
+        {
+            // The engine itself runs at this period for as long as the stream is open
+            Microsoft::WRL::ComPtr<IAudioClient3> client3;
+            if (SUCCEEDED(m_client.As(&client3)))
+                hr = client3->InitializeSharedAudioStream(eventFlag, config.periodFrames, m_mixFormat, nullptr);
+            period = (REFERENCE_TIME)(10000000.0 * config.periodFrames / m_mixFormat->nSamplesPerSec + 0.5);
+            m_format = MixFormat();
+        }
+        else
+        {
+            // The engine signals once per its default period and the buffer is refilled in part
+            REFERENCE_TIME minimumPeriod = 0;
+            hr = m_client->Initialize(AUDCLNT_SHAREMODE_SHARED, eventFlag, 100000, 0, m_mixFormat, nullptr);
+            m_client->GetDevicePeriod(&period, &minimumPeriod);
+            m_format = MixFormat();
+        }
+        if (FAILED(hr))
+        {
+            CloseStream();
+            return false;
+        }
+        m_exclusive = config.mode == AudioShareMode::Exclusive;
+        m_config = config;
+        m_config.format = m_format;
+        m_config.periodFrames = (uint32_t)((period * m_format.sampleRate + 5000000) / 10000000);
+        m_period = std::chrono::nanoseconds((int64_t)period * 100);
+
+        REFERENCE_TIME latency = 0;
+        m_client->GetStreamLatency(&latency);
+        m_latencyMs = (float)latency / 10000.0f;
+
+        m_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        m_wake = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!m_event || !m_wake || FAILED(m_client->SetEventHandle(m_event)) ||
+            FAILED(m_client->GetBufferSize(&m_bufferFrames)) ||
+            FAILED(m_client->GetService(IID_PPV_ARGS(&m_render))) ||
+            FAILED(m_client->GetService(IID_PPV_ARGS(&m_clock))) || FAILED(m_clock->GetFrequency(&m_clockFrequency)))
+        {
+            CloseStream();
+            return false;
+        }
+        return true;
+    }
+
+    // After the audio thread stopped
+    void Close()
+    {
+        CloseStream();
+        m_device.Reset();
+        m_deviceId.clear();
+        if (m_mixFormat)
+        {
+            CoTaskMemFree(m_mixFormat);
+            m_mixFormat = nullptr;
+        }
+        m_mixUsable = false;
+    }
+
+    const AudioFormat &Format() const { return m_format; }
+    const AudioConfig &Config() const { return m_config; } // As opened (the period the driver aligned to)
+    Clock::duration Period() const { return m_period; }
+    bool Exclusive() const { return m_exclusive; }
+    float LatencyMs() const { return m_latencyMs; } // Reported stream latency, for display
+
+    bool Enter() override
+    {
+        m_comEntered = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+        return m_comEntered;
+    }
+    bool Start() override { return SUCCEEDED(m_client->Start()); }
+    void Exit() override
+    {
+        m_client->Stop();
+        if (m_comEntered)
+            CoUninitialize();
+        m_comEntered = false;
+    }
+    void Wake() override { SetEvent(m_wake); }
+
+    bool WaitPeriod(uint32_t timeoutMs) override
+    {
+        HANDLE handles[2] = {m_event, m_wake};
+        return WaitForMultipleObjects(2, handles, FALSE, timeoutMs) == WAIT_OBJECT_0;
+    }
+    size_t Writable() override
+    {
+        if (m_exclusive)
+            return m_bufferFrames;
+        UINT32 padding = 0;
+        if (FAILED(m_client->GetCurrentPadding(&padding)))
+            return 0;
+        return m_bufferFrames - padding;
+    }
+    void *Acquire(size_t frames) override
+    {
+        BYTE *data = nullptr;
+        return SUCCEEDED(m_render->GetBuffer((UINT32)frames, &data)) ? data : nullptr;
+    }
+    void Release(size_t frames) override { m_render->ReleaseBuffer((UINT32)frames, 0); }
+    bool PlayedFrames(uint64_t &frames, TimePoint &at) override
+    {
+        // The QPC value comes in 100 ns units; on Windows the timebase is QPC in ns
+        UINT64 position = 0, qpcPosition = 0;
+        if (m_clockFrequency == 0 || FAILED(m_clock->GetPosition(&position, &qpcPosition)))
+            return false;
+        frames = position * m_format.sampleRate / m_clockFrequency;
+        at = TimePoint(std::chrono::nanoseconds((int64_t)qpcPosition * 100));
+        return true;
+    }
+
+private:
+    bool Activate()
+    {
+        m_client.Reset();
+        return m_device &&
+               SUCCEEDED(m_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void **)&m_client));
+    }
+
+    // Releases the stream but keeps the selected device
+    void CloseStream()
+    {
+        m_clock.Reset();
+        m_render.Reset();
+        m_client.Reset();
+        if (m_event)
+        {
+            CloseHandle(m_event);
+            m_event = nullptr;
+        }
+        if (m_wake)
+        {
+            CloseHandle(m_wake);
+            m_wake = nullptr;
+        }
+        m_bufferFrames = 0;
+        m_clockFrequency = 0;
+        m_exclusive = false;
+    }
+
+    // Extensible PCM/float description of a format, speakers as in the mix where they match
+    WAVEFORMATEXTENSIBLE MakeFormat(const AudioFormat &format) const
+    {
+        // KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT share this base; Data1 is the format tag
+        static const GUID SUBTYPE_BASE = {0x00000000, 0x0000, 0x0010, {0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71}};
+        const bool isFloat = format.sample == SampleFormat::Float32;
+        WAVEFORMATEXTENSIBLE wave = {};
+        wave.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+        wave.Format.nChannels = format.channels;
+        wave.Format.nSamplesPerSec = format.sampleRate;
+        wave.Format.wBitsPerSample = isFloat ? 32 : 16;
+        wave.Format.nBlockAlign = (WORD)(format.channels * wave.Format.wBitsPerSample / 8);
+        wave.Format.nAvgBytesPerSec = format.sampleRate * wave.Format.nBlockAlign;
+        wave.Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+        wave.Samples.wValidBitsPerSample = wave.Format.wBitsPerSample;
+        if (m_mixFormat && m_mixFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE &&
+            m_mixFormat->nChannels == format.channels)
+            wave.dwChannelMask = reinterpret_cast<const WAVEFORMATEXTENSIBLE *>(m_mixFormat)->dwChannelMask;
+        else if (format.channels == 2)
+            wave.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+        wave.SubFormat = SUBTYPE_BASE;
+        wave.SubFormat.Data1 = isFloat ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+        return wave;
+    }
+
+    Microsoft::WRL::ComPtr<IMMDevice> m_device;
+    Microsoft::WRL::ComPtr<IAudioClient> m_client;
+    Microsoft::WRL::ComPtr<IAudioRenderClient> m_render;
+    Microsoft::WRL::ComPtr<IAudioClock> m_clock;
+    std::string m_deviceId; // Endpoint id string, UTF-8 (the cache key)
+    WAVEFORMATEX *m_mixFormat = nullptr;
+    SampleFormat m_mixSample = SampleFormat::Float32;
+    bool m_mixUsable = false;
+    HANDLE m_event = nullptr; // Device period event (auto-reset)
+    HANDLE m_wake = nullptr;  // Stop request
+    UINT32 m_bufferFrames = 0;
+    UINT64 m_clockFrequency = 0;
+    bool m_exclusive = false;
+    bool m_comEntered = false;
+
+    AudioFormat m_format;
+    AudioConfig m_config;
+    Clock::duration m_period{0};
+    float m_latencyMs = 0.0f;
+};